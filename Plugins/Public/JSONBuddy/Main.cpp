@@ -125,70 +125,60 @@ void LoadSettings()
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-#define IS_CMD(a) !wscCmd.compare(L##a)
-
 // Admin commands
-bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
+bool AdminCmd_GetStats(CCmds* cmds, const wstring &wscCmd)
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	if (IS_CMD("getstats"))
+	struct PlayerData *pPD = 0;
+	while (pPD = Players.traverse_active(pPD))
 	{
-		struct PlayerData *pPD = 0;
-		while (pPD = Players.traverse_active(pPD))
-		{
-			uint iClientID = HkGetClientIdFromPD(pPD);
-			if (HkIsInCharSelectMenu(iClientID))
-				continue;
+		uint iClientID = HkGetClientIdFromPD(pPD);
+		if (HkIsInCharSelectMenu(iClientID))
+			continue;
 
 
-			CDPClientProxy *cdpClient = g_cClientProxyArray[iClientID - 1];
-			if (!cdpClient)
-				continue;
+		CDPClientProxy *cdpClient = g_cClientProxyArray[iClientID - 1];
+		if (!cdpClient)
+			continue;
 
-			int saturation = (int)(cdpClient->GetLinkSaturation() * 100);
-			int txqueue = cdpClient->GetSendQSize();
-			cmds->Print(L"charname=%s clientid=%u loss=%u lag=%u pingfluct=%u saturation=%u txqueue=%u\n",
-				Players.GetActiveCharacterName(iClientID), iClientID,
-				ConData[iClientID].iAverageLoss, ConData[iClientID].iLags, ConData[iClientID].iPingFluctuation,
-				saturation, txqueue);
-		}
-		cmds->Print(L"OK\n");
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		return true;
+		int saturation = (int)(cdpClient->GetLinkSaturation() * 100);
+		int txqueue = cdpClient->GetSendQSize();
+		cmds->Print(L"charname=%s clientid=%u loss=%u lag=%u pingfluct=%u saturation=%u txqueue=%u\n",
+			Players.GetActiveCharacterName(iClientID), iClientID,
+			ConData[iClientID].iAverageLoss, ConData[iClientID].iLags, ConData[iClientID].iPingFluctuation,
+			saturation, txqueue);
 	}
-	else if (IS_CMD("kick"))
+	cmds->Print(L"OK\n");
+	return true;
+}
+
+// Replaces FLHook's kick, returns false to fall back to it if the character isn't found.
+bool AdminCmd_Kick(CCmds* cmds, const wstring &wscCmd)
+{
+	// Find by charname. If this fails, fall through to default behaviour.
+	CAccount *acc = HkGetAccountByCharname(cmds->ArgCharname(1));
+	if (!acc)
+		return false;
+
+	// Logout.
+	acc->ForceLogout();
+	cmds->Print(L"OK\n");
+
+	// If the client is still active then force the disconnect.
+	uint iClientID = HkGetClientIdFromAccount(acc);
+	if (iClientID != -1)
 	{
-		// Find by charname. If this fails, fall through to default behaviour.
-		CAccount *acc = HkGetAccountByCharname(cmds->ArgCharname(1));
-		if (!acc)
-			return false;
-
-		// Logout.
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		acc->ForceLogout();
-		cmds->Print(L"OK\n");
-
-		// If the client is still active then force the disconnect.
-		uint iClientID = HkGetClientIdFromAccount(acc);
-		if (iClientID != -1)
-		{
-			cmds->Print(L"Forcing logout on iClientID=%d\n", iClientID);
-			Players.logout(iClientID);
-		}
-		return true;
+		cmds->Print(L"Forcing logout on iClientID=%d\n", iClientID);
+		Players.logout(iClientID);
 	}
-	return false;
+	return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-typedef bool(*_UserCmdProc)(uint, const wstring &, const wstring &, const wchar_t*);
-
 struct USERCMD
 {
 	wchar_t *wszCmd;
-	_UserCmdProc proc;
+	USERCMD_CALLBACK proc;
 	wchar_t *usage;
 };
 
@@ -201,44 +191,13 @@ USERCMD UserCmds[] =
 
 
 /**
-This function is called by FLHook when a user types a chat string. We look at the
-string they've typed and see if it starts with one of the above commands. If it
-does we try to process it.
+The commands are registered with FLHook's command router, which calls the command's
+function directly instead of offering every chat string to this plugin.
 */
-bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
+void RegisterUserCommands()
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	wstring wscCmdLineLower = ToLower(wscCmd);
-
-	// If the chat string does not match the USER_CMD then we do not handle the
-	// command, so let other plugins or FLHook kick in. We require an exact match
 	for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
-	{
-
-		if (wscCmdLineLower.find(UserCmds[i].wszCmd) == 0)
-		{
-			// Extract the parameters string from the chat string. It should
-			// be immediately after the command and a space.
-			wstring wscParam = L"";
-			if (wscCmd.length() > wcslen(UserCmds[i].wszCmd))
-			{
-				if (wscCmd[wcslen(UserCmds[i].wszCmd)] != ' ')
-					continue;
-				wscParam = wscCmd.substr(wcslen(UserCmds[i].wszCmd) + 1);
-			}
-
-			// Dispatch the command to the appropriate processing function.
-			if (UserCmds[i].proc(iClientID, wscCmd, wscParam, UserCmds[i].usage))
-			{
-				// We handled the command tell FL hook to stop processing this
-				// chat string.
-				returncode = SKIPPLUGINS_NOFUNCTIONCALL; // we handled the command, return immediatly
-				return true;
-			}
-		}
-	}
-	return false;
+		HkRegisterUserCommand(UserCmds[i].wszCmd, UserCmds[i].proc, UserCmds[i].usage);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -441,7 +400,6 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&LoadSettings, PLUGIN_LoadSettings, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkTimerJSON, PLUGIN_HkTimerCheckKick, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ExecuteCommandString_Callback, PLUGIN_ExecuteCommandString_Callback, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&PlayerLaunch, PLUGIN_HkIServerImpl_PlayerLaunch, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ClearClientInfo, PLUGIN_ClearClientInfo, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&BaseEnter_AFTER, PLUGIN_HkIServerImpl_BaseEnter_AFTER, 0));
@@ -450,7 +408,14 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Help, PLUGIN_UserCmd_Help, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&Update, PLUGIN_HkIServerImpl_Update, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&SPObjUpdate, PLUGIN_HkIServerImpl_SPObjUpdate, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
+
+	HkRegisterAdminCommand(L"getstats", 0, AdminCmd_GetStats);
+	HkRegisterAdminCommand(L"kick", 0, AdminCmd_Kick);
+
+	RegisterUserCommands();
+
+	HkScheduleTimer(1000, 1000, Condata::TimerUpdatePingData);
+	HkScheduleTimer(LOSS_INTERVALL, LOSS_INTERVALL, Condata::TimerUpdateLossData);
 
 	return p_PI;
 }
\ No newline at end of file
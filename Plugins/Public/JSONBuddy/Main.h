@@ -21,6 +21,8 @@ namespace Condata
 	void HkTimerCheckKick();
 	void SPObjUpdate(struct SSPObjUpdateInfo const &ui, unsigned int iClientID);
 	int Update();
+	void TimerUpdatePingData(uint iTimerID, void *pData);
+	void TimerUpdateLossData(uint iTimerID, void *pData);
 	void PlayerLaunch(unsigned int iShip, unsigned int iClientID);
 	bool UserCmd_Ping(uint iClientID, const wstring &wscCmd, const wstring &wscParam, const wchar_t *usage);
 	bool UserCmd_PingTarget(uint iClientID, const wstring &wscCmd, const wstring &wscParam, const wchar_t *usage);
@@ -172,7 +172,7 @@ void Condata::HkTimerCheckKick()
 Update average ping data
 **************************************************************************************************************/
 
-void TimerUpdatePingData()
+void Condata::TimerUpdatePingData(uint iTimerID, void *pData)
 {
 
 	// for all players
@@ -220,7 +220,7 @@ void TimerUpdatePingData()
 Update average loss data
 **************************************************************************************************************/
 
-void TimerUpdateLossData()
+void Condata::TimerUpdateLossData(uint iTimerID, void *pData)
 {
 
 	// for all players 
@@ -278,25 +278,6 @@ void TimerUpdateLossData()
 	}
 }
 
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-	// add timers here
-typedef void(*_TimerFunc)();
-
-struct TIMER
-{
-	_TimerFunc	proc;
-	mstime		tmIntervallMS;
-	mstime		tmLastCall;
-};
-
-TIMER Timers[] =
-{
-	{ TimerUpdatePingData, 1000, 0 },
-	{ TimerUpdateLossData, LOSS_INTERVALL, 0 },
-};
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 int Condata::Update()
@@ -310,16 +291,6 @@ int Condata::Update()
 			ClearConData(HkGetClientIdFromPD(pPD));
 	}
 
-	// call timers
-	for (uint i = 0; (i < sizeof(Timers) / sizeof(TIMER)); i++)
-	{
-		if ((timeInMS() - Timers[i].tmLastCall) >= Timers[i].tmIntervallMS)
-		{
-			Timers[i].tmLastCall = timeInMS();
-			Timers[i].proc();
-		}
-	}
-
 	return 0; // it doesnt matter what we return here since we have set the return code to "DEFAULT_RETURNCODE", so FLHook will just ignore it
 }
 
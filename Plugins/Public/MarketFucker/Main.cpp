@@ -180,25 +180,13 @@ void HkTimerCheckKick()
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-#define IS_CMD(a) !wscCmd.compare(L##a)
-
 // Admin commands
-bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
+bool AdminCmd_ShowMarket(CCmds* cmds, const wstring &wscCmd)
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	if (IS_CMD("showmarket"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		//AdminCmd_GenerateID(cmds, cmds->ArgStrToEnd(1));
-		return true;
-	}
-
-	return false;
+	//AdminCmd_GenerateID(cmds, cmds->ArgStrToEnd(1));
+	return true;
 }
 
-FILE *Logfile = fopen("./flhook_logs/marketfucker.log", "at");
-
 void Logging(const char *szString, ...)
 {
 	char szBufString[1024];
@@ -206,14 +194,10 @@ void Logging(const char *szString, ...)
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
 
-	char szBuf[64];
-	time_t tNow = time(0);
-	struct tm *t = localtime(&tNow);
-	strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-	fprintf(Logfile, "%s %s\n", szBuf, szBufString);
-	fflush(Logfile);
-	fclose(Logfile);
-	Logfile = fopen("./flhook_logs/marketfucker.log", "at");
+	static uint iLogID = 0;
+	if (!iLogID)
+		iLogID = HkLogOpen("./flhook_logs/marketfucker.log", 0, LOG_STAMP_PLUGIN);
+	HkLogWrite(iLogID, "%s", szBufString);
 }
 
 void LogCheater(uint client, const wstring &reason)
@@ -498,12 +482,12 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&LoadSettings, PLUGIN_LoadSettings, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkTimerCheckKick, PLUGIN_HkTimerCheckKick, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ExecuteCommandString_Callback, PLUGIN_ExecuteCommandString_Callback, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&GFGoodBuy, PLUGIN_HkIServerImpl_GFGoodBuy, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&GFGoodSell, PLUGIN_HkIServerImpl_GFGoodSell, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&PlayerLaunch, PLUGIN_HkIServerImpl_PlayerLaunch, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ClearClientInfo, PLUGIN_ClearClientInfo, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&BaseEnter_AFTER, PLUGIN_HkIServerImpl_BaseEnter_AFTER, 0));
 
+	HkRegisterAdminCommand(L"showmarket", 0, AdminCmd_ShowMarket);
 	return p_PI;
 }
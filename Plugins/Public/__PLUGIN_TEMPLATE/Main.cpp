@@ -123,12 +123,10 @@ void ClearClientInfo(uint iClientID)
 //Client command processing
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-typedef bool(*_UserCmdProc)(uint, const wstring &, const wstring &, const wchar_t*);
-
 struct USERCMD
 {
 	wchar_t *wszCmd;
-	_UserCmdProc proc;
+	USERCMD_CALLBACK proc;
 	wchar_t *usage;
 };
 
@@ -139,44 +137,13 @@ USERCMD UserCmds[] =
 };
 
 /**
-This function is called by FLHook when a user types a chat string. We look at the
-string they've typed and see if it starts with one of the above commands. If it
-does we try to process it.
+The commands are registered with FLHook's command router, which calls the command's
+function directly instead of offering every chat string to this plugin.
 */
-bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
+void RegisterUserCommands()
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	wstring wscCmdLineLower = ToLower(wscCmd);
-
-	// If the chat string does not match the USER_CMD then we do not handle the
-	// command, so let other plugins or FLHook kick in. We require an exact match
 	for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
-	{
-
-		if (wscCmdLineLower.find(UserCmds[i].wszCmd) == 0)
-		{
-			// Extract the parameters string from the chat string. It should
-			// be immediately after the command and a space.
-			wstring wscParam = L"";
-			if (wscCmd.length() > wcslen(UserCmds[i].wszCmd))
-			{
-				if (wscCmd[wcslen(UserCmds[i].wszCmd)] != ' ')
-					continue;
-				wscParam = wscCmd.substr(wcslen(UserCmds[i].wszCmd) + 1);
-			}
-
-			// Dispatch the command to the appropriate processing function.
-			if (UserCmds[i].proc(iClientID, wscCmd, wscParam, UserCmds[i].usage))
-			{
-				// We handled the command tell FL hook to stop processing this
-				// chat string.
-				returncode = SKIPPLUGINS_NOFUNCTIONCALL; // we handled the command, return immediatly
-				return true;
-			}
-		}
-	}
-	return false;
+		HkRegisterUserCommand(UserCmds[i].wszCmd, UserCmds[i].proc, UserCmds[i].usage);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -194,7 +161,8 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&LoadSettings, PLUGIN_LoadSettings, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ClearClientInfo, PLUGIN_ClearClientInfo, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
+
+	RegisterUserCommands();
 
 	return p_PI;
 }
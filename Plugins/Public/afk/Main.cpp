@@ -95,12 +95,10 @@ void __stdcall SubmitChat(struct CHAT_ID cId, unsigned long lP1, void const* rdl
 		UserCmdBack(cId.iID,L"",L"",L"");
 }
 
-typedef bool(*_UserCmdProc)(uint, const wstring &, const wstring &, const wchar_t*);
-
 struct USERCMD
 {
 	wchar_t *wszCmd;
-	_UserCmdProc proc;
+	USERCMD_CALLBACK proc;
 	wchar_t *usage;
 };
 
@@ -110,40 +108,14 @@ USERCMD UserCmds[] =
 	{ L"/back*", UserCmdBack, L"Removes the AFK status." },
 };
 
-bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
+/**
+The commands are registered with FLHook's command router, which calls the command's
+function directly instead of offering every chat string to this plugin.
+*/
+void RegisterUserCommands()
 {
-	returnCode = DEFAULT_RETURNCODE;
-
-	wstring wscCmdLineLower = ToLower(wscCmd);
-
-	// If the chat string does not match the USER_CMD then we do not handle the
-	// command, so let other plugins or FLHook kick in. We require an exact match
 	for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
-	{
-
-		if (wscCmdLineLower.find(UserCmds[i].wszCmd) == 0)
-		{
-			// Extract the parameters string from the chat string. It should
-			// be immediately after the command and a space.
-			wstring wscParam = L"";
-			if (wscCmd.length() > wcslen(UserCmds[i].wszCmd))
-			{
-				if (wscCmd[wcslen(UserCmds[i].wszCmd)] != ' ')
-					continue;
-				wscParam = wscCmd.substr(wcslen(UserCmds[i].wszCmd) + 1);
-			}
-
-			// Dispatch the command to the appropriate processing function.
-			if (UserCmds[i].proc(iClientID, wscCmd, wscParam, UserCmds[i].usage))
-			{
-				// We handled the command tell FL hook to stop processing this
-				// chat string.
-				returnCode = SKIPPLUGINS_NOFUNCTIONCALL; // we handled the command, return immediatly
-				return true;
-			}
-		}
-	}
-	return false;
+		HkRegisterUserCommand(UserCmds[i].wszCmd, UserCmds[i].proc, UserCmds[i].usage);
 }
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // FLHOOK STUFF
@@ -162,7 +134,8 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ClearClientInfo, PLUGIN_ClearClientInfo, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&Cb_SendChat, PLUGIN_HkCb_SendChat, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&SubmitChat, PLUGIN_HkIServerImpl_SubmitChat, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
+
+	RegisterUserCommands();
 
 	return p_PI;
 }
\ No newline at end of file
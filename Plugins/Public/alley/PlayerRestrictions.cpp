@@ -31,8 +31,6 @@
 namespace pt = boost::posix_time;
 static int set_iPluginDebug = 0;
 
-FILE *GiftLogfile = fopen("./flhook_logs/alley_gifts.log", "at");
-
 void GiftLogging(const char *szString, ...)
 {
 	char szBufString[1024];
@@ -40,19 +38,14 @@ void GiftLogging(const char *szString, ...)
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
 
-	if (GiftLogfile) {
-		char szBuf[64];
-		time_t tNow = time(0);
-		struct tm *t = localtime(&tNow);
-		strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-		fprintf(GiftLogfile, "%s %s\n", szBuf, szBufString);
-		fflush(GiftLogfile);
-		fclose(GiftLogfile);
-	}
-	else {
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = HkLogOpen("./flhook_logs/alley_gifts.log", 0, LOG_STAMP_PLUGIN)))
+	{
 		ConPrint(L"Failed to write gift log! This might be due to inability to create the directory - are you running as an administrator?\n");
+		return;
 	}
-	GiftLogfile = fopen("./flhook_logs/alley_gifts.log", "at");
+
+	HkLogWrite(iLogID, "%s", szBufString);
 }
 
 /////////////////////////////////////////Penis
@@ -201,7 +194,6 @@ EXPORT PLUGIN_RETURNCODE Get_PluginReturnCode()
 	return returncode;
 }
 
-FILE *PMLogfile = fopen("./flhook_logs/generatedids.log", "at");
 //FILE *JSON_playersonline = fopen("./flhook/playersonline.json", "w");
 
 void PMLogging(const char *szString, ...)
@@ -211,19 +203,14 @@ void PMLogging(const char *szString, ...)
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
 
-	if (PMLogfile) {
-		char szBuf[64];
-		time_t tNow = time(0);
-		struct tm *t = localtime(&tNow);
-		strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-		fprintf(PMLogfile, "%s %s\n", szBuf, szBufString);
-		fflush(PMLogfile);
-		fclose(PMLogfile);
-	}
-	else {
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = HkLogOpen("./flhook_logs/generatedids.log", 0, LOG_STAMP_PLUGIN)))
+	{
 		ConPrint(L"Failed to write generatedids log! This might be due to inability to create the directory - are you running as an administrator?\n");
+		return;
 	}
-	PMLogfile = fopen("./flhook_logs/generatedids.log", "at");
+
+	HkLogWrite(iLogID, "%s", szBufString);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -427,8 +414,15 @@ bool GiftCmd(uint iClientID, const wstring &wscCmd, const wstring &wscParam, con
 	return true;
 }
 
-void AdminCmd_GenerateID(CCmds* cmds, wstring argument)
+bool AdminCmd_GenerateID(CCmds* cmds, const wstring &wscCmd)
 {
+	if (cmds->rights != RIGHT_SUPERADMIN)
+	{
+		cmds->Print(L"ERR No permission\n");
+		return true;
+	}
+
+	wstring argument = cmds->ArgStrToEnd(1);
 	uint thegeneratedid = CreateID(wstos(argument).c_str());
 
 	string s;
@@ -445,15 +439,15 @@ void AdminCmd_GenerateID(CCmds* cmds, wstring argument)
 	cmds->Print(L"OK %s\n", wscMsg.c_str());
 	PMLogging("%s", scText.c_str());
 
-	return;
+	return true;
 }
 
-void AdminCmd_missiontest1(CCmds* cmds, wstring argument)
+bool AdminCmd_missiontest1(CCmds* cmds, const wstring &wscCmd)
 {
 	if (cmds->rights != RIGHT_SUPERADMIN)
 	{
 		cmds->Print(L"ERR No permission\n");
-		return;
+		return true;
 	}
 
 	const wchar_t *wszTargetName = 0;
@@ -486,17 +480,18 @@ void AdminCmd_missiontest1(CCmds* cmds, wstring argument)
 
 	cmds->Print(L"OK\n");
 
-	return;
+	return true;
 }
 
-void AdminCmd_missiontest2(CCmds* cmds, wstring argument)
+bool AdminCmd_missiontest2(CCmds* cmds, const wstring &wscCmd)
 {
 	if (cmds->rights != RIGHT_SUPERADMIN)
 	{
 		cmds->Print(L"ERR No permission\n");
-		return;
+		return true;
 	}
 
+	wstring argument = cmds->ArgStrToEnd(1);
 	const wchar_t *wszTargetName = argument.c_str();
 
 	struct PlayerData *pPD = 0;
@@ -514,22 +509,22 @@ void AdminCmd_missiontest2(CCmds* cmds, wstring argument)
 
 	cmds->Print(L"OK\n");
 
-	return;
+	return true;
 }
 
-void AdminCmd_missiontest2b(CCmds* cmds, wstring argument)
+bool AdminCmd_missiontest2b(CCmds* cmds, const wstring &wscCmd)
 {
 	if (cmds->rights != RIGHT_SUPERADMIN)
 	{
 		cmds->Print(L"ERR No permission\n");
-		return;
+		return true;
 	}
 
 	HKPLAYERINFO adminPlyr;
 	if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK || adminPlyr.iShip == 0)
 	{
 		cmds->Print(L"ERR Not in space\n");
-		return;
+		return true;
 	}
 
 	uint iShip;
@@ -542,6 +537,7 @@ void AdminCmd_missiontest2b(CCmds* cmds, wstring argument)
 	uint iSystem;
 	pub::Player::GetSystem(adminPlyr.iClientID, iSystem);
 
+	wstring argument = cmds->ArgStrToEnd(1);
 	const wchar_t *wszTargetName = argument.c_str();
 
 	struct PlayerData *pPD = 0;
@@ -573,7 +569,7 @@ void AdminCmd_missiontest2b(CCmds* cmds, wstring argument)
 
 	cmds->Print(L"OK\n");
 
-	return;
+	return true;
 }
 
 bool  UserCmd_MarkObjGroup(uint iClientID, const wstring &wscCmd, const wstring &wscParam, const wchar_t *usage)
@@ -699,12 +695,10 @@ bool UserCmd_JettisonAll(uint iClientID, const wstring &wscCmd, const wstring &w
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-typedef bool(*_UserCmdProc)(uint, const wstring &, const wstring &, const wchar_t*);
-
 struct USERCMD
 {
 	wchar_t *wszCmd;
-	_UserCmdProc proc;
+	USERCMD_CALLBACK proc;
 	wchar_t *usage;
 };
 
@@ -733,268 +727,235 @@ USERCMD UserCmds[] =
 
 
 /**
-This function is called by FLHook when a user types a chat string. We look at the
-string they've typed and see if it starts with one of the above commands. If it
-does we try to process it.
+The commands are registered with FLHook's command router, which calls the command's
+function directly instead of offering every chat string to this plugin.
 */
-bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
+void RegisterUserCommands()
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	wstring wscCmdLineLower = ToLower(wscCmd);
-
-	// If the chat string does not match the USER_CMD then we do not handle the
-	// command, so let other plugins or FLHook kick in. We require an exact match
 	for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
-	{
-
-		if (wscCmdLineLower.find(UserCmds[i].wszCmd) == 0)
-		{
-			// Extract the parameters string from the chat string. It should
-			// be immediately after the command and a space.
-			wstring wscParam = L"";
-			if (wscCmd.length() > wcslen(UserCmds[i].wszCmd))
-			{
-				if (wscCmd[wcslen(UserCmds[i].wszCmd)] != ' ')
-					continue;
-				wscParam = wscCmd.substr(wcslen(UserCmds[i].wszCmd) + 1);
-			}
-
-			// Dispatch the command to the appropriate processing function.
-			if (UserCmds[i].proc(iClientID, wscCmd, wscParam, UserCmds[i].usage))
-			{
-				// We handled the command tell FL hook to stop processing this
-				// chat string.
-				returncode = SKIPPLUGINS_NOFUNCTIONCALL; // we handled the command, return immediatly
-				return true;
-			}
-		}
-	}
-	return false;
+		HkRegisterUserCommand(UserCmds[i].wszCmd, UserCmds[i].proc, UserCmds[i].usage);
 }
 
-#define IS_CMD(a) !wscCmd.compare(L##a)
-bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
+bool AdminCmd_ShipTest(CCmds* cmds, const wstring &wscCmd)
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	if (IS_CMD("generateid"))
+	HKPLAYERINFO adminPlyr;
+	if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK)
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-
-		if (cmds->rights != RIGHT_SUPERADMIN)
-		{
-			cmds->Print(L"ERR No permission\n");
-			return true;
-		}
-
-		AdminCmd_GenerateID(cmds, cmds->ArgStrToEnd(1));
+		cmds->Print(L"ERR\n");
 		return true;
 	}
-	else if (IS_CMD("shiptest"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		HKPLAYERINFO adminPlyr;
-		if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK)
-		{
-			cmds->Print(L"ERR\n");
-			return true;
-		}
-
-		if (cmds->rights != RIGHT_SUPERADMIN)
-		{
-			cmds->Print(L"ERR No permission\n");
-			return true;
-		}
-
-		Archetype::Ship* TheShipArch = Archetype::GetShip(Players[adminPlyr.iClientID].iShipArchetype);
-		PrintUserCmdText(adminPlyr.iClientID, L"The secret code is %d", TheShipArch->iArchID);
 
+	if (cmds->rights != RIGHT_SUPERADMIN)
+	{
+		cmds->Print(L"ERR No permission\n");
 		return true;
 	}
-	else if (IS_CMD("healthtest1"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		HKPLAYERINFO adminPlyr;
-		if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK)
-		{
-			cmds->Print(L"ERR\n");
-			return true;
-		}
 
-		if (cmds->rights != RIGHT_SUPERADMIN)
-		{
-			cmds->Print(L"ERR No permission\n");
-			return true;
-		}
-
-		uint iShip;
-		pub::Player::GetShip(adminPlyr.iClientID, iShip);
+	Archetype::Ship* TheShipArch = Archetype::GetShip(Players[adminPlyr.iClientID].iShipArchetype);
+	PrintUserCmdText(adminPlyr.iClientID, L"The secret code is %d", TheShipArch->iArchID);
 
-		float curr, max;
-		pub::SpaceObj::GetHealth(iShip, curr, max);
+	return true;
+}
 
-		float woop = curr - 2000.0f;
-		pub::SpaceObj::SetRelativeHealth(iShip, woop);
+bool AdminCmd_HealthTest1(CCmds* cmds, const wstring &wscCmd)
+{
+	HKPLAYERINFO adminPlyr;
+	if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK)
+	{
+		cmds->Print(L"ERR\n");
 		return true;
 	}
-	else if (IS_CMD("healthtest2"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		HKPLAYERINFO adminPlyr;
-		if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK)
-		{
-			cmds->Print(L"ERR\n");
-			return true;
-		}
 
-		if (cmds->rights != RIGHT_SUPERADMIN)
-		{
-			cmds->Print(L"ERR No permission\n");
-			return true;
-		}
+	if (cmds->rights != RIGHT_SUPERADMIN)
+	{
+		cmds->Print(L"ERR No permission\n");
+		return true;
+	}
 
-		uint iShip;
-		pub::Player::GetShip(adminPlyr.iClientID, iShip);
+	uint iShip;
+	pub::Player::GetShip(adminPlyr.iClientID, iShip);
 
-		float curr, max;
-		pub::SpaceObj::GetHealth(iShip, curr, max);
+	float curr, max;
+	pub::SpaceObj::GetHealth(iShip, curr, max);
 
-		float woop = curr + 2000.0f;
+	float woop = curr - 2000.0f;
+	pub::SpaceObj::SetRelativeHealth(iShip, woop);
+	return true;
+}
 
-		if (woop > max)
-		{
-			HkMsgU(L"DEBUG: woop > max");
-			return true;
-		}
-		pub::SpaceObj::SetRelativeHealth(iShip, woop);
+bool AdminCmd_HealthTest2(CCmds* cmds, const wstring &wscCmd)
+{
+	HKPLAYERINFO adminPlyr;
+	if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK)
+	{
+		cmds->Print(L"ERR\n");
 		return true;
 	}
-	else if (IS_CMD("missiontest1"))
+
+	if (cmds->rights != RIGHT_SUPERADMIN)
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		AdminCmd_missiontest1(cmds, cmds->ArgStrToEnd(1));
+		cmds->Print(L"ERR No permission\n");
 		return true;
 	}
-	else if (IS_CMD("missiontest2"))
+
+	uint iShip;
+	pub::Player::GetShip(adminPlyr.iClientID, iShip);
+
+	float curr, max;
+	pub::SpaceObj::GetHealth(iShip, curr, max);
+
+	float woop = curr + 2000.0f;
+
+	if (woop > max)
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		AdminCmd_missiontest2(cmds, cmds->ArgStrToEnd(1));
+		HkMsgU(L"DEBUG: woop > max");
 		return true;
 	}
-	else if (IS_CMD("missiontest2b"))
+	pub::SpaceObj::SetRelativeHealth(iShip, woop);
+	return true;
+}
+
+bool AdminCmd_NoDock(CCmds* cmds, const wstring &wscCmd)
+{
+	ADOCK::AdminNoDock(cmds, cmds->ArgCharname(1));
+	return true;
+}
+
+bool AdminCmd_TestFuseObj(CCmds* cmds, const wstring &wscCmd)
+{
+	if (cmds->rights != RIGHT_SUPERADMIN)
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		AdminCmd_missiontest2b(cmds, cmds->ArgStrToEnd(1));
+		cmds->Print(L"ERR No permission\n");
 		return true;
 	}
-	else if (IS_CMD("nodock"))
+
+	HKPLAYERINFO adminPlyr;
+	if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK || adminPlyr.iShip == 0)
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		ADOCK::AdminNoDock(cmds, cmds->ArgCharname(1));
+		cmds->Print(L"ERR Not in space\n");
 		return true;
 	}
-	else if (IS_CMD("testfuseobj"))
-	{
-		if (cmds->rights != RIGHT_SUPERADMIN)
-		{
-			cmds->Print(L"ERR No permission\n");
-			return true;
-		}
 
-		HKPLAYERINFO adminPlyr;
-		if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK || adminPlyr.iShip == 0)
-		{
-			cmds->Print(L"ERR Not in space\n");
-			return true;
-		}
+	string fuse = wstos(cmds->ArgStrToEnd(1));
 
-		string fuse = wstos(cmds->ArgStrToEnd(1));
+	uint space_obj = 0;
+	pub::SpaceObj::GetTarget(adminPlyr.iShip, space_obj);
+	pub::SpaceObj::LightFuse(space_obj, fuse.c_str(), 0);
+	return true;
+}
 
-		uint space_obj = 0;
-		pub::SpaceObj::GetTarget(adminPlyr.iShip, space_obj);
-		pub::SpaceObj::LightFuse(space_obj, fuse.c_str(), 0);
+bool AdminCmd_TestUnfuseObj(CCmds* cmds, const wstring &wscCmd)
+{
+	if (cmds->rights != RIGHT_SUPERADMIN)
+	{
+		cmds->Print(L"ERR No permission\n");
 		return true;
 	}
-	else if (IS_CMD("testunfuseobj"))
+
+	HKPLAYERINFO adminPlyr;
+	if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK || adminPlyr.iShip == 0)
 	{
-		if (cmds->rights != RIGHT_SUPERADMIN)
-		{
-			cmds->Print(L"ERR No permission\n");
-			return true;
-		}
+		cmds->Print(L"ERR Not in space\n");
+		return true;
+	}
 
-		HKPLAYERINFO adminPlyr;
-		if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK || adminPlyr.iShip == 0)
-		{
-			cmds->Print(L"ERR Not in space\n");
-			return true;
-		}
+	uint space_obj = 0;
+	pub::SpaceObj::GetTarget(adminPlyr.iShip, space_obj);
 
-		uint space_obj = 0;
-		pub::SpaceObj::GetTarget(adminPlyr.iShip, space_obj);
+	uint fuse = CreateID(wstos(cmds->ArgStrToEnd(1)).c_str());
+	uint dunno;
+	IObjInspectImpl *inspect;
 
-		uint fuse = CreateID(wstos(cmds->ArgStrToEnd(1)).c_str());
-		uint dunno;
-		IObjInspectImpl *inspect;
+	if (GetShipInspect(space_obj, inspect, dunno))
+	{
+		HkUnLightFuse((IObjRW*)inspect, fuse, 0);
+		cmds->Print(L"OK unlighted fuse");
+	}
 
-		if (GetShipInspect(space_obj, inspect, dunno))
-		{
-			HkUnLightFuse((IObjRW*)inspect, fuse, 0);
-			cmds->Print(L"OK unlighted fuse");
-		}
+	return true;
+}
 
+bool AdminCmd_TestSelfFuseObj(CCmds* cmds, const wstring &wscCmd)
+{
+	if (cmds->rights != RIGHT_SUPERADMIN)
+	{
+		cmds->Print(L"ERR No permission\n");
 		return true;
 	}
-	else if (IS_CMD("testselffuseobj"))
+
+	HKPLAYERINFO adminPlyr;
+	if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK || adminPlyr.iShip == 0)
 	{
-		if (cmds->rights != RIGHT_SUPERADMIN)
-		{
-			cmds->Print(L"ERR No permission\n");
-			return true;
-		}
+		cmds->Print(L"ERR Not in space\n");
+		return true;
+	}
 
-		HKPLAYERINFO adminPlyr;
-		if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK || adminPlyr.iShip == 0)
-		{
-			cmds->Print(L"ERR Not in space\n");
-			return true;
-		}
+	string fuse = wstos(cmds->ArgStrToEnd(1));
 
-		string fuse = wstos(cmds->ArgStrToEnd(1));
+	pub::SpaceObj::LightFuse(adminPlyr.iShip, fuse.c_str(), 0);
+	return true;
+}
 
-		pub::SpaceObj::LightFuse(adminPlyr.iShip, fuse.c_str(), 0);
+bool AdminCmd_TestSelfUnfuseObj(CCmds* cmds, const wstring &wscCmd)
+{
+	if (cmds->rights != RIGHT_SUPERADMIN)
+	{
+		cmds->Print(L"ERR No permission\n");
 		return true;
 	}
-	else if (IS_CMD("testselfunfuseobj"))
+
+	HKPLAYERINFO adminPlyr;
+	if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK || adminPlyr.iShip == 0)
 	{
-		if (cmds->rights != RIGHT_SUPERADMIN)
-		{
-			cmds->Print(L"ERR No permission\n");
-			return true;
-		}
+		cmds->Print(L"ERR Not in space\n");
+		return true;
+	}
 
-		HKPLAYERINFO adminPlyr;
-		if (HkGetPlayerInfo(cmds->GetAdminName(), adminPlyr, false) != HKE_OK || adminPlyr.iShip == 0)
-		{
-			cmds->Print(L"ERR Not in space\n");
-			return true;
-		}
 
+	uint fuse = CreateID(wstos(cmds->ArgStrToEnd(1)).c_str());
+	uint dunno;
+	IObjInspectImpl *inspect;
 
-		uint fuse = CreateID(wstos(cmds->ArgStrToEnd(1)).c_str());
-		uint dunno;
-		IObjInspectImpl *inspect;
+	if (GetShipInspect(adminPlyr.iShip, inspect, dunno))
+	{
+		HkUnLightFuse((IObjRW*)inspect, fuse, 0);
+		cmds->Print(L"OK unlighted fuse");
+	}
 
-		if (GetShipInspect(adminPlyr.iShip, inspect, dunno))
-		{
-			HkUnLightFuse((IObjRW*)inspect, fuse, 0);
-			cmds->Print(L"OK unlighted fuse");
-		}
+	return true;
+}
 
-		return true;
-	}
-	return false;
+struct ADMINCMD
+{
+	wchar_t *wszCmd;
+	ADMIN_CMD_CALLBACK proc;
+};
+
+ADMINCMD AdminCmds[] =
+{
+	{ L"generateid", AdminCmd_GenerateID },
+	{ L"shiptest", AdminCmd_ShipTest },
+	{ L"healthtest1", AdminCmd_HealthTest1 },
+	{ L"healthtest2", AdminCmd_HealthTest2 },
+	{ L"missiontest1", AdminCmd_missiontest1 },
+	{ L"missiontest2", AdminCmd_missiontest2 },
+	{ L"missiontest2b", AdminCmd_missiontest2b },
+	{ L"nodock", AdminCmd_NoDock },
+	{ L"testfuseobj", AdminCmd_TestFuseObj },
+	{ L"testunfuseobj", AdminCmd_TestUnfuseObj },
+	{ L"testselffuseobj", AdminCmd_TestSelfFuseObj },
+	{ L"testselfunfuseobj", AdminCmd_TestSelfUnfuseObj },
+};
+
+/*
+The commands are registered with FLHook, which calls the command's function
+directly instead of offering every admin command to this plugin. They are
+superadmin only and check that themselves.
+*/
+void RegisterAdminCommands()
+{
+	for (uint i = 0; (i < sizeof(AdminCmds) / sizeof(ADMINCMD)); i++)
+		HkRegisterAdminCommand(AdminCmds[i].wszCmd, 0, AdminCmds[i].proc);
 }
 
 void __stdcall HkCb_AddDmgEntry_AFTER(DamageList *dmg, unsigned short p1, float& damage, enum DamageEntry::SubObjFate fate)
@@ -1286,8 +1247,6 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&LoadSettings, PLUGIN_LoadSettings, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkTimerCheckKick, PLUGIN_HkTimerCheckKick, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ExecuteCommandString_Callback, PLUGIN_ExecuteCommandString_Callback, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkCb_AddDmgEntry_AFTER, PLUGIN_HkCb_AddDmgEntry_AFTER, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&JettisonCargo, PLUGIN_HkIServerImpl_JettisonCargo, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&AddTradeEquip, PLUGIN_HkIServerImpl_AddTradeEquip, 0));
@@ -1306,5 +1265,8 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&CharacterSelect_AFTER, PLUGIN_HkIServerImpl_CharacterSelect_AFTER, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&SetVisitedState, PLUGIN_HkIServerImpl_SetVisitedState, 0));
 
+	RegisterAdminCommands();
+	RegisterUserCommands();
+
 	return p_PI;
 }
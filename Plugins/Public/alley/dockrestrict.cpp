@@ -43,8 +43,6 @@ static list<uint> baseblacklist;
 
 static list<wstring> superNoDockedShips;
 
-FILE *Logfile = fopen("./flhook_logs/nodockcommand.log", "at");
-
 void Logging(const char *szString, ...)
 {
 	char szBufString[1024];
@@ -52,19 +50,14 @@ void Logging(const char *szString, ...)
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
 
-	if (Logfile) {
-		char szBuf[64];
-		time_t tNow = time(0);
-		struct tm *t = localtime(&tNow);
-		strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-		fprintf(Logfile, "%s %s\n", szBuf, szBufString);
-		fflush(Logfile);
-		fclose(Logfile);
-	}
-	else {
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = HkLogOpen("./flhook_logs/nodockcommand.log", 0, LOG_STAMP_PLUGIN)))
+	{
 		ConPrint(L"Failed to write nodockcommand log! This might be due to inability to create the directory - are you running as an administrator?\n");
+		return;
 	}
-	Logfile = fopen("./flhook_logs/nodockcommand.log", "at");
+
+	HkLogWrite(iLogID, "%s", szBufString);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,128 @@
+// Index of the player bases by system and position.
+//
+// Every system with bases has the list of its bases and a uniform grid
+// of BASE_GRID_CELL_SIZE cubes keyed on the cell coordinates, so system
+// and distance queries don't have to walk all the bases in the universe.
+// Bases add themselves when they are constructed and remove themselves
+// when they are deleted, they never change their system or position in
+// between.
+
+#include "Main.h"
+
+#define BASE_GRID_CELL_SIZE 10000.0f
+
+namespace BaseIndex
+{
+	typedef unsigned long long GRID_KEY;
+
+	struct SYSTEM_BASES
+	{
+		vector<PlayerBase*> bases;
+		map<GRID_KEY, vector<PlayerBase*> > grid;
+	};
+
+	static map<uint, SYSTEM_BASES> system_bases;
+	static const vector<PlayerBase*> no_bases;
+
+	static int GetCell(float coord)
+	{
+		return (int)floor(coord / BASE_GRID_CELL_SIZE);
+	}
+
+	// 21 bits per axis, which covers +-10 million km at the cell size above
+	static GRID_KEY GetKey(int x, int y, int z)
+	{
+		return ((GRID_KEY)(x & 0x1FFFFF) << 42) | ((GRID_KEY)(y & 0x1FFFFF) << 21) | (GRID_KEY)(z & 0x1FFFFF);
+	}
+
+	static GRID_KEY GetKey(const Vector &pos)
+	{
+		return GetKey(GetCell(pos.x), GetCell(pos.y), GetCell(pos.z));
+	}
+
+	static void EraseBase(vector<PlayerBase*> &bases, PlayerBase *base)
+	{
+		vector<PlayerBase*>::iterator i = find(bases.begin(), bases.end(), base);
+		if (i != bases.end())
+			bases.erase(i);
+	}
+
+	void Add(PlayerBase *base)
+	{
+		SYSTEM_BASES &sys = system_bases[base->system];
+		sys.bases.push_back(base);
+		sys.grid[GetKey(base->position)].push_back(base);
+	}
+
+	void Remove(PlayerBase *base)
+	{
+		map<uint, SYSTEM_BASES>::iterator sys = system_bases.find(base->system);
+		if (sys == system_bases.end())
+			return;
+
+		EraseBase(sys->second.bases, base);
+
+		map<GRID_KEY, vector<PlayerBase*> >::iterator cell = sys->second.grid.find(GetKey(base->position));
+		if (cell != sys->second.grid.end())
+		{
+			EraseBase(cell->second, base);
+			if (cell->second.empty())
+				sys->second.grid.erase(cell);
+		}
+
+		if (sys->second.bases.empty())
+			system_bases.erase(sys);
+	}
+
+	const vector<PlayerBase*>& GetSystemBases(uint system)
+	{
+		map<uint, SYSTEM_BASES>::iterator sys = system_bases.find(system);
+		if (sys == system_bases.end())
+			return no_bases;
+		return sys->second.bases;
+	}
+
+	// Append all bases in the system that are closer than range to pos.
+	void FindInRange(uint system, const Vector &pos, float range, vector<PlayerBase*> &bases)
+	{
+		map<uint, SYSTEM_BASES>::iterator sys = system_bases.find(system);
+		if (sys == system_bases.end())
+			return;
+
+		int x1 = GetCell(pos.x - range), x2 = GetCell(pos.x + range);
+		int y1 = GetCell(pos.y - range), y2 = GetCell(pos.y + range);
+		int z1 = GetCell(pos.z - range), z2 = GetCell(pos.z + range);
+
+		// For a range that covers more cells than there are bases it is
+		// quicker to check the bases directly.
+		float cells = (float)(x2 - x1 + 1) * (float)(y2 - y1 + 1) * (float)(z2 - z1 + 1);
+		if (cells > (float)sys->second.bases.size())
+		{
+			for (vector<PlayerBase*>::iterator i = sys->second.bases.begin(); i != sys->second.bases.end(); ++i)
+			{
+				if (HkDistance3D((*i)->position, pos) < range)
+					bases.push_back(*i);
+			}
+			return;
+		}
+
+		for (int x = x1; x <= x2; x++)
+		{
+			for (int y = y1; y <= y2; y++)
+			{
+				for (int z = z1; z <= z2; z++)
+				{
+					map<GRID_KEY, vector<PlayerBase*> >::iterator cell = sys->second.grid.find(GetKey(x, y, z));
+					if (cell == sys->second.grid.end())
+						continue;
+
+					for (vector<PlayerBase*>::iterator i = cell->second.begin(); i != cell->second.end(); ++i)
+					{
+						if (HkDistance3D((*i)->position, pos) < range)
+							bases.push_back(*i);
+					}
+				}
+			}
+		}
+	}
+}
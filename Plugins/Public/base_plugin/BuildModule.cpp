@@ -202,17 +202,17 @@ void BuildModule::LoadState(INI_Reader &ini)
 	}
 }
 
-void BuildModule::SaveState(FILE *file)
+void BuildModule::SaveState(string &buffer)
 {
-	fprintf(file, "[BuildModule]\n");
-	fprintf(file, "build_type = %u\n", build_type);
-	fprintf(file, "paused = %d\n", Paused);
-	fprintf(file, "produced_item = %u\n", active_recipe.produced_item);
-	fprintf(file, "cooking_rate = %u\n", active_recipe.cooking_rate);
-	fprintf(file, "infotext = %s\n", wstos(active_recipe.infotext).c_str());
+	buf_printf(buffer, "[BuildModule]\n");
+	buf_printf(buffer, "build_type = %u\n", build_type);
+	buf_printf(buffer, "paused = %d\n", Paused);
+	buf_printf(buffer, "produced_item = %u\n", active_recipe.produced_item);
+	buf_printf(buffer, "cooking_rate = %u\n", active_recipe.cooking_rate);
+	buf_printf(buffer, "infotext = %s\n", wstos(active_recipe.infotext).c_str());
 	for (map<uint, uint>::iterator i = active_recipe.consumed_items.begin();
 		i != active_recipe.consumed_items.end(); ++i)
 	{
-		fprintf(file, "consumed = %u, %u\n", i->first, i->second);
+		buf_printf(buffer, "consumed = %u, %u\n", i->first, i->second);
 	}
 }
\ No newline at end of file
@@ -401,11 +401,11 @@ void CoreModule::LoadState(INI_Reader &ini)
 	}
 }
 
-void CoreModule::SaveState(FILE *file)
+void CoreModule::SaveState(string &buffer)
 {
-	fprintf(file, "[CoreModule]\n");
-	fprintf(file, "dont_eat = %d\n", dont_eat);
-	fprintf(file, "dont_rust = %d\n", dont_rust);
+	buf_printf(buffer, "[CoreModule]\n");
+	buf_printf(buffer, "dont_eat = %d\n", dont_eat);
+	buf_printf(buffer, "dont_rust = %d\n", dont_rust);
 }
 
 void CoreModule::RepairDamage(float max_base_health)
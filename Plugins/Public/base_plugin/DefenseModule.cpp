@@ -444,12 +444,12 @@ void DefenseModule::LoadState(INI_Reader &ini)
 }
 
 // Append module state to the ini file.
-void DefenseModule::SaveState(FILE *file)
+void DefenseModule::SaveState(string &buffer)
 {
-	fprintf(file, "[DefenseModule]\n");
-	fprintf(file, "type = %u\n", type);
-	fprintf(file, "pos = %0.0f, %0.0f, %0.0f\n", pos.x, pos.y, pos.z);
-	fprintf(file, "rot = %0.0f, %0.0f, %0.0f\n", rot.x, rot.y, rot.z);
+	buf_printf(buffer, "[DefenseModule]\n");
+	buf_printf(buffer, "type = %u\n", type);
+	buf_printf(buffer, "pos = %0.0f, %0.0f, %0.0f\n", pos.x, pos.y, pos.z);
+	buf_printf(buffer, "rot = %0.0f, %0.0f, %0.0f\n", rot.x, rot.y, rot.z);
 }
 
 bool DefenseModule::Timer(uint time)
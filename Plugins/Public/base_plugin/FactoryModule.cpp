@@ -102,6 +102,7 @@ bool FactoryModule::Timer(uint time)
 			active_recipe = i->second;
 		}
 		build_queue.pop_front();
+		base->save_dirty = true;
 	}
 
 	// Nothing to do.
@@ -189,24 +190,24 @@ void FactoryModule::LoadState(INI_Reader &ini)
 	}
 }
 
-void FactoryModule::SaveState(FILE *file)
+void FactoryModule::SaveState(string &buffer)
 {
-	fprintf(file, "[FactoryModule]\n");
-	fprintf(file, "type = %u\n", type);
-	fprintf(file, "nickname = %u\n", active_recipe.nickname);
-	fprintf(file, "paused = %d\n", Paused);
-	fprintf(file, "produced_item = %u\n", active_recipe.produced_item);
-	fprintf(file, "cooking_rate = %u\n", active_recipe.cooking_rate);
-	fprintf(file, "infotext = %s\n", wstos(active_recipe.infotext).c_str());
+	buf_printf(buffer, "[FactoryModule]\n");
+	buf_printf(buffer, "type = %u\n", type);
+	buf_printf(buffer, "nickname = %u\n", active_recipe.nickname);
+	buf_printf(buffer, "paused = %d\n", Paused);
+	buf_printf(buffer, "produced_item = %u\n", active_recipe.produced_item);
+	buf_printf(buffer, "cooking_rate = %u\n", active_recipe.cooking_rate);
+	buf_printf(buffer, "infotext = %s\n", wstos(active_recipe.infotext).c_str());
 	for (map<uint, uint>::iterator i = active_recipe.consumed_items.begin();
 		i != active_recipe.consumed_items.end(); ++i)
 	{
-		fprintf(file, "consumed = %u, %u\n", i->first, i->second);
+		buf_printf(buffer, "consumed = %u, %u\n", i->first, i->second);
 	}
 	for (list<uint>::iterator i = build_queue.begin();
 		i != build_queue.end(); ++i)
 	{
-		fprintf(file, "build_queue = %u\n", *i);
+		buf_printf(buffer, "build_queue = %u\n", *i);
 	}
 }
 
@@ -34,25 +34,9 @@ namespace Log
 
 	void LogBaseAction(string basename, const char *message)
 	{
-		char szBufString[1024];
-		va_list marker;
-		va_start(marker, message);
-		_vsnprintf(szBufString, sizeof(szBufString) - 1, message, marker);
-
-		char szBuf[64];
-		time_t tNow = time(0);
-		struct tm *t = localtime(&tNow);
-		strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-
+		// one file per base, FLHook's log writer opens and closes it off the game thread
 		string BuildFilePath = "./flhook_logs/pob/" + basename + ".log";
-		FILE *Logfile = fopen((BuildFilePath.c_str()), "at");
-
-		if (Logfile)
-		{
-			fprintf(Logfile, "%s %s\n", szBuf, szBufString);
-			fflush(Logfile);
-			fclose(Logfile);
-		}
+		HkLogAppend(BuildFilePath, LOG_STAMP_PLUGIN, "%s", message);
 	}
 
 	void LogGenericAction(string message)
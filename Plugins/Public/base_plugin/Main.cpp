@@ -196,18 +196,10 @@ void Logging(const char *szString, ...)
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
 
-	char szBuf[64];
-	time_t tNow = time(0);
-	struct tm *t = localtime(&tNow);
-	strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-
-	FILE *Logfile = fopen(("./flhook_logs/flhook_cheaters.log"), "at");
-	if (Logfile)
-	{
-		fprintf(Logfile, "%s %s\n", szBuf, szBufString);
-		fflush(Logfile);
-		fclose(Logfile);
-	}
+	static uint iLogID = 0;
+	if (!iLogID)
+		iLogID = HkLogOpen("./flhook_logs/flhook_cheaters.log", 0, LOG_STAMP_EVENT);
+	HkLogWrite(iLogID, "%s", szBufString);
 }
 
 // These logging functions need consolidating.
@@ -218,22 +210,12 @@ void BaseLogging(const char *szString, ...)
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
 
-	char szBuf[64];
-	time_t tNow = time(0);
-	struct tm *t = localtime(&tNow);
-	strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-
-	FILE *BaseLogfile = fopen("./flhook_logs/playerbase_events.log", "at");
-	if (BaseLogfile)
-	{
-		fprintf(BaseLogfile, "%s %s\n", szBuf, szBufString);
-		fflush(BaseLogfile);
-		fclose(BaseLogfile);
-	}
+	static uint iLogID = 0;
+	if (!iLogID)
+		iLogID = HkLogOpen("./flhook_logs/playerbase_events.log", 0, LOG_STAMP_PLUGIN);
+	HkLogWrite(iLogID, "%s", szBufString);
 }
 
-FILE *LogfileEventCommodities = fopen("./flhook_logs/event_pobsales.log", "at");
-
 void LoggingEventCommodity(const char *szString, ...)
 {
 	char szBufString[1024];
@@ -241,14 +223,10 @@ void LoggingEventCommodity(const char *szString, ...)
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
 
-	char szBuf[64];
-	time_t tNow = time(0);
-	struct tm *t = localtime(&tNow);
-	strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-	fprintf(LogfileEventCommodities, "%s %s\n", szBuf, szBufString);
-	fflush(LogfileEventCommodities);
-	fclose(LogfileEventCommodities);
-	LogfileEventCommodities = fopen("./flhook_logs/event_pobsales.log", "at");
+	static uint iLogID = 0;
+	if (!iLogID)
+		iLogID = HkLogOpen("./flhook_logs/event_pobsales.log", 0, LOG_STAMP_PLUGIN);
+	HkLogWrite(iLogID, "%s", szBufString);
 }
 
 void Notify_Event_Commodity_Sold(uint iClientID, string commodity, int count, string basename)
@@ -313,21 +291,18 @@ void SyncReputationForClientShip(uint ship, uint client)
 	uint system;
 	pub::SpaceObj::GetSystem(ship, system);
 
-	map<uint, PlayerBase*>::iterator base = player_bases.begin();
-	for (; base != player_bases.end(); base++)
+	const vector<PlayerBase*> &bases = BaseIndex::GetSystemBases(system);
+	for (vector<PlayerBase*>::const_iterator base = bases.begin(); base != bases.end(); ++base)
 	{
-		if (base->second->system == system)
+		float attitude = (*base)->GetAttitudeTowardsClient(client);
+		if (set_plugin_debug > 1)
+			ConPrint(L"SyncReputationForClientShip:: ship=%u attitude=%f base=%08x\n", ship, attitude, (*base)->base);
+		for (vector<Module*>::iterator module = (*base)->modules.begin();
+			module != (*base)->modules.end(); ++module)
 		{
-			float attitude = base->second->GetAttitudeTowardsClient(client);
-			if (set_plugin_debug > 1)
-				ConPrint(L"SyncReputationForClientShip:: ship=%u attitude=%f base=%08x\n", ship, attitude, base->first);
-			for (vector<Module*>::iterator module = base->second->modules.begin();
-				module != base->second->modules.end(); ++module)
+			if (*module)
 			{
-				if (*module)
-				{
-					(*module)->SetReputation(player_rep, attitude);
-				}
+				(*module)->SetReputation(player_rep, attitude);
 			}
 		}
 	}
@@ -759,7 +734,8 @@ void LoadSettingsActual()
 	string basedir = string(datapath) + "\\Accts\\MultiPlayer\\player_bases\\";
 	CreateDirectoryA(basedir.c_str(), 0);
 
-	// Load and spawn all bases
+	// Load and spawn all bases, saves still waiting to be written go first
+	SaveWriter::Flush();
 	string path = string(datapath) + "\\Accts\\MultiPlayer\\player_bases\\base_*.ini";
 
 	WIN32_FIND_DATA findfile;
@@ -817,10 +793,22 @@ void LoadSettingsActual()
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void HkTimerCheckKick()
+void __stdcall Shutdown()
+{
+	returncode = DEFAULT_RETURNCODE;
+	SaveWriter::Shutdown();
+}
+
+// Called by FLHook before the plugin dll is freed.
+void Plugin_Unload()
 {
 	returncode = DEFAULT_RETURNCODE;
+	SaveWriter::Shutdown();
+}
 
+// Runs every second from the timer scheduled in Get_PluginInfo.
+void BaseTimer(uint timer_id, void *data)
+{
 	if (load_settings_required)
 	{
 		load_settings_required = false;
@@ -1032,294 +1020,341 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 	return true;
 }
 
-bool UserCmd_Process(uint client, const wstring &args)
+bool UserCmd_BaseLogin(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
 {
-	returncode = DEFAULT_RETURNCODE;
-	if (args.find(L"/base login") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseLogin(client, args);
-		return true;
-	}
-	else if (args.find(L"/base addpwd") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseAddPwd(client, args);
-		return true;
-	}
-	else if (args.find(L"/base rmpwd") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseRmPwd(client, args);
-		return true;
-	}
-	else if (args.find(L"/base lstpwd") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseLstPwd(client, args);
-		return true;
-	}
-	else if (args.find(L"/base setmasterpwd") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseSetMasterPwd(client, args);
-		return true;
-	}
-	else if (args.find(L"/base addtag") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PrintUserCmdText(client, L"Checking if ship/tag exist in blacklist...");
-		PlayerCommands::BaseRmHostileTag(client, args);
-		PrintUserCmdText(client, L"Proceeding...");
-		PlayerCommands::BaseAddAllyTag(client, args);
-		return true;
-	}
-	else if (args.find(L"/base rmtag") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseRmAllyTag(client, args);
-		return true;
-	}
-	else if (args.find(L"/base lsttag") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseLstAllyTag(client, args);
-		return true;
-	}
-	else if (args.find(L"/base addfac") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseAddAllyFac(client, args);
-		return true;
-	}
-	else if (args.find(L"/base rmfac") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseRmAllyFac(client, args);
-		return true;
-	}
-	else if (args.find(L"/base clearfac") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseClearAllyFac(client, args);
-		return true;
-	}
-	else if (args.find(L"/base lstfac") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseLstAllyFac(client, args);
-		return true;
-	}
-	else if (args.find(L"/base addhfac") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseAddAllyFac(client, args, true);
-		return true;
-	}
-	else if (args.find(L"/base rmhfac") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseRmAllyFac(client, args, true);
-		return true;
-	}
-	else if (args.find(L"/base clearhfac") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseClearAllyFac(client, args, true);
-		return true;
-	}
-	else if (args.find(L"/base lsthfac") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseLstAllyFac(client, args, true);
-		return true;
-	}
-	else if (args.find(L"/base myfac") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseViewMyFac(client, args);
-		return true;
-	}
-	else if (args.find(L"/base addhostile") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PrintUserCmdText(client, L"Checking if ship/tag exist in whitelist...");
-		PlayerCommands::BaseRmAllyTag(client, args);
-		PrintUserCmdText(client, L"Proceeding...");
-		PlayerCommands::BaseAddHostileTag(client, args);
-		return true;
-	}
-	else if (args.find(L"/base rmhostile") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseRmHostileTag(client, args);
-		return true;
-	}
-	else if (args.find(L"/base lsthostile") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseLstHostileTag(client, args);
-		return true;
-	}
-	else if (args.find(L"/base rep") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseRep(client, args);
-		return true;
-	}
-	else if (args.find(L"/base defensemode") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseDefenseMode(client, args);
-		return true;
-	}
-	else if (args.find(L"/base deploy") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseDeploy(client, args);
-		return true;
-	}
-	else if (args.find(L"/shop") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::Shop(client, args);
-		return true;
-	}
-	else if (args.find(L"/bank") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::Bank(client, args);
-		return true;
-	}
-	else if (args.find(L"/base info") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseInfo(client, args);
-		return true;
-	}
-	else if (args.find(L"/base supplies") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::GetNecessitiesStatus(client, args);
-		return true;
-	}
-	else if (args.find(L"/base facmod") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseFacMod(client, args);
-		return true;
-	}
-	else if (args.find(L"/base defmod") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseDefMod(client, args);
-		return true;
-	}
-	else if (args.find(L"/base shieldmod") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseShieldMod(client, args);
-		return true;
-	}
-	else if (args.find(L"/base buildmod") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseBuildMod(client, args);
-		return true;
-	}
-	else if (args.find(L"/base") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		PlayerCommands::BaseHelp(client, args);
-		return true;
-	}
-	return false;
+	PlayerCommands::BaseLogin(client, args);
+	return true;
 }
 
+bool UserCmd_BaseAddPwd(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseAddPwd(client, args);
+	return true;
+}
 
+bool UserCmd_BaseRmPwd(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseRmPwd(client, args);
+	return true;
+}
 
-static bool IsDockingAllowed(PlayerBase *base, uint client)
+bool UserCmd_BaseLstPwd(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
 {
-	// Allies can always dock.
-	wstring charname = (const wchar_t*)Players.GetActiveCharacterName(client);
-	for (list<wstring>::iterator i = base->ally_tags.begin(); i != base->ally_tags.end(); ++i)
-	{
-		if (charname.find(*i) == 0)
-		{
-			return true;
-		}
-	}
+	PlayerCommands::BaseLstPwd(client, args);
+	return true;
+}
 
-	//Hostile listed can't dock even if they are friendly faction listed
-	for (list<wstring>::iterator i = base->perma_hostile_tags.begin(); i != base->perma_hostile_tags.end(); ++i)
-	{
-		if (charname.find(*i) == 0)
-		{
-			return false;
-		}
-	}
+bool UserCmd_BaseSetMasterPwd(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseSetMasterPwd(client, args);
+	return true;
+}
 
-	uint playeraff = GetAffliationFromClient(client);
-	//Do not allow dock if player is on the hostile faction list.
-	if (base->hostile_factions.find(playeraff) != base->hostile_factions.end())
-	{
-		return false;
-	}
+bool UserCmd_BaseAddTag(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PrintUserCmdText(client, L"Checking if ship/tag exist in blacklist...");
+	PlayerCommands::BaseRmHostileTag(client, args);
+	PrintUserCmdText(client, L"Proceeding...");
+	PlayerCommands::BaseAddAllyTag(client, args);
+	return true;
+}
 
-	//Allow dock if player is on the friendly faction list.
-	if (base->ally_factions.find(playeraff) != base->ally_factions.end())
-	{
-		return true;
-	}
+bool UserCmd_BaseRmTag(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseRmAllyTag(client, args);
+	return true;
+}
 
-	// Base allows neutral ships to dock
-	if (base->defense_mode == 2)
-	{
-		return true;
-	}
+bool UserCmd_BaseLstTag(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseLstAllyTag(client, args);
+	return true;
+}
 
-	// Base allows neutral ships to dock
-	if (base->defense_mode == 4)
-	{
-		return true;
-	}
+bool UserCmd_BaseAddFac(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseAddAllyFac(client, args);
+	return true;
+}
 
-	return false;
+bool UserCmd_BaseRmFac(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseRmAllyFac(client, args);
+	return true;
 }
 
-// If this is a docking request at a player controlled based then send
-// an update to set the base arrival text, base economy and change the
-// infocards.
+bool UserCmd_BaseClearFac(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseClearAllyFac(client, args);
+	return true;
+}
 
-void __stdcall SystemSwitchOutComplete(unsigned int iShip, unsigned int iClientID)
+bool UserCmd_BaseLstFac(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
 {
-	returncode = DEFAULT_RETURNCODE;
-	// Make player invincible to fix JHs/JGs near mine fields sometimes
-	// exploding player while jumping (in jump tunnel)
-	pub::SpaceObj::SetInvincible(iShip, true, true, 0);
-	if (AP::SystemSwitchOutComplete(iShip, iClientID))
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+	PlayerCommands::BaseLstAllyFac(client, args);
+	return true;
 }
 
-int __cdecl Dock_Call(unsigned int const &iShip, unsigned int const &base, int iCancel, enum DOCK_HOST_RESPONSE response)
+bool UserCmd_BaseAddHFac(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
 {
-	returncode = DEFAULT_RETURNCODE;
+	PlayerCommands::BaseAddAllyFac(client, args, true);
+	return true;
+}
 
-	uint client = HkGetClientIDByShip(iShip);
-	//AP::ClearClientInfo(client);
+bool UserCmd_BaseRmHFac(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseRmAllyFac(client, args, true);
+	return true;
+}
 
-	if (client && (response == PROCEED_DOCK || response == DOCK) && iCancel != -1)
-	{
-		PlayerBase* pbase = GetPlayerBase(base);
-		if (pbase)
-		{
-			if (mapArchs[pbase->basetype].isjump == 1)
-			{
-				//check if we have an ID restriction
-				if (mapArchs[pbase->basetype].idrestriction == 1)
-				{
-					bool foundid = false;
-					for (list<EquipDesc>::iterator item = Players[client].equipDescList.equip.begin(); item != Players[client].equipDescList.equip.end(); item++)
+bool UserCmd_BaseClearHFac(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseClearAllyFac(client, args, true);
+	return true;
+}
+
+bool UserCmd_BaseLstHFac(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseLstAllyFac(client, args, true);
+	return true;
+}
+
+bool UserCmd_BaseMyFac(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseViewMyFac(client, args);
+	return true;
+}
+
+bool UserCmd_BaseAddHostile(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PrintUserCmdText(client, L"Checking if ship/tag exist in whitelist...");
+	PlayerCommands::BaseRmAllyTag(client, args);
+	PrintUserCmdText(client, L"Proceeding...");
+	PlayerCommands::BaseAddHostileTag(client, args);
+	return true;
+}
+
+bool UserCmd_BaseRmHostile(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseRmHostileTag(client, args);
+	return true;
+}
+
+bool UserCmd_BaseLstHostile(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseLstHostileTag(client, args);
+	return true;
+}
+
+bool UserCmd_BaseRep(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseRep(client, args);
+	return true;
+}
+
+bool UserCmd_BaseDefenseMode(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseDefenseMode(client, args);
+	return true;
+}
+
+bool UserCmd_BaseDeploy(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseDeploy(client, args);
+	return true;
+}
+
+bool UserCmd_Shop(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::Shop(client, args);
+	return true;
+}
+
+bool UserCmd_Bank(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::Bank(client, args);
+	return true;
+}
+
+bool UserCmd_BaseInfo(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseInfo(client, args);
+	return true;
+}
+
+bool UserCmd_BaseSupplies(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::GetNecessitiesStatus(client, args);
+	return true;
+}
+
+bool UserCmd_BaseFacMod(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseFacMod(client, args);
+	return true;
+}
+
+bool UserCmd_BaseDefMod(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseDefMod(client, args);
+	return true;
+}
+
+bool UserCmd_BaseShieldMod(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseShieldMod(client, args);
+	return true;
+}
+
+bool UserCmd_BaseBuildMod(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseBuildMod(client, args);
+	return true;
+}
+
+bool UserCmd_BaseHelp(uint client, const wstring &args, const wstring &param, const wchar_t *usage)
+{
+	PlayerCommands::BaseHelp(client, args);
+	return true;
+}
+
+struct USERCMD
+{
+	wchar_t *wszCmd;
+	USERCMD_CALLBACK proc;
+};
+
+USERCMD UserCmds[] =
+{
+	{ L"/base login", UserCmd_BaseLogin },
+	{ L"/base addpwd", UserCmd_BaseAddPwd },
+	{ L"/base rmpwd", UserCmd_BaseRmPwd },
+	{ L"/base lstpwd", UserCmd_BaseLstPwd },
+	{ L"/base setmasterpwd", UserCmd_BaseSetMasterPwd },
+	{ L"/base addtag", UserCmd_BaseAddTag },
+	{ L"/base rmtag", UserCmd_BaseRmTag },
+	{ L"/base lsttag", UserCmd_BaseLstTag },
+	{ L"/base addfac", UserCmd_BaseAddFac },
+	{ L"/base rmfac", UserCmd_BaseRmFac },
+	{ L"/base clearfac", UserCmd_BaseClearFac },
+	{ L"/base lstfac", UserCmd_BaseLstFac },
+	{ L"/base addhfac", UserCmd_BaseAddHFac },
+	{ L"/base rmhfac", UserCmd_BaseRmHFac },
+	{ L"/base clearhfac", UserCmd_BaseClearHFac },
+	{ L"/base lsthfac", UserCmd_BaseLstHFac },
+	{ L"/base myfac", UserCmd_BaseMyFac },
+	{ L"/base addhostile", UserCmd_BaseAddHostile },
+	{ L"/base rmhostile", UserCmd_BaseRmHostile },
+	{ L"/base lsthostile", UserCmd_BaseLstHostile },
+	{ L"/base rep", UserCmd_BaseRep },
+	{ L"/base defensemode", UserCmd_BaseDefenseMode },
+	{ L"/base deploy", UserCmd_BaseDeploy },
+	{ L"/shop", UserCmd_Shop },
+	{ L"/bank", UserCmd_Bank },
+	{ L"/base info", UserCmd_BaseInfo },
+	{ L"/base supplies", UserCmd_BaseSupplies },
+	{ L"/base facmod", UserCmd_BaseFacMod },
+	{ L"/base defmod", UserCmd_BaseDefMod },
+	{ L"/base shieldmod", UserCmd_BaseShieldMod },
+	{ L"/base buildmod", UserCmd_BaseBuildMod },
+	{ L"/base", UserCmd_BaseHelp },
+};
+
+/*
+The commands are registered with FLHook's command router, which calls the command's
+function directly instead of offering every chat string to this plugin. "/base" on its
+own catches the base commands that don't exist and shows the help.
+*/
+void RegisterUserCommands()
+{
+	for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
+		HkRegisterUserCommand(UserCmds[i].wszCmd, UserCmds[i].proc);
+}
+
+
+
+static bool IsDockingAllowed(PlayerBase *base, uint client)
+{
+	// Allies can always dock.
+	wstring charname = (const wchar_t*)Players.GetActiveCharacterName(client);
+	for (list<wstring>::iterator i = base->ally_tags.begin(); i != base->ally_tags.end(); ++i)
+	{
+		if (charname.find(*i) == 0)
+		{
+			return true;
+		}
+	}
+
+	//Hostile listed can't dock even if they are friendly faction listed
+	for (list<wstring>::iterator i = base->perma_hostile_tags.begin(); i != base->perma_hostile_tags.end(); ++i)
+	{
+		if (charname.find(*i) == 0)
+		{
+			return false;
+		}
+	}
+
+	uint playeraff = GetAffliationFromClient(client);
+	//Do not allow dock if player is on the hostile faction list.
+	if (base->hostile_factions.find(playeraff) != base->hostile_factions.end())
+	{
+		return false;
+	}
+
+	//Allow dock if player is on the friendly faction list.
+	if (base->ally_factions.find(playeraff) != base->ally_factions.end())
+	{
+		return true;
+	}
+
+	// Base allows neutral ships to dock
+	if (base->defense_mode == 2)
+	{
+		return true;
+	}
+
+	// Base allows neutral ships to dock
+	if (base->defense_mode == 4)
+	{
+		return true;
+	}
+
+	return false;
+}
+
+// If this is a docking request at a player controlled based then send
+// an update to set the base arrival text, base economy and change the
+// infocards.
+
+void __stdcall SystemSwitchOutComplete(unsigned int iShip, unsigned int iClientID)
+{
+	returncode = DEFAULT_RETURNCODE;
+	// Make player invincible to fix JHs/JGs near mine fields sometimes
+	// exploding player while jumping (in jump tunnel)
+	pub::SpaceObj::SetInvincible(iShip, true, true, 0);
+	if (AP::SystemSwitchOutComplete(iShip, iClientID))
+		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+}
+
+int __cdecl Dock_Call(unsigned int const &iShip, unsigned int const &base, int iCancel, enum DOCK_HOST_RESPONSE response)
+{
+	returncode = DEFAULT_RETURNCODE;
+
+	uint client = HkGetClientIDByShip(iShip);
+	//AP::ClearClientInfo(client);
+
+	if (client && (response == PROCEED_DOCK || response == DOCK) && iCancel != -1)
+	{
+		PlayerBase* pbase = GetPlayerBase(base);
+		if (pbase)
+		{
+			if (mapArchs[pbase->basetype].isjump == 1)
+			{
+				//check if we have an ID restriction
+				if (mapArchs[pbase->basetype].idrestriction == 1)
+				{
+					bool foundid = false;
+					for (list<EquipDesc>::iterator item = Players[client].equipDescList.equip.begin(); item != Players[client].equipDescList.equip.end(); item++)
 					{
 						if (item->bMounted)
 						{
@@ -2217,557 +2252,561 @@ static void ForcePlayerBaseDock(uint client, PlayerBase *base)
 	}
 }
 
-#define IS_CMD(a) !args.compare(L##a)
-#define RIGHT_CHECK(a) if(!(cmd->rights & a)) { cmd->Print(L"ERR No permission\n"); return true; }
-bool ExecuteCommandString_Callback(CCmds* cmd, const wstring &args)
+bool AdminCmd_TestRecipe(CCmds* cmd, const wstring &args)
 {
-	returncode = DEFAULT_RETURNCODE;
-	/*if (args.find(L"dumpbases")==0)
+	uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
+	PlayerBase *base = GetPlayerBaseForClient(client);
+	if (!base)
 	{
-		Universe::ISystem *sys = Universe::GetFirstSystem();
-		FILE* f = fopen("bases.txt", "w");
-		while (sys)
-		{
-			fprintf(f, "[Base]\n");
-			fprintf(f, "nickname = %s_proxy_base\n", sys->nickname);
-			fprintf(f, "system = %s\n", sys->nickname);
-			fprintf(f, "strid_name = 0\n");
-			fprintf(f, "file=Universe\\Systems\\proxy_base->ini\n");
-			fprintf(f, "BGCS_base_run_by=W02bF35\n\n");
+		cmd->Print(L"ERR Not in player base");
+		return true;
+	}
 
-			sys = Universe::GetNextSystem();
-		}
-		fclose(f);
+	uint recipe_name = CreateID(wstos(cmd->ArgStr(1)).c_str());
+
+	RECIPE recipe = recipes[recipe_name];
+	for (map<uint, uint>::iterator i = recipe.consumed_items.begin(); i != recipe.consumed_items.end(); ++i)
+	{
+		base->market_items[i->first].quantity += i->second;
+		SendMarketGoodUpdated(base, i->first, base->market_items[i->first]);
+		cmd->Print(L"Added %ux %08x", i->second, i->first);
 	}
-	if (args.find(L"makebases")==0)
+	base->Save();
+	cmd->Print(L"OK");
+	return true;
+}
+
+bool AdminCmd_TestDeploy(CCmds* cmd, const wstring &args)
+{
+	uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
+	if (!client)
 	{
-		struct Universe::ISystem *sys = Universe::GetFirstSystem();
-		while (sys)
-		{
-			string path = string("..\\DATA\\UNIVERSE\\SYSTEMS\\") + string(sys->nickname) + "\\" + string(sys->nickname) + ".ini";
-			FILE *file = fopen(path.c_str(), "a+");
-			if (file)
-			{
-				ConPrint(L"doing path %s\n", stows(path).c_str());
-				fprintf(file, "\n\n[Object]\n");
-				fprintf(file, "nickname = %s_proxy_base\n", sys->nickname);
-				fprintf(file, "dock_with = %s_proxy_base\n", sys->nickname);
-				fprintf(file, "base = %s_proxy_base\n", sys->nickname);
-				fprintf(file, "pos = 0, -100000, 0\n");
-				fprintf(file, "archetype = invisible_base\n");
-				fprintf(file, "behavior = NOTHING\n");
-				fprintf(file, "visit = 128\n");
-				fclose(file);
-			}
-			sys = Universe::GetNextSystem();
-		}
+		cmd->Print(L"ERR Not in game");
 		return true;
-	}*/
+	}
 
-	if (args.find(L"testrecipe") == 0)
+	for (map<uint, uint>::iterator i = construction_items.begin(); i != construction_items.end(); ++i)
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+		uint good = i->first;
+		uint quantity = i->second;
+		pub::Player::AddCargo(client, good, quantity, 1.0, false);
+	}
 
-		RIGHT_CHECK(RIGHT_BASES)
+	cmd->Print(L"OK");
+	return true;
+}
 
-			uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
-		PlayerBase *base = GetPlayerBaseForClient(client);
-		if (!base)
+bool AdminCmd_BaseDestroy(CCmds* cmd, const wstring &args)
+{
+	uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
+
+	//return SpaceObjDestroyed(space_obj);
+	//alleynote1
+	int billythecat = 0;
+	PlayerBase *base;
+	for (map<uint, PlayerBase*>::iterator i = player_bases.begin(); i != player_bases.end(); ++i)
+	{
+		if (i->second->basename == cmd->ArgStrToEnd(1))
 		{
-			cmd->Print(L"ERR Not in player base");
-			return true;
+			base = i->second;
+			billythecat = 1;
 		}
+	}
 
-		uint recipe_name = CreateID(wstos(cmd->ArgStr(1)).c_str());
 
-		RECIPE recipe = recipes[recipe_name];
-		for (map<uint, uint>::iterator i = recipe.consumed_items.begin(); i != recipe.consumed_items.end(); ++i)
-		{
-			base->market_items[i->first].quantity += i->second;
-			SendMarketGoodUpdated(base, i->first, base->market_items[i->first]);
-			cmd->Print(L"Added %ux %08x", i->second, i->first);
-		}
-		base->Save();
-		cmd->Print(L"OK");
+	if (billythecat == 0)
+	{
+		cmd->Print(L"ERR Base doesn't exist lmao");
 		return true;
 	}
-	else if (args.find(L"testdeploy") == 0)
+
+	base->base_health = 0;
+	if (base->base_health < 1)
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+		return CoreModule(base).SpaceObjDestroyed(CoreModule(base).space_obj);
+	}
 
-		RIGHT_CHECK(RIGHT_BASES)
+	//cmd->Print(L"OK Base is gone are you proud of yourself.");
+	return true;
+}
 
-			uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
-		if (!client)
-		{
-			cmd->Print(L"ERR Not in game");
-			return true;
-		}
+bool AdminCmd_BaseToggleGod(CCmds* cmd, const wstring &args)
+{
+	uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
+	bool optype = cmd->ArgInt(1);
 
-		for (map<uint, uint>::iterator i = construction_items.begin(); i != construction_items.end(); ++i)
+	//return SpaceObjDestroyed(space_obj);
+	//alleynote1
+	int billythecat = 0;
+	PlayerBase *base;
+	for (map<uint, PlayerBase*>::iterator i = player_bases.begin(); i != player_bases.end(); ++i)
+	{
+		if (i->second->basename == cmd->ArgStrToEnd(2))
 		{
-			uint good = i->first;
-			uint quantity = i->second;
-			pub::Player::AddCargo(client, good, quantity, 1.0, false);
+			base = i->second;
+			billythecat = 1;
+			break;
 		}
+	}
 
-		cmd->Print(L"OK");
+
+	if (billythecat == 0)
+	{
+		cmd->Print(L"ERR Base doesn't exist lmao");
 		return true;
 	}
-	else if (args.compare(L"beam") == 0)
+
+
+	if (optype == true)
 	{
-		returncode = DEFAULT_RETURNCODE;
-		wstring charname = cmd->ArgCharname(1);
-		wstring basename = cmd->ArgStrToEnd(2);
+		base->invulnerable = true;
+		base->save_dirty = true;
+		cmd->Print(L"OK Base made invulnerable.");
+	}
+	else if (optype == false)
+	{
+		base->invulnerable = false;
+		base->save_dirty = true;
+		cmd->Print(L"OK Base made vulnerable.");
+	}
 
-		// Fall back to default behaviour.
-		if (cmd->rights != RIGHT_SUPERADMIN)
-		{
-			return false;
-		}
+	//cmd->Print(L"OK Base is gone are you proud of yourself.");
+	return true;
+}
 
-		HKPLAYERINFO info;
-		if (HkGetPlayerInfo(charname, info, false) != HKE_OK)
-		{
-			return false;
-		}
+bool AdminCmd_TestBase(CCmds* cmd, const wstring &args)
+{
+	uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
 
-		if (info.iShip == 0)
-		{
-			return false;
-		}
+	uint ship;
+	pub::Player::GetShip(client, ship);
+	if (!ship)
+	{
+		PrintUserCmdText(client, L"ERR Not in space");
+		return true;
+	}
 
-		// Search for an match at the start of the name
-		for (map<uint, PlayerBase*>::iterator i = player_bases.begin(); i != player_bases.end(); ++i)
-		{
-			if (ToLower(i->second->basename).find(ToLower(basename)) == 0)
-			{
-				returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-				ForcePlayerBaseDock(info.iClientID, i->second);
-				cmd->Print(L"OK");
-				return true;
-			}
-		}
+	int min = 100;
+	int max = 5000;
+	int randomsiegeint = min + (rand() % (int)(max - min + 1));
 
-		// Exact match failed, try a for an partial match
-		for (map<uint, PlayerBase*>::iterator i = player_bases.begin(); i != player_bases.end(); ++i)
-		{
-			if (ToLower(i->second->basename).find(ToLower(basename)) != -1)
-			{
-				returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-				ForcePlayerBaseDock(info.iClientID, i->second);
-				cmd->Print(L"OK");
-				return true;
-			}
-		}
+	string randomname = "TB";
 
-		// Fall back to default flhook .beam command
-		return false;
-	}
-	else if (args.find(L"basedestroy") == 0)
+	stringstream ss;
+	ss << randomsiegeint;
+	string str = ss.str();
+
+	randomname.append(str);
+
+	// Check for conflicting base name
+	if (GetPlayerBase(CreateID(PlayerBase::CreateBaseNickname(randomname).c_str())))
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+		PrintUserCmdText(client, L"ERR Deployment error, please reiterate.");
+		return true;
+	}
 
-		RIGHT_CHECK(RIGHT_BASES)
+	wstring charname = (const wchar_t*)Players.GetActiveCharacterName(client);
+	AddLog("NOTICE: Base created %s by %s (%s)",
+		randomname.c_str(),
+		wstos(charname).c_str(),
+		wstos(HkGetAccountID(HkGetAccountByCharname(charname))).c_str());
 
-			uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
+	wstring password = L"hastesucks";
+	wstring basename = stows(randomname);
 
-		//return SpaceObjDestroyed(space_obj);
-		//alleynote1
-		int billythecat = 0;
-		PlayerBase *base;
-		for (map<uint, PlayerBase*>::iterator i = player_bases.begin(); i != player_bases.end(); ++i)
-		{
-			if (i->second->basename == cmd->ArgStrToEnd(1))
-			{
-				base = i->second;
-				billythecat = 1;
-			}
-		}
+	PlayerBase *newbase = new PlayerBase(client, password, basename);
+	player_bases[newbase->base] = newbase;
+	newbase->basetype = "legacy";
+	newbase->basesolar = "legacy";
+	newbase->baseloadout = "legacy";
+	newbase->defense_mode = 1;
 
+	for (map<string, ARCHTYPE_STRUCT>::iterator iter = mapArchs.begin(); iter != mapArchs.end(); iter++)
+	{
 
-		if (billythecat == 0)
+		ARCHTYPE_STRUCT &thearch = iter->second;
+		if (iter->first == newbase->basetype)
 		{
-			cmd->Print(L"ERR Base doesn't exist lmao");
-			return true;
+			newbase->invulnerable = thearch.invulnerable;
+			newbase->logic = thearch.logic;
 		}
+	}
 
-		base->base_health = 0;
-		if (base->base_health < 1)
-		{
-			return CoreModule(base).SpaceObjDestroyed(CoreModule(base).space_obj);
-		}
+	newbase->Spawn();
+	newbase->Save();
+
+	PrintUserCmdText(client, L"OK: Siege Cannon deployed");
+	PrintUserCmdText(client, L"Default administration password is %s", password.c_str());
 
-		//cmd->Print(L"OK Base is gone are you proud of yourself.");
+	return true;
+}
+
+bool AdminCmd_JumpCreate(CCmds* cmd, const wstring &args)
+{
+	uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
+	PlayerBase *base = GetPlayerBaseForClient(client);
+
+	uint ship;
+	pub::Player::GetShip(client, ship);
+	if (!ship)
+	{
+		PrintUserCmdText(client, L"ERR Not in space");
 		return true;
 	}
-	else if (args.find(L"basetogglegod") == 0)
+
+	// If the ship is moving, abort the processing.
+	Vector dir1;
+	Vector dir2;
+	pub::SpaceObj::GetMotion(ship, dir1, dir2);
+	if (dir1.x > 5 || dir1.y > 5 || dir1.z > 5)
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+		PrintUserCmdText(client, L"ERR Ship is moving");
+		return true;
+	}
 
-		RIGHT_CHECK(RIGHT_BASES)
+	wstring archtype = cmd->ArgStr(1);
+	if (!archtype.length())
+	{
+		PrintUserCmdText(client, L"ERR No archtype");
+		PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
+		return true;
+	}
+	wstring loadout = cmd->ArgStr(2);
+	if (!loadout.length())
+	{
+		PrintUserCmdText(client, L"ERR No loadout");
+		PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
+		return true;
+	}
+	wstring type = cmd->ArgStr(3);
+	if (!type.length())
+	{
+		PrintUserCmdText(client, L"ERR No type");
+		PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
+		return true;
+	}
+	wstring destsystem = cmd->ArgStr(4);
+	if (!destsystem.length())
+	{
+		PrintUserCmdText(client, L"ERR No destination system");
+		PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
+		return true;
+	}
 
-			uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
-		bool optype = cmd->ArgInt(1);
+	Vector destpos;
+	destpos.x = cmd->ArgFloat(5);
+	destpos.y = cmd->ArgFloat(6);
+	destpos.z = cmd->ArgFloat(7);
 
-		//return SpaceObjDestroyed(space_obj);
-		//alleynote1
-		int billythecat = 0;
-		PlayerBase *base;
-		for (map<uint, PlayerBase*>::iterator i = player_bases.begin(); i != player_bases.end(); ++i)
-		{
-			if (i->second->basename == cmd->ArgStrToEnd(2))
-			{
-				base = i->second;
-				billythecat = 1;
-				break;
-			}
-		}
+	wstring theaffiliation = cmd->ArgStr(8);
+	if (!theaffiliation.length())
+	{
+		PrintUserCmdText(client, L"ERR No affiliation");
+		PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
+		return true;
+	}
 
 
-		if (billythecat == 0)
-		{
-			cmd->Print(L"ERR Base doesn't exist lmao");
-			return true;
-		}
+	wstring basename = cmd->ArgStrToEnd(9);
+	if (!basename.length())
+	{
+		PrintUserCmdText(client, L"ERR No name entered");
+		PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
+		return true;
+	}
 
 
-		if (optype == true)
-		{
-			base->invulnerable = true;
-			cmd->Print(L"OK Base made invulnerable.");
-		}
-		else if (optype == false)
-		{
-			base->invulnerable = false;
-			cmd->Print(L"OK Base made vulnerable.");
-		}
 
-		//cmd->Print(L"OK Base is gone are you proud of yourself.");
+	// Check for conflicting base name
+	if (GetPlayerBase(CreateID(PlayerBase::CreateBaseNickname(wstos(basename)).c_str())))
+	{
+		PrintUserCmdText(client, L"ERR Base name already exists");
 		return true;
 	}
-	else if (args.find(L"testbase") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
 
-		RIGHT_CHECK(RIGHT_BASES)
-
-			uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
-
-		uint ship;
-		pub::Player::GetShip(client, ship);
-		if (!ship)
-		{
-			PrintUserCmdText(client, L"ERR Not in space");
-			return true;
-		}
+	wstring charname = (const wchar_t*)Players.GetActiveCharacterName(client);
+	AddLog("NOTICE: Base created %s by %s (%s)",
+		wstos(basename).c_str(),
+		wstos(charname).c_str(),
+		wstos(HkGetAccountID(HkGetAccountByCharname(charname))).c_str());
 
-		int min = 100;
-		int max = 5000;
-		int randomsiegeint = min + (rand() % (int)(max - min + 1));
+	wstring password = L"nopassword";
 
-		string randomname = "TB";
+	PlayerBase *newbase = new PlayerBase(client, password, basename);
+	player_bases[newbase->base] = newbase;
+	newbase->affiliation = CreateID(wstos(theaffiliation).c_str());
+	newbase->basetype = wstos(type);
+	newbase->basesolar = wstos(archtype);
+	newbase->baseloadout = wstos(loadout);
+	newbase->defense_mode = 4;
+	newbase->base_health = 10000000000;
 
-		stringstream ss;
-		ss << randomsiegeint;
-		string str = ss.str();
+	newbase->destsystem = CreateID(wstos(destsystem).c_str());
+	newbase->destposition = destpos;
 
-		randomname.append(str);
+	for (map<string, ARCHTYPE_STRUCT>::iterator iter = mapArchs.begin(); iter != mapArchs.end(); iter++)
+	{
 
-		// Check for conflicting base name
-		if (GetPlayerBase(CreateID(PlayerBase::CreateBaseNickname(randomname).c_str())))
+		ARCHTYPE_STRUCT &thearch = iter->second;
+		if (iter->first == newbase->basetype)
 		{
-			PrintUserCmdText(client, L"ERR Deployment error, please reiterate.");
-			return true;
+			newbase->invulnerable = thearch.invulnerable;
+			newbase->logic = thearch.logic;
+			newbase->radius = thearch.radius;
 		}
+	}
 
-		wstring charname = (const wchar_t*)Players.GetActiveCharacterName(client);
-		AddLog("NOTICE: Base created %s by %s (%s)",
-			randomname.c_str(),
-			wstos(charname).c_str(),
-			wstos(HkGetAccountID(HkGetAccountByCharname(charname))).c_str());
-
-		wstring password = L"hastesucks";
-		wstring basename = stows(randomname);
-
-		PlayerBase *newbase = new PlayerBase(client, password, basename);
-		player_bases[newbase->base] = newbase;
-		newbase->basetype = "legacy";
-		newbase->basesolar = "legacy";
-		newbase->baseloadout = "legacy";
-		newbase->defense_mode = 1;
-
-		for (map<string, ARCHTYPE_STRUCT>::iterator iter = mapArchs.begin(); iter != mapArchs.end(); iter++)
-		{
+	newbase->Spawn();
+	newbase->Save();
 
-			ARCHTYPE_STRUCT &thearch = iter->second;
-			if (iter->first == newbase->basetype)
-			{
-				newbase->invulnerable = thearch.invulnerable;
-				newbase->logic = thearch.logic;
-			}
-		}
+	PrintUserCmdText(client, L"OK: Solar deployed");
+	//PrintUserCmdText(client, L"Default administration password is %s", password.c_str());
+	return true;
+}
 
-		newbase->Spawn();
-		newbase->Save();
+bool AdminCmd_BaseCreate(CCmds* cmd, const wstring &args)
+{
+	uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
+	PlayerBase *base = GetPlayerBaseForClient(client);
 
-		PrintUserCmdText(client, L"OK: Siege Cannon deployed");
-		PrintUserCmdText(client, L"Default administration password is %s", password.c_str());
+	uint ship;
+	pub::Player::GetShip(client, ship);
+	if (!ship)
+	{
+		PrintUserCmdText(client, L"ERR Not in space");
+		return true;
+	}
 
+	// If the ship is moving, abort the processing.
+	Vector dir1;
+	Vector dir2;
+	pub::SpaceObj::GetMotion(ship, dir1, dir2);
+	if (dir1.x > 5 || dir1.y > 5 || dir1.z > 5)
+	{
+		PrintUserCmdText(client, L"ERR Ship is moving");
 		return true;
 	}
-	else if (args.find(L"jumpcreate") == 0)
+
+	wstring password = cmd->ArgStr(1);
+	if (!password.length())
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+		PrintUserCmdText(client, L"ERR No password");
+		PrintUserCmdText(client, L"Usage: .basecreate <password> <archtype> <loadout> <type> <name>");
+		return true;
+	}
+	wstring archtype = cmd->ArgStr(2);
+	if (!archtype.length())
+	{
+		PrintUserCmdText(client, L"ERR No archtype");
+		PrintUserCmdText(client, L"Usage: .basecreate <password> <archtype> <loadout> <type> <name>");
+		return true;
+	}
+	wstring loadout = cmd->ArgStr(3);
+	if (!loadout.length())
+	{
+		PrintUserCmdText(client, L"ERR No loadout");
+		PrintUserCmdText(client, L"Usage: .basecreate <password> <archtype> <loadout> <type> <name>");
+		return true;
+	}
+	wstring type = cmd->ArgStr(4);
+	if (!type.length())
+	{
+		PrintUserCmdText(client, L"ERR No type");
+		PrintUserCmdText(client, L"Usage: .basecreate <password> <archtype> <loadout> <type> <name>");
+		return true;
+	}
+	uint theaffiliation = cmd->ArgInt(5);
 
-		RIGHT_CHECK(RIGHT_BASES)
+	wstring basename = cmd->ArgStrToEnd(6);
+	if (!basename.length())
+	{
+		PrintUserCmdText(client, L"ERR No name");
+		PrintUserCmdText(client, L"Usage: .basecreate <password> <archtype> <loadout> <type> <name>");
+		return true;
+	}
 
-			uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
-		PlayerBase *base = GetPlayerBaseForClient(client);
 
-		uint ship;
-		pub::Player::GetShip(client, ship);
-		if (!ship)
-		{
-			PrintUserCmdText(client, L"ERR Not in space");
-			return true;
-		}
 
-		// If the ship is moving, abort the processing.
-		Vector dir1;
-		Vector dir2;
-		pub::SpaceObj::GetMotion(ship, dir1, dir2);
-		if (dir1.x > 5 || dir1.y > 5 || dir1.z > 5)
-		{
-			PrintUserCmdText(client, L"ERR Ship is moving");
-			return true;
-		}
+	// Check for conflicting base name
+	if (GetPlayerBase(CreateID(PlayerBase::CreateBaseNickname(wstos(basename)).c_str())))
+	{
+		PrintUserCmdText(client, L"ERR Base name already exists");
+		return true;
+	}
 
-		wstring archtype = cmd->ArgStr(1);
-		if (!archtype.length())
-		{
-			PrintUserCmdText(client, L"ERR No archtype");
-			PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
-			return true;
-		}
-		wstring loadout = cmd->ArgStr(2);
-		if (!loadout.length())
-		{
-			PrintUserCmdText(client, L"ERR No loadout");
-			PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
-			return true;
-		}
-		wstring type = cmd->ArgStr(3);
-		if (!type.length())
-		{
-			PrintUserCmdText(client, L"ERR No type");
-			PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
-			return true;
-		}
-		wstring destsystem = cmd->ArgStr(4);
-		if (!destsystem.length())
-		{
-			PrintUserCmdText(client, L"ERR No destination system");
-			PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
-			return true;
-		}
+	wstring charname = (const wchar_t*)Players.GetActiveCharacterName(client);
+	AddLog("NOTICE: Base created %s by %s (%s)",
+		wstos(basename).c_str(),
+		wstos(charname).c_str(),
+		wstos(HkGetAccountID(HkGetAccountByCharname(charname))).c_str());
+
+	PlayerBase *newbase = new PlayerBase(client, password, basename);
+	player_bases[newbase->base] = newbase;
+	newbase->affiliation = theaffiliation;
+	newbase->basetype = wstos(type);
+	newbase->basesolar = wstos(archtype);
+	newbase->baseloadout = wstos(loadout);
+	newbase->defense_mode = 2;
+	newbase->base_health = 10000000000;
 
-		Vector destpos;
-		destpos.x = cmd->ArgFloat(5);
-		destpos.y = cmd->ArgFloat(6);
-		destpos.z = cmd->ArgFloat(7);
+	for (map<string, ARCHTYPE_STRUCT>::iterator iter = mapArchs.begin(); iter != mapArchs.end(); iter++)
+	{
 
-		wstring theaffiliation = cmd->ArgStr(8);
-		if (!theaffiliation.length())
+		ARCHTYPE_STRUCT &thearch = iter->second;
+		if (iter->first == newbase->basetype)
 		{
-			PrintUserCmdText(client, L"ERR No affiliation");
-			PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
-			return true;
+			newbase->invulnerable = thearch.invulnerable;
+			newbase->logic = thearch.logic;
 		}
+	}
 
+	newbase->Spawn();
+	newbase->Save();
 
-		wstring basename = cmd->ArgStrToEnd(9);
-		if (!basename.length())
-		{
-			PrintUserCmdText(client, L"ERR No name entered");
-			PrintUserCmdText(client, L"Usage: .jumpcreate <archtype> <loadout> <type> <dest system> <x> <y> <z> <affiliation> <name>");
-			return true;
-		}
+	PrintUserCmdText(client, L"OK: Base deployed");
+	PrintUserCmdText(client, L"Default administration password is %s", password.c_str());
+	return true;
+}
 
+bool AdminCmd_BaseDebugOn(CCmds* cmd, const wstring &args)
+{
+	set_plugin_debug = 1;
+	cmd->Print(L"OK base debug is on, sure hope you know what you're doing here.\n");
+	return true;
+}
 
+bool AdminCmd_BaseDebugOff(CCmds* cmd, const wstring &args)
+{
+	set_plugin_debug = 0;
+	cmd->Print(L"OK base debug is off.\n");
+	return true;
+}
 
-		// Check for conflicting base name
-		if (GetPlayerBase(CreateID(PlayerBase::CreateBaseNickname(wstos(basename)).c_str())))
-		{
-			PrintUserCmdText(client, L"ERR Base name already exists");
-			return true;
-		}
+struct ADMINCMD
+{
+	wchar_t *wszCmd;
+	ADMIN_CMD_CALLBACK proc;
+};
 
-		wstring charname = (const wchar_t*)Players.GetActiveCharacterName(client);
-		AddLog("NOTICE: Base created %s by %s (%s)",
-			wstos(basename).c_str(),
-			wstos(charname).c_str(),
-			wstos(HkGetAccountID(HkGetAccountByCharname(charname))).c_str());
-
-		wstring password = L"nopassword";
-
-		PlayerBase *newbase = new PlayerBase(client, password, basename);
-		player_bases[newbase->base] = newbase;
-		newbase->affiliation = CreateID(wstos(theaffiliation).c_str());
-		newbase->basetype = wstos(type);
-		newbase->basesolar = wstos(archtype);
-		newbase->baseloadout = wstos(loadout);
-		newbase->defense_mode = 4;
-		newbase->base_health = 10000000000;
-
-		newbase->destsystem = CreateID(wstos(destsystem).c_str());
-		newbase->destposition = destpos;
-
-		for (map<string, ARCHTYPE_STRUCT>::iterator iter = mapArchs.begin(); iter != mapArchs.end(); iter++)
+ADMINCMD AdminCmds[] =
+{
+	{ L"testrecipe", AdminCmd_TestRecipe },
+	{ L"testdeploy", AdminCmd_TestDeploy },
+	{ L"basedestroy", AdminCmd_BaseDestroy },
+	{ L"basetogglegod", AdminCmd_BaseToggleGod },
+	{ L"testbase", AdminCmd_TestBase },
+	{ L"jumpcreate", AdminCmd_JumpCreate },
+	{ L"basecreate", AdminCmd_BaseCreate },
+	{ L"basedebugon", AdminCmd_BaseDebugOn },
+	{ L"basedebugoff", AdminCmd_BaseDebugOff },
+};
+
+/*
+The commands are registered with FLHook, which checks RIGHT_BASES and calls the
+command's function directly instead of offering every admin command to this plugin.
+*/
+void RegisterAdminCommands()
+{
+	for (uint i = 0; (i < sizeof(AdminCmds) / sizeof(ADMINCMD)); i++)
+		HkRegisterAdminCommand(AdminCmds[i].wszCmd, RIGHT_BASES, AdminCmds[i].proc);
+}
+
+// .beam is not registered, it falls back to playercntl's and FLHook's beam if
+// the target is not a player base.
+bool ExecuteCommandString_Callback(CCmds* cmd, const wstring &args)
+{
+	returncode = DEFAULT_RETURNCODE;
+	/*if (args.find(L"dumpbases")==0)
+	{
+		Universe::ISystem *sys = Universe::GetFirstSystem();
+		FILE* f = fopen("bases.txt", "w");
+		while (sys)
 		{
+			fprintf(f, "[Base]\n");
+			fprintf(f, "nickname = %s_proxy_base\n", sys->nickname);
+			fprintf(f, "system = %s\n", sys->nickname);
+			fprintf(f, "strid_name = 0\n");
+			fprintf(f, "file=Universe\\Systems\\proxy_base->ini\n");
+			fprintf(f, "BGCS_base_run_by=W02bF35\n\n");
 
-			ARCHTYPE_STRUCT &thearch = iter->second;
-			if (iter->first == newbase->basetype)
-			{
-				newbase->invulnerable = thearch.invulnerable;
-				newbase->logic = thearch.logic;
-				newbase->radius = thearch.radius;
-			}
+			sys = Universe::GetNextSystem();
 		}
-
-		newbase->Spawn();
-		newbase->Save();
-
-		PrintUserCmdText(client, L"OK: Solar deployed");
-		//PrintUserCmdText(client, L"Default administration password is %s", password.c_str());
-		return true;
+		fclose(f);
 	}
-	else if (args.find(L"basecreate") == 0)
+	if (args.find(L"makebases")==0)
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-
-		RIGHT_CHECK(RIGHT_BASES)
-
-			uint client = HkGetClientIdFromCharname(cmd->GetAdminName());
-		PlayerBase *base = GetPlayerBaseForClient(client);
-
-		uint ship;
-		pub::Player::GetShip(client, ship);
-		if (!ship)
+		struct Universe::ISystem *sys = Universe::GetFirstSystem();
+		while (sys)
 		{
-			PrintUserCmdText(client, L"ERR Not in space");
-			return true;
+			string path = string("..\\DATA\\UNIVERSE\\SYSTEMS\\") + string(sys->nickname) + "\\" + string(sys->nickname) + ".ini";
+			FILE *file = fopen(path.c_str(), "a+");
+			if (file)
+			{
+				ConPrint(L"doing path %s\n", stows(path).c_str());
+				fprintf(file, "\n\n[Object]\n");
+				fprintf(file, "nickname = %s_proxy_base\n", sys->nickname);
+				fprintf(file, "dock_with = %s_proxy_base\n", sys->nickname);
+				fprintf(file, "base = %s_proxy_base\n", sys->nickname);
+				fprintf(file, "pos = 0, -100000, 0\n");
+				fprintf(file, "archetype = invisible_base\n");
+				fprintf(file, "behavior = NOTHING\n");
+				fprintf(file, "visit = 128\n");
+				fclose(file);
+			}
+			sys = Universe::GetNextSystem();
 		}
+		return true;
+	}*/
 
-		// If the ship is moving, abort the processing.
-		Vector dir1;
-		Vector dir2;
-		pub::SpaceObj::GetMotion(ship, dir1, dir2);
-		if (dir1.x > 5 || dir1.y > 5 || dir1.z > 5)
-		{
-			PrintUserCmdText(client, L"ERR Ship is moving");
-			return true;
-		}
+	if (args.compare(L"beam") == 0)
+	{
+		returncode = DEFAULT_RETURNCODE;
+		wstring charname = cmd->ArgCharname(1);
+		wstring basename = cmd->ArgStrToEnd(2);
 
-		wstring password = cmd->ArgStr(1);
-		if (!password.length())
-		{
-			PrintUserCmdText(client, L"ERR No password");
-			PrintUserCmdText(client, L"Usage: .basecreate <password> <archtype> <loadout> <type> <name>");
-			return true;
-		}
-		wstring archtype = cmd->ArgStr(2);
-		if (!archtype.length())
-		{
-			PrintUserCmdText(client, L"ERR No archtype");
-			PrintUserCmdText(client, L"Usage: .basecreate <password> <archtype> <loadout> <type> <name>");
-			return true;
-		}
-		wstring loadout = cmd->ArgStr(3);
-		if (!loadout.length())
+		// Fall back to default behaviour.
+		if (cmd->rights != RIGHT_SUPERADMIN)
 		{
-			PrintUserCmdText(client, L"ERR No loadout");
-			PrintUserCmdText(client, L"Usage: .basecreate <password> <archtype> <loadout> <type> <name>");
-			return true;
+			return false;
 		}
-		wstring type = cmd->ArgStr(4);
-		if (!type.length())
+
+		HKPLAYERINFO info;
+		if (HkGetPlayerInfo(charname, info, false) != HKE_OK)
 		{
-			PrintUserCmdText(client, L"ERR No type");
-			PrintUserCmdText(client, L"Usage: .basecreate <password> <archtype> <loadout> <type> <name>");
-			return true;
+			return false;
 		}
-		uint theaffiliation = cmd->ArgInt(5);
 
-		wstring basename = cmd->ArgStrToEnd(6);
-		if (!basename.length())
+		if (info.iShip == 0)
 		{
-			PrintUserCmdText(client, L"ERR No name");
-			PrintUserCmdText(client, L"Usage: .basecreate <password> <archtype> <loadout> <type> <name>");
-			return true;
+			return false;
 		}
 
-
-
-		// Check for conflicting base name
-		if (GetPlayerBase(CreateID(PlayerBase::CreateBaseNickname(wstos(basename)).c_str())))
+		// Search for an match at the start of the name
+		for (map<uint, PlayerBase*>::iterator i = player_bases.begin(); i != player_bases.end(); ++i)
 		{
-			PrintUserCmdText(client, L"ERR Base name already exists");
-			return true;
+			if (ToLower(i->second->basename).find(ToLower(basename)) == 0)
+			{
+				returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+				ForcePlayerBaseDock(info.iClientID, i->second);
+				cmd->Print(L"OK");
+				return true;
+			}
 		}
 
-		wstring charname = (const wchar_t*)Players.GetActiveCharacterName(client);
-		AddLog("NOTICE: Base created %s by %s (%s)",
-			wstos(basename).c_str(),
-			wstos(charname).c_str(),
-			wstos(HkGetAccountID(HkGetAccountByCharname(charname))).c_str());
-
-		PlayerBase *newbase = new PlayerBase(client, password, basename);
-		player_bases[newbase->base] = newbase;
-		newbase->affiliation = theaffiliation;
-		newbase->basetype = wstos(type);
-		newbase->basesolar = wstos(archtype);
-		newbase->baseloadout = wstos(loadout);
-		newbase->defense_mode = 2;
-		newbase->base_health = 10000000000;
-
-		for (map<string, ARCHTYPE_STRUCT>::iterator iter = mapArchs.begin(); iter != mapArchs.end(); iter++)
+		// Exact match failed, try a for an partial match
+		for (map<uint, PlayerBase*>::iterator i = player_bases.begin(); i != player_bases.end(); ++i)
 		{
-
-			ARCHTYPE_STRUCT &thearch = iter->second;
-			if (iter->first == newbase->basetype)
+			if (ToLower(i->second->basename).find(ToLower(basename)) != -1)
 			{
-				newbase->invulnerable = thearch.invulnerable;
-				newbase->logic = thearch.logic;
+				returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+				ForcePlayerBaseDock(info.iClientID, i->second);
+				cmd->Print(L"OK");
+				return true;
 			}
 		}
 
-		newbase->Spawn();
-		newbase->Save();
-
-		PrintUserCmdText(client, L"OK: Base deployed");
-		PrintUserCmdText(client, L"Default administration password is %s", password.c_str());
-		return true;
-	}
-	else if (args.find(L"basedebugon") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-
-		RIGHT_CHECK(RIGHT_BASES)
-
-			set_plugin_debug = 1;
-		cmd->Print(L"OK base debug is on, sure hope you know what you're doing here.\n");
-		return true;
-	}
-	else if (args.find(L"basedebugoff") == 0)
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-
-		RIGHT_CHECK(RIGHT_BASES)
-
-			set_plugin_debug = 0;
-		cmd->Print(L"OK base debug is off.\n");
-		return true;
+		// Fall back to default flhook .beam command
+		return false;
 	}
 
 	return false;
@@ -2886,14 +2925,18 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ReqSetCash, PLUGIN_HkIServerImpl_ReqSetCash, 15));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ReqEquipment, PLUGIN_HkIServerImpl_ReqEquipment, 11));
 
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkTimerCheckKick, PLUGIN_HkTimerCheckKick, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
+	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&Shutdown, PLUGIN_HkIServerImpl_Shutdown, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ExecuteCommandString_Callback, PLUGIN_ExecuteCommandString_Callback, 0));
 
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&CShip_destroy, PLUGIN_HkIEngine_CShip_destroy, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&BaseDestroyed, PLUGIN_BaseDestroyed, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkCb_AddDmgEntry, PLUGIN_HkCb_AddDmgEntry, 15));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&Plugin_Communication_CallBack, PLUGIN_Plugin_Communication, 11));
+	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&Plugin_Unload, PLUGIN_Plugin_Unload, 0));
+
+	RegisterAdminCommands();
+	RegisterUserCommands();
+	HkScheduleTimer(250, 1000, BaseTimer);
 	return p_PI;
 }
 
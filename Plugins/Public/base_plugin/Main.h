@@ -107,7 +107,7 @@ public:
 	virtual void Spawn() {}
 	virtual wstring GetInfo(bool xml) = 0;
 	virtual void LoadState(INI_Reader &ini) = 0;
-	virtual void SaveState(FILE *file) = 0;
+	virtual void SaveState(string &buffer) = 0;
 
 	virtual bool Timer(uint time) { return false; }
 
@@ -147,7 +147,7 @@ public:
 	wstring GetInfo(bool xml);
 
 	void LoadState(INI_Reader &ini);
-	void SaveState(FILE *file);
+	void SaveState(string &buffer);
 
 	bool Timer(uint time);
 	float SpaceObjDamaged(uint space_obj, uint attacking_space_obj, float curr_hitpoints, float new_hitpoints);
@@ -172,7 +172,7 @@ public:
 	wstring GetInfo(bool xml);
 
 	void LoadState(INI_Reader &ini);
-	void SaveState(FILE *file);
+	void SaveState(string &buffer);
 
 	bool Timer(uint time);
 	void SetReputation(int player_rep, float attitude);
@@ -190,7 +190,7 @@ public:
 	wstring GetInfo(bool xml);
 
 	void LoadState(INI_Reader &ini);
-	void SaveState(FILE *file);
+	void SaveState(string &buffer);
 };
 
 class DefenseModule : public Module
@@ -213,7 +213,7 @@ public:
 	wstring GetInfo(bool xml);
 
 	void LoadState(INI_Reader &ini);
-	void SaveState(FILE *file);
+	void SaveState(string &buffer);
 
 	bool Timer(uint time);
 	float SpaceObjDamaged(uint space_obj, uint attacking_space_obj, float curr_hitpoints, float new_hitpoints);
@@ -238,7 +238,7 @@ public:
 
 	bool Paused = false;
 	void LoadState(INI_Reader &ini);
-	void SaveState(FILE *file);
+	void SaveState(string &buffer);
 
 	bool Timer(uint time);
 };
@@ -258,7 +258,7 @@ public:
 	FactoryModule(PlayerBase *the_base, uint type);
 	wstring GetInfo(bool xml);
 	void LoadState(INI_Reader &ini);
-	void SaveState(FILE *file);
+	void SaveState(string &buffer);
 	bool Timer(uint time);
 
 	bool Paused = false;
@@ -423,6 +423,15 @@ public:
 	// When this timer drops to less than 0 the base is saved	 
 	int save_timer;
 
+	// Set when something that is saved changed, the base is then saved
+	// when save_timer runs out. Changes of the health are found by
+	// comparing with saved_health.
+	bool save_dirty;
+	float saved_health;
+
+	// The contents of the save file as last written
+	string saved_state;
+
 	int logic;
 	int invulnerable;
 
@@ -492,6 +501,16 @@ struct CLIENT_DATA
 	uint last_player_base;
 };
 
+namespace SaveWriter
+{
+	void Queue(const string &path, const string &contents);
+	void Flush();
+	void Shutdown();
+}
+
+void buf_printf(string &buffer, const char *format, ...);
+void ini_write_wstring(string &buffer, const string &parmname, const wstring &in);
+
 namespace ExportData
 {
 	void ToHTML();
@@ -564,6 +583,15 @@ extern map<uint, Module*> spaceobj_modules;
 // Map of ingame hash to info
 extern map<uint, class PlayerBase*> player_bases;
 
+// Bases by system and position
+namespace BaseIndex
+{
+	void Add(PlayerBase *base);
+	void Remove(PlayerBase *base);
+	const vector<PlayerBase*>& GetSystemBases(uint system);
+	void FindInRange(uint system, const Vector &pos, float range, vector<PlayerBase*> &bases);
+}
+
 struct POBSOUNDS
 {
 	uint destruction1;
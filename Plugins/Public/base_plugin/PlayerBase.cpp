@@ -4,7 +4,8 @@ PlayerBase::PlayerBase(uint client, const wstring &password, const wstring &the_
 	: basename(the_basename),
 	base(0), money(0), base_health(0),
 	base_level(1), defense_mode(0), proxy_base(0), affiliation(0), siege_mode(false),
-	repairing(false), shield_active_time(0), shield_state(PlayerBase::SHIELD_STATE_OFFLINE)
+	repairing(false), shield_active_time(0), shield_state(PlayerBase::SHIELD_STATE_OFFLINE),
+	save_dirty(false), saved_health(0)
 {
 	nickname = CreateBaseNickname(wstos(basename));
 	base = CreateID(nickname.c_str());
@@ -33,24 +34,32 @@ PlayerBase::PlayerBase(uint client, const wstring &password, const wstring &the_
 	SetupDefaults();
 
 	save_timer = rand() % 60;
+
+	BaseIndex::Add(this);
 }
 
 PlayerBase::PlayerBase(const string &the_path)
 	: path(the_path), base(0), money(0),
 	base_health(0), base_level(0), defense_mode(0), proxy_base(0), affiliation(0),
-	repairing(false), shield_active_time(0), shield_state(PlayerBase::SHIELD_STATE_OFFLINE)
+	repairing(false), shield_active_time(0), shield_state(PlayerBase::SHIELD_STATE_OFFLINE),
+	save_dirty(false), saved_health(0)
 {
 	// Load and spawn base modules
 	Load();
+	saved_health = base_health;
 
 	// Setup derived fields
 	SetupDefaults();
 
 	save_timer = rand() % 60;
+
+	BaseIndex::Add(this);
 }
 
 PlayerBase::~PlayerBase()
 {
+	BaseIndex::Remove(this);
+
 	for (vector<Module*>::iterator i = modules.begin(); i != modules.end(); ++i)
 	{
 		if (*i)
@@ -88,11 +97,12 @@ bool PlayerBase::Timer(uint curr_time)
 		}
 	}
 
-	// Save base status every 60 seconds.
+	// Save base status every 60 seconds if anything changed.
 	if (save_timer-- < 0)
 	{
 		save_timer = 60;
-		Save();
+		if (save_dirty || base_health != saved_health)
+			Save();
 	}
 
 	return false;
@@ -364,84 +374,91 @@ void PlayerBase::Load()
 
 void PlayerBase::Save()
 {
-	FILE *file = fopen(path.c_str(), "w");
-	if (file)
-	{
-		fprintf(file, "[Base]\n");
-		fprintf(file, "nickname = %s\n", nickname.c_str());
-		fprintf(file, "basetype = %s\n", basetype.c_str());
-		fprintf(file, "basesolar = %s\n", basesolar.c_str());
-		fprintf(file, "baseloadout = %s\n", baseloadout.c_str());
-		fprintf(file, "upgrade = %u\n", base_level);
-		fprintf(file, "affiliation = %u\n", affiliation);
-		fprintf(file, "logic = %u\n", logic);
-		fprintf(file, "invulnerable = %u\n", invulnerable);
-
-		fprintf(file, "money = %I64d\n", money);
-		fprintf(file, "system = %u\n", system);
-		fprintf(file, "pos = %0.0f, %0.0f, %0.0f\n", position.x, position.y, position.z);
-
-		fprintf(file, "destsystem = %u\n", destsystem);
-		fprintf(file, "destposition = %0.0f, %0.0f, %0.0f\n", destposition.x, destposition.y, destposition.z);
-
-		Vector vRot = MatrixToEuler(rotation);
-		fprintf(file, "rot = %0.0f, %0.0f, %0.0f\n", vRot.x, vRot.y, vRot.z);
-
-		ini_write_wstring(file, "infoname", basename);
-		for (int i = 1; i <= MAX_PARAGRAPHS; i++)
-		{
-			ini_write_wstring(file, "infocardpara", infocard_para[i]);
-		}
-		for (map<UINT, MARKET_ITEM>::iterator i = market_items.begin();
-			i != market_items.end(); ++i)
-		{
-			fprintf(file, "commodity = %u, %u, %f, %u, %u\n",
-				i->first, i->second.quantity, i->second.price, i->second.min_stock, i->second.max_stock);
-		}
+	// Format the base on the game thread, the file is written by the SaveWriter.
+	string buffer;
+	buffer.reserve(saved_state.size() + 256);
+
+	buf_printf(buffer, "[Base]\n");
+	buf_printf(buffer, "nickname = %s\n", nickname.c_str());
+	buf_printf(buffer, "basetype = %s\n", basetype.c_str());
+	buf_printf(buffer, "basesolar = %s\n", basesolar.c_str());
+	buf_printf(buffer, "baseloadout = %s\n", baseloadout.c_str());
+	buf_printf(buffer, "upgrade = %u\n", base_level);
+	buf_printf(buffer, "affiliation = %u\n", affiliation);
+	buf_printf(buffer, "logic = %u\n", logic);
+	buf_printf(buffer, "invulnerable = %u\n", invulnerable);
+
+	buf_printf(buffer, "money = %I64d\n", money);
+	buf_printf(buffer, "system = %u\n", system);
+	buf_printf(buffer, "pos = %0.0f, %0.0f, %0.0f\n", position.x, position.y, position.z);
+
+	buf_printf(buffer, "destsystem = %u\n", destsystem);
+	buf_printf(buffer, "destposition = %0.0f, %0.0f, %0.0f\n", destposition.x, destposition.y, destposition.z);
+
+	Vector vRot = MatrixToEuler(rotation);
+	buf_printf(buffer, "rot = %0.0f, %0.0f, %0.0f\n", vRot.x, vRot.y, vRot.z);
+
+	ini_write_wstring(buffer, "infoname", basename);
+	for (int i = 1; i <= MAX_PARAGRAPHS; i++)
+	{
+		ini_write_wstring(buffer, "infocardpara", infocard_para[i]);
+	}
+	for (map<UINT, MARKET_ITEM>::iterator i = market_items.begin();
+		i != market_items.end(); ++i)
+	{
+		buf_printf(buffer, "commodity = %u, %u, %f, %u, %u\n",
+			i->first, i->second.quantity, i->second.price, i->second.min_stock, i->second.max_stock);
+	}
 
-		fprintf(file, "defensemode = %u\n", defense_mode);
-		foreach(ally_tags, wstring, i)
-		{
-			ini_write_wstring(file, "ally_tag", *i);
-		}
-		for(auto i : ally_factions)
-		{
-			fprintf(file, "faction_ally_tag = %d\n", i);
-		}
-		for (auto i : hostile_factions)
-		{
-			fprintf(file, "faction_hostile_tag = %d\n", i);
-		}
-		for (map<wstring, wstring>::iterator i = hostile_tags.begin();
-			i != hostile_tags.end(); ++i)
-		{
-			ini_write_wstring(file, "hostile_tag", (wstring&)i->first);
-		}
-		foreach(perma_hostile_tags, wstring, i)
-		{
-			ini_write_wstring(file, "perma_hostile_tag", *i);
-		}
-		foreach(passwords, BasePassword, i)
-		{
-			BasePassword bp = *i;
-			wstring l = bp.pass;
-			if (!bp.admin && bp.viewshop) {
-				l += L" viewshop";
-			}
-			ini_write_wstring(file, "passwd", l);
+	buf_printf(buffer, "defensemode = %u\n", defense_mode);
+	foreach(ally_tags, wstring, i)
+	{
+		ini_write_wstring(buffer, "ally_tag", *i);
+	}
+	for(auto i : ally_factions)
+	{
+		buf_printf(buffer, "faction_ally_tag = %d\n", i);
+	}
+	for (auto i : hostile_factions)
+	{
+		buf_printf(buffer, "faction_hostile_tag = %d\n", i);
+	}
+	for (map<wstring, wstring>::iterator i = hostile_tags.begin();
+		i != hostile_tags.end(); ++i)
+	{
+		ini_write_wstring(buffer, "hostile_tag", (wstring&)i->first);
+	}
+	foreach(perma_hostile_tags, wstring, i)
+	{
+		ini_write_wstring(buffer, "perma_hostile_tag", *i);
+	}
+	foreach(passwords, BasePassword, i)
+	{
+		BasePassword bp = *i;
+		wstring l = bp.pass;
+		if (!bp.admin && bp.viewshop) {
+			l += L" viewshop";
 		}
-		fprintf(file, "health = %0.0f\n", base_health);
+		ini_write_wstring(buffer, "passwd", l);
+	}
+	buf_printf(buffer, "health = %0.0f\n", base_health);
 
-		for (vector<Module*>::iterator i = modules.begin(); i != modules.end(); ++i)
+	for (vector<Module*>::iterator i = modules.begin(); i != modules.end(); ++i)
+	{
+		if (*i)
 		{
-			if (*i)
-			{
-				(*i)->SaveState(file);
-			}
+			(*i)->SaveState(buffer);
 		}
+	}
 
-		fclose(file);
+	// Nothing to write if the base didn't change since the last save.
+	if (buffer != saved_state)
+	{
+		saved_state.swap(buffer);
+		SaveWriter::Queue(path, saved_state);
 	}
+	save_dirty = false;
+	saved_health = base_health;
 
 	SendBaseStatus(this);
 }
@@ -457,6 +474,7 @@ bool PlayerBase::AddMarketGood(uint good, uint quantity)
 
 	market_items[good].quantity += quantity;
 	SendMarketGoodUpdated(this, good, market_items[good]);
+	save_dirty = true;
 	return true;
 }
 
@@ -470,6 +488,7 @@ void PlayerBase::RemoveMarketGood(uint good, uint quantity)
 		else
 			iter->second.quantity -= quantity;
 		SendMarketGoodUpdated(this, good, iter->second);
+		save_dirty = true;
 	}
 }
 
@@ -478,6 +497,7 @@ void PlayerBase::ChangeMoney(INT64 the_money)
 	money += the_money;
 	if (money < 0)
 		money = 0;
+	save_dirty = true;
 }
 
 uint PlayerBase::GetRemainingCargoSpace()
@@ -720,26 +740,22 @@ void ReportAttack(wstring basename, wstring charname, uint system, wstring alert
 // of this base.
 void PlayerBase::SiegeModChainReaction(uint client)
 {
-	map<uint, PlayerBase*>::iterator it;
-	for (it = player_bases.begin(); it != player_bases.end(); it++)
+	vector<PlayerBase*> nearby_bases;
+	BaseIndex::FindInRange(this->system, this->position, siege_mode_chain_reaction_trigger_distance, nearby_bases);
+	for (vector<PlayerBase*>::iterator it = nearby_bases.begin(); it != nearby_bases.end(); ++it)
 	{
-		if (it->second->system == this->system)
+		PlayerBase *base = *it;
+		if (!(base->siege_mode))
 		{
-			if (HkDistance3D(it->second->position, this->position) < siege_mode_chain_reaction_trigger_distance)
+			float attitude = base->GetAttitudeTowardsClient(client, true);
+			if (attitude < -0.55f)
 			{
-				if (!(it->second->siege_mode))
-				{
-					float attitude = it->second->GetAttitudeTowardsClient(client, true);
-					if (attitude < -0.55f)
-					{
-						it->second->siege_mode = true;
+				base->siege_mode = true;
 
-						const wstring& charname = (const wchar_t*)Players.GetActiveCharacterName(client);
-						ReportAttack(it->second->basename, charname, it->second->system, L"has detected hostile activity at a nearby base by");
+				const wstring& charname = (const wchar_t*)Players.GetActiveCharacterName(client);
+				ReportAttack(base->basename, charname, base->system, L"has detected hostile activity at a nearby base by");
 
-						it->second->SyncReputationForBase();
-					}
-				}
+				base->SyncReputationForBase();
 			}
 		}
 	}
@@ -780,6 +796,7 @@ float PlayerBase::SpaceObjDamaged(uint space_obj, uint attacking_space_obj, floa
 			if (!is_ally && (hostile_tags_damage[charname] + incoming_damage) > damage_threshold)
 			{
 				hostile_tags[charname] = charname;
+				save_dirty = true;
 
 				const wstring& charname = (const wchar_t*)Players.GetActiveCharacterName(client);
 				ReportAttack(this->basename, charname, this->system, L"has activated self-defense against");
@@ -44,6 +44,7 @@ void DeleteBase(PlayerBase *base)
 	sprintf(namehash, "%08x", base->base);
 
 	string fullpath = basesvdir + "base_" + namehash + "." + timestamp + ".ini";
+	SaveWriter::Flush();
 	if (!MoveFile(base->path.c_str(), fullpath.c_str())) {
 		AddLog(
 			"ERROR: Base destruction MoveFile FAILED! Error code: %s",
@@ -0,0 +1,169 @@
+// Background writer for the base save files.
+//
+// PlayerBase::Save() formats the base into a string on the game thread and
+// queues it here. A writer thread writes each file to <file>.tmp and renames
+// it over the old one, so a crash during a save never leaves a half written
+// base behind. If a base is saved again before its last save was written
+// only the newest contents are written.
+
+#include "Main.h"
+
+#define SAVE_WRITER_IDLE_WAIT 1000
+
+namespace SaveWriter
+{
+	// path -> contents of the saves that still have to be written
+	static map<string, string> pending_saves;
+
+	// pending_saves is protected by cs_pending. cs_writing is held while a
+	// batch of saves is being written so Flush() can wait for it.
+	static CRITICAL_SECTION cs_pending;
+	static CRITICAL_SECTION cs_writing;
+
+	static HANDLE writer_thread = 0;
+	static HANDLE wake_event = 0;
+	static volatile bool stop = false;
+
+	static struct SAVE_WRITER_INIT
+	{
+		SAVE_WRITER_INIT()
+		{
+			InitializeCriticalSection(&cs_pending);
+			InitializeCriticalSection(&cs_writing);
+		}
+	} save_writer_init;
+
+	static void WriteSave(const string &path, const string &contents)
+	{
+		string temp_path = path + ".tmp";
+		FILE *file = fopen(temp_path.c_str(), "w");
+		if (!file)
+		{
+			AddLog("ERROR: Unable to write base file %s", temp_path.c_str());
+			return;
+		}
+
+		bool ok = (fwrite(contents.data(), 1, contents.size(), file) == contents.size());
+		ok = (fclose(file) == 0) && ok;
+		if (!ok || !MoveFileEx(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		{
+			AddLog("ERROR: Unable to replace base file %s (%u)", path.c_str(), GetLastError());
+			DeleteFile(temp_path.c_str());
+		}
+	}
+
+	static void WritePending()
+	{
+		EnterCriticalSection(&cs_writing);
+
+		map<string, string> saves;
+		EnterCriticalSection(&cs_pending);
+		saves.swap(pending_saves);
+		LeaveCriticalSection(&cs_pending);
+
+		for (map<string, string>::iterator i = saves.begin(); i != saves.end(); ++i)
+			WriteSave(i->first, i->second);
+
+		LeaveCriticalSection(&cs_writing);
+	}
+
+	static DWORD WINAPI WriterThread(LPVOID lpParam)
+	{
+		while (!stop)
+		{
+			WaitForSingleObject(wake_event, SAVE_WRITER_IDLE_WAIT);
+			WritePending();
+		}
+
+		WritePending();
+		return 0;
+	}
+
+	void Queue(const string &path, const string &contents)
+	{
+		if (!writer_thread)
+		{
+			stop = false;
+			wake_event = CreateEvent(0, FALSE, FALSE, 0);
+			DWORD id;
+			writer_thread = CreateThread(0, 0, WriterThread, 0, 0, &id);
+		}
+
+		EnterCriticalSection(&cs_pending);
+		pending_saves[path] = contents;
+		LeaveCriticalSection(&cs_pending);
+
+		if (writer_thread)
+			SetEvent(wake_event);
+		else
+			WritePending();
+	}
+
+	// Writes everything that was queued so far before returning. Must be
+	// called before moving or deleting a base file.
+	void Flush()
+	{
+		WritePending();
+	}
+
+	// Stops the writer thread and waits until it has exited. The thread runs
+	// code of this dll so this has to be done before the dll is freed, and
+	// not from DllMain where the thread can't exit while we wait for it.
+	void Shutdown()
+	{
+		if (writer_thread)
+		{
+			stop = true;
+			SetEvent(wake_event);
+			WaitForSingleObject(writer_thread, INFINITE);
+			CloseHandle(writer_thread);
+			CloseHandle(wake_event);
+			writer_thread = 0;
+			wake_event = 0;
+		}
+
+		WritePending();
+	}
+}
+
+// Append printf style formatted text to a save buffer.
+void buf_printf(string &buffer, const char *format, ...)
+{
+	char text[1024];
+	va_list args;
+	va_start(args, format);
+	int len = _vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+
+	if (len < 0 || len >= (int)sizeof(text))
+	{
+		// Too long for the stack buffer, format it again into the string.
+		va_start(args, format);
+		len = _vscprintf(format, args);
+		va_end(args);
+
+		size_t start = buffer.size();
+		buffer.resize(start + len + 1);
+		va_start(args, format);
+		_vsnprintf(&buffer[start], len + 1, format, args);
+		va_end(args);
+		buffer.resize(start + len);
+		return;
+	}
+
+	buffer.append(text, len);
+}
+
+// Same as ini_write_wstring from the plugin utilities but into a save buffer.
+void ini_write_wstring(string &buffer, const string &parmname, const wstring &in)
+{
+	buffer += parmname;
+	buffer += '=';
+	for (int i = 0; i < (int)in.size(); i++)
+	{
+		UINT v1 = in[i] >> 8;
+		UINT v2 = in[i] & 0xFF;
+		buf_printf(buffer, "%02x%02x", v1, v2);
+	}
+	buffer += '\n';
+}
@@ -40,9 +40,9 @@ void ShieldModule::LoadState(INI_Reader &ini)
 }
 
 // Append module state to the ini file.
-void ShieldModule::SaveState(FILE *file)
+void ShieldModule::SaveState(string &buffer)
 {
-	fprintf(file, "[ShieldModule]\n");
+	buf_printf(buffer, "[ShieldModule]\n");
 }
 
 bool ShieldModule::HasShieldPower()
@@ -152,20 +152,14 @@ int Siege::CalculateHealthPercentage(uint basehash, int health, int maxhealth)
 void Siege::SiegeAudioCalc(uint basehash, uint iSystemID, Vector pos, int level)
 {
 	// For all players in system...
-	struct PlayerData *pPD = 0;
-	while (pPD = Players.traverse_active(pPD))
+	const CLIENT_SET &clients = PlayerIndex::GetSystemClients(iSystemID);
+	for (uint iClientID = ClientSetNext(clients, 0); iClientID; iClientID = ClientSetNext(clients, iClientID))
 	{
-		// Get the this player's current system and location in the system.
-		uint iClientID = HkGetClientIdFromPD(pPD);
-
-		uint iClientSystem = 0;
-		pub::Player::GetSystem(iClientID, iClientSystem);
-		if (iSystemID != iClientSystem)
+		// Get the location of this player's ship, docked players can't hear it.
+		uint iShip = PlayerIndex::GetShip(iClientID);
+		if (!iShip)
 			continue;
 
-		uint iShip;
-		pub::Player::GetShip(iClientID, iShip);
-
 		Vector vShipLoc;
 		Matrix mShipDir;
 		pub::SpaceObj::GetLocation(iShip, vShipLoc, mShipDir);
@@ -22,7 +22,7 @@ void StorageModule::LoadState(INI_Reader &ini)
 	}
 }
 
-void StorageModule::SaveState(FILE *file)
+void StorageModule::SaveState(string &buffer)
 {
-	fprintf(file, "[StorageModule]\n");
+	buf_printf(buffer, "[StorageModule]\n");
 }
\ No newline at end of file
@@ -62,6 +62,9 @@ struct CLOAK_INFO
 		arch.iHoldSizeLimit = 0;
 		arch.mapFuelToUsage.clear();
 		arch.bDropShieldsOnUncloak = false;
+
+		sFuelID = 0;
+		iFuelUsage = 0;
 	}
 
 	uint iCloakSlot;
@@ -72,6 +75,13 @@ struct CLOAK_INFO
 	int DisruptTime;
 	bool singleCloakConsumed = false;
 
+	// the fuel cargo found on launch, only searched for again when it runs dry
+	ushort sFuelID;
+	uint iFuelUsage;
+
+	// clients that were sent the "off" state of this ship since it was created for them
+	set<uint> setObserversOff;
+
 	CLOAK_ARCH arch;
 };
 
@@ -100,6 +110,10 @@ static map<uint, CDSTRUCT> mapCloakDisruptors;
 
 static set<uint> setJumpingClients;
 
+// "off" states sent to single observers and the one second re-broadcasts this replaced
+static uint iOffStatesSent = 0;
+static uint iOffStatesSaved = 0;
+
 void LoadSettings();
 
 BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
@@ -223,10 +237,18 @@ void LoadSettings()
 	}
 }
 
+// the client lost all the ships it was shown (disconnect, docking, system change)
+void ForgetObserver(uint iClientID)
+{
+	for (map<uint, CLOAK_INFO>::iterator ci = mapClientsCloak.begin(); ci != mapClientsCloak.end(); ++ci)
+		ci->second.setObserversOff.erase(iClientID);
+}
+
 void ClearClientInfo(uint iClientID)
 {
 	mapClientsCloak.erase(iClientID);
 	setJumpingClients.erase(iClientID);
+	ForgetObserver(iClientID);
 }
 
 void SetCloak(uint iClientID, uint iShipID, bool bOn)
@@ -244,6 +266,7 @@ void SetState(uint iClientID, uint iShipID, int iNewState)
 	{
 		mapClientsCloak[iClientID].iState = iNewState;
 		mapClientsCloak[iClientID].tmCloakTime = timeInMS();
+		mapClientsCloak[iClientID].setObserversOff.clear();
 		CLIENT_CLOAK_STRUCT communicationInfo;
 		switch (iNewState)
 		{
@@ -289,21 +312,49 @@ void SetState(uint iClientID, uint iShipID, int iNewState)
 	}
 }
 
-bool removeSingleFuel(uint iClientID, CLOAK_INFO &info)
+// Looks for cargo that can feed the cloaking device and remembers its slot.
+static bool ResolveFuel(uint iClientID, CLOAK_INFO &info)
 {
+	info.sFuelID = 0;
+	info.iFuelUsage = 0;
+
 	for (list<EquipDesc>::iterator item = Players[iClientID].equipDescList.equip.begin(); item != Players[iClientID].equipDescList.equip.end(); item++)
 	{
-		uint fuel_usage = info.arch.mapFuelToUsage[item->iArchID];
-		if (item->iCount >= fuel_usage)
+		map<uint, uint>::iterator fuel = info.arch.mapFuelToUsage.find(item->iArchID);
+		if (fuel != info.arch.mapFuelToUsage.end() && item->iCount >= fuel->second)
 		{
-			pub::Player::RemoveCargo(iClientID, item->sID, fuel_usage);
-			info.singleCloakConsumed = true;
+			info.sFuelID = item->sID;
+			info.iFuelUsage = fuel->second;
 			return true;
 		}
 	}
 
 	return false;
+}
+
+// Removes one dose of fuel from the remembered slot, the cargo is only searched
+// again if that slot is gone or empty.
+static bool RemoveFuel(uint iClientID, CLOAK_INFO &info)
+{
+	const EquipDesc *item = info.sFuelID ? Players[iClientID].equipDescList.find_equipment_item(info.sFuelID) : 0;
+	map<uint, uint>::iterator fuel = item ? info.arch.mapFuelToUsage.find(item->iArchID) : info.arch.mapFuelToUsage.end();
+	if (fuel == info.arch.mapFuelToUsage.end() || fuel->second != info.iFuelUsage || item->iCount < info.iFuelUsage)
+	{
+		if (!ResolveFuel(iClientID, info))
+			return false;
+	}
 
+	pub::Player::RemoveCargo(iClientID, info.sFuelID, info.iFuelUsage);
+	return true;
+}
+
+bool removeSingleFuel(uint iClientID, CLOAK_INFO &info)
+{
+	if (!RemoveFuel(iClientID, info))
+		return false;
+
+	info.singleCloakConsumed = true;
+	return true;
 }
 
 // Returns false if the ship has no fuel to operate its cloaking device.
@@ -321,24 +372,26 @@ static bool ProcessFuel(uint iClientID, CLOAK_INFO &info)
 		return true;
 	}
 
-	for (list<EquipDesc>::iterator item = Players[iClientID].equipDescList.equip.begin(); item != Players[iClientID].equipDescList.equip.end(); item++)
-	{
-		if (info.arch.mapFuelToUsage.find(item->iArchID) != info.arch.mapFuelToUsage.end())
-		{
-			uint fuel_usage = info.arch.mapFuelToUsage[item->iArchID];
-			if (item->iCount >= fuel_usage)
-			{
-				pub::Player::RemoveCargo(iClientID, item->sID, fuel_usage);
-				return true;
-			}
-		}
-	}
+	return RemoveFuel(iClientID, info);
+}
 
-	return false;
+// Tells one observer that the cloaking device of the ship is off.
+static void SendOffState(uint iObserver, uint iShipID, CLOAK_INFO &info)
+{
+	if (!info.setObserversOff.insert(iObserver).second)
+		return;
+
+	XActivateEquip ActivateEq;
+	ActivateEq.bActivate = false;
+	ActivateEq.iSpaceID = iShipID;
+	ActivateEq.sID = info.iCloakSlot;
+	HookClient->Send_FLPACKET_COMMON_ACTIVATEEQUIP(iObserver, ActivateEq);
+	++iOffStatesSent;
 }
 
 void PlayerLaunch_AFTER(unsigned int iShip, unsigned int iClientID)
 {
+	ForgetObserver(iClientID);
 	mapClientsCloak[iClientID].bCanCloak = false;
 	mapClientsCloak[iClientID].bAdmin = false;
 
@@ -398,6 +451,8 @@ void PlayerLaunch_AFTER(unsigned int iShip, unsigned int iClientID)
 					mapClientsCloak[iClientID].arch.mapFuelToUsage.clear();
 				}
 
+				ResolveFuel(iClientID, mapClientsCloak[iClientID]);
+
 				mapClientsCloak[iClientID].DisruptTime = 0;
 				mapClientsCloak[iClientID].bCanCloak = true;
 				mapClientsCloak[iClientID].iState = STATE_CLOAK_INVALID;
@@ -415,9 +470,46 @@ void BaseEnter(unsigned int iBaseID, unsigned int iClientID)
 {
 	mapClientsCloak.erase(iClientID);
 	mapClientsCD.erase(iClientID);
+	ForgetObserver(iClientID);
 }
 
-void HkTimerCheckKick()
+/**
+Players didn't always see that a cloak-capable ship was uncloaked. Instead of re-broadcasting
+the "off" state every second, it is sent to an observer once when the ship is created for it
+(the observer launches, enters the system or the ship comes into view).
+*/
+bool Send_FLPACKET_SERVER_CREATESHIP_AFTER(uint iClientID, FLPACKET_CREATESHIP& pShip)
+{
+	returncode = DEFAULT_RETURNCODE;
+
+	uint iOwner = HkGetClientIDByShip(pShip.iSpaceID);
+	if (!iOwner || iOwner == iClientID)
+		return true;
+
+	map<uint, CLOAK_INFO>::iterator ci = mapClientsCloak.find(iOwner);
+	if (ci != mapClientsCloak.end() && ci->second.bCanCloak && ci->second.iState == STATE_CLOAK_OFF)
+		SendOffState(iClientID, pShip.iSpaceID, ci->second);
+
+	return true;
+}
+
+bool __stdcall Send_FLPACKET_SERVER_DESTROYOBJECT(uint iClientID, FLPACKET_DESTROYOBJECT& pDestroy)
+{
+	returncode = DEFAULT_RETURNCODE;
+
+	uint iOwner = HkGetClientIDByShip(pDestroy.iSpaceID);
+	if (iOwner)
+	{
+		map<uint, CLOAK_INFO>::iterator ci = mapClientsCloak.find(iOwner);
+		if (ci != mapClientsCloak.end())
+			ci->second.setObserversOff.erase(iClientID);
+	}
+
+	return true;
+}
+
+// runs every second, scheduled in Get_PluginInfo
+void CloakTimer(uint iTimerID, void *pData)
 {
 	mstime now = timeInMS();
 	uint curr_time = (uint)time(0);
@@ -449,13 +541,9 @@ void HkTimerCheckKick()
 			switch (info.iState)
 			{
 			case STATE_CLOAK_OFF:
-				// Send cloak state for uncloaked cloak-able players (only for them in space)
-				// this is the code to fix the bug where players wouldnt always see uncloaked players
-				XActivateEquip ActivateEq;
-				ActivateEq.bActivate = false;
-				ActivateEq.iSpaceID = iShipID;
-				ActivateEq.sID = info.iCloakSlot;
-				Server.ActivateEquip(iClientID, ActivateEq);
+				// the "off" state used to be re-broadcast here, it is now sent when
+				// the ship is created for an observer
+				++iOffStatesSaved;
 				break;
 
 			case STATE_CLOAK_CHARGING:
@@ -736,12 +824,10 @@ bool UserCmd_Disruptor(uint iClientID, const wstring &wscCmd, const wstring &wsc
 }
 
 
-typedef bool(*_UserCmdProc)(uint, const wstring &, const wstring &, const wchar_t*);
-
 struct USERCMD
 {
 	wchar_t *wszCmd;
-	_UserCmdProc proc;
+	USERCMD_CALLBACK proc;
 	wchar_t *usage;
 };
 
@@ -755,94 +841,60 @@ USERCMD UserCmds[] =
 };
 
 /**
-This function is called by FLHook when a user types a chat string. We look at the
-string they've typed and see if it starts with one of the above commands. If it
-does we try to process it.
+The commands are registered with FLHook's command router, which calls the command's
+function directly instead of offering every chat string to this plugin.
 */
-bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
+void RegisterUserCommands()
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	wstring wscCmdLineLower = ToLower(wscCmd);
-
-	// If the chat string does not match the USER_CMD then we do not handle the
-	// command, so let other plugins or FLHook kick in. We require an exact match
 	for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
-	{
-		if (wscCmdLineLower.find(UserCmds[i].wszCmd) == 0)
-		{
-			// Extract the parameters string from the chat string. It should
-			// be immediately after the command and a space.
-			wstring wscParam = L"";
-			if (wscCmd.length() > wcslen(UserCmds[i].wszCmd))
-			{
-				if (wscCmd[wcslen(UserCmds[i].wszCmd)] != ' ')
-					continue;
-				wscParam = wscCmd.substr(wcslen(UserCmds[i].wszCmd) + 1);
-			}
-
-			// Dispatch the command to the appropriate processing function.
-			if (UserCmds[i].proc(iClientID, wscCmd, wscParam, UserCmds[i].usage))
-			{
-				// We handled the command tell FL hook to stop processing this
-				// chat string.
-				returncode = SKIPPLUGINS_NOFUNCTIONCALL; // we handled the command, return immediatly
-				return true;
-			}
-		}
-	}
-	return false;
+		HkRegisterUserCommand(UserCmds[i].wszCmd, UserCmds[i].proc, UserCmds[i].usage);
 }
 
-#define IS_CMD(a) !wscCmd.compare(L##a)
-
-bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
+/** The admin commands are registered with FLHook, which checks RIGHT_CLOAK before calling them. */
+bool AdminCmd_Cloak(CCmds* cmds, const wstring &wscCmd)
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	if (IS_CMD("cloak"))
+	uint iClientID = HkGetClientIdFromCharname(cmds->GetAdminName());
+	
+	if (iClientID == -1)
 	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-
-		uint iClientID = HkGetClientIdFromCharname(cmds->GetAdminName());
-		
-		if (!(cmds->rights & RIGHT_CLOAK)) { cmds->Print(L"ERR No permission\n"); return true; }
-		
-		if (iClientID == -1)
-		{
-			cmds->Print(L"ERR On console");
-			return true;
-		}
-
-		uint iShip;
-		pub::Player::GetShip(iClientID, iShip);
-		if (!iShip)
-		{
-			PrintUserCmdText(iClientID, L"ERR Not in space");
-			return true;
-		}
+		cmds->Print(L"ERR On console");
+		return true;
+	}
 
-		if (!mapClientsCloak[iClientID].bCanCloak)
-		{
-			cmds->Print(L"ERR Cloaking device not available");
-			return true;
-		}
+	uint iShip;
+	pub::Player::GetShip(iClientID, iShip);
+	if (!iShip)
+	{
+		PrintUserCmdText(iClientID, L"ERR Not in space");
+		return true;
+	}
 
-		switch (mapClientsCloak[iClientID].iState)
-		{
-		case STATE_CLOAK_OFF:
-			mapClientsCloak[iClientID].bAdmin = true;
-			SetState(iClientID, iShip, STATE_CLOAK_ON);
-			break;
-		case STATE_CLOAK_CHARGING:
-		case STATE_CLOAK_ON:
-			mapClientsCloak[iClientID].bAdmin = true;
-			SetState(iClientID, iShip, STATE_CLOAK_OFF);
-			break;
-		}
+	if (!mapClientsCloak[iClientID].bCanCloak)
+	{
+		cmds->Print(L"ERR Cloaking device not available");
 		return true;
 	}
-	return false;
+
+	switch (mapClientsCloak[iClientID].iState)
+	{
+	case STATE_CLOAK_OFF:
+		mapClientsCloak[iClientID].bAdmin = true;
+		SetState(iClientID, iShip, STATE_CLOAK_ON);
+		break;
+	case STATE_CLOAK_CHARGING:
+	case STATE_CLOAK_ON:
+		mapClientsCloak[iClientID].bAdmin = true;
+		SetState(iClientID, iShip, STATE_CLOAK_OFF);
+		break;
+	}
+	return true;
+}
+
+bool AdminCmd_CloakStats(CCmds* cmds, const wstring &wscCmd)
+{
+	cmds->Print(L"offstates_sent=%u broadcasts_saved=%u\n", iOffStatesSent, iOffStatesSaved);
+	cmds->Print(L"OK\n");
+	return true;
 }
 
 void __stdcall HkCb_AddDmgEntry(DamageList *dmg, unsigned short p1, float& damage, enum DamageEntry::SubObjFate fate)
@@ -873,6 +925,7 @@ void __stdcall JumpInComplete_AFTER(unsigned int iSystem, unsigned int iShip)
 	returncode = DEFAULT_RETURNCODE;
 	uint iClientID = HkGetClientIDByShip(iShip);
 	setJumpingClients.erase(iClientID);
+	ForgetObserver(iClientID);
 
 	if (iClientID && mapClientsCloak[iClientID].iState == STATE_CLOAK_CHARGING)
 	{
@@ -945,13 +998,18 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ClearClientInfo, PLUGIN_ClearClientInfo, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&PlayerLaunch_AFTER, PLUGIN_HkIServerImpl_PlayerLaunch_AFTER, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&BaseEnter, PLUGIN_HkIServerImpl_BaseEnter, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkTimerCheckKick, PLUGIN_HkTimerCheckKick, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ExecuteCommandString_Callback, PLUGIN_ExecuteCommandString_Callback, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkCb_AddDmgEntry, PLUGIN_HkCb_AddDmgEntry, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&JumpInComplete_AFTER, PLUGIN_HkIServerImpl_JumpInComplete_AFTER, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&Dock_Call, PLUGIN_HkCb_Dock_Call, 0));
+	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&Send_FLPACKET_SERVER_CREATESHIP_AFTER, PLUGIN_HkIClientImpl_Send_FLPACKET_SERVER_CREATESHIP_AFTER, 0));
+	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&Send_FLPACKET_SERVER_DESTROYOBJECT, PLUGIN_HkIClientImpl_Send_FLPACKET_SERVER_DESTROYOBJECT, 0));
+
+	HkRegisterAdminCommand(L"cloak", RIGHT_CLOAK, AdminCmd_Cloak);
+	HkRegisterAdminCommand(L"cloakstats", RIGHT_CLOAK, AdminCmd_CloakStats);
+
+	RegisterUserCommands();
 
+	HkScheduleTimer(250, 1000, CloakTimer);
 
 	return p_PI;
 }
@@ -209,74 +209,68 @@ bool CheckReturnDock(unsigned int client, unsigned int target)
 	return false;
 }
 
-bool UserCmd_Process(uint client, const wstring &cmd)
+bool UserCmd_Conn(uint client, const wstring &wscCmd, const wstring &wscParam, const wchar_t *usage)
 {
-	returncode = DEFAULT_RETURNCODE;
+	// Prohibit jump if in a restricted system or in the target system
+	uint system = 0;
+	pub::Player::GetSystem(client, system);
+	if (find(set_lRestrictedSystemIDs.begin(), set_lRestrictedSystemIDs.end(), system) != set_lRestrictedSystemIDs.end()
+		|| system == set_iTargetSystemID
+		|| GetCustomBaseForClient(client))
+	{
+		PrintUserCmdText(client, L"ERR Cannot use command in this system or base");
+		return true;
+	}
 
-	if (!cmd.compare(L"/conn"))
+	if (!IsDockedClient(client))
 	{
-		// Prohibit jump if in a restricted system or in the target system
-		uint system = 0;
-		pub::Player::GetSystem(client, system);
-		if (find(set_lRestrictedSystemIDs.begin(), set_lRestrictedSystemIDs.end(), system) != set_lRestrictedSystemIDs.end()
-			|| system == set_iTargetSystemID
-			|| GetCustomBaseForClient(client))
-		{
-			PrintUserCmdText(client, L"ERR Cannot use command in this system or base");
-			return true;
-		}
+		PrintUserCmdText(client, STR_INFO1);
+		return true;
+	}
 
-		if (!IsDockedClient(client))
-		{
-			PrintUserCmdText(client, STR_INFO1);
-			return true;
-		}
+	if (!ValidateCargo(client))
+	{
+		PrintUserCmdText(client, STR_INFO2);
+		return true;
+	}
 
-		if (!ValidateCargo(client))
-		{
-			PrintUserCmdText(client, STR_INFO2);
-			return true;
-		}
+	StoreReturnPointForClient(client);
+	PrintUserCmdText(client, L"Redirecting undock to Connecticut.");
+	transferFlags[client] = CLIENT_STATE_TRANSFER;
 
-		StoreReturnPointForClient(client);
-		PrintUserCmdText(client, L"Redirecting undock to Connecticut.");
-		transferFlags[client] = CLIENT_STATE_TRANSFER;
+	return true;
+}
 
+bool UserCmd_Return(uint client, const wstring &wscCmd, const wstring &wscParam, const wchar_t *usage)
+{
+	if (!ReadReturnPointForClient(client))
+	{
+		PrintUserCmdText(client, L"No return possible");
 		return true;
 	}
-	else if (!cmd.compare(L"/return"))
-	{
-		if (!ReadReturnPointForClient(client))
-		{
-			PrintUserCmdText(client, L"No return possible");
-			return true;
-		}
-
-		if (!IsDockedClient(client))
-		{
-			PrintUserCmdText(client, STR_INFO1);
-			return true;
-		}
-
-		if (!CheckReturnDock(client, set_iTargetBaseID))
-		{
-			PrintUserCmdText(client, L"Not in correct base");
-			return true;
-		}
 
-		if (!ValidateCargo(client))
-		{
-			PrintUserCmdText(client, STR_INFO2);
-			return true;
-		}
+	if (!IsDockedClient(client))
+	{
+		PrintUserCmdText(client, STR_INFO1);
+		return true;
+	}
 
-		PrintUserCmdText(client, L"Redirecting undock to previous base");
-		transferFlags[client] = CLIENT_STATE_RETURN;
+	if (!CheckReturnDock(client, set_iTargetBaseID))
+	{
+		PrintUserCmdText(client, L"Not in correct base");
+		return true;
+	}
 
+	if (!ValidateCargo(client))
+	{
+		PrintUserCmdText(client, STR_INFO2);
 		return true;
 	}
 
-	return false;
+	PrintUserCmdText(client, L"Redirecting undock to previous base");
+	transferFlags[client] = CLIENT_STATE_RETURN;
+
+	return true;
 }
 
 void __stdcall CharacterSelect(struct CHARACTER_ID const &charid, unsigned int client)
@@ -336,6 +330,8 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ClearClientInfo, PLUGIN_ClearClientInfo, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&CharacterSelect, PLUGIN_HkIServerImpl_CharacterSelect, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&PlayerLaunch_AFTER, PLUGIN_HkIServerImpl_PlayerLaunch_AFTER, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
+
+	HkRegisterUserCommand(L"/conn", UserCmd_Conn);
+	HkRegisterUserCommand(L"/return", UserCmd_Return);
 	return p_PI;
 }
\ No newline at end of file
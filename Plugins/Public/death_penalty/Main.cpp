@@ -237,7 +237,7 @@ void __stdcall ShipDestroyed(DamageList* dmg, const DWORD* ecx, uint iKill)
 		uint iKillerId = 0;
 		if (client)
 		{
-			uint lastInflictorId = dmg->get_cause() == 0 ? ClientInfo[client].dmgLast.get_inflictor_id() : dmg->get_inflictor_id();
+			uint lastInflictorId = dmg->get_cause() == 0 ? ClientInfo[client].dmgLast.iInflictorShip : dmg->get_inflictor_id();
 			if (lastInflictorId)
 			{
 				iKillerId = lastInflictorId;
@@ -269,13 +269,13 @@ void SaveDPNoticeToCharFile(uint client, std::string value)
 /** @ingroup DeathPenalty
  * @brief /dp command. Shows information about death penalty
  */
-void UserCmd_DP(uint client, const std::wstring& wscParam)
+bool UserCmd_DP(uint client, const std::wstring& wscCmd, const std::wstring& wscParam, const wchar_t* usage)
 {
 	// If there is no death penalty, no point in having death penalty commands
 	if (std::abs(DeathPenaltyFraction) < 0.0001f)
 	{
 		ConPrint(L"DP Plugin active, but no/too low death penalty fraction is set.");
-		return;
+		return true;
 	}
 
 	if (wscParam.length()) // Arguments passed
@@ -319,14 +319,6 @@ void UserCmd_DP(uint client, const std::wstring& wscParam)
 			    L"because you are in a specific system.");
 		}
 	}
-}
-
-bool UserCmd_Process(uint client, const std::wstring& wscParam)
-{
-	if (wscParam.find(L"/dp") == 0)
-	{
-		UserCmd_DP(client, GetParamToEnd(wscParam, ' ', 1));
-	}
 	return true;
 }
 
@@ -345,7 +337,7 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&LoadUserCharSettings, PLUGIN_LoadUserCharSettings, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ClearClientInfo, PLUGIN_ClearClientInfo, 0));
 
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
+	HkRegisterUserCommand(L"/dp", UserCmd_DP);
 
 	return p_PI;
 }
\ No newline at end of file
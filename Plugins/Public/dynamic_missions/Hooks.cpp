@@ -246,55 +246,32 @@ HK_ERROR HkTest2(uint iTest)
 	return HKE_OK;
 }
 
-void CmdTest(CCmds* classptr, uint iTest)
+bool CmdTest(CCmds* classptr, const wstring& wscCmd)
 {
+	uint iTest = classptr->ArgInt(1);
 
 	// right check
-	if(classptr->rights != RIGHT_SUPERADMIN) { classptr->Print(L"ERR No permission\n"); return;}
+	if(classptr->rights != RIGHT_SUPERADMIN) { classptr->Print(L"ERR No permission\n"); return true;}
 
 	if(((classptr->hkLastErr = HkTest(iTest)) == HKE_OK)) // hksuccess 
 		classptr->Print(L"OK\n");
 	else
 		classptr->PrintError();
+	return true;
 }
 
-void CmdTest2(CCmds* classptr, uint iTest)
+bool CmdTest2(CCmds* classptr, const wstring& wscCmd)
 {
+	uint iTest = classptr->ArgInt(1);
 
 	// right check
-	if(classptr->rights != RIGHT_SUPERADMIN) { classptr->Print(L"ERR No permission\n"); return;}
+	if(classptr->rights != RIGHT_SUPERADMIN) { classptr->Print(L"ERR No permission\n"); return true;}
 
 	if(((classptr->hkLastErr = HkTest2(iTest)) == HKE_OK)) // hksuccess 
 		classptr->Print(L"OK\n");
 	else
 		classptr->PrintError();
-}
-
-#define IS_CMD(a) !wscCmd.compare(L##a)
-
-EXPORT bool ExecuteCommandString_Callback(CCmds* classptr, const wstring& wscCmd)
-{
-	returncode = NOFUNCTIONCALL;  // flhook needs to care about our return code
-
-	if(IS_CMD("startmission")) {
-
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL; // do not let other plugins kick in since we now handle the command
-
-		CmdTest(classptr, classptr->ArgInt(1));
-
-		return true;
-	}
-
-	if(IS_CMD("endmission")) {
-
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL; // do not let other plugins kick in since we now handle the command
-
-		CmdTest2(classptr, classptr->ArgInt(1));
-
-		return true;
-	}
-
-    return false;
+	return true;
 }
 
 EXPORT void CmdHelp_Callback(CCmds* classptr)
@@ -318,7 +295,9 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&LoadSettings, PLUGIN_LoadSettings, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkIEngine::CShip_init, PLUGIN_HkIEngine_CShip_init, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkIEngine::CShip_destroy, PLUGIN_HkIEngine_CShip_destroy, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ExecuteCommandString_Callback, PLUGIN_ExecuteCommandString_Callback, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&CmdHelp_Callback, PLUGIN_CmdHelp_Callback, 0));
+
+	HkRegisterAdminCommand(L"startmission", 0, CmdTest);
+	HkRegisterAdminCommand(L"endmission", 0, CmdTest2);
 	return p_PI;
 }
@@ -563,8 +563,6 @@ void LoadSettings()
 //Functions
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-FILE *Logfile = fopen("./flhook_logs/event_log.log", "at");
-
 void Logging(const char *szString, ...)
 {
 	char szBufString[1024];
@@ -572,14 +570,10 @@ void Logging(const char *szString, ...)
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
 
-	char szBuf[64];
-	time_t tNow = time(0);
-	struct tm *t = localtime(&tNow);
-	strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-	fprintf(Logfile, "%s %s\n", szBuf, szBufString);
-	fflush(Logfile);
-	fclose(Logfile);
-	Logfile = fopen("./flhook_logs/event_log.log", "at");
+	static uint iLogID = 0;
+	if (!iLogID)
+		iLogID = HkLogOpen("./flhook_logs/event_log.log", 0, LOG_STAMP_PLUGIN);
+	HkLogWrite(iLogID, "%s", szBufString);
 }
 
 void Notify_TradeEvent_Start(uint iClientID, string eventname)
@@ -44,9 +44,9 @@ std::wstring deathDamageTemplate = L"{0} took most hull damage from {1}, {2}%";
 /** @ingroup KillTracker
  * @brief Called when a player types "/kills".
  */
-void UserCmd_Kills(uint client, const std::wstring& wscParam)
+bool UserCmd_Kills(uint client, const std::wstring& wscCmd, const std::wstring& wscParam, const wchar_t* usage)
 {
-	std::wstring targetCharName = GetParam(wscParam, ' ', 1);
+	std::wstring targetCharName = GetParam(wscParam, ' ', 0);
 	uint clientId;
 
 	if (!targetCharName.empty())
@@ -55,7 +55,7 @@ void UserCmd_Kills(uint client, const std::wstring& wscParam)
 		if (!clientId)
 		{
 			PrintUserCmdText(client, L"Player not found");
-			return;
+			return true;
 		}
 	}
 	else
@@ -68,17 +68,7 @@ void UserCmd_Kills(uint client, const std::wstring& wscParam)
 	pub::Player::GetRank(clientId, rank);
 	PrintUserCmdText(client, L"PvP kills: %u", kills);
 	PrintUserCmdText(client, L"Level: %u", rank);
-}
-
-uint GetClientIdByShip(uint shipId)
-{
-	PlayerData* pd = nullptr;
-	while (pd = Players.traverse_active(pd))
-	{
-		if (pd->iShipID == shipId)
-			return pd->iOnlineID;
-	}
-	return 0;
+	return true;
 }
 
 /** @ingroup KillTracker
@@ -93,8 +83,8 @@ void __stdcall ShipDestroyed(DamageList* dmg, DWORD* ecx, uint kill)
 
 		if (uint client = cShip->GetOwnerPlayer())
 		{
-			uint lastInflictorId = dmg->get_cause() == 0 ? ClientInfo[client].dmgLast.get_inflictor_id() : dmg->get_inflictor_id();
-			uint killerId = GetClientIdByShip(lastInflictorId);
+			uint lastInflictorId = dmg->get_cause() == 0 ? ClientInfo[client].dmgLast.iInflictorShip : dmg->get_inflictor_id();
+			uint killerId = HkGetClientIDByShip(lastInflictorId);
 
 			if (killerId && killerId != client)
 			{
@@ -200,19 +190,6 @@ void __stdcall CharacterSelect(CHARACTER_ID const& cid, uint client)
 	clearDamageDone(client);
 }
 
-
-bool UserCmd_Process(uint client, const wstring &wscCmd)
-{
-	returncode = DEFAULT_RETURNCODE;
-
-	if (wscCmd.find(L"/kills") == 0)
-	{
-		UserCmd_Kills(client, wscCmd);
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-	}
-	return true;
-}
-
 // Load Settings
 void __stdcall LoadSettings()
 {
@@ -231,7 +208,6 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->bMayUnload = true;
 	p_PI->ePluginReturnCode = &returncode;
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&LoadSettings, PLUGIN_LoadSettings, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ShipDestroyed, PLUGIN_ShipDestroyed, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&AddDamageEntry, PLUGIN_HkCb_AddDmgEntry_AFTER, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&SendDeathMessage, PLUGIN_SendDeathMsg, 0));
@@ -239,5 +215,7 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&PlayerLaunch, PLUGIN_HkIServerImpl_PlayerLaunch, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&CharacterSelect, PLUGIN_HkIServerImpl_CharacterSelect, 0));
 
+	HkRegisterUserCommand(L"/kills", UserCmd_Kills);
+
 	return p_PI;
 }
\ No newline at end of file
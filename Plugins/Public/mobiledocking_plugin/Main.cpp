@@ -521,147 +521,173 @@ void __stdcall ShipDestroyed(DamageList *_dmg, DWORD *ecx, uint kill)
 }
 
 
-bool UserCmd_Process(uint client, const wstring &wscCmd)
+bool UserCmd_ListDocked(uint client, const wstring &wscCmd, const wstring &wscParam, const wchar_t *usage)
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	if (wscCmd.find(L"/listdocked") == 0)
+	if (mobiledockClients[client].mapDockedShips.empty())
 	{
-		if (mobiledockClients[client].mapDockedShips.empty())
-		{
-			PrintUserCmdText(client, L"No ships currently docked");
-		}
-		else
+		PrintUserCmdText(client, L"No ships currently docked");
+	}
+	else
+	{
+		PrintUserCmdText(client, L"Docked ships:");
+		for (map<wstring, wstring>::iterator i = mobiledockClients[client].mapDockedShips.begin();
+			i != mobiledockClients[client].mapDockedShips.end(); ++i)
 		{
-			PrintUserCmdText(client, L"Docked ships:");
-			for (map<wstring, wstring>::iterator i = mobiledockClients[client].mapDockedShips.begin();
-				i != mobiledockClients[client].mapDockedShips.end(); ++i)
-			{
-				PrintUserCmdText(client, i->first);
-			}
+			PrintUserCmdText(client, i->first);
 		}
+	}
+	return true;
+}
+
+bool UserCmd_JettisonShip(uint client, const wstring &wscCmd, const wstring &wscParam, const wchar_t *usage)
+{
+	// Get the supposed ship we should be ejecting from the command parameters
+	wstring charname = Trim(GetParam(wscCmd, ' ', 1));
+	if (charname.empty())
+	{
+		PrintUserCmdText(client, L"Usage: /jettisonship <charname>");
 		return true;
 	}
-	else if (wscCmd.find(L"/conn") == 0 || wscCmd.find(L"/return") == 0)
+
+	// Only allow jettisonning a ship if the carrier is undocked
+	uint carrierShip;
+	pub::Player::GetShip(client, carrierShip);
+	if (!carrierShip)
 	{
-		// This plugin always runs before the Conn Plugin runs it's /conn function. Verify that there are no docked ships.
-		if (!mobiledockClients[client].mapDockedShips.empty())
-		{
-			PrintUserCmdText(client, L"You cannot use this command if you have vessels docked with you!");
-			returncode = SKIPPLUGINS;
-			return true;
-		}
+		PrintUserCmdText(client, L"You can only jettison a vessel if you are in space.");
+		return true;
 	}
-	else if (wscCmd.find(L"/jettisonship") == 0)
+
+
+	// Check to see if the user listed is actually docked with the carrier at the moment
+	if (mobiledockClients[client].mapDockedShips.find(charname) == mobiledockClients[client].mapDockedShips.end())
 	{
-		// Get the supposed ship we should be ejecting from the command parameters
-		wstring charname = Trim(GetParam(wscCmd, ' ', 1));
-		if (charname.empty())
-		{
-			PrintUserCmdText(client, L"Usage: /jettisonship <charname>");
-			return true;
-		}
+		PrintUserCmdText(client, L"%s is not docked with you!", charname);
+		return true;
+	}
 
-		// Only allow jettisonning a ship if the carrier is undocked
-		uint carrierShip;
-		pub::Player::GetShip(client, carrierShip);
-		if (!carrierShip)
-		{
-			PrintUserCmdText(client, L"You can only jettison a vessel if you are in space.");
-			return true;
-		}
+	// The player exists. Remove him from the docked list, and kick him into space
+	const uint iDockedClientID = HkGetClientIdFromCharname(charname);
+	if (iDockedClientID != -1)
+	{
+		// Update the client with the current carrier location
+		UpdateCarrierLocationInformation(iDockedClientID, carrierShip);
 
+		// Force the docked ship to launch. The teleport coordinates have been set by the previous method
+		JettisonShip(client, iDockedClientID);
+	}
 
-		// Check to see if the user listed is actually docked with the carrier at the moment
-		if (mobiledockClients[client].mapDockedShips.find(charname) == mobiledockClients[client].mapDockedShips.end())
-		{
-			PrintUserCmdText(client, L"%s is not docked with you!", charname);
-			return true;
-		}
+	return true;
+}
 
-		// The player exists. Remove him from the docked list, and kick him into space
-		const uint iDockedClientID = HkGetClientIdFromCharname(charname);
-		if (iDockedClientID != -1)
-		{
-			// Update the client with the current carrier location
-			UpdateCarrierLocationInformation(iDockedClientID, carrierShip);
+bool UserCmd_AllowDock(uint client, const wstring &wscCmd, const wstring &wscParam, const wchar_t *usage)
+{
+	//If we're not in space, then ignore the request
+	uint iShip;
+	pub::Player::GetShip(client, iShip);
+	if (!iShip)
+		return true;
 
-			// Force the docked ship to launch. The teleport coordinates have been set by the previous method
-			JettisonShip(client, iDockedClientID);
-		}
+	//If there is no ship currently targeted, then ignore the request
+	uint iTargetShip;
+	pub::SpaceObj::GetTarget(iShip, iTargetShip);
+	if (!iTargetShip)
+		return true;
 
+	// If the target is not a player ship, or if the ship is too far away, ignore
+	const uint iTargetClientID = HkGetClientIDByShip(iTargetShip);
+	if (!iTargetClientID || HkDistance3DByShip(iShip, iTargetShip) > 1000.0f)
+	{
+		PrintUserCmdText(client, L"Ship is out of range");
 		return true;
+	}
 
+	// Find the docking request. If none, ignore.
+	if (mapPendingDockingRequests.find(iTargetClientID) == mapPendingDockingRequests.end())
+	{
+		PrintUserCmdText(client, L"No pending docking requests for this ship");
+		return true;
 	}
-	else if (wscCmd.find(L"/allowdock") == 0)
+
+	// Check that there is an empty docking module
+	if (mobiledockClients[client].iDockingModulesAvailable <= 0)
 	{
-		//If we're not in space, then ignore the request
-		uint iShip;
-		pub::Player::GetShip(client, iShip);
-		if (!iShip)
-			return true;
+		mapPendingDockingRequests.erase(iTargetClientID);
+		PrintUserCmdText(client, L"No free docking modules available.");
+		return true;
+	}
 
-		//If there is no ship currently targeted, then ignore the request
-		uint iTargetShip;
-		pub::SpaceObj::GetTarget(iShip, iTargetShip);
-		if (!iTargetShip)
-			return true;
+	// The client is free to dock, erase from the pending list and handle
+	mapPendingDockingRequests.erase(iTargetClientID);
 
-		// If the target is not a player ship, or if the ship is too far away, ignore
-		const uint iTargetClientID = HkGetClientIDByShip(iTargetShip);
-		if (!iTargetClientID || HkDistance3DByShip(iShip, iTargetShip) > 1000.0f)
-		{
-			PrintUserCmdText(client, L"Ship is out of range");
-			return true;
-		}
+	string scProxyBase = HkGetPlayerSystemS(client) + "_proxy_base";
+	uint iBaseID;
+	if (pub::GetBaseID(iBaseID, scProxyBase.c_str()) == -4)
+	{
+		PrintUserCmdText(client, L"No proxy base in system detected. Contact a developer about this please. Required base: %s", scProxyBase);
+		return true;
+	}
 
-		// Find the docking request. If none, ignore.
-		if (mapPendingDockingRequests.find(iTargetClientID) == mapPendingDockingRequests.end())
-		{
-			PrintUserCmdText(client, L"No pending docking requests for this ship");
-			return true;
-		}
+	// Save the carrier info
+	wstring charname = (const wchar_t*)Players.GetActiveCharacterName(iTargetClientID);
+	mobiledockClients[client].mapDockedShips[charname] = charname;
+	pub::SpaceObj::GetSystem(iShip, mobiledockClients[client].carrierSystem);
+	if (mobiledockClients[client].iLastBaseID != 0)
+		mobiledockClients[client].iLastBaseID = Players[client].iLastBaseID;
 
-		// Check that there is an empty docking module
-		if (mobiledockClients[client].iDockingModulesAvailable <= 0)
-		{
-			mapPendingDockingRequests.erase(iTargetClientID);
-			PrintUserCmdText(client, L"No free docking modules available.");
-			return true;
-		}
+	// Save the docking ship info
+	mobiledockClients[iTargetClientID].mobileDocked = true;
+	mobiledockClients[iTargetClientID].wscDockedWithCharname = (const wchar_t*)Players.GetActiveCharacterName(client);
+	mobiledockClients[iTargetClientID].iLastBaseID = Players[iTargetClientID].iLastBaseID;
+	mobiledockClients[iTargetClientID].proxyBaseID = iBaseID;
+	pub::SpaceObj::GetSystem(iShip, mobiledockClients[iTargetClientID].carrierSystem);
 
-		// The client is free to dock, erase from the pending list and handle
-		mapPendingDockingRequests.erase(iTargetClientID);
+	mobiledockClients[client].iDockingModulesAvailable--;
 
-		string scProxyBase = HkGetPlayerSystemS(client) + "_proxy_base";
-		uint iBaseID;
-		if (pub::GetBaseID(iBaseID, scProxyBase.c_str()) == -4)
-		{
-			PrintUserCmdText(client, L"No proxy base in system detected. Contact a developer about this please. Required base: %s", scProxyBase);
-			return true;
-		}
+	// Land the ship on the proxy base
+	pub::Player::ForceLand(iTargetClientID, iBaseID);
+	PrintUserCmdText(client, L"Ship docked");
 
-		// Save the carrier info
-		wstring charname = (const wchar_t*)Players.GetActiveCharacterName(iTargetClientID);
-		mobiledockClients[client].mapDockedShips[charname] = charname;
-		pub::SpaceObj::GetSystem(iShip, mobiledockClients[client].carrierSystem);
-		if (mobiledockClients[client].iLastBaseID != 0)
-			mobiledockClients[client].iLastBaseID = Players[client].iLastBaseID;
+	return true;
+}
 
-		// Save the docking ship info
-		mobiledockClients[iTargetClientID].mobileDocked = true;
-		mobiledockClients[iTargetClientID].wscDockedWithCharname = (const wchar_t*)Players.GetActiveCharacterName(client);
-		mobiledockClients[iTargetClientID].iLastBaseID = Players[iTargetClientID].iLastBaseID;
-		mobiledockClients[iTargetClientID].proxyBaseID = iBaseID;
-		pub::SpaceObj::GetSystem(iShip, mobiledockClients[iTargetClientID].carrierSystem);
+struct USERCMD
+{
+	wchar_t *wszCmd;
+	USERCMD_CALLBACK proc;
+};
 
-		mobiledockClients[client].iDockingModulesAvailable--;
+USERCMD UserCmds[] =
+{
+	{ L"/listdocked", UserCmd_ListDocked },
+	{ L"/jettisonship", UserCmd_JettisonShip },
+	{ L"/allowdock", UserCmd_AllowDock },
+};
+
+/*
+The commands are registered with FLHook's command router, which calls the command's
+function directly instead of offering every chat string to this plugin.
+*/
+void RegisterUserCommands()
+{
+	for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
+		HkRegisterUserCommand(UserCmds[i].wszCmd, UserCmds[i].proc);
+}
 
-		// Land the ship on the proxy base
-		pub::Player::ForceLand(iTargetClientID, iBaseID);
-		PrintUserCmdText(client, L"Ship docked");
+// /conn and /return belong to the conn plugin, this hook only stops them while ships are docked.
+bool UserCmd_Process(uint client, const wstring &wscCmd)
+{
+	returncode = DEFAULT_RETURNCODE;
 
-		return true;
+	if (wscCmd.find(L"/conn") == 0 || wscCmd.find(L"/return") == 0)
+	{
+		// This plugin always runs before the Conn Plugin runs it's /conn function. Verify that there are no docked ships.
+		if (!mobiledockClients[client].mapDockedShips.empty())
+		{
+			PrintUserCmdText(client, L"You cannot use this command if you have vessels docked with you!");
+			returncode = SKIPPLUGINS_NOFUNCTIONCALL;
+			return true;
+		}
 	}
 	return false;
 }
@@ -701,192 +727,183 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 	return true;
 }
 
-#define IS_CMD(a) !wscCmd.compare(L##a)
-
-bool ExecuteCommandString_Callback(CCmds* classptr, const wstring &wscCmd)
+bool AdminCmd_LogActivity(CCmds* classptr, const wstring &wscCmd)
 {
-	returncode = DEFAULT_RETURNCODE;
+	// Log current time in file name.
+	std::time_t rawtime;
+	std::tm* timeinfo;
+	char buffer[80];
 
-	if (IS_CMD("logactivity"))
-	{
-		// Log current time in file name.
-		std::time_t rawtime;
-		std::tm* timeinfo;
-		char buffer[80];
+	std::time(&rawtime);
+	timeinfo = std::localtime(&rawtime);
 
-		std::time(&rawtime);
-		timeinfo = std::localtime(&rawtime);
+	std::strftime(buffer, 80, "[%Y-%m-%d]%H-%M-%S", timeinfo);
 
-		std::strftime(buffer, 80, "[%Y-%m-%d]%H-%M-%S", timeinfo);
+	string path = "./flhook_logs/logactivity " + string(buffer) + ".log";
 
-		string path = "./flhook_logs/logactivity " + string(buffer) + ".log";
+	// Lines list to add in new file.
+	vector<string> Lines;
 
-		// Lines list to add in new file.
-		vector<string> Lines;
+	Lines.push_back("DOCK: mobiledockClients | Size = " + to_string(mobiledockClients.size()));
 
-		Lines.push_back("DOCK: mobiledockClients | Size = " + to_string(mobiledockClients.size()));
+	vector<wstring> DOCKcharnames;
+	for (map<uint, CLIENT_DATA>::iterator it = mobiledockClients.begin(); it != mobiledockClients.end(); ++it)
+	{
+		wstring charname;
 
-		vector<wstring> DOCKcharnames;
-		for (map<uint, CLIENT_DATA>::iterator it = mobiledockClients.begin(); it != mobiledockClients.end(); ++it)
+		try
+		{
+			charname = (const wchar_t*)Players.GetActiveCharacterName(it->first);
+		}
+		catch (...)
 		{
-			wstring charname;
+			charname = L"<Error>";
+		}
 
-			try
-			{
-				charname = (const wchar_t*)Players.GetActiveCharacterName(it->first);
-			}
-			catch (...)
+		string ID = to_string(it->first);
+		string Charname = wstos(charname);
+		string Type = it->second.iDockingModulesInstalled == 0 ? "Docked" : "Carrier";
+		if (Type == "Carrier")
+		{
+			wstring docked = L"";
+			for (map<wstring, wstring>::iterator cit = it->second.mapDockedShips.begin(); cit != it->second.mapDockedShips.end(); cit++)
 			{
-				charname = L"<Error>";
+				if (docked != L"")
+					docked += L" | ";
+				docked += cit->first;
 			}
 
-			string ID = to_string(it->first);
-			string Charname = wstos(charname);
-			string Type = it->second.iDockingModulesInstalled == 0 ? "Docked" : "Carrier";
-			if (Type == "Carrier")
-			{
-				wstring docked = L"";
-				for (map<wstring, wstring>::iterator cit = it->second.mapDockedShips.begin(); cit != it->second.mapDockedShips.end(); cit++)
-				{
-					if (docked != L"")
-						docked += L" | ";
-					docked += cit->first;
-				}
+			Type += "[" + to_string(it->second.iDockingModulesInstalled) + "](" + wstos(docked) + ")";
+		}
+		else
+		{
 
-				Type += "[" + to_string(it->second.iDockingModulesInstalled) + "](" + wstos(docked) + ")";
-			}
-			else
+			if (it->second.wscDockedWithCharname.empty())
 			{
-
-				if (it->second.wscDockedWithCharname.empty())
-				{
-					if (!it->second.mobileDocked)
-						continue;
-					Type += "[" + wstos(L"<Error>") + "]";
-				}
-				else
-					Type += "[" + wstos(it->second.wscDockedWithCharname) + "]";
+				if (!it->second.mobileDocked)
+					continue;
+				Type += "[" + wstos(L"<Error>") + "]";
 			}
-			string State = "";
+			else
+				Type += "[" + wstos(it->second.wscDockedWithCharname) + "]";
+		}
+		string State = "";
 
-			if (it->first == 0 || it->first > MAX_CLIENT_ID)
-				State += "Out of range";
+		if (it->first == 0 || it->first > MAX_CLIENT_ID)
+			State += "Out of range";
 
-			if (find(DOCKcharnames.begin(), DOCKcharnames.end(), charname) != DOCKcharnames.end())
-			{
-				if (State != "")
-					State += " | ";
-				State += "Doubled";
-			}
+		if (find(DOCKcharnames.begin(), DOCKcharnames.end(), charname) != DOCKcharnames.end())
+		{
+			if (State != "")
+				State += " | ";
+			State += "Doubled";
+		}
 
-			if (State == "")
-				State = "Fine";
+		if (State == "")
+			State = "Fine";
 
-			if (charname != L"<Error>")
-				DOCKcharnames.push_back(charname);
+		if (charname != L"<Error>")
+			DOCKcharnames.push_back(charname);
 
-			Lines.push_back(ID + " " + Charname + " " + Type + " " + State);
-		}
+		Lines.push_back(ID + " " + Charname + " " + Type + " " + State);
+	}
 
-		Lines.push_back("");
+	Lines.push_back("");
 
 
-		vector<string> SERVERlines;
+	vector<string> SERVERlines;
 
-		vector<wstring> SERVERcharnames;
-		vector<uint> IDs;
-		struct PlayerData *pPD = 0;
-		while (pPD = Players.traverse_active(pPD))
+	vector<wstring> SERVERcharnames;
+	vector<uint> IDs;
+	struct PlayerData *pPD = 0;
+	while (pPD = Players.traverse_active(pPD))
+	{
+		uint clientID;
+		try
 		{
-			uint clientID;
-			try
-			{
-				clientID = HkGetClientIdFromPD(pPD);
-			}
-			catch (...)
-			{
-				clientID = 0;
-			}
+			clientID = HkGetClientIdFromPD(pPD);
+		}
+		catch (...)
+		{
+			clientID = 0;
+		}
 
-			string ID;
+		string ID;
 
-			if (clientID == 0)
-				ID = "<Error>";
-			else
-				ID = to_string(clientID);
+		if (clientID == 0)
+			ID = "<Error>";
+		else
+			ID = to_string(clientID);
 
-			wstring charname;
-			wstring wscIP;
+		wstring charname;
+		wstring wscIP;
 
-			try
-			{
-				charname = (const wchar_t*)Players.GetActiveCharacterName(clientID);
-			}
-			catch (...)
-			{
-				charname = L"<NotLogged>";
-			}
+		try
+		{
+			charname = (const wchar_t*)Players.GetActiveCharacterName(clientID);
+		}
+		catch (...)
+		{
+			charname = L"<NotLogged>";
+		}
 
-			try
-			{
-				HkGetPlayerIP(clientID, wscIP);
-			}
-			catch (...)
-			{
-				wscIP = L"<Error>";
-			}
+		try
+		{
+			HkGetPlayerIP(clientID, wscIP);
+		}
+		catch (...)
+		{
+			wscIP = L"<Error>";
+		}
 
-			string Charname = wstos(charname);
-			string State = "";
+		string Charname = wstos(charname);
+		string State = "";
 
-			if (clientID > MAX_CLIENT_ID)
-				State += "Out of range";
+		if (clientID > MAX_CLIENT_ID)
+			State += "Out of range";
 
 
-			if (find(SERVERcharnames.begin(), SERVERcharnames.end(), charname) != SERVERcharnames.end())
-			{
-				if (State != "")
-					State += " | ";
-				State += "DoubledName";
-			}
+		if (find(SERVERcharnames.begin(), SERVERcharnames.end(), charname) != SERVERcharnames.end())
+		{
+			if (State != "")
+				State += " | ";
+			State += "DoubledName";
+		}
 
-			if (find(IDs.begin(), IDs.end(), clientID) != IDs.end())
-			{
-				if (State != "")
-					State += " | ";
-				State += "DoubledID";
-			}
+		if (find(IDs.begin(), IDs.end(), clientID) != IDs.end())
+		{
+			if (State != "")
+				State += " | ";
+			State += "DoubledID";
+		}
 
-			if (State == "")
-				State = "Fine";
+		if (State == "")
+			State = "Fine";
 
-			if (charname != L"<NotLogged>")
-				SERVERcharnames.push_back(charname);
-			IDs.push_back(clientID);
+		if (charname != L"<NotLogged>")
+			SERVERcharnames.push_back(charname);
+		IDs.push_back(clientID);
 
-			SERVERlines.push_back(ID + " " + Charname + " " + wstos(wscIP) + " " + State);
-		}
+		SERVERlines.push_back(ID + " " + Charname + " " + wstos(wscIP) + " " + State);
+	}
 
-		Lines.push_back("SERVER: PlayersDB | Size = " + to_string(SERVERlines.size()));
-		Lines.insert(Lines.end(), SERVERlines.begin(), SERVERlines.end());
+	Lines.push_back("SERVER: PlayersDB | Size = " + to_string(SERVERlines.size()));
+	Lines.insert(Lines.end(), SERVERlines.begin(), SERVERlines.end());
 
-		// Create new file.
-		FILE *newfile = fopen(path.c_str(), "w");
-		if (newfile)
+	// Create new file.
+	FILE *newfile = fopen(path.c_str(), "w");
+	if (newfile)
+	{
+		for (vector<string>::iterator it = Lines.begin(); it != Lines.end(); ++it)
 		{
-			for (vector<string>::iterator it = Lines.begin(); it != Lines.end(); ++it)
-			{
-				fprintf(newfile, (*it + "\n").c_str());
-			}
-
-			fclose(newfile);
+			fprintf(newfile, (*it + "\n").c_str());
 		}
 
-		ConPrint(L"Saved to: " + stows(path) + L"\n");
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		return true;
+		fclose(newfile);
 	}
-	return false;
+
+	ConPrint(L"Saved to: " + stows(path) + L"\n");
+	return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -906,7 +923,6 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->bMayPause = true;
 	p_PI->bMayUnload = true;
 	p_PI->ePluginReturnCode = &returncode;
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ExecuteCommandString_Callback, PLUGIN_ExecuteCommandString_Callback, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&LoadSettings, PLUGIN_LoadSettings, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&PlayerLaunch_AFTER, PLUGIN_HkIServerImpl_PlayerLaunch_AFTER, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&CharacterSelect_AFTER, PLUGIN_HkIServerImpl_CharacterSelect_AFTER, 0));
@@ -922,5 +938,7 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&DisConnect, PLUGIN_HkIServerImpl_DisConnect, 0));
 
+	HkRegisterAdminCommand(L"logactivity", 0, AdminCmd_LogActivity);
+	RegisterUserCommands();
 	return p_PI;
 }
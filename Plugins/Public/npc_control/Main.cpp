@@ -26,7 +26,6 @@
 #include <sstream>
 #include <iostream>
 
-#define RIGHT_CHECK(a) if(!(cmds->rights & a)) { cmds->Print(L"ERR No permission\n"); return; }
 static int set_iPluginDebug = 0;
 
 /// A return code to indicate to FLHook if we want the hook processing to continue.
@@ -382,8 +381,6 @@ void LoadSettings()
 
 
 
-FILE *Logfile = fopen("./flhook_logs/npc_log.log", "at");
-
 void Logging(const char *szString, ...)
 {
 	char szBufString[1024];
@@ -391,14 +388,10 @@ void Logging(const char *szString, ...)
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
 
-	char szBuf[64];
-	time_t tNow = time(0);
-	struct tm *t = localtime(&tNow);
-	strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-	fprintf(Logfile, "%s %s\n", szBuf, szBufString);
-	fflush(Logfile);
-	fclose(Logfile);
-	Logfile = fopen("./flhook_logs/npc_log.log", "at");
+	static uint iLogID = 0;
+	if (!iLogID)
+		iLogID = HkLogOpen("./flhook_logs/npc_log.log", 0, LOG_STAMP_PLUGIN);
+	HkLogWrite(iLogID, "%s", szBufString);
 }
 
 bool IsFLHookNPC(CShip* ship)
@@ -538,13 +531,13 @@ void CreateNPC(wstring name, Vector pos, Matrix rot, uint iSystem)
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//Client command processing
+//Admin command processing
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// The commands are registered with RIGHT_AICONTROL, FLHook checks the rights before calling them.
+
 void AdminCmd_AIMake(CCmds* cmds, int Amount, wstring NpcType)
 {
-	RIGHT_CHECK(RIGHT_AICONTROL)
-
 	if (Amount == 0) { Amount = 1; }
 
 	NPC_ARCHTYPESSTRUCT arch;
@@ -584,10 +577,15 @@ void AdminCmd_AIMake(CCmds* cmds, int Amount, wstring NpcType)
 	return;
 }
 
-void AdminCmd_AIKill(CCmds* cmds, int loot)
+bool AdminCmd_AICreate(CCmds* cmds, const wstring &wscCmd)
 {
-	RIGHT_CHECK(RIGHT_AICONTROL)
+	AdminCmd_AIMake(cmds, cmds->ArgInt(1), cmds->ArgStr(2));
+	return true;
+}
 
+bool AdminCmd_AIKill(CCmds* cmds, const wstring &wscCmd)
+{
+	int loot = cmds->ArgInt(1);
 	int num = loot;
 	if (num >= 2)
 		num = 0;
@@ -599,14 +597,12 @@ void AdminCmd_AIKill(CCmds* cmds, int loot)
 	npcs.clear();
 	cmds->Print(L"OK\n");
 
-	return;
+	return true;
 }
 
 /* Make AI come to your position */
-void AdminCmd_AICome(CCmds* cmds)
+bool AdminCmd_AICome(CCmds* cmds, const wstring &wscCmd)
 {
-	RIGHT_CHECK(RIGHT_AICONTROL)
-
 	uint iShip1;
 	pub::Player::GetShip(HkGetClientIdFromCharname(cmds->GetAdminName()), iShip1);
 	if (iShip1)
@@ -631,13 +627,13 @@ void AdminCmd_AICome(CCmds* cmds)
 		}
 	}
 	cmds->Print(L"OK\n");
-	return;
+	return true;
 }
 
 /* Make AI follow you until death */
-void AdminCmd_AIFollow(CCmds* cmds, wstring &wscCharname)
+bool AdminCmd_AIFollow(CCmds* cmds, const wstring &wscCmd)
 {
-	RIGHT_CHECK(RIGHT_AICONTROL)
+	wstring wscCharname = cmds->ArgCharname(1);
 
 	// If no player specified follow the admin
 	uint iClientId;
@@ -672,14 +668,12 @@ void AdminCmd_AIFollow(CCmds* cmds, wstring &wscCharname)
 			cmds->Print(L"%s is not in space\n", wscCharname.c_str());
 		}
 	}
-	return;
+	return true;
 }
 
 /* Cancel the current operation */
-void AdminCmd_AICancel(CCmds* cmds)
+bool AdminCmd_AICancel(CCmds* cmds, const wstring &wscCmd)
 {
-	RIGHT_CHECK(RIGHT_AICONTROL)
-
 	uint iShip1;
 	pub::Player::GetShip(HkGetClientIdFromCharname(cmds->GetAdminName()), iShip1);
 	if (iShip1)
@@ -691,14 +685,12 @@ void AdminCmd_AICancel(CCmds* cmds)
 		}
 	}
 	cmds->Print(L"OK\n");
-	return;
+	return true;
 }
 
 /** List npc fleets */
-void AdminCmd_ListNPCFleets(CCmds* cmds)
+bool AdminCmd_ListNPCFleets(CCmds* cmds, const wstring &wscCmd)
 {
-	RIGHT_CHECK(RIGHT_AICONTROL)
-
 	cmds->Print(L"Available fleets: %d\n", mapNPCFleets.size());
 	for (map<wstring, NPC_FLEETSTRUCT>::iterator i = mapNPCFleets.begin();
 		i != mapNPCFleets.end(); ++i)
@@ -707,14 +699,14 @@ void AdminCmd_ListNPCFleets(CCmds* cmds)
 	}
 	cmds->Print(L"OK\n");
 
-	return;
+	return true;
 }
 
 
 /* Spawn a Fleet */
-void AdminCmd_AIFleet(CCmds* cmds, wstring FleetName)
+bool AdminCmd_AIFleet(CCmds* cmds, const wstring &wscCmd)
 {
-	RIGHT_CHECK(RIGHT_AICONTROL)
+	wstring FleetName = cmds->ArgStr(1);
 
 	int wrongnpcname = 0;
 
@@ -738,11 +730,11 @@ void AdminCmd_AIFleet(CCmds* cmds, wstring FleetName)
 	if (wrongnpcname == 1)
 	{
 		cmds->Print(L"ERR Wrong Fleet name\n");
-		return;
+		return true;
 	}
 
 	cmds->Print(L"OK fleet spawned\n");
-	return;
+	return true;
 }
 
 /*
@@ -807,54 +799,31 @@ bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
 
 */
 
-#define IS_CMD(a) !wscCmd.compare(L##a)
+struct ADMINCMD
+{
+	wchar_t *wszCmd;
+	ADMIN_CMD_CALLBACK proc;
+};
 
-bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
+ADMINCMD AdminCmds[] =
 {
-	returncode = DEFAULT_RETURNCODE;
-	if (IS_CMD("aicreate"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		AdminCmd_AIMake(cmds, cmds->ArgInt(1), cmds->ArgStr(2));
-		return true;
-	}
-	else if (IS_CMD("aidestroy"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		AdminCmd_AIKill(cmds, cmds->ArgInt(1));
-		return true;
-	}
-	else if (IS_CMD("aicancel"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		AdminCmd_AICancel(cmds);
-		return true;
-	}
-	else if (IS_CMD("aifollow"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		AdminCmd_AIFollow(cmds, cmds->ArgCharname(1));
-		return true;
-	}
-	else if (IS_CMD("aicome"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		AdminCmd_AICome(cmds);
-		return true;
-	}
-	else if (IS_CMD("aifleet"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		AdminCmd_AIFleet(cmds, cmds->ArgStr(1));
-		return true;
-	}
-	else if (IS_CMD("fleetlist"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		AdminCmd_ListNPCFleets(cmds);
-		return true;
-	}
-	return false;
+	{ L"aicreate", AdminCmd_AICreate },
+	{ L"aidestroy", AdminCmd_AIKill },
+	{ L"aicancel", AdminCmd_AICancel },
+	{ L"aifollow", AdminCmd_AIFollow },
+	{ L"aicome", AdminCmd_AICome },
+	{ L"aifleet", AdminCmd_AIFleet },
+	{ L"fleetlist", AdminCmd_ListNPCFleets },
+};
+
+/*
+The commands are registered with FLHook, which calls the command's function
+directly instead of offering every admin command to this plugin.
+*/
+void RegisterAdminCommands()
+{
+	for (uint i = 0; (i < sizeof(AdminCmds) / sizeof(ADMINCMD)); i++)
+		HkRegisterAdminCommand(AdminCmds[i].wszCmd, RIGHT_AICONTROL, AdminCmds[i].proc);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -870,9 +839,10 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->bMayUnload = true;
 	p_PI->ePluginReturnCode = &returncode;
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&LoadSettings, PLUGIN_LoadSettings, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ExecuteCommandString_Callback, PLUGIN_ExecuteCommandString_Callback, 0));
 	//p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ShipDestroyed, PLUGIN_ShipDestroyed, 0));
 
+	RegisterAdminCommands();
+
 	return p_PI;
 }
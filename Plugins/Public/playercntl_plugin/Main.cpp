@@ -945,12 +945,10 @@ void __stdcall RequestBestPath(unsigned int p1, DWORD *p2, int p3)
 	}
 }
 
-typedef bool(*_UserCmdProc)(uint, const wstring &, const wstring &, const wchar_t*);
-
 struct USERCMD
 {
 	wchar_t *wszCmd;
-	_UserCmdProc proc;
+	USERCMD_CALLBACK proc;
 	wchar_t *usage;
 };
 
@@ -1114,9 +1112,18 @@ USERCMD UserCmds[] =
 };
 
 /**
-This function is called by FLHook when a user types a chat string. We look at the
-string they've typed and see if it starts with one of the above commands. If it
-does we try to process it.
+The commands are registered with FLHook's command router, which calls the command's
+function directly instead of offering every chat string to this plugin.
+*/
+void RegisterUserCommands()
+{
+	for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
+		HkRegisterUserCommand(UserCmds[i].wszCmd, UserCmds[i].proc, UserCmds[i].usage);
+}
+
+/**
+Every chat string still comes through here so it can be echoed back to the sender,
+the commands themselves are handled by the router.
 */
 bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
 {
@@ -1124,36 +1131,7 @@ bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
 
 	try
 	{
-		wstring wscCmdLineLower = ToLower(wscCmd);
-
-		Message::UserCmd_Process(iClientID, wscCmdLineLower);
-
-		// If the chat string does not match the USER_CMD then we do not handle the
-		// command, so let other plugins or FLHook kick in. We require an exact match
-		for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
-		{
-			if (wscCmdLineLower.find(UserCmds[i].wszCmd) == 0)
-			{
-				// Extract the parameters string from the chat string. It should
-				// be immediately after the command and a space.
-				wstring wscParam = L"";
-				if (wscCmd.length() > wcslen(UserCmds[i].wszCmd))
-				{
-					if (wscCmd[wcslen(UserCmds[i].wszCmd)] != ' ')
-						continue;
-					wscParam = wscCmd.substr(wcslen(UserCmds[i].wszCmd) + 1);
-				}
-
-				// Dispatch the command to the appropriate processing function.
-				if (UserCmds[i].proc(iClientID, wscCmd, wscParam, UserCmds[i].usage))
-				{
-					// We handled the command tell FL hook to stop processing this
-					// chat string.
-					returncode = SKIPPLUGINS_NOFUNCTIONCALL; // we handled the command, return immediatly
-					return true;
-				}
-			}
-		}
+		Message::UserCmd_Process(iClientID, ToLower(wscCmd));
 	}
 	catch (...)
 	{
@@ -1400,45 +1378,174 @@ pub::AI::SetPersonalityParams HkMakePersonality() {
 	return p;
 }
 
-#define IS_CMD(a) !wscCmd.compare(L##a)
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Admin commands, the functions check the rights themselves.
 
-bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
+bool AdminCmd_SmiteAll(CCmds* cmds, const wstring &wscCmd)
 {
-	returncode = DEFAULT_RETURNCODE;
+	MiscCmds::AdminCmd_SmiteAll(cmds);
+	return true;
+}
 
+bool AdminCmd_Bob(CCmds* cmds, const wstring &wscCmd)
+{
+	MiscCmds::AdminCmd_Bob(cmds, cmds->ArgCharname(1));
+	return true;
+}
 
-	if (IS_CMD("smiteall"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		MiscCmds::AdminCmd_SmiteAll(cmds);
-		return true;
-	}
-	else if (IS_CMD("bob"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		MiscCmds::AdminCmd_Bob(cmds, cmds->ArgCharname(1));
-		return true;
-	}
+bool AdminCmd_PlayMusic(CCmds* cmds, const wstring &wscCmd)
+{
+	MiscCmds::AdminCmd_PlayMusic(cmds, cmds->ArgStrToEnd(1));
+	return true;
+}
 
-	else if (IS_CMD("playmusic"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		MiscCmds::AdminCmd_PlayMusic(cmds, cmds->ArgStrToEnd(1));
-		return true;
-	}
-	else if (IS_CMD("playsound"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		MiscCmds::AdminCmd_PlaySound(cmds, cmds->ArgStrToEnd(1));
-		return true;
-	}
-	else if (IS_CMD("playnnm"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		MiscCmds::AdminCmd_PlayNNM(cmds, cmds->ArgStrToEnd(1));
-		return true;
-	}
-	else if (IS_CMD("beam"))
+bool AdminCmd_PlaySound(CCmds* cmds, const wstring &wscCmd)
+{
+	MiscCmds::AdminCmd_PlaySound(cmds, cmds->ArgStrToEnd(1));
+	return true;
+}
+
+bool AdminCmd_PlayNNM(CCmds* cmds, const wstring &wscCmd)
+{
+	MiscCmds::AdminCmd_PlayNNM(cmds, cmds->ArgStrToEnd(1));
+	return true;
+}
+
+bool AdminCmd_Pull(CCmds* cmds, const wstring &wscCmd)
+{
+	HyperJump::AdminCmd_Pull(cmds, cmds->ArgCharname(1));
+	return true;
+}
+
+bool AdminCmd_Move(CCmds* cmds, const wstring &wscCmd)
+{
+	HyperJump::AdminCmd_Move(cmds, cmds->ArgFloat(1), cmds->ArgFloat(2), cmds->ArgFloat(3));
+	return true;
+}
+
+bool AdminCmd_Chase(CCmds* cmds, const wstring &wscCmd)
+{
+	HyperJump::AdminCmd_Chase(cmds, cmds->ArgCharname(1));
+	return true;
+}
+
+bool AdminCmd_ListRestrictedShips(CCmds* cmds, const wstring &wscCmd)
+{
+	HyperJump::AdminCmd_ListRestrictedShips(cmds);
+	return true;
+}
+
+bool AdminCmd_MakeCoord(CCmds* cmds, const wstring &wscCmd)
+{
+	HyperJump::AdminCmd_MakeCoord(cmds);
+	return true;
+}
+
+bool AdminCmd_AuthenticateChar(CCmds* cmds, const wstring &wscCmd)
+{
+	IPBans::AdminCmd_AuthenticateChar(cmds, cmds->ArgStr(1));
+	return true;
+}
+
+bool AdminCmd_ReloadBans(CCmds* cmds, const wstring &wscCmd)
+{
+	IPBans::AdminCmd_ReloadBans(cmds);
+	return true;
+}
+
+bool AdminCmd_SetAccMoveCode(CCmds* cmds, const wstring &wscCmd)
+{
+	Rename::AdminCmd_SetAccMoveCode(cmds, cmds->ArgCharname(1), cmds->ArgStr(2));
+	return true;
+}
+
+bool AdminCmd_RotateLogs(CCmds* cmds, const wstring &wscCmd)
+{
+	// the logs are moved by FLHook's log writer thread, which owns the files
+	HkLogRotate(sDebugLog, sDebugLog + ".old");
+	HkLogRotate("./flhook_logs/FLHook.log", "./flhook_logs/FLHook.log.old");
+
+	cmds->Print(L"OK\n");
+	return true;
+}
+
+bool AdminCmd_SendMail(CCmds* cmds, const wstring &wscCmd)
+{
+	Message::AdminCmd_SendMail(cmds, cmds->ArgCharname(1), cmds->ArgStrToEnd(2));
+	return true;
+}
+
+bool AdminCmd_ShowTags(CCmds* cmds, const wstring &wscCmd)
+{
+	Rename::AdminCmd_ShowTags(cmds);
+	return true;
+}
+
+bool AdminCmd_AddTag(CCmds* cmds, const wstring &wscCmd)
+{
+	Rename::AdminCmd_AddTag(cmds, cmds->ArgStr(1), cmds->ArgStr(2), cmds->ArgStrToEnd(3));
+	return true;
+}
+
+bool AdminCmd_DropTag(CCmds* cmds, const wstring &wscCmd)
+{
+	Rename::AdminCmd_DropTag(cmds, cmds->ArgStr(1));
+	return true;
+}
+
+bool AdminCmd_ReloadLockedShips(CCmds* cmds, const wstring &wscCmd)
+{
+	Rename::ReloadLockedShips();
+	return true;
+}
+
+struct ADMINCMD
+{
+	wchar_t *wszCmd;
+	ADMIN_CMD_CALLBACK proc;
+};
+
+ADMINCMD AdminCmds[] =
+{
+	{ L"smiteall", AdminCmd_SmiteAll },
+	{ L"bob", AdminCmd_Bob },
+	{ L"playmusic", AdminCmd_PlayMusic },
+	{ L"playsound", AdminCmd_PlaySound },
+	{ L"playnnm", AdminCmd_PlayNNM },
+	{ L"pull", AdminCmd_Pull },
+	{ L"move", AdminCmd_Move },
+	{ L"chase", AdminCmd_Chase },
+	{ L"lrs", AdminCmd_ListRestrictedShips },
+	{ L"makecoord", AdminCmd_MakeCoord },
+	{ L"authchar", AdminCmd_AuthenticateChar },
+	{ L"reloadbans", AdminCmd_ReloadBans },
+	{ L"setaccmovecode", AdminCmd_SetAccMoveCode },
+	{ L"rotatelogs", AdminCmd_RotateLogs },
+	{ L"pm", AdminCmd_SendMail },
+	{ L"privatemsg", AdminCmd_SendMail },
+	{ L"showtags", AdminCmd_ShowTags },
+	{ L"addtag", AdminCmd_AddTag },
+	{ L"droptag", AdminCmd_DropTag },
+	{ L"reloadlockedships", AdminCmd_ReloadLockedShips },
+};
+
+/*
+The commands are registered with FLHook, which calls the command's function
+directly instead of offering every admin command to this plugin.
+*/
+void RegisterAdminCommands()
+{
+	for (uint i = 0; (i < sizeof(AdminCmds) / sizeof(ADMINCMD)); i++)
+		HkRegisterAdminCommand(AdminCmds[i].wszCmd, 0, AdminCmds[i].proc);
+}
+
+// .beam is not registered, if HyperJump doesn't handle it the command goes on to
+// base_plugin's and FLHook's beam.
+bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
+{
+	returncode = DEFAULT_RETURNCODE;
+
+	if (!wscCmd.compare(L"beam"))
 	{
 		if (HyperJump::AdminCmd_Beam(cmds, cmds->ArgCharname(1), cmds->ArgStrToEnd(2)))
 		{
@@ -1446,112 +1553,6 @@ bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
 			return true;
 		}
 	}
-	else if (IS_CMD("pull"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		HyperJump::AdminCmd_Pull(cmds, cmds->ArgCharname(1));
-		return true;
-	}
-	if (IS_CMD("move"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		HyperJump::AdminCmd_Move(cmds, cmds->ArgFloat(1), cmds->ArgFloat(2), cmds->ArgFloat(3));
-		return true;
-	}
-	else if (IS_CMD("chase"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		HyperJump::AdminCmd_Chase(cmds, cmds->ArgCharname(1));
-		return true;
-	}
-	else if (IS_CMD("lrs"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		HyperJump::AdminCmd_ListRestrictedShips(cmds);
-		return true;
-	}
-	else if (IS_CMD("makecoord"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		HyperJump::AdminCmd_MakeCoord(cmds);
-		return true;
-	}
-	else if (IS_CMD("authchar"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		IPBans::AdminCmd_AuthenticateChar(cmds, cmds->ArgStr(1));
-		return true;
-	}
-	else if (IS_CMD("reloadbans"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		IPBans::AdminCmd_ReloadBans(cmds);
-		return true;
-	}
-	else if (IS_CMD("setaccmovecode"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		Rename::AdminCmd_SetAccMoveCode(cmds, cmds->ArgCharname(1), cmds->ArgStr(2));
-		return true;
-	}
-	else if (IS_CMD("rotatelogs"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		if (fLogDebug)
-		{
-			fclose(fLogDebug);
-			::MoveFileA(sDebugLog.c_str(), string(sDebugLog + ".old").c_str());
-			_unlink(sDebugLog.c_str());
-			fLogDebug = fopen(sDebugLog.c_str(), "wt");
-		}
-
-		if (fLog)
-		{
-			fclose(fLog);
-			::MoveFileA("./flhook_logs/FLHook.log", "./flhook_logs/FLHook.log.old");
-			_unlink("./flhook_logs/FLHook.log");
-			fLog = fopen("./flhook_logs/FLHook.log", "wt");
-		}
-
-		cmds->Print(L"OK\n");
-		return true;
-	}
-	else if (IS_CMD("pm") || IS_CMD("privatemsg"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		Message::AdminCmd_SendMail(cmds, cmds->ArgCharname(1), cmds->ArgStrToEnd(2));
-		return true;
-	}
-	else if (IS_CMD("pm") || IS_CMD("privatemsg"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		Message::AdminCmd_SendMail(cmds, cmds->ArgCharname(1), cmds->ArgStrToEnd(2));
-		return true;
-	}
-	else if (IS_CMD("showtags"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		Rename::AdminCmd_ShowTags(cmds);
-		return true;
-	}
-	else if (IS_CMD("addtag"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		Rename::AdminCmd_AddTag(cmds, cmds->ArgStr(1), cmds->ArgStr(2), cmds->ArgStrToEnd(3));
-		return true;
-	}
-	else if (IS_CMD("droptag"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		Rename::AdminCmd_DropTag(cmds, cmds->ArgStr(1));
-		return true;
-	}
-	else if (IS_CMD("reloadlockedships"))
-	{
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-		Rename::ReloadLockedShips();
-		return true;
-	}
 	return false;
 }
 
@@ -1676,5 +1677,8 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&RequestBestPath, PLUGIN_HkIServerImpl_RequestBestPath, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&Plugin_Communication_CallBack, PLUGIN_Plugin_Communication, 0));
 	//	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&SPMunitionCollision, PLUGIN_HkIServerImpl_SPMunitionCollision, 0));
+
+	RegisterAdminCommands();
+	RegisterUserCommands();
 	return p_PI;
 }
@@ -38,9 +38,6 @@
 float set_iLocalChatRangeUtl = 9999;
 
 /// Record people using /pm /r and /t
-/// TODO: Turn this into a generic logging function and move it to PluginUtilities
-FILE *PMLogfile = fopen("./flhook_logs/private_chats.log", "at");
-
 void PMLogging(const char *szString, ...)
 {
 	char szBufString[1024];
@@ -48,14 +45,10 @@ void PMLogging(const char *szString, ...)
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
 
-	char szBuf[64];
-	time_t tNow = time(0);
-	struct tm *t = localtime(&tNow);
-	strftime(szBuf, sizeof(szBuf), "%d/%m/%Y %H:%M:%S", t);
-	fprintf(PMLogfile, "%s %s\n", szBuf, szBufString);
-	fflush(PMLogfile);
-	fclose(PMLogfile);
-	PMLogfile = fopen("./flhook_logs/private_chats.log", "at");
+	static uint iLogID = 0;
+	if (!iLogID)
+		iLogID = HkLogOpen("./flhook_logs/private_chats.log", 0, LOG_STAMP_PLUGIN);
+	HkLogWrite(iLogID, "%s", szBufString);
 }
 
 /// Load the configuration
@@ -257,8 +250,13 @@ namespace Message
 
 	static float set_fDisconnectSwearingInSpaceRange;
 
-	/** list of swear words */
-	static std::list<wstring> set_lstSwearWords;
+	/** swear words compiled into one matcher, allowed words mask the swear words they contain */
+	enum SWEAR_MASK
+	{
+		SWEAR_WORD = 1,
+		SWEAR_ALLOWED = 2,
+	};
+	static CStringMatcher set_swearWords;
 
 	/** Load the msgs for specified client ID into memory. */
 	static void LoadMsgs(uint iClientID)
@@ -412,6 +410,10 @@ namespace Message
 		set_lstSpecialBannerLines.clear();
 		set_vctStandardBannerLines.clear();
 
+		set_swearWords.Clear();
+		set_swearWords.Add(L"cockpit", SWEAR_ALLOWED);
+		set_swearWords.Add(L"cockroach", SWEAR_ALLOWED);
+
 		INI_Reader ini;
 		if (ini.open(scPluginCfgFile.c_str(), false))
 		{
@@ -442,16 +444,24 @@ namespace Message
 				}
 				else if (ini.is_header("SwearWords"))
 				{
+					// Word = whole words only, Allow = words that are not swearing even
+					// though they contain a swear word, anything else matches anywhere.
 					while (ini.read_value())
 					{
 						wstring word = Trim(stows(ini.get_value_string()));
 						word = ReplaceStr(word, L"_", L" ");
-						set_lstSwearWords.push_back(word);
+						if (ini.is_value("Word"))
+							set_swearWords.Add(word, SWEAR_WORD, true);
+						else if (ini.is_value("Allow"))
+							set_swearWords.Add(word, SWEAR_ALLOWED);
+						else
+							set_swearWords.Add(word, SWEAR_WORD);
 					}
 				}
 			}
 			ini.close();
 		}
+		set_swearWords.Compile();
 	}
 
 	/// On this timer display banners
@@ -535,6 +545,39 @@ namespace Message
 		}
 	}
 
+	/** Scan the message once for all swear words. A swear word doesn't count if it is
+	part of an allowed word (e.g. "cock" in "cockpit"). */
+	static bool IsSwearing(const wstring &wscChatMsg)
+	{
+		list<STRING_MATCH> lstMatches;
+		uint iMask = set_swearWords.Find(wscChatMsg, lstMatches);
+		if (!(iMask & SWEAR_WORD))
+			return false;
+		if (!(iMask & SWEAR_ALLOWED))
+			return true;
+
+		foreach(lstMatches, STRING_MATCH, swear)
+		{
+			if (!(swear->iMask & SWEAR_WORD))
+				continue;
+
+			bool bAllowed = false;
+			foreach(lstMatches, STRING_MATCH, allowed)
+			{
+				if ((allowed->iMask & SWEAR_ALLOWED) && allowed->iPos <= swear->iPos
+					&& (allowed->iPos + allowed->iLen) >= (swear->iPos + swear->iLen))
+				{
+					bAllowed = true;
+					break;
+				}
+			}
+
+			if (!bAllowed)
+				return true;
+		}
+		return false;
+	}
+
 	bool Message::SubmitChat(CHAT_ID cId, unsigned long iSize, const void *rdlReader, CHAT_ID cIdTo, int p2)
 	{
 		// Ignore group join/leave commands
@@ -562,44 +605,30 @@ namespace Message
 		if (!bIsGroup)
 		{
 			// If a restricted word appears in the message take appropriate action.
-			foreach(set_lstSwearWords, wstring, worditer)
+			if (IsSwearing(wscChatMsg))
 			{
-				if (wscChatMsg.find(*worditer) != -1)
-				{
-					if (*worditer == (L"cock"))
-					{
-						if (wscChatMsg.find(L"cockpit") != -1)
-						{
-							return false;
-						}
-						else if (wscChatMsg.find(L"cockroach") != -1)
-						{
-							return false;
-						}
-					}
-					PrintUserCmdText(iClientID, L"This is an automated message.");
-					PrintUserCmdText(iClientID, L"Please do not swear or you may be sanctioned.");
+				PrintUserCmdText(iClientID, L"This is an automated message.");
+				PrintUserCmdText(iClientID, L"Please do not swear or you may be sanctioned.");
 
-					mapInfo[iClientID].iSwearWordWarnings++;
-					if (mapInfo[iClientID].iSwearWordWarnings > 2)
+				mapInfo[iClientID].iSwearWordWarnings++;
+				if (mapInfo[iClientID].iSwearWordWarnings > 2)
+				{
+					wstring wscCharname = (const wchar_t*)Players.GetActiveCharacterName(iClientID);
+					AddLog("NOTICE: Swearing tempban on %s (%s) reason='%s'",
+						wstos(wscCharname).c_str(), wstos(HkGetAccountID(HkGetAccountByCharname(wscCharname))).c_str(),
+						wstos(wscChatMsg).c_str());
+					HkTempBan(iClientID, 10);
+					HkDelayedKick(iClientID, 1);
+
+					if (set_fDisconnectSwearingInSpaceRange > 0.0f)
 					{
-						wstring wscCharname = (const wchar_t*)Players.GetActiveCharacterName(iClientID);
-						AddLog("NOTICE: Swearing tempban on %s (%s) reason='%s'",
-							wstos(wscCharname).c_str(), wstos(HkGetAccountID(HkGetAccountByCharname(wscCharname))).c_str(),
-							wstos(wscChatMsg).c_str());
-						HkTempBan(iClientID, 10);
-						HkDelayedKick(iClientID, 1);
-
-						if (set_fDisconnectSwearingInSpaceRange > 0.0f)
-						{
-							wstring wscMsg = set_wscDisconnectSwearingInSpaceMsg;
-							wscMsg = ReplaceStr(wscMsg, L"%time", GetTimeString(set_bLocalTime));
-							wscMsg = ReplaceStr(wscMsg, L"%player", wscCharname);
-							PrintLocalUserCmdText(iClientID, wscMsg, set_fDisconnectSwearingInSpaceRange);
-						}
+						wstring wscMsg = set_wscDisconnectSwearingInSpaceMsg;
+						wscMsg = ReplaceStr(wscMsg, L"%time", GetTimeString(set_bLocalTime));
+						wscMsg = ReplaceStr(wscMsg, L"%player", wscCharname);
+						PrintLocalUserCmdText(iClientID, wscMsg, set_fDisconnectSwearingInSpaceRange);
 					}
-					return true;
 				}
+				return true;
 			}
 		}
 
@@ -394,12 +394,10 @@ bool UserCmd_Value(uint iClientID, const wstring &wscCmd, const wstring &wscPara
 //Client command processing
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-typedef bool(*_UserCmdProc)(uint, const wstring &, const wstring &, const wchar_t*);
-
 struct USERCMD
 {
 	wchar_t *wszCmd;
-	_UserCmdProc proc;
+	USERCMD_CALLBACK proc;
 	wchar_t *usage;
 };
 
@@ -410,53 +408,18 @@ USERCMD UserCmds[] =
 };
 
 /**
-This function is called by FLHook when a user types a chat string. We look at the
-string they've typed and see if it starts with one of the above commands. If it
-does we try to process it.
+The commands are registered with FLHook's command router, which calls the command's
+function directly instead of offering every chat string to this plugin.
 */
-bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
+void RegisterUserCommands()
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	wstring wscCmdLineLower = ToLower(wscCmd);
-
-	// If the chat string does not match the USER_CMD then we do not handle the
-	// command, so let other plugins or FLHook kick in. We require an exact match
 	for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
-	{
-
-		if (wscCmdLineLower.find(UserCmds[i].wszCmd) == 0)
-		{
-			// Extract the parameters string from the chat string. It should
-			// be immediately after the command and a space.
-			wstring wscParam = L"";
-			if (wscCmd.length() > wcslen(UserCmds[i].wszCmd))
-			{
-				if (wscCmd[wcslen(UserCmds[i].wszCmd)] != ' ')
-					continue;
-				wscParam = wscCmd.substr(wcslen(UserCmds[i].wszCmd) + 1);
-			}
-
-			// Dispatch the command to the appropriate processing function.
-			if (UserCmds[i].proc(iClientID, wscCmd, wscParam, UserCmds[i].usage))
-			{
-				returncode = SKIPPLUGINS_NOFUNCTIONCALL;
-				return true;
-			}
-		}
-	}
-	return false;
+		HkRegisterUserCommand(UserCmds[i].wszCmd, UserCmds[i].proc, UserCmds[i].usage);
 }
 
-bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
+// registered with RIGHT_PLUGINS, FLHook checks the rights before calling it
+bool AdminCmd_PveController(CCmds* cmds, const wstring &wscCmd)
 {
-	returncode = DEFAULT_RETURNCODE;
-
-	if (wscCmd.compare(L"pvecontroller"))
-		return false;
-
-	if (!(cmds->rights & RIGHT_PLUGINS)) { cmds->Print(L"ERR No permission\n"); return false; }
-
 	if (!cmds->ArgStrToEnd(1).compare(L"status"))
 	{
 		cmds->Print(L"PVECONTROLLER: PvE Controller (Phase 1) is active.\n");
@@ -474,7 +437,6 @@ bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
 			}
 			cmds->Print(L"  There are %d outstanding bounty pools worth $%lld credits for %d kill%s to be paid out in %dm%ds.\n", pools, poolvalue, poolkills, (poolkills != 1 ? L"s" : L""), next_tick / 60, next_tick % 60);
 		}
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
 		return true;
 	}
 	else if (!cmds->ArgStrToEnd(1).compare(L"payout"))
@@ -493,14 +455,12 @@ bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
 			}
 			cmds->Print(L"PVECONTROLLER: Paid out %d outstanding bounty pools worth $%lld credits for %d kill%s.\n", pools, poolvalue, poolkills, (poolkills != 1 ? L"s" : L""));
 		}
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
 		return true;
 	}
 	else if (!cmds->ArgStrToEnd(1).compare(L"reloadall"))
 	{
 		cmds->Print(L"PVECONTROLLER: COMPLETE LIVE RELOAD requested by %s.\n", cmds->GetAdminName());
 		LoadSettings();
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
 		cmds->Print(L"PVECONTROLLER: Live reload completed.\n");
 		return true;
 	}
@@ -508,7 +468,6 @@ bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
 	{
 		cmds->Print(L"PVECONTROLLER: Live NPC bounties reload requested by %s.\n", cmds->GetAdminName());
 		LoadSettingsNPCBounties();
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
 		cmds->Print(L"PVECONTROLLER: Live NPC bounties reload completed.\n");
 		return true;
 	}
@@ -516,7 +475,6 @@ bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
 	{
 		cmds->Print(L"PVECONTROLLER: Live NPC drops reload requested by %s.\n", cmds->GetAdminName());
 		LoadSettingsNPCDrops();
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
 		cmds->Print(L"PVECONTROLLER: Live NPC drops reload completed.\n");
 		return true;
 	}
@@ -528,10 +486,8 @@ bool ExecuteCommandString_Callback(CCmds* cmds, const wstring &wscCmd)
 		cmds->Print(L"  .pvecontroller reloadall -- Reloads ALL settings on the fly.\n");
 		cmds->Print(L"  .pvecontroller reloadnpcbounties -- Reloads NPC bounty settings on the fly.\n");
 		cmds->Print(L"  .pvecontroller reloadnpcdrops -- Reloads NPC drop settings on the fly.\n");
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL;
 		return true;
 	}
-	return false;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -777,12 +733,14 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&LoadSettings, PLUGIN_LoadSettings, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ClearClientInfo, PLUGIN_ClearClientInfo, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&UserCmd_Process, PLUGIN_UserCmd_Process, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ExecuteCommandString_Callback, PLUGIN_ExecuteCommandString_Callback, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkCb_AddDmgEntry, PLUGIN_HkCb_AddDmgEntry, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkTimerCheckKick, PLUGIN_HkTimerCheckKick, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&BaseEnter, PLUGIN_HkIServerImpl_BaseEnter, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&DisConnect, PLUGIN_HkIServerImpl_DisConnect, 0));
 
+	HkRegisterAdminCommand(L"pvecontroller", RIGHT_PLUGINS, AdminCmd_PveController);
+
+	RegisterUserCommands();
+
 	return p_PI;
 }
@@ -141,34 +141,17 @@ EXPORT void Plugin_Communication_CallBack(PLUGIN_MESSAGE msg, void* data)
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void CmdTempBan(CCmds* classptr, const wstring &wscCharname, uint iDuration)
+// registered with RIGHT_BAN, FLHook checks the rights before calling it
+bool CmdTempBan(CCmds* classptr, const wstring &wscCmd)
 {
-
-	// right check
-	if (!(classptr->rights & RIGHT_BAN)) { classptr->Print(L"ERR No permission\n"); return; }
+	wstring wscCharname = classptr->ArgCharname(1);
+	uint iDuration = classptr->ArgInt(2);
 
 	if (((classptr->hkLastErr = HkTempBan(wscCharname, iDuration)) == HKE_OK)) // hksuccess 
 		classptr->Print(L"OK\n");
 	else
 		classptr->PrintError();
-}
-
-#define IS_CMD(a) !wscCmd.compare(L##a)
-
-EXPORT bool ExecuteCommandString_Callback(CCmds* classptr, const wstring &wscCmd)
-{
-	returncode = NOFUNCTIONCALL;  // flhook needs to care about our return code
-
-	if (IS_CMD("tempban")) {
-
-		returncode = SKIPPLUGINS_NOFUNCTIONCALL; // do not let other plugins kick in since we now handle the command
-
-		CmdTempBan(classptr, classptr->ArgCharname(1), classptr->ArgInt(2));
-
-		return true;
-	}
-
-	return false;
+	return true;
 }
 
 EXPORT void CmdHelp_Callback(CCmds* classptr)
@@ -193,7 +176,8 @@ EXPORT PLUGIN_INFO* Get_PluginInfo()
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkTimerCheckKick, PLUGIN_HkTimerCheckKick, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&HkIServerImpl::Login, PLUGIN_HkIServerImpl_Login, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&Plugin_Communication_CallBack, PLUGIN_Plugin_Communication, 0));
-	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&ExecuteCommandString_Callback, PLUGIN_ExecuteCommandString_Callback, 0));
 	p_PI->lstHooks.push_back(PLUGIN_HOOKINFO((FARPROC*)&CmdHelp_Callback, PLUGIN_CmdHelp_Callback, 0));
+
+	HkRegisterAdminCommand(L"tempban", RIGHT_BAN, CmdTempBan);
 	return p_PI;
 }
@@ -1,5 +1,6 @@
 #include "global.h"
 #include "CCmds.h"
+#include <map>
 
 #define RIGHT_CHECK(a) if(!(this->rights & a)) { Print(L"ERR No permission\n"); return; }
 #define RIGHT_CHECK_SUPERADMIN() if(!(this->rights == RIGHT_SUPERADMIN)) { Print(L"ERR No permission\n"); return; }
@@ -632,6 +633,54 @@ void CCmds::CmdServerInfo()
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void CCmds::CmdPerfStats(const wstring &wscParam)
+{
+	RIGHT_CHECK(RIGHT_OTHER);
+
+	if (!PerfTimers::bEnabled)
+	{
+		Print(L"ERR performance timers are disabled\n");
+		return;
+	}
+
+	if (ToLower(wscParam) == L"reset")
+	{
+		PerfTimers::Reset();
+		Print(L"OK\n");
+		return;
+	}
+
+	list<PERF_TIMER_STATS> lstStats;
+	PerfTimers::GetStats(lstStats);
+	foreach(lstStats, PERF_TIMER_STATS, it)
+		Print(L"timer=%s count=%I64u total=%I64u p50=%u p90=%u p99=%u max=%u\n", stows(it->sFunction).c_str(), it->iCount, it->tmTotalUS, it->iP50, it->iP90, it->iP99, it->iMax);
+	Print(L"OK\n");
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CCmds::CmdFrameStats()
+{
+	RIGHT_CHECK(RIGHT_OTHER);
+
+	if (!PerfTimers::bEnabled)
+	{
+		Print(L"ERR performance timers are disabled\n");
+		return;
+	}
+
+	FRAME_STATS stats;
+	FrameProfiler::GetStats(stats);
+	Print(L"frames=%u p50=%u p90=%u p99=%u max=%u\n", stats.iFrames, stats.iP50, stats.iP90, stats.iP99, stats.iMax);
+	Print(L"avg timers=%u plugins=%u server=%u\n", stats.arrAvgPhaseUS[FRAME_PHASE_TIMERS], stats.arrAvgPhaseUS[FRAME_PHASE_PLUGINS], stats.arrAvgPhaseUS[FRAME_PHASE_SERVER]);
+	Print(L"overbudget=%u overbudgettotal=%I64u budget=%ums\n", stats.iOverBudget, stats.iOverBudgetTotal, set_iFrameBudget);
+	foreach(stats.lstPlugins, FRAME_PLUGIN_STATS, it)
+		Print(L"plugin=%s avg=%u max=%u\n", stows(it->sName).c_str(), it->iAvgUS, it->iMaxUS);
+	Print(L"OK\n");
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void CCmds::CmdGetGroupMembers(const wstring &wscCharname)
 {
 	RIGHT_CHECK(RIGHT_OTHER);
@@ -856,6 +905,8 @@ void CCmds::CmdHelp()
 		L"isonserver <charname>\n"
 		L"isloggedin <charname>\n"
 		L"serverinfo\n"
+		L"perfstats [reset]\n"
+		L"framestats\n"
 		L"moneyfixlist\n"
 		L"savechar <charname>\n"
 		L"setadmin <charname> <rights>\n"
@@ -1005,7 +1056,156 @@ wstring CCmds::ArgStrToEnd(uint iArg)
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-#define IS_CMD(a) !wscCmd.compare(L##a)
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// built-in admin commands, looked up by name instead of comparing against every command
+enum CORE_CMD
+{
+	CMD_UNKNOWN = 0,
+	CMD_GETCASH,
+	CMD_SETCASH,
+	CMD_SETCASHSEC,
+	CMD_ADDCASH,
+	CMD_ADDCASHSEC,
+	CMD_KICK,
+	CMD_BAN,
+	CMD_UNBAN,
+	CMD_KICKBAN,
+	CMD_GETBASESTATUS,
+	CMD_GETCLIENTID,
+	CMD_BEAM,
+	CMD_KILL,
+	CMD_RESETREP,
+	CMD_SETREP,
+	CMD_SETALLREP,
+	CMD_GETREP,
+	CMD_MSG,
+	CMD_MSGS,
+	CMD_MSGU,
+	CMD_FMSG,
+	CMD_FMSGS,
+	CMD_FMSGU,
+	CMD_ENUMCARGO,
+	CMD_REMOVECARGO,
+	CMD_ADDCARGO,
+	CMD_RENAME,
+	CMD_DELETECHAR,
+	CMD_READCHARFILE,
+	CMD_WRITECHARFILE,
+	CMD_GETPLAYERINFO,
+	CMD_GETPLAYERS,
+	CMD_XGETPLAYERINFO,
+	CMD_XGETPLAYERS,
+	CMD_GETPLAYERIDS,
+	CMD_GETACCOUNTDIRNAME,
+	CMD_GETCHARFILENAME,
+	CMD_SAVECHAR,
+	CMD_ISONSERVER,
+	CMD_ISLOGGEDIN,
+	CMD_MONEYFIXLIST,
+	CMD_SERVERINFO,
+	CMD_PERFSTATS,
+	CMD_FRAMESTATS,
+	CMD_GETGROUPMEMBERS,
+	CMD_GETRESERVEDSLOT,
+	CMD_SETRESERVEDSLOT,
+	CMD_SETADMIN,
+	CMD_GETADMIN,
+	CMD_DELADMIN,
+	CMD_UNLOADPLUGIN,
+	CMD_LOADPLUGINS,
+	CMD_LOADPLUGIN,
+	CMD_LISTPLUGINS,
+	CMD_PAUSEPLUGIN,
+	CMD_UNPAUSEPLUGIN,
+	CMD_REHASH,
+	CMD_HELP,
+	CMD_TEST,
+};
+
+struct CORE_CMD_ENTRY
+{
+	const wchar_t *wszName;
+	CORE_CMD eCmd;
+};
+
+static const CORE_CMD_ENTRY CoreCmds[] =
+{
+	{ L"getcash", CMD_GETCASH },
+	{ L"setcash", CMD_SETCASH },
+	{ L"setcashsec", CMD_SETCASHSEC },
+	{ L"addcash", CMD_ADDCASH },
+	{ L"addcashsec", CMD_ADDCASHSEC },
+	{ L"kick", CMD_KICK },
+	{ L"ban", CMD_BAN },
+	{ L"unban", CMD_UNBAN },
+	{ L"kickban", CMD_KICKBAN },
+	{ L"getbasestatus", CMD_GETBASESTATUS },
+	{ L"getclientid", CMD_GETCLIENTID },
+	{ L"beam", CMD_BEAM },
+	{ L"kill", CMD_KILL },
+	{ L"resetrep", CMD_RESETREP },
+	{ L"setrep", CMD_SETREP },
+	{ L"setallrep", CMD_SETALLREP },
+	{ L"getrep", CMD_GETREP },
+	{ L"msg", CMD_MSG },
+	{ L"msgs", CMD_MSGS },
+	{ L"msgu", CMD_MSGU },
+	{ L"fmsg", CMD_FMSG },
+	{ L"fmsgs", CMD_FMSGS },
+	{ L"fmsgu", CMD_FMSGU },
+	{ L"enumcargo", CMD_ENUMCARGO },
+	{ L"removecargo", CMD_REMOVECARGO },
+	{ L"addcargo", CMD_ADDCARGO },
+	{ L"rename", CMD_RENAME },
+	{ L"deletechar", CMD_DELETECHAR },
+	{ L"readcharfile", CMD_READCHARFILE },
+	{ L"writecharfile", CMD_WRITECHARFILE },
+	{ L"getplayerinfo", CMD_GETPLAYERINFO },
+	{ L"getplayers", CMD_GETPLAYERS },
+	{ L"xgetplayerinfo", CMD_XGETPLAYERINFO },
+	{ L"xgetplayers", CMD_XGETPLAYERS },
+	{ L"getplayerids", CMD_GETPLAYERIDS },
+	{ L"getaccountdirname", CMD_GETACCOUNTDIRNAME },
+	{ L"getcharfilename", CMD_GETCHARFILENAME },
+	{ L"savechar", CMD_SAVECHAR },
+	{ L"isonserver", CMD_ISONSERVER },
+	{ L"isloggedin", CMD_ISLOGGEDIN },
+	{ L"moneyfixlist", CMD_MONEYFIXLIST },
+	{ L"serverinfo", CMD_SERVERINFO },
+	{ L"perfstats", CMD_PERFSTATS },
+	{ L"framestats", CMD_FRAMESTATS },
+	{ L"getgroupmembers", CMD_GETGROUPMEMBERS },
+	{ L"getreservedslot", CMD_GETRESERVEDSLOT },
+	{ L"setreservedslot", CMD_SETRESERVEDSLOT },
+	{ L"setadmin", CMD_SETADMIN },
+	{ L"getadmin", CMD_GETADMIN },
+	{ L"deladmin", CMD_DELADMIN },
+	{ L"unloadplugin", CMD_UNLOADPLUGIN },
+	{ L"loadplugins", CMD_LOADPLUGINS },
+	{ L"loadplugin", CMD_LOADPLUGIN },
+	{ L"listplugins", CMD_LISTPLUGINS },
+	{ L"pauseplugin", CMD_PAUSEPLUGIN },
+	{ L"unpauseplugin", CMD_UNPAUSEPLUGIN },
+	{ L"rehash", CMD_REHASH },
+	{ L"help", CMD_HELP },
+	{ L"test", CMD_TEST },
+};
+
+static CORE_CMD GetCoreCmd(const wstring &wscCmd)
+{
+	static map<wstring, CORE_CMD> mapCoreCmds;
+	if (mapCoreCmds.empty())
+	{
+		for (uint i = 0; i < sizeof(CoreCmds) / sizeof(CORE_CMD_ENTRY); i++)
+			mapCoreCmds[CoreCmds[i].wszName] = CoreCmds[i].eCmd;
+	}
+
+	map<wstring, CORE_CMD>::iterator it = mapCoreCmds.find(wscCmd);
+	return (it != mapCoreCmds.end()) ? it->second : CMD_UNKNOWN;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 bool ExecuteCommandString_Callback(CCmds* classptr, const wstring &wscCmdStr)
 {
@@ -1083,184 +1283,192 @@ void CCmds::ExecuteCommandString(const wstring &wscCmdStr)
 			wscCmd.erase(wscCmd.length() - 1, 1);
 		}
 
-		if (!ExecuteCommandString_Callback(this, wscCmd))
+		// commands registered by plugins, then the plugins hooking every command, then the built-in ones
+		if (!AdminCommands::Execute(this, wscCmd) && !ExecuteCommandString_Callback(this, wscCmd))
 		{
-
-			if (IS_CMD("getcash")) {
+			switch (GetCoreCmd(wscCmd))
+			{
+			case CMD_GETCASH:
 				CmdGetCash(ArgCharname(1));
-			}
-			else if (IS_CMD("setcash")) {
+				break;
+			case CMD_SETCASH:
 				CmdSetCash(ArgCharname(1), ArgInt(2));
-			}
-			else if (IS_CMD("setcashsec")) {
+				break;
+			case CMD_SETCASHSEC:
 				CmdSetCashSec(ArgCharname(1), ArgInt(2), ArgInt(3));
-			}
-			else if (IS_CMD("addcash")) {
+				break;
+			case CMD_ADDCASH:
 				CmdAddCash(ArgCharname(1), ArgInt(2));
-			}
-			else if (IS_CMD("addcashsec")) {
+				break;
+			case CMD_ADDCASHSEC:
 				CmdAddCashSec(ArgCharname(1), ArgInt(2), ArgInt(3));
-			}
-			else if (IS_CMD("kick")) {
+				break;
+			case CMD_KICK:
 				CmdKick(ArgCharname(1), ArgStrToEnd(2));
-			}
-			else if (IS_CMD("ban")) {
+				break;
+			case CMD_BAN:
 				CmdBan(ArgCharname(1));
-			}
-			else if (IS_CMD("unban")) {
+				break;
+			case CMD_UNBAN:
 				CmdUnban(ArgCharname(1));
-			}
-			else if (IS_CMD("kickban")) {
+				break;
+			case CMD_KICKBAN:
 				CmdKickBan(ArgCharname(1), ArgStrToEnd(2));
-			}
-			else if (IS_CMD("getbasestatus")) {
+				break;
+			case CMD_GETBASESTATUS:
 				CmdGetBaseStatus(ArgStr(1));
-			}
-			else if (IS_CMD("getclientid")) {
+				break;
+			case CMD_GETCLIENTID:
 				CmdGetClientId(ArgCharname(1));
-			}
-			else if (IS_CMD("beam")) {
+				break;
+			case CMD_BEAM:
 				CmdBeam(ArgCharname(1), ArgStrToEnd(2));
-			}
-			else if (IS_CMD("kill")) {
+				break;
+			case CMD_KILL:
 				CmdKill(ArgCharname(1));
-			}
-			else if (IS_CMD("resetrep")) {
+				break;
+			case CMD_RESETREP:
 				CmdResetRep(ArgCharname(1));
-			}
-			else if (IS_CMD("setrep")) {
+				break;
+			case CMD_SETREP:
 				CmdSetRep(ArgCharname(1), ArgStr(2), ArgFloat(3));
-			}
-			else if (IS_CMD("setallrep")) { // brac3r - setallrep command, sets all (player) reps to the value
+				break;
+			case CMD_SETALLREP: // brac3r - setallrep command, sets all (player) reps to the value
 				CmdSetAllRep(ArgCharname(1), ArgFloat(2));
-			}
-			else if (IS_CMD("getrep")) {
+				break;
+			case CMD_GETREP:
 				CmdGetRep(ArgCharname(1), ArgStr(2));
-			}
-			else if (IS_CMD("msg")) {
+				break;
+			case CMD_MSG:
 				CmdMsg(ArgCharname(1), ArgStrToEnd(2));
-			}
-			else if (IS_CMD("msgs")) {
+				break;
+			case CMD_MSGS:
 				CmdMsgS(ArgCharname(1), ArgStrToEnd(2));
-			}
-			else if (IS_CMD("msgu")) {
+				break;
+			case CMD_MSGU:
 				CmdMsgU(ArgStrToEnd(1));
-			}
-			else if (IS_CMD("fmsg")) {
+				break;
+			case CMD_FMSG:
 				CmdFMsg(ArgCharname(1), ArgStrToEnd(2));
-			}
-			else if (IS_CMD("fmsgs")) {
+				break;
+			case CMD_FMSGS:
 				CmdFMsgS(ArgCharname(1), ArgStrToEnd(2));
-			}
-			else if (IS_CMD("fmsgu")) {
+				break;
+			case CMD_FMSGU:
 				CmdFMsgU(ArgStrToEnd(1));
-			}
-			else if (IS_CMD("enumcargo")) {
+				break;
+			case CMD_ENUMCARGO:
 				CmdEnumCargo(ArgCharname(1));
-			}
-			else if (IS_CMD("removecargo")) {
+				break;
+			case CMD_REMOVECARGO:
 				CmdRemoveCargo(ArgCharname(1), ArgInt(2), ArgInt(3));
-			}
-			else if (IS_CMD("addcargo")) {
+				break;
+			case CMD_ADDCARGO:
 				CmdAddCargo(ArgCharname(1), ArgStr(2), ArgInt(3), ArgInt(4));
-			}
-			else if (IS_CMD("rename")) {
+				break;
+			case CMD_RENAME:
 				CmdRename(ArgCharname(1), ArgStr(2));
-			}
-			else if (IS_CMD("deletechar")) {
+				break;
+			case CMD_DELETECHAR:
 				CmdDeleteChar(ArgCharname(1));
-			}
-			else if (IS_CMD("readcharfile")) {
+				break;
+			case CMD_READCHARFILE:
 				CmdReadCharFile(ArgCharname(1));
-			}
-			else if (IS_CMD("writecharfile")) {
+				break;
+			case CMD_WRITECHARFILE:
 				CmdWriteCharFile(ArgCharname(1), ArgStrToEnd(2));
-			}
-			else if (IS_CMD("getplayerinfo")) {
+				break;
+			case CMD_GETPLAYERINFO:
 				CmdGetPlayerInfo(ArgCharname(1));
-			}
-			else if (IS_CMD("getplayers")) {
+				break;
+			case CMD_GETPLAYERS:
 				CmdGetPlayers();
-			}
-			else if (IS_CMD("xgetplayerinfo")) {
+				break;
+			case CMD_XGETPLAYERINFO:
 				CmdXGetPlayerInfo(ArgCharname(1));
-			}
-			else if (IS_CMD("xgetplayers")) {
+				break;
+			case CMD_XGETPLAYERS:
 				CmdXGetPlayers();
-			}
-			else if (IS_CMD("getplayerids")) {
+				break;
+			case CMD_GETPLAYERIDS:
 				CmdGetPlayerIDs();
-			}
-			else if (IS_CMD("getaccountdirname")) {
+				break;
+			case CMD_GETACCOUNTDIRNAME:
 				CmdGetAccountDirName(ArgCharname(1));
-			}
-			else if (IS_CMD("getcharfilename")) {
+				break;
+			case CMD_GETCHARFILENAME:
 				CmdGetCharFileName(ArgCharname(1));
-			}
-			else if (IS_CMD("savechar")) {
+				break;
+			case CMD_SAVECHAR:
 				CmdSaveChar(ArgCharname(1));
-			}
-			else if (IS_CMD("isonserver")) {
+				break;
+			case CMD_ISONSERVER:
 				CmdIsOnServer(ArgCharname(1));
-			}
-			else if (IS_CMD("isloggedin")) {
+				break;
+			case CMD_ISLOGGEDIN:
 				CmdIsLoggedIn(ArgCharname(1));
-			}
-			else if (IS_CMD("moneyfixlist")) {
+				break;
+			case CMD_MONEYFIXLIST:
 				CmdMoneyFixList();
-			}
-			else if (IS_CMD("serverinfo")) {
+				break;
+			case CMD_SERVERINFO:
 				CmdServerInfo();
-			}
-			else if (IS_CMD("getgroupmembers")) {
+				break;
+			case CMD_PERFSTATS:
+				CmdPerfStats(ArgStr(1));
+				break;
+			case CMD_FRAMESTATS:
+				CmdFrameStats();
+				break;
+			case CMD_GETGROUPMEMBERS:
 				CmdGetGroupMembers(ArgCharname(1));
-			}
-			else if (IS_CMD("getreservedslot")) {
+				break;
+			case CMD_GETRESERVEDSLOT:
 				CmdGetReservedSlot(ArgCharname(1));
-			}
-			else if (IS_CMD("setreservedslot")) {
+				break;
+			case CMD_SETRESERVEDSLOT:
 				CmdSetReservedSlot(ArgCharname(1), ArgInt(2));
-			}
-			else if (IS_CMD("setadmin")) {
+				break;
+			case CMD_SETADMIN:
 				CmdSetAdmin(ArgCharname(1), ArgStrToEnd(2));
-			}
-			else if (IS_CMD("getadmin")) {
+				break;
+			case CMD_GETADMIN:
 				CmdGetAdmin(ArgCharname(1));
-			}
-			else if (IS_CMD("deladmin")) {
+				break;
+			case CMD_DELADMIN:
 				CmdDelAdmin(ArgCharname(1));
-			}
-			else if (IS_CMD("unloadplugin")) {
+				break;
+			case CMD_UNLOADPLUGIN:
 				CmdUnloadPlugin(ArgStrToEnd(1));
-			}
-			else if (IS_CMD("loadplugins")) {
+				break;
+			case CMD_LOADPLUGINS:
 				CmdLoadPlugins();
-			}
-			else if (IS_CMD("loadplugin")) {
+				break;
+			case CMD_LOADPLUGIN:
 				CmdLoadPlugin(ArgStrToEnd(1));
-			}
-			else if (IS_CMD("listplugins")) {
+				break;
+			case CMD_LISTPLUGINS:
 				CmdListPlugins();
-			}
-			else if (IS_CMD("pauseplugin")) {
+				break;
+			case CMD_PAUSEPLUGIN:
 				CmdPausePlugin(ArgStrToEnd(1));
-			}
-			else if (IS_CMD("unpauseplugin")) {
+				break;
+			case CMD_UNPAUSEPLUGIN:
 				CmdUnpausePlugin(ArgStrToEnd(1));
-			}
-			else if (IS_CMD("rehash")) {
+				break;
+			case CMD_REHASH:
 				CmdRehash();
-			}
-			else if (IS_CMD("help")) {
+				break;
+			case CMD_HELP:
 				CmdHelp();
-			}
-			else if (IS_CMD("test")) {
+				break;
+			case CMD_TEST:
 				CmdTest(ArgInt(1), ArgInt(2), ArgInt(3));
-			}
-			else {
+				break;
+			default:
 				Print(L"ERR unknown command\n");
+				break;
 			}
-
 		}
 		if (bSocket)
 		{
@@ -95,6 +95,8 @@ public:
 	void CmdIsLoggedIn(const wstring &wscCharname);
 	void CmdMoneyFixList();
 	void CmdServerInfo();
+	void CmdPerfStats(const wstring &wscParam);
+	void CmdFrameStats();
 	void CmdGetGroupMembers(const wstring &wscCharname);
 
 	void CmdSaveChar(const wstring &wscCharname);
@@ -132,4 +134,17 @@ public:
 	wstring wscCurCmdString;
 };
 
+// admin commands of plugins
+typedef bool(*ADMIN_CMD_CALLBACK)(CCmds *cmds, const wstring &wscCmd);
+EXPORT bool HkRegisterAdminCommand(const wstring &wscCmd, DWORD dwRights, ADMIN_CMD_CALLBACK callback);
+EXPORT void HkUnregisterAdminCommand(const wstring &wscCmd);
+namespace AdminCommands
+{
+	bool Register(const wstring &wscCmd, DWORD dwRights, ADMIN_CMD_CALLBACK callback);
+	void Unregister(const wstring &wscCmd);
+	void PauseModule(HMODULE hModule, bool bPause);
+	void RemoveModule(HMODULE hModule);
+	bool Execute(CCmds *cmds, const wstring &wscCmd);
+}
+
 #endif
\ No newline at end of file
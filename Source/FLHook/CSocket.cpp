@@ -1,80 +1,146 @@
 #include "CSocket.h"
 
+#define RINGBUFFER_MIN_SIZE 4096
+#define RINGBUFFER_KEEP_SIZE (64 * 1024)
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void CSocket::DoPrint(const wstring &wscTextIn)
+bool CRingBuffer::Reserve(uint iNeeded)
 {
-	wstring wscText(wscTextIn);
-	for (uint i = 0; (i < wscText.length()); i++)
+	if (iNeeded <= vData.size())
+		return true;
+	if (iNeeded > iMaxSize)
+		return false;
+
+	uint iCapacity = vData.size() ? (uint)vData.size() : RINGBUFFER_MIN_SIZE;
+	while (iCapacity < iNeeded)
+		iCapacity *= 2;
+	if (iCapacity > iMaxSize)
+		iCapacity = iMaxSize;
+
+	// unwrap the queued data into the new buffer
+	vector<char> vNew(iCapacity);
+	if (iSize)
 	{
-		if (wscText[i] == '\n')
-		{
-			wscText.replace(i, 1, L"\r\n");
-			i++;
-		}
+		uint iFirst = min(iSize, (uint)vData.size() - iHead);
+		memcpy(&vNew[0], &vData[iHead], iFirst);
+		if (iSize > iFirst)
+			memcpy(&vNew[iFirst], &vData[0], iSize - iFirst);
 	}
 
-	int iSndBuf = 300000; // fix: set send-buffer to this size (bytes) 
-	int size = sizeof(int);
-	setsockopt(this->s, SOL_SOCKET, SO_SNDBUF, (const char*)&iSndBuf, size);
+	vData.swap(vNew);
+	iHead = 0;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CRingBuffer::Write(const char *pData, uint iLen)
+{
+	if (!iLen)
+		return true;
+	if (!Reserve(iSize + iLen))
+		return false;
+
+	uint iCapacity = (uint)vData.size();
+	uint iTail = (iHead + iSize) % iCapacity;
+	uint iFirst = min(iLen, iCapacity - iTail);
+	memcpy(&vData[iTail], pData, iFirst);
+	if (iLen > iFirst)
+		memcpy(&vData[0], pData + iFirst, iLen - iFirst);
+	iSize += iLen;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-	if (bEncrypted)
+char* CRingBuffer::WritePtr(uint &iLen)
+{
+	if (iSize == vData.size() && !Reserve(iSize + 1))
 	{
-		int iLen;
-		char *data;
-		const char* tempData;
-		if (bUnicode)
-		{
-			uint iRem = (uint)(wscText.length() % 4);
-			if (iRem) //Data to be encrypted is not a multiple of 8 bytes, add 0x00s to compensate
-			{
-				iRem = 4 - iRem;
-				wscText.resize(wscText.length() + iRem, L'\x00');
-			}
-			tempData = (const char*)wscText.data();
-			iLen = (uint)(wscText.length() * 2);
-			data = (char*)malloc(iLen);
-			memcpy(data, tempData, iLen);
-		}
-		else
-		{
-			uint iRem = (uint)(wscText.length() % 8);
-			if (iRem)
-			{
-				iRem = 8 - iRem;
-				string scText = wstos(wscText);
-				scText.resize(scText.length() + iRem, '\x00');
-				tempData = scText.data();
-				iLen = (int)scText.length();
-				data = (char*)malloc(iLen);
-				memcpy(data, tempData, iLen);
-			}
-			else
-			{
-				string scText = wstos(wscText);
-				tempData = scText.data();
-				iLen = (int)wscText.length();
-				data = (char*)malloc(iLen);
-				memcpy(data, tempData, iLen);
-			}
-		}
-
-		SwapBytes(data, iLen);
-		if (Blowfish_Encrypt(bfc, data, iLen))
-		{
-			SwapBytes(data, iLen);
-			send(this->s, data, iLen, 0);
-			free(data);
-		}
+		iLen = 0;
+		return 0;
 	}
-	else
+
+	uint iCapacity = (uint)vData.size();
+	uint iTail = (iHead + iSize) % iCapacity;
+	iLen = (iTail >= iHead) ? (iCapacity - iTail) : (iHead - iTail);
+	return &vData[iTail];
+}
+
+void CRingBuffer::Commit(uint iLen)
+{
+	iSize += iLen;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const char* CRingBuffer::ReadPtr(uint &iLen) const
+{
+	if (!iSize)
 	{
-		if (bUnicode)
-			send(this->s, (const char*)wscText.c_str(), (int)wscText.length() * 2, 0);
-		else
-			send(this->s, wstos(wscText).c_str(), (int)wscText.length(), 0);
+		iLen = 0;
+		return 0;
 	}
 
+	iLen = min(iSize, (uint)vData.size() - iHead);
+	return &vData[iHead];
+}
+
+void CRingBuffer::Consume(uint iLen)
+{
+	iSize -= iLen;
+	iHead = iSize ? ((iHead + iLen) % (uint)vData.size()) : 0;
+
+	// don't keep the memory of a burst around
+	if (!iSize && vData.size() > RINGBUFFER_KEEP_SIZE)
+		vector<char>().swap(vData);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CSocketQueue::Push(SOCKET_MESSAGE_TYPE eType, uint iConnID, const wstring &wscText)
+{
+	LONG lSlot = lTail;
+	LONG lNext = (lSlot + 1) % (LONG)vSlots.size();
+	if (lNext == lHead)
+		return false;
+
+	SOCKET_MESSAGE &msg = vSlots[lSlot];
+	msg.eType = eType;
+	msg.iConnID = iConnID;
+	msg.wscText.assign(wscText);
+	InterlockedExchange(&lTail, lNext);
+	return true;
+}
+
+bool CSocketQueue::Pop(SOCKET_MESSAGE &msg)
+{
+	LONG lSlot = lHead;
+	if (lSlot == lTail)
+		return false;
+
+	SOCKET_MESSAGE &slot = vSlots[lSlot];
+	msg.eType = slot.eType;
+	msg.iConnID = slot.iConnID;
+	msg.wscText.swap(slot.wscText);
+	InterlockedExchange(&lHead, (lSlot + 1) % (LONG)vSlots.size());
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// hands the text to the network thread, which encodes, encrypts and sends it
+void CSocket::DoPrint(const wstring &wscText)
+{
+	if (bOverflow)
+		return;
+
+	if (!SocketServer::Send(SOCKET_MSG_TEXT, iConnID, wscText))
+	{
+		AddLog("socket: output queue full, closing connection from %s:%d", sIP.c_str(), iPort);
+		bOverflow = true;
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -3,19 +3,89 @@
 #ifndef _CSOCKET_
 #define _CSOCKET_
 
+// byte ring buffer that grows (by doubling) up to a maximum size
+class CRingBuffer
+{
+	vector<char> vData;
+	uint iHead;
+	uint iSize;
+	uint iMaxSize;
+
+	bool Reserve(uint iNeeded);
+
+public:
+	CRingBuffer(uint iMaxSize) : iHead(0), iSize(0), iMaxSize(iMaxSize) {}
+	uint Size() const { return iSize; }
+	bool Write(const char *pData, uint iLen);
+	char* WritePtr(uint &iLen); // contiguous free space, 0 if the buffer is at its maximum
+	void Commit(uint iLen);
+	const char* ReadPtr(uint &iLen) const; // contiguous queued data
+	void Consume(uint iLen);
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum SOCKET_MESSAGE_TYPE
+{
+	// network thread -> game thread
+	SOCKET_MSG_OPENED,
+	SOCKET_MSG_COMMAND,
+	SOCKET_MSG_CLOSED,
+
+	// game thread -> network thread
+	SOCKET_MSG_TEXT,
+	SOCKET_MSG_AUTHED,
+	SOCKET_MSG_CLOSE,
+	SOCKET_MSG_EVENTMODE, // text: topics to receive, separated by spaces (all if empty)
+	SOCKET_MSG_EVENTS, // connection id 0, text: a batch of event lines
+};
+
+struct SOCKET_MESSAGE
+{
+	SOCKET_MESSAGE_TYPE eType;
+	uint iConnID;
+	wstring wscText;
+};
+
+// bounded single producer/single consumer queue. the slots are allocated once, pushing and popping swap
+// the text buffers in and out so they are reused instead of allocated per message.
+class CSocketQueue
+{
+	vector<SOCKET_MESSAGE> vSlots;
+	volatile LONG lHead;
+	volatile LONG lTail;
+
+public:
+	CSocketQueue(uint iSize) : vSlots(iSize), lHead(0), lTail(0) {}
+	bool Push(SOCKET_MESSAGE_TYPE eType, uint iConnID, const wstring &wscText);
+	bool Pop(SOCKET_MESSAGE &msg);
+	bool Full() const { return ((lTail + 1) % (LONG)vSlots.size()) == lHead; }
+};
+
+namespace SocketServer
+{
+	void Start();
+	void Stop();
+	bool Receive(SOCKET_MESSAGE &msg);
+	bool Send(SOCKET_MESSAGE_TYPE eType, uint iConnID, const wstring &wscText);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// admin state of a socket connection, the socket itself belongs to the network thread (SocketServer)
 class CSocket : public CCmds
 {
 public:
-	SOCKET s;
-	BLOWFISH_CTX *bfc;
+	uint iConnID;
 	bool bAuthed;
 	bool bEventMode;
 	bool bUnicode;
 	bool bEncrypted;
 	string sIP;
 	ushort iPort;
+	bool bOverflow; // output couldn't be queued, the connection gets closed
 
-	CSocket() { bAuthed = false; bEventMode = false; bUnicode = false; }
+	CSocket() { iConnID = 0; bAuthed = false; bEventMode = false; bUnicode = false; bEncrypted = false; bOverflow = false; }
 	void DoPrint(const wstring &wscText);
 	wstring GetAdminName();
 };
@@ -0,0 +1,177 @@
+#include "hook.h"
+
+/**************************************************************************************************************
+multi pattern substring search (aho-corasick). the patterns are added in lower case and compiled into a trie
+with failure links, a text is then scanned once no matter how many patterns there are. the text is lowered
+char by char while scanning so the caller doesn't have to copy it.
+whole word patterns only match if they are not surrounded by letters or digits.
+**************************************************************************************************************/
+
+CStringMatcher::CStringMatcher()
+{
+	Clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CStringMatcher::Clear()
+{
+	vNodes.clear();
+	vNodes.push_back(NODE());
+	vNodes[0].iFail = 0;
+	vNodes[0].iOutput = 0;
+	vNodes[0].iLen = 0;
+	vNodes[0].iMask = 0;
+	vNodes[0].iWordMask = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CStringMatcher::Add(const wstring &wscPattern, uint iMask, bool bWholeWord)
+{
+	if (!wscPattern.length())
+		return;
+
+	uint iNode = 0;
+	for (uint i = 0; i < wscPattern.length(); i++)
+	{
+		wchar_t wc = towlower(wscPattern[i]);
+		map<wchar_t, uint>::iterator it = vNodes[iNode].mapNext.find(wc);
+		if (it != vNodes[iNode].mapNext.end())
+		{
+			iNode = it->second;
+			continue;
+		}
+
+		vNodes.push_back(NODE());
+		uint iChild = (uint)vNodes.size() - 1;
+		vNodes[iChild].iFail = 0;
+		vNodes[iChild].iOutput = 0;
+		vNodes[iChild].iLen = i + 1;
+		vNodes[iChild].iMask = 0;
+		vNodes[iChild].iWordMask = 0;
+		vNodes[iNode].mapNext[wc] = iChild;
+		iNode = iChild;
+	}
+
+	if (bWholeWord)
+		vNodes[iNode].iWordMask |= iMask;
+	else
+		vNodes[iNode].iMask |= iMask;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// sets the failure links breadth first, the output link points to the next shorter pattern ending in the same place
+void CStringMatcher::Compile()
+{
+	list<uint> lstQueue;
+	for (map<wchar_t, uint>::iterator it = vNodes[0].mapNext.begin(); it != vNodes[0].mapNext.end(); it++)
+	{
+		vNodes[it->second].iFail = 0;
+		vNodes[it->second].iOutput = 0;
+		lstQueue.push_back(it->second);
+	}
+
+	while (lstQueue.size())
+	{
+		uint iNode = lstQueue.front();
+		lstQueue.pop_front();
+
+		for (map<wchar_t, uint>::iterator it = vNodes[iNode].mapNext.begin(); it != vNodes[iNode].mapNext.end(); it++)
+		{
+			NODE &child = vNodes[it->second];
+			child.iFail = Next(vNodes[iNode].iFail, it->first);
+			const NODE &fail = vNodes[child.iFail];
+			child.iOutput = (fail.iMask || fail.iWordMask) ? child.iFail : fail.iOutput;
+			lstQueue.push_back(it->second);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint CStringMatcher::Next(uint iNode, wchar_t wc) const
+{
+	while (true)
+	{
+		map<wchar_t, uint>::const_iterator it = vNodes[iNode].mapNext.find(wc);
+		if (it != vNodes[iNode].mapNext.end())
+			return it->second;
+		if (!iNode)
+			return 0;
+		iNode = vNodes[iNode].iFail;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool IsWord(const wstring &wscText, uint iPos, uint iLen)
+{
+	if (iPos && iswalnum(wscText[iPos - 1]))
+		return false;
+	if ((iPos + iLen) < wscText.length() && iswalnum(wscText[iPos + iLen]))
+		return false;
+	return true;
+}
+
+uint CStringMatcher::Scan(const wstring &wscText, list<STRING_MATCH> *lstMatches) const
+{
+	if (vNodes[0].mapNext.empty())
+		return 0;
+
+	uint iMask = 0;
+	uint iNode = 0;
+	for (uint i = 0; i < wscText.length(); i++)
+	{
+		iNode = Next(iNode, towlower(wscText[i]));
+
+		// every pattern ending here
+		uint iOut = (vNodes[iNode].iMask || vNodes[iNode].iWordMask) ? iNode : vNodes[iNode].iOutput;
+		for (; iOut; iOut = vNodes[iOut].iOutput)
+		{
+			const NODE &node = vNodes[iOut];
+			uint iPos = i + 1 - node.iLen;
+			uint iHit = node.iMask;
+			if (node.iWordMask && IsWord(wscText, iPos, node.iLen))
+				iHit |= node.iWordMask;
+			if (!iHit)
+				continue;
+
+			iMask |= iHit;
+			if (lstMatches)
+			{
+				STRING_MATCH match;
+				match.iPos = iPos;
+				match.iLen = node.iLen;
+				match.iMask = iHit;
+				lstMatches->push_back(match);
+			}
+		}
+	}
+
+	return iMask;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// returns the masks of all patterns found in wscText or'ed together, Compile must have been called
+uint CStringMatcher::Match(const wstring &wscText) const
+{
+	return Scan(wscText, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// appends every match (position and length in wscText) in the order the matches end, returns the masks like Match
+uint CStringMatcher::Find(const wstring &wscText, list<STRING_MATCH> &lstMatches) const
+{
+	return Scan(wscText, &lstMatches);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool CStringMatcher::Empty() const
+{
+	return vNodes[0].mapNext.empty();
+}
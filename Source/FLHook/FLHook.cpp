@@ -1,5 +1,6 @@
 #include "global.h"
 #include <Psapi.h>
+#include <map>
 #include "hook.h"
 #include "CConsole.h"
 #include "CSocket.h"
@@ -11,7 +12,6 @@ EXPORT st6_free_t st6_free;
 // structs
 struct SOCKET_CONNECTION
 {
-	wstring wscPending;
 	CSocket	csock;
 };
 
@@ -40,11 +40,13 @@ SOCKET sEWListen = INVALID_SOCKET;
 list<wstring*> lstConsoleCmds;
 list<SOCKET_CONNECTION*> lstSockets;
 list<SOCKET_CONNECTION*> lstDelete;
+map<uint, SOCKET_CONNECTION*> mapSockets;
+uint iEventModeSockets = 0;
+wstring wscEventBatch;
+uint iEventsDropped = 0;
 
 CRITICAL_SECTION cs;
 
-FILE *fLog = 0;
-FILE *fLogDebug = 0;
 
 bool bExecuted = false;
 
@@ -243,7 +245,7 @@ void FLHookInit_Pre()
 		hConsoleThread = CreateThread(0, 0, (LPTHREAD_START_ROUTINE)ReadConsoleEvents, &dwParam, 0, &id);
 
 		// logs
-		fLog = fopen("./flhook_logs/FLHook.log", "at");
+		InitLogs();
 		char szDate[64];
 		time_t tNow = time(0);
 		struct tm *t = localtime(&tNow);
@@ -332,8 +334,7 @@ bool FLHookInit()
 		// load settings
 		LoadSettings();
 
-		if (set_bDebug && !fLogDebug)
-			fLogDebug = fopen(sDebugLog.c_str(), "at");
+		UpdateDebugLog();
 
 		CALL_PLUGINS_NORET(PLUGIN_LoadSettings, , (), ());
 
@@ -413,6 +414,9 @@ bool FLHookInit()
 					ConPrint(L"socket(encrypted-unicode): socket connection listening\n");
 				}
 			}
+
+			// accepting, reading and writing is done by the network thread
+			SocketServer::Start();
 		}
 
 
@@ -465,7 +469,8 @@ void FLHookUnload()
 	SetConsoleCtrlHandler(ConsoleHandler, FALSE);
 	FreeConsole();
 
-	// quit network sockets
+	// quit network sockets, the network thread has to stop using them first
+	SocketServer::Stop();
 	if (sListen != INVALID_SOCKET)
 		closesocket(sListen);
 	if (sWListen != INVALID_SOCKET)
@@ -476,11 +481,9 @@ void FLHookUnload()
 		closesocket(sEWListen);
 
 	for (list<SOCKET_CONNECTION*>::iterator i = lstSockets.begin(); (i != lstSockets.end()); i++)
-	{
-		closesocket((*i)->csock.s);
 		delete *i;
-	}
 	lstSockets.clear();
+	mapSockets.clear();
 
 	// free blowfish encryption data
 	if (set_BF_CTX)
@@ -524,10 +527,8 @@ void FLHookShutdown()
 
 	AddLog("-------------------");
 
-	// close log
-	fclose(fLog);
-	if (set_bDebug)
-		fclose(fLogDebug);
+	// write and close the logs
+	Logger::Shutdown();
 
 	// unload rest
 	DWORD id;
@@ -588,6 +589,9 @@ bool ProcessSocketCmd(SOCKET_CONNECTION *sc, wstring wscCmd)
 			else if (!scPass.compare(wstos(wszPass))) {
 				sc->csock.bAuthed = true;
 				sc->csock.SetRightsByString(scRights);
+				// lifts the input limit of the connection
+				if (!SocketServer::Send(SOCKET_MSG_AUTHED, sc->csock.iConnID, L""))
+					sc->csock.bOverflow = true;
 				sc->csock.Print(L"OK\n");
 				ConPrint(L"socket: socket authentication successful\n");
 				return false;
@@ -600,9 +604,14 @@ bool ProcessSocketCmd(SOCKET_CONNECTION *sc, wstring wscCmd)
 		if (wscCmd[wscCmd.length() - 1] == '\r')
 			wscCmd = wscCmd.substr(0, wscCmd.length() - 1);
 
-		if (!wscCmd.compare(L"eventmode")) {
+		if (!wscCmd.compare(0, 9, L"eventmode") && (wscCmd.length() == 9 || wscCmd[9] == L' ')) {
 			if (sc->csock.rights & RIGHT_EVENTMODE) {
 				sc->csock.Print(L"OK\n");
+				// "eventmode <topic> <topic> ..." only receives these events (e.g. chat kill launch)
+				if (!SocketServer::Send(SOCKET_MSG_EVENTMODE, sc->csock.iConnID, wscCmd.substr(min(wscCmd.length(), (size_t)10))))
+					sc->csock.bOverflow = true;
+				if (!sc->csock.bEventMode)
+					iEventModeSockets++;
 				sc->csock.bEventMode = true;
 			}
 			else {
@@ -634,9 +643,36 @@ void ConPrint(wstring wscText, ...)
 }
 
 /**************************************************************************************************************
-send event to all sockets which are in eventmode
+send event to all sockets which are in eventmode. the events of a frame are collected and handed to the network
+thread in one batch (FlushEvents), which encodes every line once and sends it to all matching connections.
 **************************************************************************************************************/
 
+#define EVENT_BATCH_MAX (256 * 1024)
+
+static void DispatchEvent(wstring &wscText)
+{
+	CALL_PLUGINS_V(PLUGIN_ProcessEvent_BEFORE, , (wstring &wscText), (wscText));
+
+	if (!iEventModeSockets)
+		return;
+
+	if (wscEventBatch.length() + wscText.length() >= EVENT_BATCH_MAX)
+	{
+		iEventsDropped++;
+		return;
+	}
+
+	// one line per event, line breaks in e.g. chat text would start a new event
+	size_t iStart = wscEventBatch.length();
+	wscEventBatch += wscText;
+	for (size_t i = iStart; i < wscEventBatch.length(); i++)
+	{
+		if (wscEventBatch[i] == L'\n' || wscEventBatch[i] == L'\r')
+			wscEventBatch[i] = L' ';
+	}
+	wscEventBatch += L'\n';
+}
+
 void ProcessEvent(wstring wscText, ...)
 {
 	wchar_t wszBuf[1024] = L"";
@@ -645,20 +681,41 @@ void ProcessEvent(wstring wscText, ...)
 	_vsnwprintf(wszBuf, (sizeof(wszBuf) / 2) - 1, wscText.c_str(), marker);
 
 	wscText = wszBuf;
+	DispatchEvent(wscText);
+}
 
-	CALL_PLUGINS_V(PLUGIN_ProcessEvent_BEFORE, , (wstring &wscText), (wscText));
+void FlushEvents()
+{
+	if (wscEventBatch.empty())
+		return;
 
-	foreach(lstSockets, SOCKET_CONNECTION*, i)
+	// stays queued when the network thread is behind, new events are dropped once the batch is full
+	if (!SocketServer::Send(SOCKET_MSG_EVENTS, 0, wscEventBatch))
+		return;
+
+	wscEventBatch.clear();
+	if (iEventsDropped)
 	{
-		if ((*i)->csock.bEventMode)
-			(*i)->csock.Print(L"%s\n", wscText.c_str());
+		AddLog("socket: %u events dropped, the event mode connections don't keep up", iEventsDropped);
+		iEventsDropped = 0;
 	}
 }
 
 /**************************************************************************************************************
 process and send an eventmode log message for given chat parameters
 **************************************************************************************************************/
+static void AppendUInt(wstring &wscText, uint iValue)
+{
+	wchar_t wszBuf[16];
+	_ultow(iValue, wszBuf, 10);
+	wscText += wszBuf;
+}
+
 void SendChatEvent(uint iClientID, uint iToID, wstring &wscMsg) {
+	// nobody would see it
+	if (!iEventModeSockets && !pPluginDispatch[(int)PLUGIN_ProcessEvent_BEFORE].iCount)
+		return;
+
 	wstring wscEvent;
 	wscEvent.reserve(256);
 	wscEvent = L"chat";
@@ -672,7 +729,7 @@ void SendChatEvent(uint iClientID, uint iToID, wstring &wscMsg) {
 		wscEvent += wszFrom;
 
 	wscEvent += L" id=";
-	wscEvent += stows(itos(iClientID));
+	AppendUInt(wscEvent, iClientID);
 
 	wscEvent += L" type=";
 	if (iToID == 0x00010000)
@@ -681,7 +738,7 @@ void SendChatEvent(uint iClientID, uint iToID, wstring &wscMsg) {
 	{
 		wscEvent += L"group";
 		wscEvent += L" grpidto=";
-		wscEvent += stows(itos(Players.GetGroupID(iClientID)));
+		AppendUInt(wscEvent, Players.GetGroupID(iClientID));
 	}
 	else if (iToID & 0x00010000)
 		wscEvent += L"system";
@@ -698,233 +755,122 @@ void SendChatEvent(uint iClientID, uint iToID, wstring &wscMsg) {
 			wscEvent += wszTo;
 
 		wscEvent += L" idto=";
-		wscEvent += stows(itos(iToID));
+		AppendUInt(wscEvent, iToID);
 	}
 
 	wscEvent += L" text=";
 	wscEvent += wscMsg;
-	ProcessEvent(L"%s", wscEvent.c_str());
+	DispatchEvent(wscEvent);
 }
 
 /**************************************************************************************************************
-check for pending admin commands in console or socket and execute them
+game thread side of the admin sockets. the network thread (SocketServer) hands over new connections, complete
+command lines and closed connections, the commands are executed here and their output is handed back.
 **************************************************************************************************************/
 
-struct timeval tv = { 0, 0 };
+static void RemoveSocketConnection(SOCKET_CONNECTION *sc)
+{
+	if (sc->csock.bEventMode)
+		iEventModeSockets--;
+	mapSockets.erase(sc->csock.iConnID);
+	lstSockets.remove(sc);
+	delete sc;
+}
 
-void ProcessPendingCommands()
+// false if the close couldn't be queued, it's retried on the next call
+static bool CloseSocketConnection(SOCKET_CONNECTION *sc)
 {
-	try {
-		// check for new console commands
-		EnterCriticalSection(&cs);
-		while (lstConsoleCmds.size())
-		{
-			wstring *pwscCmd = lstConsoleCmds.front();
-			lstConsoleCmds.pop_front();
-			AdminConsole.ExecuteCommandString(*pwscCmd);
-			delete pwscCmd;
-		}
-		LeaveCriticalSection(&cs);
+	if (!SocketServer::Send(SOCKET_MSG_CLOSE, sc->csock.iConnID, L""))
+	{
+		sc->csock.bOverflow = true;
+		return false;
+	}
 
-		if (sListen != INVALID_SOCKET)
-		{ // check for new ascii socket connections
-			FD_SET fds;
-			FD_ZERO(&fds);
-			FD_SET(sListen, &fds);
-			if (select(0, &fds, 0, 0, &tv))
-			{ // accept new connection 
-				sockaddr_in adr;
-
-				int iLen = sizeof(adr);
-				SOCKET s = accept(sListen, (sockaddr*)&adr, &iLen);
-				ulong lNB = 1;
-				ioctlsocket(s, FIONBIO, &lNB);
-				SOCKET_CONNECTION *sc = new SOCKET_CONNECTION;
-				sc->csock.s = s;
-				sc->csock.sIP = (string)inet_ntoa(adr.sin_addr);
-				sc->csock.iPort = adr.sin_port;
-				sc->csock.bUnicode = false;
-				sc->csock.bEncrypted = false;
-				sc->wscPending = L"";
-				lstSockets.push_back(sc);
-				ConPrint(L"socket(ascii): new socket connection from %s:%d\n", stows(sc->csock.sIP).c_str(), sc->csock.iPort);
-				sc->csock.Print(L"Welcome to FLHack, please authenticate\n");
-			}
-		}
+	RemoveSocketConnection(sc);
+	return true;
+}
 
-		if (sWListen != INVALID_SOCKET)
-		{ // check for new ascii socket connections
-			FD_SET fds;
-			FD_ZERO(&fds);
-			FD_SET(sWListen, &fds);
-			if (select(0, &fds, 0, 0, &tv))
-			{ // accept new connection 
-				sockaddr_in adr;
-
-				int iLen = sizeof(adr);
-				SOCKET s = accept(sWListen, (sockaddr*)&adr, &iLen);
-				ulong lNB = 1;
-				ioctlsocket(s, FIONBIO, &lNB);
-				SOCKET_CONNECTION *sc = new SOCKET_CONNECTION;
-				sc->csock.s = s;
-				sc->csock.sIP = (string)inet_ntoa(adr.sin_addr);
-				sc->csock.iPort = adr.sin_port;
-				sc->csock.bUnicode = true;
-				sc->wscPending = L"";
-				sc->csock.bEncrypted = false;
-				lstSockets.push_back(sc);
-				ConPrint(L"socket(unicode): new socket connection from %s:%d\n", stows(sc->csock.sIP).c_str(), sc->csock.iPort);
-				sc->csock.Print(L"Welcome to FLHack, please authenticate\n");
-			}
-		}
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-		if (sEListen != INVALID_SOCKET)
-		{ // check for new ascii socket connections
-			FD_SET fds;
-			FD_ZERO(&fds);
-			FD_SET(sEListen, &fds);
-			if (select(0, &fds, 0, 0, &tv))
-			{ // accept new connection 
-				sockaddr_in adr;
-
-				int iLen = sizeof(adr);
-				SOCKET s = accept(sEListen, (sockaddr*)&adr, &iLen);
-				ulong lNB = 1;
-				ioctlsocket(s, FIONBIO, &lNB);
-				SOCKET_CONNECTION *sc = new SOCKET_CONNECTION;
-				sc->csock.s = s;
-				sc->csock.sIP = (string)inet_ntoa(adr.sin_addr);
-				sc->csock.iPort = adr.sin_port;
-				sc->csock.bUnicode = false;
-				sc->wscPending = L"";
-				sc->csock.bEncrypted = true;
-				sc->csock.bfc = set_BF_CTX;
-				lstSockets.push_back(sc);
-				ConPrint(L"socket(encrypted-ascii): new socket connection from %s:%d\n", stows(sc->csock.sIP).c_str(), sc->csock.iPort);
-				sc->csock.Print(L"Welcome to FLHack, please authenticate\n");
-			}
+static void ProcessSockets()
+{
+	SOCKET_MESSAGE msg;
+	while (SocketServer::Receive(msg))
+	{
+		if (msg.eType == SOCKET_MSG_OPENED)
+		{
+			// "<ip> <port> <unicode> <encrypted>"
+			wchar_t wszIP[64] = L"";
+			uint iPort = 0, iUnicode = 0, iEncrypted = 0;
+			swscanf(msg.wscText.c_str(), L"%63s %u %u %u", wszIP, &iPort, &iUnicode, &iEncrypted);
+
+			SOCKET_CONNECTION *sc = new SOCKET_CONNECTION;
+			sc->csock.iConnID = msg.iConnID;
+			sc->csock.sIP = wstos(wszIP);
+			sc->csock.iPort = (ushort)iPort;
+			sc->csock.bUnicode = (iUnicode != 0);
+			sc->csock.bEncrypted = (iEncrypted != 0);
+			lstSockets.push_back(sc);
+			mapSockets[msg.iConnID] = sc;
+
+			const wchar_t *wszType = sc->csock.bEncrypted ? (sc->csock.bUnicode ? L"encrypted-unicode" : L"encrypted-ascii") : (sc->csock.bUnicode ? L"unicode" : L"ascii");
+			ConPrint(L"socket(%s): new socket connection from %s:%d\n", wszType, wszIP, sc->csock.iPort);
+			sc->csock.Print(L"Welcome to FLHack, please authenticate\n");
+			continue;
 		}
 
-		if (sEWListen != INVALID_SOCKET)
-		{ // check for new ascii socket connections
-			FD_SET fds;
-			FD_ZERO(&fds);
-			FD_SET(sEWListen, &fds);
-			if (select(0, &fds, 0, 0, &tv))
-			{ // accept new connection 
-				sockaddr_in adr;
-
-				int iLen = sizeof(adr);
-				SOCKET s = accept(sEWListen, (sockaddr*)&adr, &iLen);
-				ulong lNB = 1;
-				ioctlsocket(s, FIONBIO, &lNB);
-				SOCKET_CONNECTION *sc = new SOCKET_CONNECTION;
-				sc->csock.s = s;
-				sc->csock.sIP = (string)inet_ntoa(adr.sin_addr);
-				sc->csock.iPort = adr.sin_port;
-				sc->csock.bUnicode = true;
-				sc->wscPending = L"";
-				sc->csock.bEncrypted = true;
-				sc->csock.bfc = set_BF_CTX;
-				lstSockets.push_back(sc);
-				ConPrint(L"socket(encrypted-unicode): new socket connection from %s:%d\n", stows(sc->csock.sIP).c_str(), sc->csock.iPort);
-				sc->csock.Print(L"Welcome to FLHack, please authenticate\n");
-			}
-		}
+		map<uint, SOCKET_CONNECTION*>::iterator it = mapSockets.find(msg.iConnID);
+		if (it == mapSockets.end())
+			continue;
 
-		// check for pending socket-commands
-		foreach(lstSockets, SOCKET_CONNECTION*, i)
+		SOCKET_CONNECTION *sc = it->second;
+		if (msg.eType == SOCKET_MSG_COMMAND)
 		{
-			SOCKET_CONNECTION *sc = *i;
-
-			FD_SET fds;
-			FD_ZERO(&fds);
-			FD_SET(sc->csock.s, &fds);
-			struct timeval tv = { 0, 0 };
-			if (select(0, &fds, 0, 0, &tv))
-			{ // data to be read
-				ulong lSize;
-				ioctlsocket(sc->csock.s, FIONREAD, &lSize);
-				char *szData = new char[lSize + 1];
-				memset(szData, 0, lSize + 1);
-				if (recv(sc->csock.s, szData, lSize, 0) <= 0)
-				{
-					ConPrint(L"socket: socket connection closed\n");
-					delete[] szData;
-					lstDelete.push_back(sc);
-					continue;
-				}
-
-				// enqueue commands (terminated by \n)
-				wstring wscData;
-				if (sc->csock.bEncrypted)
-				{
-					SwapBytes(szData, lSize);
-					Blowfish_Decrypt(sc->csock.bfc, szData, lSize);
-					SwapBytes(szData, lSize);
-				}
-				if (sc->csock.bUnicode)
-					wscData = wstring((wchar_t*)szData, lSize / 2);
-				else
-					wscData = stows(szData);
-
-				wstring wscTmp = sc->wscPending + wscData;
-				wscData = wscTmp;
-
-				// check for memory overflow ddos attack
-				uint iMaxKB = 1;
-				if ((sc->csock.bAuthed))  // not authenticated yet
-					iMaxKB = 500;
-				if (wscData.length() > (1024 * iMaxKB)) {
-					ConPrint(L"socket: socket connection closed (possible ddos attempt)\n");
-					AddLog("socket: socket connection from %s:%d closed (possible ddos attempt)", sc->csock.sIP.c_str(), sc->csock.iPort);
-					delete[] szData;
-					lstDelete.push_back(sc);
-					continue;
-				}
+			if (!sc->csock.bOverflow && ProcessSocketCmd(sc, msg.wscText))
+				CloseSocketConnection(sc);
+		}
+		else if (msg.eType == SOCKET_MSG_CLOSED)
+		{
+			ConPrint(L"socket: socket connection closed\n");
+			RemoveSocketConnection(sc);
+		}
+	}
 
-				list<wstring> lstCmds;
-				wstring wscCmd;
-				for (uint i = 0; (i < wscData.length()); i++)
-				{
-					if (!wscData.substr(i, 2).compare(L"\r\n")) {
-						lstCmds.push_back(wscCmd);
-						wscCmd = L"";
-						i++;
-					}
-					else if (wscData[i] == '\n') {
-						lstCmds.push_back(wscCmd);
-						wscCmd = L"";
-					}
-					else
-						wscCmd.append(1, wscData[i]);
-				}
+	// connections whose output couldn't be queued
+	foreach(lstSockets, SOCKET_CONNECTION*, i)
+	{
+		if ((*i)->csock.bOverflow)
+			lstDelete.push_back(*i);
+	}
 
-				sc->wscPending = wscCmd;
+	foreach(lstDelete, SOCKET_CONNECTION*, it)
+	{
+		if (!CloseSocketConnection(*it))
+			break;
+	}
 
-				// process cmds
-				foreach(lstCmds, wstring, it)
-				{
-					if (ProcessSocketCmd(sc, (*it)))
-					{
-						lstDelete.push_back(sc);
-						break;
-					}
-				}
+	lstDelete.clear();
+}
 
-				delete[] szData;
-			}
-		}
+/**************************************************************************************************************
+check for pending admin commands in console or socket and execute them
+**************************************************************************************************************/
 
-		// delete closed connections
-		foreach(lstDelete, SOCKET_CONNECTION*, it)
+void ProcessPendingCommands()
+{
+	try {
+		// check for new console commands
+		EnterCriticalSection(&cs);
+		while (lstConsoleCmds.size())
 		{
-			closesocket((*it)->csock.s);
-			lstSockets.remove(*it);
-			delete (*it);
+			wstring *pwscCmd = lstConsoleCmds.front();
+			lstConsoleCmds.pop_front();
+			AdminConsole.ExecuteCommandString(*pwscCmd);
+			delete pwscCmd;
 		}
+		LeaveCriticalSection(&cs);
 
-		lstDelete.clear();
+		ProcessSockets();
 	}
 	catch (...) {
 		LOG_EXCEPTION
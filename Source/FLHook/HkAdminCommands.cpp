@@ -0,0 +1,107 @@
+#include "global.h"
+#include "CCmds.h"
+#include <map>
+
+/**************************************************************************************************************
+admin commands registered by plugins. a registered command goes straight to the plugin that owns it, the
+ExecuteCommandString_Callback hook (which offers every command to every plugin) is only used for the rest.
+**************************************************************************************************************/
+
+namespace AdminCommands
+{
+	struct PLUGIN_CMD
+	{
+		ADMIN_CMD_CALLBACK callback;
+		DWORD dwRights;
+		HMODULE hModule;
+		bool bPaused;
+	};
+
+	static map<wstring, PLUGIN_CMD> mapCmds;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	bool Register(const wstring &wscCmd, DWORD dwRights, ADMIN_CMD_CALLBACK callback)
+	{
+		wstring wscName = ToLower(wscCmd);
+		if (!callback || !wscName.length() || wscName.find(L' ') != wstring::npos || mapCmds.find(wscName) != mapCmds.end())
+			return false;
+
+		PLUGIN_CMD cmd;
+		cmd.callback = callback;
+		cmd.dwRights = dwRights;
+		cmd.bPaused = false;
+
+		// remember which dll the callback lives in, its commands have to go when the plugin is unloaded
+		cmd.hModule = 0;
+		GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)callback, &cmd.hModule);
+
+		mapCmds[wscName] = cmd;
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void Unregister(const wstring &wscCmd)
+	{
+		mapCmds.erase(ToLower(wscCmd));
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void PauseModule(HMODULE hModule, bool bPause)
+	{
+		for (map<wstring, PLUGIN_CMD>::iterator it = mapCmds.begin(); it != mapCmds.end(); ++it)
+		{
+			if (it->second.hModule == hModule)
+				it->second.bPaused = bPause;
+		}
+	}
+
+	void RemoveModule(HMODULE hModule)
+	{
+		for (map<wstring, PLUGIN_CMD>::iterator it = mapCmds.begin(); it != mapCmds.end(); )
+		{
+			if (it->second.hModule == hModule)
+				it = mapCmds.erase(it);
+			else
+				++it;
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// true if a plugin registered and handled the command
+	bool Execute(CCmds *cmds, const wstring &wscCmd)
+	{
+		map<wstring, PLUGIN_CMD>::iterator it = mapCmds.find(wscCmd);
+		if (it == mapCmds.end() || it->second.bPaused)
+			return false;
+
+		if (it->second.dwRights && !(cmds->rights & it->second.dwRights))
+		{
+			cmds->Print(L"ERR No permission\n");
+			return true;
+		}
+
+		return it->second.callback(cmds, wscCmd);
+	}
+}
+
+/**************************************************************************************************************
+Register an admin command of a plugin, the callback is called for exactly this command (lower case, without
+the $/&/! suffix) and returns true if it handled it. If dwRights is set, admins without one of these rights get
+"ERR No permission" without the callback being called. Fails if the command is registered already.
+**************************************************************************************************************/
+
+bool HkRegisterAdminCommand(const wstring &wscCmd, DWORD dwRights, ADMIN_CMD_CALLBACK callback)
+{
+	return AdminCommands::Register(wscCmd, dwRights, callback);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HkUnregisterAdminCommand(const wstring &wscCmd)
+{
+	AdminCommands::Unregister(wscCmd);
+}
@@ -4,7 +4,75 @@
 called when chat-text is being sent to a player, we reformat it(/set chatfont)
 **************************************************************************************************************/
 
-#define HAS_FLAG(a, b) ((a).wscFlags.find(b) != -1)
+enum CHAT_COLOR
+{
+	CC_PRIVATE,
+	CC_MSGS,
+	CC_MSGU,
+	CC_UNIVERSE,
+	CC_GROUP,
+	CC_LOCAL,
+	CC_SYSTEM,
+};
+
+// sender and text color
+static const wchar_t *wszChatColors[][2] =
+{
+	{ L"FFFFFF", L"19BD3A" },
+	{ L"00FF00", L"E6C684" },
+	{ L"00FF00", L"FFFFFF" },
+	{ L"FFFFFF", L"FFFFFF" },
+	{ L"FFFFFF", L"FF7BFF" },
+	{ L"FFFFFF", L"FF8F40" },
+	{ L"FFFFFF", L"E6C684" },
+};
+
+static CHAT_COLOR GetChatColor(uint iTo)
+{
+	if (g_bMsg)
+		return CC_PRIVATE;
+	else if (g_bMsgS)
+		return CC_MSGS;
+	else if (g_bMsgU)
+		return CC_MSGU;
+	else if (iTo == 0x10000)
+		return CC_UNIVERSE;
+	else if (iTo == 0)
+		return CC_UNIVERSE; // console
+	else if (iTo == 0x10003)
+		return CC_GROUP;
+	else if (iTo == 0x10002)
+		return CC_LOCAL;
+	else if (iTo & 0x10000)
+		return CC_SYSTEM;
+	else
+		return CC_PRIVATE;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// flserver hands the same rdl to every recipient of a line, it is only extracted again if it differs
+static void ParseChat(CHAT_CONTEXT &chat, uint iSize, void *pRDL)
+{
+	if (chat.sRDL.length() && chat.sRDL.length() == iSize && !memcmp(chat.sRDL.data(), pRDL, iSize))
+		return;
+
+	wchar_t wszBuf[1024] = L"";
+	// extract text from rdlReader
+	BinaryRDLReader rdl;
+	uint iRet;
+	rdl.extract_text_from_buffer((unsigned short*)wszBuf, sizeof(wszBuf), iRet, (const char*)pRDL, iSize);
+
+	wstring wscBuf = wszBuf;
+	chat.wscSender = wscBuf.substr(0, wscBuf.length() - chat.iTextLen - 2);
+	chat.wscSenderLower = ToLower(chat.wscSender);
+	chat.wscSenderXML = XMLText(chat.wscSender);
+	chat.wscTextXML = XMLText(wscBuf.substr(wscBuf.length() - chat.iTextLen));
+	chat.sRDL.assign((const char*)pRDL, iSize);
+	chat.lstVariants.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void __stdcall HkCb_SendChat(uint iClientID, uint iTo, uint iSize, void *pRDL)
 {
@@ -14,28 +82,15 @@ void __stdcall HkCb_SendChat(uint iClientID, uint iTo, uint iSize, void *pRDL)
 
 	try {
 		if (HkIServerImpl::g_bInSubmitChat && (iTo != 0x10004)) {
-			wchar_t wszBuf[1024] = L"";
-			// extract text from rdlReader
-			BinaryRDLReader rdl;
-			uint iRet;
-			rdl.extract_text_from_buffer((unsigned short*)wszBuf, sizeof(wszBuf), iRet, (const char*)pRDL, iSize);
-
-			wstring wscBuf = wszBuf;
-			wstring wscSender = wscBuf.substr(0, wscBuf.length() - HkIServerImpl::g_iTextLen - 2);
-			wstring wscText = wscBuf.substr(wscBuf.length() - HkIServerImpl::g_iTextLen);
-
-			if (set_bUserCmdIgnore && ((iTo & 0xFFFF) != 0))
-			{ // check ignores
-				foreach(ClientInfo[iClientID].lstIgnore, IGNORE_INFO, it)
-				{
-					if (HAS_FLAG(*it, L"p") && (iTo & 0x10000))
-						continue; // no privchat
-					else if (!HAS_FLAG(*it, L"i") && !(ToLower(wscSender).compare(ToLower((*it).wscCharname))))
-						return; // ignored
-					else if (HAS_FLAG(*it, L"i") && (ToLower(wscSender).find(ToLower((*it).wscCharname)) != -1))
-						return; // ignored
-				}
-			}
+			// the line is parsed and encoded once per font and color, not for every recipient
+			CHAT_CONTEXT chatLocal;
+			chatLocal.iTextLen = HkIServerImpl::g_iTextLen;
+			CHAT_CONTEXT &chat = HkIServerImpl::g_pChat ? *HkIServerImpl::g_pChat : chatLocal;
+			ParseChat(chat, iSize, pRDL);
+
+			// check ignores, "p" entries only apply to private chat
+			if (set_bUserCmdIgnore && ((iTo & 0xFFFF) != 0) && IgnoreFilter::IsIgnored(iClientID, chat.wscSenderLower, !(iTo & 0x10000)))
+				return;
 
 			uchar cFormat = 0x00;
 			if (set_bUserCmdSetChatFont) {
@@ -76,39 +131,35 @@ void __stdcall HkCb_SendChat(uint iClientID, uint iTo, uint iSize, void *pRDL)
 				}
 			}
 
-			wchar_t wszFormatBuf[8];
-			swprintf(wszFormatBuf, L"%02X", (long)cFormat);
-			wstring wscTRADataFormat = wszFormatBuf;
-			wstring wscTRADataColor;
-			wstring wscTRADataSenderColor = L"FFFFFF";
-			if (g_bMsg) {
-				//				wscTRADataSenderColor = L"00FF00";
-				wscTRADataColor = L"19BD3A"; // pm chatcolor
-			}
-			else if (g_bMsgS) {
-				wscTRADataSenderColor = L"00FF00";
-				wscTRADataColor = L"E6C684"; // system chatcolor
-			}
-			else if (g_bMsgU) {
-				wscTRADataSenderColor = L"00FF00";
-				wscTRADataColor = L"FFFFFF"; // universe chatcolor
+			CHAT_COLOR eColor = GetChatColor(iTo);
+			uint iKey = cFormat | (eColor << 8);
+
+			list<CHAT_VARIANT>::iterator variant = chat.lstVariants.begin();
+			while (variant != chat.lstVariants.end() && variant->iKey != iKey)
+				variant++;
+
+			if (variant == chat.lstVariants.end())
+			{
+				wchar_t wszFormatBuf[8];
+				swprintf(wszFormatBuf, L"%02X", (long)cFormat);
+				wstring wscTRADataFormat = wszFormatBuf;
+
+				wstring wscXML = L"<TRA data=\"0x" + wstring(wszChatColors[eColor][0]) + wscTRADataFormat + L"\" mask=\"-1\"/><TEXT>" + chat.wscSenderXML + L": </TEXT>" +
+					L"<TRA data=\"0x" + wszChatColors[eColor][1] + wscTRADataFormat + L"\" mask=\"-1\"/><TEXT>" + chat.wscTextXML + L"</TEXT>";
+
+				// encoded into a buffer kept for all lines instead of 64k on the stack per call
+				static string sEncodeBuf(0xFFFF, '\0');
+				uint iRet;
+				if (!HKHKSUCCESS(HkFMsgEncodeXML(wscXML, &sEncodeBuf[0], (uint)sEncodeBuf.size(), iRet)))
+					return;
+
+				CHAT_VARIANT cv;
+				cv.iKey = iKey;
+				cv.sEncoded.assign(sEncodeBuf.data(), iRet);
+				variant = chat.lstVariants.insert(chat.lstVariants.end(), cv);
 			}
-			else if (iTo == 0x10000)
-				wscTRADataColor = L"FFFFFF"; // universe chatcolor
-			else if (iTo == 0)
-				wscTRADataColor = L"FFFFFF"; // console
-			else if (iTo == 0x10003)
-				wscTRADataColor = L"FF7BFF"; // group chat
-			else if (iTo == 0x10002)
-				wscTRADataColor = L"FF8F40"; // local chatcolor
-			else if (iTo & 0x10000)
-				wscTRADataColor = L"E6C684"; // system chatcolor
-			else
-				wscTRADataColor = L"19BD3A"; // pm chatcolor
-
-			wstring wscXML = L"<TRA data=\"0x" + wscTRADataSenderColor + wscTRADataFormat + L"\" mask=\"-1\"/><TEXT>" + XMLText(wscSender) + L": </TEXT>" +
-				L"<TRA data=\"0x" + wscTRADataColor + wscTRADataFormat + L"\" mask=\"-1\"/><TEXT>" + XMLText(wscText) + L"</TEXT>";
-			HkFMsg(iClientID, wscXML);
+
+			HkFMsgSendChat(iClientID, (char*)variant->sEncoded.data(), (uint)variant->sEncoded.length());
 		}
 		else {
 			__asm
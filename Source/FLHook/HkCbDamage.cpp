@@ -3,7 +3,6 @@
 EXPORT uint iDmgTo = 0;
 EXPORT uint iDmgToSpaceID = 0;
 EXPORT uint iDmgMunitionID = 0;
-DamageList	LastDmgList;
 
 bool g_gNonGunHitsBase = false;
 float g_LastHitPts;
@@ -122,8 +121,6 @@ void __stdcall HkCb_AddDmgEntry(DamageList *dmgList, unsigned short p1, float p2
 		dmgList->add_damage_entry(p1, p2, p3);
 
 	try {
-		LastDmgList = *dmgList; // save
-
 //		float fHealth,fMaxHealth;32 256
 //		pub::SpaceObj::GetHealth(ClientInfo[iDmgTo].iShip,fHealth,fMaxHealth);
 
@@ -138,9 +135,7 @@ void __stdcall HkCb_AddDmgEntry(DamageList *dmgList, unsigned short p1, float p2
 		}
 
 		if (iDmgTo && p1 == 1) // only save hits on the hull (p1=1)
-		{
-			ClientInfo[iDmgTo].dmgLast = *dmgList;
-		}
+			HkSetLastDamage(iDmgTo, *dmgList);
 
 
 	}
@@ -245,18 +240,41 @@ bool AllowPlayerDamage(uint iClientID, uint iClientIDTarget)
 
 
 		// no-pvp check
-		uint iSystemID;
-		pub::Player::GetSystem(iClientID, iSystemID);
-		foreach(set_lstNoPVPSystems, uint, i)
-		{
-			if (iSystemID == (*i))
-				return false; // no pvp
-		}
+		if (PlayerIndex::InNoPvPSystem(iClientID))
+			return false; // no pvp
 	}
 
 	return true;
 }
 
+/**************************************************************************************************************
+Remember the last hull hit of a player for the death message. Only the inflictor and the cause are kept, a
+DamageList is built from them again by HkGetLastDamage when the player actually dies.
+**************************************************************************************************************/
+
+void HkSetLastDamage(uint iClientID, const DamageList &dmg)
+{
+	if (iClientID > MAX_CLIENT_ID)
+		return;
+
+	DAMAGE_INFO &info = ClientInfo[iClientID].dmgLast;
+	info.iInflictorShip = dmg.get_inflictor_id();
+	info.iInflictorClient = dmg.get_inflictor_owner_player();
+	info.iCause = dmg.get_cause();
+	info.tmTime = timeInMS();
+}
+
+void HkGetLastDamage(uint iClientID, DamageList &dmg)
+{
+	if (iClientID > MAX_CLIENT_ID)
+		return;
+
+	const DAMAGE_INFO &info = ClientInfo[iClientID].dmgLast;
+	dmg.set_inflictor_id(info.iInflictorShip);
+	dmg.set_inflictor_owner_player(info.iInflictorClient);
+	dmg.set_cause((enum DamageCause)info.iCause);
+}
+
 /**************************************************************************************************************
 **************************************************************************************************************/
 
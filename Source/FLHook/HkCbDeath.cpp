@@ -20,52 +20,37 @@ void SendDeathMsg(const wstring &wscMsg, uint iSystemID, uint iClientIDVictim, u
 {
 	CALL_PLUGINS_V(PLUGIN_SendDeathMsg, , (const wstring&, uint, uint, uint), (wscMsg, iSystemID, iClientIDVictim, iClientIDKiller));
 
-	// encode xml string(default and small)
-	// non-sys
-	wstring wscXMLMsg = L"<TRA data=\"" + set_wscDeathMsgStyle + L"\" mask=\"-1\"/> <TEXT>";
-	wscXMLMsg += XMLText(wscMsg);
-	wscXMLMsg += L"</TEXT>";
-
-	char szBuf[0xFFFF];
+	// encode message(default and small, non-sys and sys)
+	wstring wscTRA = L"<TRA data=\"" + set_wscDeathMsgStyle + L"\" mask=\"-1\"/> ";
+	char szBuf[0x1000];
 	uint iRet;
-	if (!HKHKSUCCESS(HkFMsgEncodeXML(wscXMLMsg, szBuf, sizeof(szBuf), iRet)))
+	if (!HKHKSUCCESS(HkFMsgEncodeMsg(wscTRA, wscMsg, szBuf, sizeof(szBuf), iRet)))
 		return;
 
-	wstring wscStyleSmall = SetSizeToSmall(set_wscDeathMsgStyle);
-	wstring wscXMLMsgSmall = wstring(L"<TRA data=\"") + wscStyleSmall + L"\" mask=\"-1\"/> <TEXT>";
-	wscXMLMsgSmall += XMLText(wscMsg);
-	wscXMLMsgSmall += L"</TEXT>";
-	char szBufSmall[0xFFFF];
+	wstring wscTRASmall = L"<TRA data=\"" + SetSizeToSmall(set_wscDeathMsgStyle) + L"\" mask=\"-1\"/> ";
+	char szBufSmall[0x1000];
 	uint iRetSmall;
-	if (!HKHKSUCCESS(HkFMsgEncodeXML(wscXMLMsgSmall, szBufSmall, sizeof(szBufSmall), iRetSmall)))
+	if (!HKHKSUCCESS(HkFMsgEncodeMsg(wscTRASmall, wscMsg, szBufSmall, sizeof(szBufSmall), iRetSmall)))
 		return;
 
-	// sys
-	wstring wscXMLMsgSys = L"<TRA data=\"" + set_wscDeathMsgStyleSys + L"\" mask=\"-1\"/> <TEXT>";
-	wscXMLMsgSys += XMLText(wscMsg);
-	wscXMLMsgSys += L"</TEXT>";
-	char szBufSys[0xFFFF];
+	wstring wscTRASys = L"<TRA data=\"" + set_wscDeathMsgStyleSys + L"\" mask=\"-1\"/> ";
+	char szBufSys[0x1000];
 	uint iRetSys;
-	if (!HKHKSUCCESS(HkFMsgEncodeXML(wscXMLMsgSys, szBufSys, sizeof(szBufSys), iRetSys)))
+	if (!HKHKSUCCESS(HkFMsgEncodeMsg(wscTRASys, wscMsg, szBufSys, sizeof(szBufSys), iRetSys)))
 		return;
 
-	wstring wscStyleSmallSys = SetSizeToSmall(set_wscDeathMsgStyleSys);
-	wstring wscXMLMsgSmallSys = L"<TRA data=\"" + wscStyleSmallSys + L"\" mask=\"-1\"/> <TEXT>";
-	wscXMLMsgSmallSys += XMLText(wscMsg);
-	wscXMLMsgSmallSys += L"</TEXT>";
-	char szBufSmallSys[0xFFFF];
+	wstring wscTRASmallSys = L"<TRA data=\"" + SetSizeToSmall(set_wscDeathMsgStyleSys) + L"\" mask=\"-1\"/> ";
+	char szBufSmallSys[0x1000];
 	uint iRetSmallSys;
-	if (!HKHKSUCCESS(HkFMsgEncodeXML(wscXMLMsgSmallSys, szBufSmallSys, sizeof(szBufSmallSys), iRetSmallSys)))
+	if (!HKHKSUCCESS(HkFMsgEncodeMsg(wscTRASmallSys, wscMsg, szBufSmallSys, sizeof(szBufSmallSys), iRetSmallSys)))
 		return;
 
 	// send
 	// for all players
-	struct PlayerData *pPD = 0;
-	while (pPD = Players.traverse_active(pPD))
+	const CLIENT_SET &clients = PlayerIndex::GetOnlineClients();
+	for (uint iClientID = ClientSetNext(clients, 0); iClientID; iClientID = ClientSetNext(clients, iClientID))
 	{
-		uint iClientID = HkGetClientIdFromPD(pPD);
-		uint iClientSystemID = 0;
-		pub::Player::GetSystem(iClientID, iClientSystemID);
+		uint iClientSystemID = PlayerIndex::GetSystem(iClientID);
 
 		char *szXMLBuf;
 		int iXMLBufRet;
@@ -138,7 +123,7 @@ void __stdcall ShipDestroyed(DamageList *_dmg, DWORD *ecx, uint iKill)
 				swprintf(wszSystem, L"%u", iSystemID);
 
 				if (!dmg.get_cause())
-					dmg = ClientInfo[iClientID].dmgLast;
+					HkGetLastDamage(iClientID, dmg);
 
 				uint iCause = dmg.get_cause();
 				uint iClientIDKiller = HkGetClientIDByShip(dmg.get_inflictor_id());
@@ -191,22 +176,17 @@ void __stdcall ShipDestroyed(DamageList *_dmg, DWORD *ecx, uint iKill)
 						{
 							if (it->iKillsInARow == ClientInfo[iClientIDKiller].iKillsInARow)
 							{
-								wstring wscXMLMsg = L"<TRA data=\"" + set_MKM_wscStyle + L"\" mask=\"-1\"/> <TEXT>";
-								wscXMLMsg += XMLText(ReplaceStr(it->wscMessage, L"%player", wscKiller));
-								wscXMLMsg += L"</TEXT>";
-
-								char szBuf[0xFFFF];
+								wstring wscTRA = L"<TRA data=\"" + set_MKM_wscStyle + L"\" mask=\"-1\"/> ";
+								char szBuf[0x1000];
 								uint iRet;
-								if (!HKHKSUCCESS(HkFMsgEncodeXML(wscXMLMsg, szBuf, sizeof(szBuf), iRet)))
+								if (!HKHKSUCCESS(HkFMsgEncodeMsg(wscTRA, ReplaceStr(it->wscMessage, L"%player", wscKiller), szBuf, sizeof(szBuf), iRet)))
 									break;
 
 								// for all players in system...
-								struct PlayerData *pPD = 0;
-								while (pPD = Players.traverse_active(pPD))
+								const CLIENT_SET &clients = PlayerIndex::GetOnlineClients();
+								for (uint iClientID = ClientSetNext(clients, 0); iClientID; iClientID = ClientSetNext(clients, iClientID))
 								{
-									uint iClientID = HkGetClientIdFromPD(pPD);
-									uint iClientSystemID = 0;
-									pub::Player::GetSystem(iClientID, iClientSystemID);
+									uint iClientSystemID = PlayerIndex::GetSystem(iClientID);
 									if ((iClientID == iClientIDKiller) || ((iSystemID == iClientSystemID) && (((ClientInfo[iClientID].dieMsg == DIEMSG_ALL) || (ClientInfo[iClientID].dieMsg == DIEMSG_SYSTEM)) || !set_bUserCmdSetDieMsg)))
 										HkFMsgSendChat(iClientID, szBuf, iRet);
 								}
@@ -258,6 +238,8 @@ void __stdcall ShipDestroyed(DamageList *_dmg, DWORD *ecx, uint iKill)
 
 			ClientInfo[iClientID].iShipOld = ClientInfo[iClientID].iShip;
 			ClientInfo[iClientID].iShip = 0;
+			PlayerIndex::ShipsChanged(iClientID);
+			PlayerIndex::ShipDestroyed(iClientID);
 		}
 	}
 	catch (...) { LOG_EXCEPTION }
@@ -15,12 +15,13 @@
 
 #define EXECUTE_SERVER_CALL(args) \
 	{ \
-	static CTimer timer(__FUNCTION__,set_iTimerThreshold); \
-	timer.start(); \
+	static uint iServerCallTimerID = PerfTimers::Intern(__FUNCTION__); \
+	mstime tmServerCallStart = PerfTimers::bEnabled ? PerfTimers::Start() : 0; \
 	try { \
 		args; \
 	} catch(...) { AddLog("ERROR: Exception in " __FUNCTION__ " on server call"); LOG_EXCEPTION; } \
-	timer.stop(); \
+	if(PerfTimers::bEnabled) \
+		PerfTimers::Stop(iServerCallTimerID, tmServerCallStart); \
 	}
 
 #define CHECK_FOR_DISCONNECT \
@@ -46,11 +47,20 @@ namespace HkIServerImpl
 		mstime		tmLastCall;
 	};
 
+	static void CallTimer(uint iTimerID, void *pData)
+	{
+		TIMER *timer = (TIMER*)pData;
+		timer->tmLastCall = timeInMS();
+		timer->proc();
+	}
+
 	TIMER Timers[] =
 	{
 		{ProcessPendingCommands,		50,					0},
 		{HkTimerCheckKick,			1000,					0},
 		{HkTimerNPCAndF1Check,			50,					0},
+		{PerfTimers::TimerDump,			1000,					0},
+		{FrameProfiler::TimerReport,		1000,					0},
 	};
 
 	int __stdcall Update(void)
@@ -61,27 +71,50 @@ namespace HkIServerImpl
 		{
 			FLHookInit();
 			bFirstTime = false;
+
+			// the timers are staggered by a few ms so the ones with the same interval don't all fire in the same frame
+			for (uint i = 0; (i < sizeof(Timers) / sizeof(TIMER)); i++)
+				HkScheduleTimer(i * 7, (uint)Timers[i].tmIntervallMS, CallTimer, &Timers[i]);
 		}
 
+		PluginManager::FreeRetiredDispatchTables();
+
+		FrameProfiler::BeginFrame();
+
 		// call timers
-		for (uint i = 0; (i < sizeof(Timers) / sizeof(TIMER)); i++)
-		{
-			if ((timeInMS() - Timers[i].tmLastCall) >= Timers[i].tmIntervallMS)
-			{
-				Timers[i].tmLastCall = timeInMS();
-				Timers[i].proc();
-			}
-		}
+		TimerWheel::Process();
+
+		// events of the last frame go to the event mode connections in one batch
+		FlushEvents();
 
 		char *pData;
 		memcpy(&pData, g_FLServerDataPtr + 0x40, 4);
 		memcpy(&g_iServerLoad, pData + 0x204, 4);
 		memcpy(&g_iPlayerCount, pData + 0x208, 4);
 
-		CALL_PLUGINS(PLUGIN_HkIServerImpl_Update, int, __stdcall, (), ());
+		FrameProfiler::EndPhase(FRAME_PHASE_TIMERS);
+
+		// same as CALL_PLUGINS, but every plugin's share of the frame is recorded as well
+		int iPluginRet = 0;
+		bool bPluginReturn = false;
+		CALL_PLUGINS_LOOP(PLUGIN_HkIServerImpl_Update,
+			{ iPluginRet = ((int(__stdcall*) ())dispatchEntry.pFunc)(); FrameProfiler::AddPlugin(dispatchEntry.iTimerID, dispatchEntry.szName, tmPluginStart); },
+			bPluginReturn = true,
+			bPluginReturn = true)
+
+		FrameProfiler::EndPhase(FRAME_PHASE_PLUGINS);
+
+		if (bPluginReturn)
+		{
+			FrameProfiler::EndFrame();
+			return iPluginRet;
+		}
 
 		int result = 0;
 		EXECUTE_SERVER_CALL(result = Server.Update());
+
+		FrameProfiler::EndPhase(FRAME_PHASE_SERVER);
+		FrameProfiler::EndFrame();
 		return result;
 	}
 
@@ -98,6 +131,7 @@ namespace HkIServerImpl
 	CInGame admin;
 	bool g_bInSubmitChat = false;
 	uint g_iTextLen = 0;
+	CHAT_CONTEXT *g_pChat = 0;
 
 	void __stdcall SubmitChat(struct CHAT_ID cId, unsigned long lP1, void const *rdlReader, struct CHAT_ID cIdTo, int iP2)
 	{
@@ -112,9 +146,10 @@ namespace HkIServerImpl
 			// Group join/leave commands
 			if (cIdTo.iID == 0x10004)
 			{
+				bool bInSubmitChatPrev = g_bInSubmitChat;
 				g_bInSubmitChat = true;
 				EXECUTE_SERVER_CALL(Server.SubmitChat(cId, lP1, rdlReader, cIdTo, iP2));
-				g_bInSubmitChat = false;
+				g_bInSubmitChat = bInSubmitChatPrev;
 				return;
 			}
 
@@ -216,10 +251,17 @@ namespace HkIServerImpl
 		}
 		catch (...) { LOG_EXCEPTION }
 
-		// send
+		// send, the recipients share the parsed and encoded line. the previous context is restored in case
+		// a plugin sends chat while flserver is still delivering this line.
+		CHAT_CONTEXT chat;
+		chat.iTextLen = g_iTextLen;
+		CHAT_CONTEXT *pChatPrev = g_pChat;
+		bool bInSubmitChatPrev = g_bInSubmitChat;
+		g_pChat = &chat;
 		g_bInSubmitChat = true;
 		EXECUTE_SERVER_CALL(Server.SubmitChat(cId, lP1, rdlReader, cIdTo, iP2));
-		g_bInSubmitChat = false;
+		g_bInSubmitChat = bInSubmitChatPrev;
+		g_pChat = pChatPrev;
 
 		CALL_PLUGINS_V(PLUGIN_HkIServerImpl_SubmitChat_AFTER, __stdcall, (struct CHAT_ID cId, unsigned long lP1, void const *rdlReader, struct CHAT_ID cIdTo, int iP2), (cId, lP1, rdlReader, cIdTo, iP2));
 	}
@@ -238,6 +280,7 @@ namespace HkIServerImpl
 
 			try {
 			ClientInfo[iClientID].iShip = iShip;
+			PlayerIndex::ShipsChanged(iClientID);
 			ClientInfo[iClientID].iKillsInARow = 0;
 			ClientInfo[iClientID].bCruiseActivated = false;
 			ClientInfo[iClientID].bThrusterActivated = false;
@@ -262,6 +305,8 @@ namespace HkIServerImpl
 
 		EXECUTE_SERVER_CALL(Server.PlayerLaunch(iShip, iClientID));
 
+		PlayerIndex::Refresh(iClientID);
+
 		try {
 			if (!ClientInfo[iClientID].iLastExitedBaseID)
 			{
@@ -433,6 +478,8 @@ namespace HkIServerImpl
 
 		EXECUTE_SERVER_CALL(Server.LaunchComplete(iBaseID, iShip));
 
+		PlayerIndex::Refresh(HkGetClientIDByShip(iShip));
+
 		CALL_PLUGINS_V(PLUGIN_HkIServerImpl_LaunchComplete_AFTER, __stdcall, (unsigned int iBaseID, unsigned int iShip), (iBaseID, iShip));
 	}
 
@@ -457,6 +504,7 @@ namespace HkIServerImpl
 			ClientInfo[iClientID].iLastExitedBaseID = 0;
 			ClientInfo[iClientID].iTradePartner = 0;
 			Server.CharacterSelect(cId, iClientID);
+			PlayerIndex::Refresh(iClientID);
 		}
 		catch (...) {
 			HkAddKickLog(iClientID, L"Corrupt charfile?");
@@ -534,6 +582,8 @@ namespace HkIServerImpl
 
 		EXECUTE_SERVER_CALL(Server.BaseEnter(iBaseID, iClientID));
 
+		PlayerIndex::Refresh(iClientID);
+
 		try {
 			// adjust cash, this is necessary when cash was added while use was in charmenu/had other char selected
 			wstring wscCharname = ToLower((wchar_t*)Players.GetActiveCharacterName(iClientID));
@@ -584,6 +634,8 @@ namespace HkIServerImpl
 
 		EXECUTE_SERVER_CALL(Server.BaseExit(iBaseID, iClientID));
 
+		PlayerIndex::Refresh(iClientID);
+
 		try {
 			const wchar_t *wszCharname = (wchar_t*)Players.GetActiveCharacterName(iClientID);
 
@@ -671,6 +723,7 @@ namespace HkIServerImpl
 				ClientInfo[iClientID].bDisconnected = true;
 				ClientInfo[iClientID].lstMoneyFix.clear();
 				ClientInfo[iClientID].iTradePartner = 0;
+				HkCancelClientTimers(iClientID);
 
 				// event
 				const wchar_t* wszCharname = (const wchar_t*)Players.GetActiveCharacterName(iClientID);
@@ -681,6 +734,7 @@ namespace HkIServerImpl
 				CALL_PLUGINS_V(PLUGIN_HkIServerImpl_DisConnect, __stdcall, (unsigned int iClientID, enum EFLConnection p2), (iClientID, p2));
 				EXECUTE_SERVER_CALL(Server.DisConnect(iClientID, p2));
 				CALL_PLUGINS_V(PLUGIN_HkIServerImpl_DisConnect_AFTER, __stdcall, (unsigned int iClientID, enum EFLConnection p2), (iClientID, p2));
+				PlayerIndex::Remove(iClientID);
 			}
 		}
 		catch (...)
@@ -926,6 +980,7 @@ namespace HkIServerImpl
 			}
 
 			Server.CharacterInfoReq(iClientID, p2);
+			PlayerIndex::Refresh(iClientID);
 		}
 		catch (...) { // something is wrong with charfile
 			HkAddKickLog(iClientID, L"Corrupt charfile?");
@@ -955,6 +1010,8 @@ namespace HkIServerImpl
 			if (!iClientID)
 				return;
 
+			PlayerIndex::Refresh(iClientID);
+
 			// event
 			ProcessEvent(L"jumpin char=%s id=%d system=%s",
 				(wchar_t*)Players.GetActiveCharacterName(iClientID),
@@ -984,6 +1041,8 @@ namespace HkIServerImpl
 
 		EXECUTE_SERVER_CALL(Server.SystemSwitchOutComplete(iShip, iClientID));
 
+		PlayerIndex::Refresh(iClientID);
+
 		try {
 			// event
 			ProcessEvent(L"switchout char=%s id=%d system=%s",
@@ -1026,6 +1085,8 @@ namespace HkIServerImpl
 				return;
 			}
 
+			PlayerIndex::Refresh(iClientID);
+
 			CALL_PLUGINS_V(PLUGIN_HkIServerImpl_Login, __stdcall, (struct SLoginInfo const &li, unsigned int iClientID), (li, iClientID));
 
 
@@ -0,0 +1,311 @@
+#include "hook.h"
+#include <map>
+
+/**************************************************************************************************************
+decoded charfiles are kept in memory instead of being decoded to a temporary .ini, read with the profile api
+and deleted again on every access. an entry stays valid as long as the file's write time and size match,
+so changes made by flserver or by hand are picked up on the next access. edits done through flhook are
+written to disk in one go and replace the cached copy.
+**************************************************************************************************************/
+
+#define CHARFILE_CACHE_SIZE 128
+
+namespace CharFileCache
+{
+	struct CACHE_ENTRY
+	{
+		string scKey;
+		CHARFILE charfile;
+	};
+
+	static list<CACHE_ENTRY> lstCache;
+	static map<string, list<CACHE_ENTRY>::iterator> mapCache;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static string CacheKey(const string &scPath)
+	{
+		return ToLower(scPath);
+	}
+
+	static string Trim(const string &scStr)
+	{
+		size_t iStart = scStr.find_first_not_of(" \t");
+		if (iStart == string::npos)
+			return "";
+
+		return scStr.substr(iStart, scStr.find_last_not_of(" \t") - iStart + 1);
+	}
+
+	static bool GetStamp(const string &scPath, FILETIME &ftLastWrite, DWORD &dwSize)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA fad;
+		if (!GetFileAttributesEx(scPath.c_str(), GetFileExInfoStandard, &fad))
+			return false;
+
+		ftLastWrite = fad.ftLastWriteTime;
+		dwSize = fad.nFileSizeLow;
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void SplitLines(const char *szData, uint iLen, CHARFILE &charfile)
+	{
+		charfile.vLines.clear();
+		charfile.bTrailingNewline = false;
+
+		uint iStart = 0;
+		for (uint i = 0; i < iLen; i++)
+		{
+			if (szData[i] != '\n')
+				continue;
+
+			uint iEnd = (i > iStart && szData[i - 1] == '\r') ? (i - 1) : i;
+			charfile.vLines.push_back(string(szData + iStart, iEnd - iStart));
+			iStart = i + 1;
+		}
+
+		if (iStart < iLen)
+			charfile.vLines.push_back(string(szData + iStart, iLen - iStart));
+		else
+			charfile.bTrailingNewline = (iLen > 0);
+	}
+
+	static string JoinLines(const CHARFILE &charfile)
+	{
+		string scData;
+		for (uint i = 0; i < charfile.vLines.size(); i++)
+		{
+			scData += charfile.vLines[i];
+			if ((i + 1) < charfile.vLines.size() || charfile.bTrailingNewline)
+				scData += "\r\n";
+		}
+
+		return scData;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static bool ReadCharFile(const string &scPath, CHARFILE &charfile)
+	{
+		HANDLE hFile = CreateFile(scPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		BY_HANDLE_FILE_INFORMATION fi;
+		if (!GetFileInformationByHandle(hFile, &fi))
+		{
+			CloseHandle(hFile);
+			return false;
+		}
+
+		string scData(fi.nFileSizeLow, '\0');
+		DWORD dwRead = 0;
+		bool bRead = !fi.nFileSizeLow || ReadFile(hFile, &scData[0], fi.nFileSizeLow, &dwRead, 0);
+		CloseHandle(hFile);
+		if (!bRead || (dwRead != fi.nFileSizeLow))
+			return false;
+
+		charfile.ftLastWrite = fi.ftLastWriteTime;
+		charfile.dwSize = fi.nFileSizeLow;
+		charfile.bEncoded = (dwRead >= 4) && !strncmp(scData.c_str(), "FLS1", 4);
+		if (charfile.bEncoded)
+		{
+			string scDecoded(dwRead - 4, '\0');
+			if (scDecoded.length() && !flc_decode_buf(scData.data(), dwRead, &scDecoded[0]))
+				return false;
+			SplitLines(scDecoded.data(), (uint)scDecoded.length(), charfile);
+		}
+		else
+			SplitLines(scData.data(), dwRead, charfile);
+
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void Store(const string &scKey, const CHARFILE &charfile)
+	{
+		map<string, list<CACHE_ENTRY>::iterator>::iterator it = mapCache.find(scKey);
+		if (it != mapCache.end())
+		{
+			if (&it->second->charfile != &charfile)
+				it->second->charfile = charfile;
+			lstCache.splice(lstCache.begin(), lstCache, it->second);
+			return;
+		}
+
+		if (lstCache.size() >= CHARFILE_CACHE_SIZE)
+		{
+			mapCache.erase(lstCache.back().scKey);
+			lstCache.pop_back();
+		}
+
+		CACHE_ENTRY entry;
+		entry.scKey = scKey;
+		entry.charfile = charfile;
+		lstCache.push_front(entry);
+		mapCache[scKey] = lstCache.begin();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// the returned charfile stays valid until the next Load/Save/Invalidate
+	HK_ERROR Load(const string &scPath, const CHARFILE *&charfile)
+	{
+		string scKey = CacheKey(scPath);
+
+		FILETIME ftLastWrite;
+		DWORD dwSize;
+		if (!GetStamp(scPath, ftLastWrite, dwSize))
+		{
+			Invalidate(scPath);
+			return HKE_CHAR_DOES_NOT_EXIST;
+		}
+
+		map<string, list<CACHE_ENTRY>::iterator>::iterator it = mapCache.find(scKey);
+		if (it != mapCache.end())
+		{
+			const CHARFILE &cached = it->second->charfile;
+			if (!CompareFileTime(&cached.ftLastWrite, &ftLastWrite) && (cached.dwSize == dwSize))
+			{
+				lstCache.splice(lstCache.begin(), lstCache, it->second);
+				charfile = &cached;
+				return HKE_OK;
+			}
+		}
+
+		CHARFILE loaded;
+		if (!ReadCharFile(scPath, loaded))
+		{
+			Invalidate(scPath);
+			return HKE_COULD_NOT_DECODE_CHARFILE;
+		}
+
+		Store(scKey, loaded);
+		charfile = &lstCache.front().charfile;
+		return HKE_OK;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	HK_ERROR Save(const string &scPath, CHARFILE &charfile, bool bEncode)
+	{
+		string scData = JoinLines(charfile);
+		if (bEncode)
+		{
+			string scEncoded(scData.length() + 4, '\0');
+			flc_encode_buf(scData.data(), (int)scData.length(), &scEncoded[0]);
+			scData.swap(scEncoded);
+		}
+
+		HANDLE hFile = CreateFile(scPath.c_str(), GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+		if (hFile == INVALID_HANDLE_VALUE)
+		{
+			Invalidate(scPath);
+			return bEncode ? HKE_COULD_NOT_ENCODE_CHARFILE : HKE_UNKNOWN_ERROR;
+		}
+
+		DWORD dwWritten = 0;
+		bool bWritten = scData.empty() || WriteFile(hFile, scData.data(), (DWORD)scData.length(), &dwWritten, 0);
+		CloseHandle(hFile);
+		if (!bWritten || (dwWritten != scData.length()))
+		{
+			Invalidate(scPath);
+			return bEncode ? HKE_COULD_NOT_ENCODE_CHARFILE : HKE_UNKNOWN_ERROR;
+		}
+
+		// write-through, the stamp of the new file keeps the entry valid
+		charfile.bEncoded = bEncode;
+		if (GetStamp(scPath, charfile.ftLastWrite, charfile.dwSize))
+			Store(CacheKey(scPath), charfile);
+		else
+			Invalidate(scPath);
+
+		return HKE_OK;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void Invalidate(const string &scPath)
+	{
+		map<string, list<CACHE_ENTRY>::iterator>::iterator it = mapCache.find(CacheKey(scPath));
+		if (it == mapCache.end())
+			return;
+
+		lstCache.erase(it->second);
+		mapCache.erase(it);
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// finds the line index of scKey in [scSection] (case insensitive like the profile api), -1 if not found.
+	// iSectionEnd receives the index after the last line of the section (-1 if the section doesn't exist).
+	static int FindKey(const CHARFILE &charfile, const string &scSection, const string &scKey, int &iSectionEnd)
+	{
+		bool bInSection = false;
+		iSectionEnd = -1;
+		for (uint i = 0; i < charfile.vLines.size(); i++)
+		{
+			string scLine = Trim(charfile.vLines[i]);
+			if (scLine.length() && scLine[0] == '[')
+			{
+				if (bInSection)
+					return -1;
+
+				size_t iClose = scLine.find(']');
+				bInSection = (iClose != string::npos) && !_stricmp(Trim(scLine.substr(1, iClose - 1)).c_str(), scSection.c_str());
+				if (bInSection)
+					iSectionEnd = i + 1;
+				continue;
+			}
+
+			if (!bInSection)
+				continue;
+
+			if (scLine.length())
+				iSectionEnd = i + 1;
+
+			size_t iEq = scLine.find('=');
+			if ((iEq != string::npos) && !_stricmp(Trim(scLine.substr(0, iEq)).c_str(), scKey.c_str()))
+				return i;
+		}
+
+		return -1;
+	}
+
+	string GetValue(const CHARFILE &charfile, const string &scSection, const string &scKey, const string &scDefault)
+	{
+		int iSectionEnd;
+		int iLine = FindKey(charfile, scSection, scKey, iSectionEnd);
+		if (iLine == -1)
+			return scDefault;
+
+		const string &scLine = charfile.vLines[iLine];
+		string scValue = Trim(scLine.substr(scLine.find('=') + 1));
+
+		// the profile api strips enclosing quotes
+		if (scValue.length() >= 2 && ((scValue[0] == '"' && scValue[scValue.length() - 1] == '"') || (scValue[0] == '\'' && scValue[scValue.length() - 1] == '\'')))
+			scValue = scValue.substr(1, scValue.length() - 2);
+
+		return scValue;
+	}
+
+	void SetValue(CHARFILE &charfile, const string &scSection, const string &scKey, const string &scValue)
+	{
+		int iSectionEnd;
+		int iLine = FindKey(charfile, scSection, scKey, iSectionEnd);
+		string scLine = scKey + "=" + scValue;
+		if (iLine != -1)
+			charfile.vLines[iLine] = scLine;
+		else if (iSectionEnd != -1)
+			charfile.vLines.insert(charfile.vLines.begin() + iSectionEnd, scLine);
+		else
+		{
+			charfile.vLines.push_back("[" + scSection + "]");
+			charfile.vLines.push_back(scLine);
+			charfile.bTrailingNewline = true;
+		}
+	}
+}
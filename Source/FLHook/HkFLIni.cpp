@@ -14,23 +14,26 @@ HK_ERROR HkFLIniGet(const wstring &wscCharname, const wstring &wscKey, wstring &
 	HkGetCharFileName(wscCharname, wscFile);
 
 	string scCharFile = scAcctPath + wstos(wscDir) + "\\" + wstos(wscFile) + ".fl";
-	if (HkIsEncoded(scCharFile)) {
-		string scCharFileNew = scCharFile + ".ini";
-		if (!flc_decode(scCharFile.c_str(), scCharFileNew.c_str()))
-			return HKE_COULD_NOT_DECODE_CHARFILE;
-
-		wscRet = stows(IniGetS(scCharFileNew, "Player", wstos(wscKey).c_str(), ""));
-		DeleteFile(scCharFileNew.c_str());
-	}
-	else {
-		wscRet = stows(IniGetS(scCharFile, "Player", wstos(wscKey).c_str(), ""));
-	}
-
+	const CHARFILE *charfile;
+	HK_ERROR err = CharFileCache::Load(scCharFile, charfile);
+	if (err == HKE_CHAR_DOES_NOT_EXIST)
+		return HKE_OK; // same as reading a key from a missing file
+	else if (!HKHKSUCCESS(err))
+		return err;
+
+	wscRet = stows(CharFileCache::GetValue(*charfile, "Player", wstos(wscKey), ""));
 	return HKE_OK;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**************************************************************************************************************
+sets a key in the [Player] section of the charfile, the file is stored decoded like before. the key is changed
+where it is found or, like WritePrivateProfileString did, added after the last line of the section; a missing
+section is added at the end of the file. unlike the profile api a missing charfile is not created, the call
+fails with HKE_CHAR_DOES_NOT_EXIST then.
+**************************************************************************************************************/
+
 HK_ERROR HkFLIniWrite(const wstring &wscCharname, const wstring &wscKey, const wstring &wscValue)
 {
 	wstring wscDir;
@@ -41,24 +44,13 @@ HK_ERROR HkFLIniWrite(const wstring &wscCharname, const wstring &wscKey, const w
 	HkGetCharFileName(wscCharname, wscFile);
 
 	string scCharFile = scAcctPath + wstos(wscDir) + "\\" + wstos(wscFile) + ".fl";
-	if (HkIsEncoded(scCharFile)) {
-		string scCharFileNew = scCharFile + ".ini";
-		if (!flc_decode(scCharFile.c_str(), scCharFileNew.c_str()))
-			return HKE_COULD_NOT_DECODE_CHARFILE;
-
-		IniWrite(scCharFileNew, "Player", wstos(wscKey).c_str(), wstos(wscValue).c_str());
-
-		// keep decoded
-		DeleteFile(scCharFile.c_str());
-		MoveFile(scCharFileNew.c_str(), scCharFile.c_str());
-		/*		if(!flc_encode(scCharFileNew.c_str(), scCharFile.c_str()))
-					return HKE_COULD_NOT_ENCODE_CHARFILE;
-
-				DeleteFile(scCharFileNew.c_str()); */
-	}
-	else {
-		IniWrite(scCharFile, "Player", wstos(wscKey).c_str(), wstos(wscValue).c_str());
-	}
-
-	return HKE_OK;
+	const CHARFILE *charfile;
+	HK_ERROR err = CharFileCache::Load(scCharFile, charfile);
+	if (!HKHKSUCCESS(err))
+		return err;
+
+	// keep decoded
+	CHARFILE charfileNew = *charfile;
+	CharFileCache::SetValue(charfileNew, "Player", wstos(wscKey), wstos(wscValue));
+	return CharFileCache::Save(scCharFile, charfileNew, false);
 }
\ No newline at end of file
@@ -2,33 +2,41 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+static uint iLogFLHook = 0;
+static uint iLogDebug = 0;
+
+void InitLogs()
+{
+	iLogFLHook = Logger::Open("./flhook_logs/FLHook.log", 0, LOG_STAMP_DEFAULT);
+}
+
+// opens or closes the debug log depending on set_bDebug
+void UpdateDebugLog()
+{
+	if (set_bDebug)
+		iLogDebug = Logger::Open(sDebugLog, set_iDebugMaxSize, LOG_STAMP_DEFAULT);
+	else if (iLogDebug)
+	{
+		Logger::Close(iLogDebug);
+		iLogDebug = 0;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 void AddDebugLog(const char *szString, ...)
 {
 	if (!set_bDebug)
 		return;
 
-	if (ftell(fLogDebug) > ((int)set_iDebugMaxSize << 10)) {
-		fclose(fLogDebug);
-		_unlink(sDebugLog.c_str());
-		fLogDebug = fopen(sDebugLog.c_str(), "at");
-	}
-
 	char szBufString[1024];
 	va_list marker;
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
+	szBufString[sizeof(szBufString) - 1] = 0;
 
-	if (fLogDebug) {
-		char szBuf[64];
-		time_t tNow = time(0);
-		struct tm *t = localtime(&tNow);
-		strftime(szBuf, sizeof(szBuf), "%d.%m.%Y %H:%M:%S", t);
-		fprintf(fLogDebug, "[%s] %s\n", szBuf, szBufString);
-		fflush(fLogDebug);
-	}
-	else {
+	if (!Logger::Write(iLogDebug, szBufString))
 		ConPrint(L"Failed to write debug log! This might be due to inability to create the directory - are you running as an administrator?\n");
-	}
 }
 
 
@@ -40,18 +48,10 @@ void AddLog(const char *szString, ...)
 	va_list marker;
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
+	szBufString[sizeof(szBufString) - 1] = 0;
 
-	if (fLog) {
-		char szBuf[64];
-		time_t tNow = time(0);
-		struct tm *t = localtime(&tNow);
-		strftime(szBuf, sizeof(szBuf), "%d.%m.%Y %H:%M:%S", t);
-		fprintf(fLog, "[%s] %s\n", szBuf, szBufString);
-		fflush(fLog);
-	}
-	else {
+	if (!Logger::Write(iLogFLHook, szBufString))
 		ConPrint(L"Failed to write log! This might be due to inability to create the directory - are you running as an administrator?\n");
-	}
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -85,8 +85,8 @@ void HkHandleCheater(uint iClientID, bool bBan, wstring wscReason, ...)
 
 bool HkAddCheaterLog(const wstring &wscCharname, const wstring &wscReason)
 {
-	FILE *f = fopen(("./flhook_logs/flhook_cheaters.log"), "at");
-	if (!f)
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = Logger::Open("./flhook_logs/flhook_cheaters.log", 0, LOG_STAMP_EVENT)))
 		return false;
 
 	CAccount *acc = HkGetAccountByCharname(wscCharname);
@@ -105,11 +105,8 @@ bool HkAddCheaterLog(const wstring &wscCharname, const wstring &wscReason)
 		HkGetPlayerIP(iClientID, wscIp);
 
 
-	time_t tNow = time(0);
-	struct tm *stNow = localtime(&tNow);
-	fprintf(f, "%.2d/%.2d/%.4d %.2d:%.2d:%.2d Possible cheating detected (%s) by %s(%s)(%s) [%s]\n",
-		stNow->tm_mon + 1, stNow->tm_mday, stNow->tm_year + 1900, stNow->tm_hour, stNow->tm_min, stNow->tm_sec, wstos(wscReason).c_str(), wstos(wscCharname).c_str(), wstos(wscAccountDir).c_str(), wstos(wscAccountID).c_str(), wstos(wscIp).c_str());
-	fclose(f);
+	HkLogWrite(iLogID, "Possible cheating detected (%s) by %s(%s)(%s) [%s]",
+		wstos(wscReason).c_str(), wstos(wscCharname).c_str(), wstos(wscAccountDir).c_str(), wstos(wscAccountID).c_str(), wstos(wscIp).c_str());
 	return true;
 }
 
@@ -117,8 +114,8 @@ bool HkAddCheaterLog(const wstring &wscCharname, const wstring &wscReason)
 
 bool HkAddCheaterLog(const uint &iClientID, const wstring &wscReason)
 {
-	FILE *f = fopen(("./flhook_logs/flhook_cheaters.log"), "at");
-	if (!f)
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = Logger::Open("./flhook_logs/flhook_cheaters.log", 0, LOG_STAMP_EVENT)))
 		return false;
 
 	CAccount *acc = Players.FindAccountFromClientID(iClientID);
@@ -139,11 +136,8 @@ bool HkAddCheaterLog(const uint &iClientID, const wstring &wscReason)
 		wscCharname = (wchar_t*)Players.GetActiveCharacterName(iClientID);
 	}
 
-	time_t tNow = time(0);
-	struct tm *stNow = localtime(&tNow);
-	fprintf(f, "%.2d/%.2d/%.4d %.2d:%.2d:%.2d Possible cheating detected (%s) by %s(%s)(%s) [%s]\n",
-		stNow->tm_mon + 1, stNow->tm_mday, stNow->tm_year + 1900, stNow->tm_hour, stNow->tm_min, stNow->tm_sec, wstos(wscReason).c_str(), wstos(wscCharname).c_str(), wstos(wscAccountDir).c_str(), wstos(wscAccountID).c_str(), wstos(wscIp).c_str());
-	fclose(f);
+	HkLogWrite(iLogID, "Possible cheating detected (%s) by %s(%s)(%s) [%s]",
+		wstos(wscReason).c_str(), wstos(wscCharname).c_str(), wstos(wscAccountDir).c_str(), wstos(wscAccountID).c_str(), wstos(wscIp).c_str());
 	return true;
 }
 
@@ -157,8 +151,8 @@ bool HkAddKickLog(uint iClientID, wstring wscReason, ...)
 
 	_vsnwprintf(wszBuf, (sizeof(wszBuf) / 2) - 1, wscReason.c_str(), marker);
 
-	FILE *f = fopen(("./flhook_logs/flhook_kicks.log"), "at");
-	if (!f)
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = Logger::Open("./flhook_logs/flhook_kicks.log", 0, LOG_STAMP_EVENT)))
 		return false;
 
 	const wchar_t *wszCharname = (wchar_t*)Players.GetActiveCharacterName(iClientID);
@@ -169,10 +163,7 @@ bool HkAddKickLog(uint iClientID, wstring wscReason, ...)
 	wstring wscAccountDir;
 	HkGetAccountDirName(acc, wscAccountDir);
 
-	time_t tNow = time(0);
-	struct tm *stNow = localtime(&tNow);
-	fprintf(f, "%.2d/%.2d/%.4d %.2d:%.2d:%.2d Kick (%s): %s(%s)(%s)\n", stNow->tm_mon + 1, stNow->tm_mday, stNow->tm_year + 1900, stNow->tm_hour, stNow->tm_min, stNow->tm_sec, wstos(wszBuf).c_str(), wstos(wszCharname).c_str(), wstos(wscAccountDir).c_str(), wstos(HkGetAccountID(acc)).c_str());
-	fclose(f);
+	HkLogWrite(iLogID, "Kick (%s): %s(%s)(%s)", wstos(wszBuf).c_str(), wstos(wszCharname).c_str(), wstos(wscAccountDir).c_str(), wstos(HkGetAccountID(acc)).c_str());
 	return true;
 }
 
@@ -186,8 +177,8 @@ bool HkAddConnectLog(uint iClientID, wstring wscReason, ...)
 
 	_vsnwprintf(wszBuf, (sizeof(wszBuf) / 2) - 1, wscReason.c_str(), marker);
 
-	FILE *f = fopen(("./flhook_logs/flhook_connects.log"), "at");
-	if (!f)
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = Logger::Open("./flhook_logs/flhook_connects.log", 0, LOG_STAMP_EVENT)))
 		return false;
 
 	const wchar_t *wszCharname = (wchar_t*)Players.GetActiveCharacterName(iClientID);
@@ -198,108 +189,74 @@ bool HkAddConnectLog(uint iClientID, wstring wscReason, ...)
 	wstring wscAccountDir;
 	HkGetAccountDirName(acc, wscAccountDir);
 
-	time_t tNow = time(0);
-	struct tm *stNow = localtime(&tNow);
-	fprintf(f, "%.2d/%.2d/%.4d %.2d:%.2d:%.2d Connect (%s): %s(%s)(%s)\n", stNow->tm_mon + 1, stNow->tm_mday, stNow->tm_year + 1900, stNow->tm_hour, stNow->tm_min, stNow->tm_sec, wstos(wszBuf).c_str(), wstos(wszCharname).c_str(), wstos(wscAccountDir).c_str(), wstos(HkGetAccountID(acc)).c_str());
-	fclose(f);
+	HkLogWrite(iLogID, "Connect (%s): %s(%s)(%s)", wstos(wszBuf).c_str(), wstos(wszCharname).c_str(), wstos(wscAccountDir).c_str(), wstos(HkGetAccountID(acc)).c_str());
 	return true;
 }
 
-
-///////////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-static void AddLog(FILE* fLog, const char *szString, ...)
-{
-	char szBufString[1024];
-	va_list marker;
-	va_start(marker, szString);
-	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
-
-	if (fLog) {
-		char szBuf[64];
-		time_t tNow = time(0);
-		struct tm *t = localtime(&tNow);
-		strftime(szBuf, sizeof(szBuf), "%d.%m.%Y %H:%M:%S", t);
-		fprintf(fLog, "[%s] %s\n", szBuf, szBufString);
-		fflush(fLog);
-	}
-	else {
-		ConPrint(L"Failed to write log! This might be due to inability to create the directory - are you running as an administrator?\n");
-	}
-}
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void HkAddAdminCmdLog(const char *szString, ...)
 {
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = Logger::Open("./flhook_logs/flhook_admincmds.log", 0, LOG_STAMP_DEFAULT)))
+		return;
+
 	char szBufString[1024];
 	va_list marker;
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
+	szBufString[sizeof(szBufString) - 1] = 0;
 
-	FILE *f = fopen(("./flhook_logs/flhook_admincmds.log"), "at");
-	if (!f)
-		return;
-
-	AddLog(f, "%s", szBufString);
-
-	fclose(f);
-	return;
+	Logger::Write(iLogID, szBufString);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void HkAddSocketCmdLog(const char *szString, ...)
 {
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = Logger::Open("./flhook_logs/flhook_socketcmds.log", 0, LOG_STAMP_DEFAULT)))
+		return;
+
 	char szBufString[1024];
 	va_list marker;
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
+	szBufString[sizeof(szBufString) - 1] = 0;
 
-	FILE *f = fopen(("./flhook_logs/flhook_socketcmds.log"), "at");
-	if (!f)
-		return;
-
-	AddLog(f, "%s", szBufString);
-
-	fclose(f);
-	return;
+	Logger::Write(iLogID, szBufString);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void HkAddUserCmdLog(const char *szString, ...)
 {
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = Logger::Open("./flhook_logs/flhook_usercmds.log", 0, LOG_STAMP_DEFAULT)))
+		return;
+
 	char szBufString[1024];
 	va_list marker;
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
+	szBufString[sizeof(szBufString) - 1] = 0;
 
-	FILE *f = fopen(("./flhook_logs/flhook_usercmds.log"), "at");
-	if (!f)
-		return;
-
-	AddLog(f, "%s", szBufString);
-
-	fclose(f);
-	return;
+	Logger::Write(iLogID, szBufString);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void HkAddPerfTimerLog(const char *szString, ...)
 {
+	static uint iLogID = 0;
+	if (!iLogID && !(iLogID = Logger::Open("./flhook_logs/flhook_perftimers.log", 0, LOG_STAMP_DEFAULT)))
+		return;
+
 	char szBufString[1024];
 	va_list marker;
 	va_start(marker, szString);
 	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
+	szBufString[sizeof(szBufString) - 1] = 0;
 
-	FILE *f = fopen(("./flhook_logs/flhook_perftimers.log"), "at");
-	if (!f)
-		return;
-
-	AddLog(f, "%s", szBufString);
-
-	fclose(f);
-	return;
-}
\ No newline at end of file
+	Logger::Write(iLogID, szBufString);
+}
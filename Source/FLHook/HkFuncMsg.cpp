@@ -1,4 +1,5 @@
 #include "hook.h"
+#include <map>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -9,10 +10,10 @@ HK_ERROR HkMsg(uint iClientID, const wstring &wscMessage)
 	struct CHAT_ID ci = { 0 };
 	struct CHAT_ID ciClient = { iClientID };
 
-	wstring wscXML = L"<TRA data=\"0x19BD3A00\" mask=\"-1\"/><TEXT>" + XMLText(wscMessage) + L"</TEXT>";
 	uint iRet;
 	char szBuf[1024];
-	HkFMsgEncodeXML(wscXML, szBuf, sizeof(szBuf), iRet);
+	if (!HKHKSUCCESS(HkFMsgEncodeMsg(L"<TRA data=\"0x19BD3A00\" mask=\"-1\"/>", wscMessage, szBuf, sizeof(szBuf), iRet)))
+		return HKE_WRONG_XML_SYNTAX;
 	g_bMsg = true;
 	HkIServerImpl::SubmitChat(ci, iRet, szBuf, ciClient, -1);
 	g_bMsg = false;
@@ -44,28 +45,22 @@ HK_ERROR HkMsgS(const wstring &wscSystemname, const wstring &wscMessage)
 			return HKE_INVALID_SYSTEM;;
 	}
 
-	// prepare xml
-	wstring wscXML = L"<TRA data=\"0xE6C68400\" mask=\"-1\"/><TEXT>" + XMLText(wscMessage) + L"</TEXT>";
+	// encode message
 	uint iRet;
 	char szBuf[1024];
-	HkFMsgEncodeXML(wscXML, szBuf, sizeof(szBuf), iRet);
+	if (!HKHKSUCCESS(HkFMsgEncodeMsg(L"<TRA data=\"0xE6C68400\" mask=\"-1\"/>", wscMessage, szBuf, sizeof(szBuf), iRet)))
+		return HKE_WRONG_XML_SYNTAX;
 
 	struct CHAT_ID ci = { 0 };
 
 	// for all players in system...
-	struct PlayerData *pPD = 0;
-	while (pPD = Players.traverse_active(pPD))
+	const CLIENT_SET &clients = PlayerIndex::GetSystemClients(iSystemID);
+	for (uint iClientID = ClientSetNext(clients, 0); iClientID; iClientID = ClientSetNext(clients, iClientID))
 	{
-		uint iClientID = HkGetClientIdFromPD(pPD);
-		uint iClientSystemID = 0;
-		pub::Player::GetSystem(iClientID, iClientSystemID);
-		if (iSystemID == iClientSystemID)
-		{
-			struct CHAT_ID ciClient = { iClientID };
-			g_bMsgS = true;
-			HkIServerImpl::SubmitChat(ci, iRet, szBuf, ciClient, -1);
-			g_bMsgS = false;
-		}
+		struct CHAT_ID ciClient = { iClientID };
+		g_bMsgS = true;
+		HkIServerImpl::SubmitChat(ci, iRet, szBuf, ciClient, -1);
+		g_bMsgS = false;
 	}
 
 	return HKE_OK;
@@ -80,10 +75,10 @@ HK_ERROR HkMsgU(const wstring &wscMessage)
 	struct CHAT_ID ci = { 0 };
 	struct CHAT_ID ciClient = { 0x00010000 };
 
-	wstring wscXML = L"<TRA font=\"1\" color=\"#FFFFFF\"/><TEXT>" + XMLText(wscMessage) + L"</TEXT>";
 	uint iRet;
 	char szBuf[1024];
-	HkFMsgEncodeXML(wscXML, szBuf, sizeof(szBuf), iRet);
+	if (!HKHKSUCCESS(HkFMsgEncodeMsg(L"<TRA font=\"1\" color=\"#FFFFFF\"/>", wscMessage, szBuf, sizeof(szBuf), iRet)))
+		return HKE_WRONG_XML_SYNTAX;
 	g_bMsgU = true;
 	HkIServerImpl::SubmitChat(ci, iRet, szBuf, ciClient, -1);
 	g_bMsgU = false;
@@ -109,6 +104,248 @@ HK_ERROR HkFMsgEncodeXML(const wstring &wscXML, char *szBuf, uint iSize, uint &i
 	return HKE_OK;;
 }
 
+/**************************************************************************************************************
+encoding of the common "<TRA .../><TEXT>text</TEXT>" messages without going through the xml reader.
+for every TRA tag a template is built once: the tag is encoded with placeholder texts of different lengths,
+the bytes around the text and the length fields that grow with it are extracted and the template is checked
+against real encodings before it is used. tags the template doesn't reproduce exactly keep using the xml path.
+encoded messages are additionally kept in a small LRU, so repeated broadcasts are a single copy.
+**************************************************************************************************************/
+
+#define RDL_PLACEHOLDER 0xE000
+#define RDL_MAX_TEMPLATE_TEXT 512
+#define RDL_CACHE_SIZE 64
+#define RDL_CACHE_MAX_MSG 4096
+
+struct RDL_LENGTH_FIELD
+{
+	uint iOffset;
+	uint iBase;
+	uint iStep;
+};
+
+struct RDL_TEMPLATE
+{
+	bool bValid;
+	string sPrefix;
+	string sSuffix;
+	list<RDL_LENGTH_FIELD> lstPrefixFields;
+	list<RDL_LENGTH_FIELD> lstSuffixFields;
+};
+
+static map<wstring, RDL_TEMPLATE> mapRDLTemplates;
+
+struct RDL_CACHE_ENTRY
+{
+	wstring wscKey;
+	string sEncoded;
+};
+
+static list<RDL_CACHE_ENTRY> lstRDLCache;
+static map<wstring, list<RDL_CACHE_ENTRY>::iterator> mapRDLCache;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static bool RDLEncodePlaceholder(const wstring &wscTRA, const wstring &wscText, string &sRet)
+{
+	char szBuf[0xFFFF];
+	uint iRet;
+	if (!HKHKSUCCESS(HkFMsgEncodeXML(wscTRA + L"<TEXT>" + wscText + L"</TEXT>", szBuf, sizeof(szBuf), iRet)))
+		return false;
+
+	sRet.assign(szBuf, iRet);
+	return true;
+}
+
+// collects the uint fields that differ between the one and two character encodings
+static bool RDLFindLengthFields(const string &sOne, const string &sTwo, list<RDL_LENGTH_FIELD> &lstFields)
+{
+	for (uint i = 0; i < sOne.length(); i++)
+	{
+		if (sOne[i] == sTwo[i])
+			continue;
+
+		if ((i + 4) > sOne.length())
+			return false;
+
+		RDL_LENGTH_FIELD field;
+		field.iOffset = i;
+		memcpy(&field.iBase, sOne.data() + i, 4);
+		uint iTwo;
+		memcpy(&iTwo, sTwo.data() + i, 4);
+		field.iStep = iTwo - field.iBase;
+		if ((field.iStep != 1) && (field.iStep != 2))
+			return false;
+
+		lstFields.push_back(field);
+		i += 3;
+	}
+
+	return true;
+}
+
+static bool RDLBuildFromTemplate(const RDL_TEMPLATE &tpl, const wstring &wscText, char *szBuf, uint iSize, uint &iRet)
+{
+	uint iTextBytes = (uint)wscText.length() * 2;
+	iRet = (uint)(tpl.sPrefix.length() + iTextBytes + tpl.sSuffix.length());
+	if (iRet > iSize)
+		return false;
+
+	char *pText = szBuf + tpl.sPrefix.length();
+	char *pSuffix = pText + iTextBytes;
+	memcpy(szBuf, tpl.sPrefix.data(), tpl.sPrefix.length());
+	memcpy(pText, wscText.data(), iTextBytes);
+	memcpy(pSuffix, tpl.sSuffix.data(), tpl.sSuffix.length());
+
+	uint iGrowth = (uint)wscText.length() - 1;
+	foreach(tpl.lstPrefixFields, RDL_LENGTH_FIELD, it)
+	{
+		uint iValue = it->iBase + it->iStep * iGrowth;
+		memcpy(szBuf + it->iOffset, &iValue, 4);
+	}
+	foreach(tpl.lstSuffixFields, RDL_LENGTH_FIELD, it)
+	{
+		uint iValue = it->iBase + it->iStep * iGrowth;
+		memcpy(pSuffix + it->iOffset, &iValue, 4);
+	}
+
+	return true;
+}
+
+static bool RDLVerifyTemplate(const RDL_TEMPLATE &tpl, const wstring &wscTRA, const wstring &wscText)
+{
+	string sExpected;
+	if (!RDLEncodePlaceholder(wscTRA, wscText, sExpected))
+		return false;
+
+	char szBuf[0xFFFF];
+	uint iRet;
+	if (!RDLBuildFromTemplate(tpl, wscText, szBuf, sizeof(szBuf), iRet))
+		return false;
+
+	return (iRet == sExpected.length()) && !memcmp(szBuf, sExpected.data(), iRet);
+}
+
+static void RDLBuildTemplate(const wstring &wscTRA, RDL_TEMPLATE &tpl)
+{
+	tpl.bValid = false;
+
+	string sOne, sTwo;
+	if (!RDLEncodePlaceholder(wscTRA, wstring(1, RDL_PLACEHOLDER), sOne)
+		|| !RDLEncodePlaceholder(wscTRA, wstring(2, RDL_PLACEHOLDER), sTwo)
+		|| (sTwo.length() != (sOne.length() + 2)))
+		return;
+
+	// the placeholder character doesn't occur anywhere else in the encoding
+	wchar_t wcPlaceholder = RDL_PLACEHOLDER;
+	string sPlaceholder((const char*)&wcPlaceholder, 2);
+	size_t iPos = sOne.find(sPlaceholder);
+	if ((iPos == string::npos) || (sOne.find(sPlaceholder, iPos + 1) != string::npos) || (sTwo.find(sPlaceholder + sPlaceholder) != iPos))
+		return;
+
+	tpl.sPrefix = sOne.substr(0, iPos);
+	tpl.sSuffix = sOne.substr(iPos + 2);
+	if (!RDLFindLengthFields(tpl.sPrefix, sTwo.substr(0, iPos), tpl.lstPrefixFields)
+		|| !RDLFindLengthFields(tpl.sSuffix, sTwo.substr(iPos + 4), tpl.lstSuffixFields))
+		return;
+
+	// check odd/even lengths, spaces and the longest text the template is used for
+	wstring wscSpaced = wstring(1, RDL_PLACEHOLDER) + L" " + wstring(1, RDL_PLACEHOLDER);
+	if (!RDLVerifyTemplate(tpl, wscTRA, wscSpaced)
+		|| !RDLVerifyTemplate(tpl, wscTRA, wstring(6, RDL_PLACEHOLDER))
+		|| !RDLVerifyTemplate(tpl, wscTRA, wstring(RDL_MAX_TEMPLATE_TEXT, RDL_PLACEHOLDER)))
+		return;
+
+	tpl.bValid = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// texts the xml reader might rewrite (control characters, whitespace runs, leading/trailing blanks) take the xml path
+static bool RDLTemplateSuitable(const wstring &wscText)
+{
+	if (wscText.empty() || (wscText.length() > RDL_MAX_TEMPLATE_TEXT))
+		return false;
+
+	if ((wscText[0] == ' ') || (wscText[wscText.length() - 1] == ' '))
+		return false;
+
+	for (uint i = 0; i < wscText.length(); i++)
+	{
+		if (wscText[i] < 0x20)
+			return false;
+		if ((wscText[i] == ' ') && (wscText[i + 1] == ' '))
+			return false;
+	}
+
+	return true;
+}
+
+/**************************************************************************************************************
+Encode wscText with the given TRA tag (e.g. L"<TRA data=\"0x19BD3A00\" mask=\"-1\"/>"), wscText is plain text.
+Same result as HkFMsgEncodeXML(wscTRA + L"<TEXT>" + XMLText(wscText) + L"</TEXT>", ...)
+**************************************************************************************************************/
+
+HK_ERROR HkFMsgEncodeMsg(const wstring &wscTRA, const wstring &wscText, char *szBuf, uint iSize, uint &iRet)
+{
+	wstring wscKey = wscTRA;
+	wscKey.append(1, L'\0');
+	wscKey += wscText;
+
+	map<wstring, list<RDL_CACHE_ENTRY>::iterator>::iterator itCache = mapRDLCache.find(wscKey);
+	if (itCache != mapRDLCache.end())
+	{
+		const string &sEncoded = itCache->second->sEncoded;
+		if (sEncoded.length() > iSize)
+			return HKE_UNKNOWN_ERROR;
+
+		memcpy(szBuf, sEncoded.data(), sEncoded.length());
+		iRet = (uint)sEncoded.length();
+		lstRDLCache.splice(lstRDLCache.begin(), lstRDLCache, itCache->second);
+		return HKE_OK;
+	}
+
+	bool bEncoded = false;
+	if (RDLTemplateSuitable(wscText))
+	{
+		map<wstring, RDL_TEMPLATE>::iterator itTpl = mapRDLTemplates.find(wscTRA);
+		if (itTpl == mapRDLTemplates.end())
+		{
+			itTpl = mapRDLTemplates.insert(make_pair(wscTRA, RDL_TEMPLATE())).first;
+			RDLBuildTemplate(wscTRA, itTpl->second);
+			if (!itTpl->second.bValid)
+				AddLog("NOTICE: Chat message style \"%s\" can't be templated, using xml encoding", wstos(wscTRA).c_str());
+		}
+
+		if (itTpl->second.bValid)
+			bEncoded = RDLBuildFromTemplate(itTpl->second, wscText, szBuf, iSize, iRet);
+	}
+
+	if (!bEncoded)
+	{
+		HK_ERROR err = HkFMsgEncodeXML(wscTRA + L"<TEXT>" + XMLText(wscText) + L"</TEXT>", szBuf, iSize, iRet);
+		if (!HKHKSUCCESS(err))
+			return err;
+	}
+
+	if (iRet <= RDL_CACHE_MAX_MSG)
+	{
+		if (lstRDLCache.size() >= RDL_CACHE_SIZE)
+		{
+			mapRDLCache.erase(lstRDLCache.back().wscKey);
+			lstRDLCache.pop_back();
+		}
+
+		RDL_CACHE_ENTRY entry;
+		entry.wscKey = wscKey;
+		entry.sEncoded.assign(szBuf, iRet);
+		lstRDLCache.push_front(entry);
+		mapRDLCache[wscKey] = lstRDLCache.begin();
+	}
+
+	return HKE_OK;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 _RCSendChatMsg RCSendChatMsg;
@@ -178,15 +415,9 @@ HK_ERROR HkFMsgS(const wstring &wscSystemname, const wstring &wscXML)
 
 
 	// for all players in system...
-	struct PlayerData *pPD = 0;
-	while (pPD = Players.traverse_active(pPD))
-	{
-		uint iClientID = HkGetClientIdFromPD(pPD);
-		uint iClientSystemID = 0;
-		pub::Player::GetSystem(iClientID, iClientSystemID);
-		if (iSystemID == iClientSystemID)
-			HkFMsgSendChat(iClientID, szBuf, iRet);
-	}
+	const CLIENT_SET &clients = PlayerIndex::GetSystemClients(iSystemID);
+	for (uint iClientID = ClientSetNext(clients, 0); iClientID; iClientID = ClientSetNext(clients, iClientID))
+		HkFMsgSendChat(iClientID, szBuf, iRet);
 
 	return HKE_OK;
 }
@@ -58,6 +58,22 @@ void HkGetPlayerIP(uint iClientID, wstring &wscIP)
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+static void HkFillPlayerInfo(const PLAYER_SNAPSHOT *player, HKPLAYERINFO &pi)
+{
+	pi.iClientID = player->iClientID;
+	pi.wscCharname = player->wscCharname;
+	pi.wscBase = player->wscBase;
+	pi.wscSystem = player->wscSystem;
+	pi.iSystem = player->iSystem;
+	pi.iShip = player->iShip;
+	pi.wscIP = player->wscIP;
+
+	// get ping
+	HkGetConnectionStats(player->iClientID, pi.ci);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 HK_ERROR HkGetPlayerInfo(const wstring &wscCharname, HKPLAYERINFO &pi, bool bAlsoCharmenu)
 {
 	HK_GET_CLIENTID(iClientID, wscCharname);
@@ -65,11 +81,19 @@ HK_ERROR HkGetPlayerInfo(const wstring &wscCharname, HKPLAYERINFO &pi, bool bAls
 	if (iClientID == -1 || (HkIsInCharSelectMenu(iClientID) && !bAlsoCharmenu))
 		return HKE_PLAYER_NOT_LOGGED_IN; // not on server
 
+	const PLAYER_SNAPSHOT *player = PlayerIndex::GetPlayer(iClientID);
+	if (player && player->wscCharname.length())
+	{
+		HkFillPlayerInfo(player, pi);
+		return HKE_OK;
+	}
+
 	const wchar_t *wszActiveCharname = (wchar_t*)Players.GetActiveCharacterName(iClientID);
 
 	pi.iClientID = iClientID;
 	pi.wscCharname = wszActiveCharname ? wszActiveCharname : L"";
 	pi.wscBase = pi.wscSystem = L"";
+	pi.iSystem = 0;
 
 	uint iBase = 0;
 	uint iSystem = 0;
@@ -103,22 +127,20 @@ HK_ERROR HkGetPlayerInfo(const wstring &wscCharname, HKPLAYERINFO &pi, bool bAls
 	return HKE_OK;
 }
 
+// the players in space or docked, built from the player snapshots without asking the server
 list<HKPLAYERINFO> HkGetPlayers()
 {
 	list<HKPLAYERINFO> lstRet;
-	wstring wscRet;
 
-	struct PlayerData *pPD = 0;
-	while (pPD = Players.traverse_active(pPD))
+	const CLIENT_SET &clients = PlayerIndex::GetOnlineClients();
+	for (uint iClientID = ClientSetNext(clients, 0); iClientID; iClientID = ClientSetNext(clients, iClientID))
 	{
-		uint iClientID = HkGetClientIdFromPD(pPD);
-
-		if (HkIsInCharSelectMenu(iClientID))
-			continue;
+		const PLAYER_SNAPSHOT *player = PlayerIndex::GetPlayer(iClientID);
+		if (!player->iBase && !player->iSystem)
+			continue; // character select menu
 
-		HKPLAYERINFO pi;
-		HkGetPlayerInfo(ARG_CLIENTID(iClientID), pi, false);
-		lstRet.push_back(pi);
+		lstRet.push_back(HKPLAYERINFO());
+		HkFillPlayerInfo(player, lstRet.back());
 	}
 
 	return lstRet;
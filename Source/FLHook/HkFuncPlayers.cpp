@@ -1,4 +1,3 @@
-#include <fstream>
 #include "hook.h"
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -22,24 +21,13 @@ HK_ERROR HkGetCash(const wstring &wscCharname, int &iCash)
 
 		string scCharFile = scAcctPath + wstos(wscDir) + "\\" + wstos(wscFile) + ".fl";
 
-		FILE* fTest = fopen(scCharFile.c_str(), "r");
-		if (!fTest)
-			return HKE_CHAR_DOES_NOT_EXIST;
-		else
-			fclose(fTest);
-
-		if (HkIsEncoded(scCharFile)) {
-			string scCharFileNew = scCharFile + ".ini";
-			if (!flc_decode(scCharFile.c_str(), scCharFileNew.c_str()))
-				return HKE_COULD_NOT_DECODE_CHARFILE;
-
-			iCash = IniGetI(scCharFileNew, "Player", "money", -1);
-			DeleteFile(scCharFileNew.c_str());
-		}
-		else {
-			iCash = IniGetI(scCharFile, "Player", "money", -1);
-		}
+		const CHARFILE *charfile;
+		HK_ERROR err = CharFileCache::Load(scCharFile, charfile);
+		if (!HKHKSUCCESS(err))
+			return err;
 
+		string scMoney = CharFileCache::GetValue(*charfile, "Player", "money", "");
+		iCash = scMoney.length() ? atoi(scMoney.c_str()) : -1;
 		return HKE_OK;
 	}
 }
@@ -74,30 +62,21 @@ HK_ERROR HkAddCash(const wstring &wscCharname, int iAmount)
 		HkGetCharFileName(wscCharname, wscFile);
 
 		string scCharFile = scAcctPath + wstos(wscDir) + "\\" + wstos(wscFile) + ".fl";
-		int iRet;
-		if (HkIsEncoded(scCharFile)) {
-			string scCharFileNew = scCharFile + ".ini";
-
-			if (!flc_decode(scCharFile.c_str(), scCharFileNew.c_str()))
-				return HKE_COULD_NOT_DECODE_CHARFILE;
-
-			iRet = IniGetI(scCharFileNew, "Player", "money", -1);
-			// Add a space to the value so the ini file line looks like "<key> = <value>"
-			// otherwise IFSO can't decode the file correctly
-			IniWrite(scCharFileNew, "Player", "money", " " + itos(iRet + iAmount));
-
-			if (!set_bDisableCharfileEncryption)
-				if (!flc_encode(scCharFileNew.c_str(), scCharFile.c_str()))
-					return HKE_COULD_NOT_ENCODE_CHARFILE;
-
-			DeleteFile(scCharFileNew.c_str());
-		}
-		else {
-			iRet = IniGetI(scCharFile, "Player", "money", -1);
-			// Add a space to the value so the ini file line looks like "<key> = <value>"
-			// otherwise IFSO can't decode the file correctly
-			IniWrite(scCharFile, "Player", "money", " " + itos(iRet + iAmount));
-		}
+		const CHARFILE *charfile;
+		HK_ERROR err = CharFileCache::Load(scCharFile, charfile);
+		if (!HKHKSUCCESS(err))
+			return err;
+
+		CHARFILE charfileNew = *charfile;
+		string scMoney = CharFileCache::GetValue(charfileNew, "Player", "money", "");
+		int iRet = scMoney.length() ? atoi(scMoney.c_str()) : -1;
+		// Add a space to the value so the ini file line looks like "<key> = <value>"
+		// otherwise IFSO can't decode the file correctly
+		CharFileCache::SetValue(charfileNew, "Player", "money", " " + itos(iRet + iAmount));
+
+		err = CharFileCache::Save(scCharFile, charfileNew, charfileNew.bEncoded && !set_bDisableCharfileEncryption);
+		if (!HKHKSUCCESS(err))
+			return err;
 
 		if (HkIsInCharSelectMenu(wscCharname) || (iClientIDAcc != -1))
 		{ // money fix in case player logs in with this account
@@ -250,6 +229,7 @@ HK_ERROR HkBeam(const wstring &wscCharname, const wstring &wscBasename)
 		Server.CharacterSelect(cID, iClientID);
 	}
 
+	PlayerIndex::Refresh(iClientID);
 	return HKE_OK;
 }
 
@@ -1129,31 +1109,15 @@ HK_ERROR HkReadCharFile(const wstring &wscCharname, list<wstring> &lstOutput)
 	wstring wscFile;
 	HkGetCharFileName(wscCharname, wscFile);
 	string scCharFile = scAcctPath + wstos(wscDir) + "\\" + wstos(wscFile) + ".fl";
-	string scFileToRead;
-	bool bDeleteAfter;
-	if (HkIsEncoded(scCharFile)) {
-		string scCharFileNew = scCharFile + ".ini";
-		if (!flc_decode(scCharFile.c_str(), scCharFileNew.c_str()))
-			return HKE_COULD_NOT_DECODE_CHARFILE;
-		scFileToRead = scCharFileNew;
-		bDeleteAfter = true;
-	}
-	else {
-		scFileToRead = scCharFile;
-		bDeleteAfter = false;
-	}
-
-	ifstream ifs;
-	ifs.open(scFileToRead.c_str(), ios_base::in);
-	if (!ifs.is_open())
+	const CHARFILE *charfile;
+	HK_ERROR err = CharFileCache::Load(scCharFile, charfile);
+	if (err == HKE_CHAR_DOES_NOT_EXIST)
 		return HKE_UNKNOWN_ERROR;
+	else if (!HKHKSUCCESS(err))
+		return err;
 
-	string scLine;
-	while (getline(ifs, scLine))
-		lstOutput.push_back(stows(scLine));
-	ifs.close();
-	if (bDeleteAfter)
-		DeleteFile(scFileToRead.c_str());
+	for (uint i = 0; i < charfile->vLines.size(); i++)
+		lstOutput.push_back(stows(charfile->vLines[i]));
 	return HKE_OK;
 }
 
@@ -1182,38 +1146,25 @@ HK_ERROR HkWriteCharFile(const wstring &wscCharname, wstring wscData)
 	wstring wscFile;
 	HkGetCharFileName(wscCharname, wscFile);
 	string scCharFile = scAcctPath + wstos(wscDir) + "\\" + wstos(wscFile) + ".fl";
-	string scFileToWrite;
-	bool bEncode;
-	if (HkIsEncoded(scCharFile)) {
-		scFileToWrite = scCharFile + ".ini";
-		bEncode = true;
-	}
-	else {
-		scFileToWrite = scCharFile;
-		bEncode = false;
-	}
-
-	ofstream ofs;
-	ofs.open(scFileToWrite.c_str(), ios_base::out);
-	if (!ofs.is_open())
-		return HKE_UNKNOWN_ERROR;
+	const CHARFILE *charfileOld;
+	bool bEncode = HKHKSUCCESS(CharFileCache::Load(scCharFile, charfileOld)) && charfileOld->bEncoded;
 
+	CHARFILE charfile;
+	charfile.bTrailingNewline = false;
 	size_t iPos;
 	while ((iPos = wscData.find(L"\\n")) != -1)
 	{
-		wstring wscLine = wscData.substr(0, iPos);
-		ofs << wstos(wscLine) << endl;
+		charfile.vLines.push_back(wstos(wscData.substr(0, iPos)));
 		wscData.erase(0, iPos + 2);
 	}
 
 	if (wscData.length())
-		ofs << wstos(wscData);
+		charfile.vLines.push_back(wstos(wscData));
+	else
+		charfile.bTrailingNewline = !charfile.vLines.empty();
 
-	ofs.close();
-	if (bEncode)
-	{
-		flc_encode(scFileToWrite.c_str(), scCharFile.c_str());
-		DeleteFile(scFileToWrite.c_str());
-	}
-	return HKE_OK;
+	HK_ERROR err = CharFileCache::Save(scCharFile, charfile, bEncode);
+	if (err == HKE_COULD_NOT_ENCODE_CHARFILE)
+		return HKE_UNKNOWN_ERROR;
+	return err;
 }
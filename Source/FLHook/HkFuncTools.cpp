@@ -4,16 +4,7 @@
 
 uint HkGetClientIdFromAccount(CAccount *acc)
 {
-	struct PlayerData *pPD = 0;
-	while (pPD = Players.traverse_active(pPD))
-	{
-		if (pPD->Account == acc)
-		{
-			return pPD->iOnlineID;
-		}
-	}
-
-	return -1;
+	return PlayerIndex::FindAccount(acc);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -39,11 +30,7 @@ CAccount* HkGetAccountByCharname(const wstring &wscCharname)
 
 uint HkGetClientIdFromCharname(const wstring &wscCharname)
 {
-	CAccount *acc = HkGetAccountByCharname(wscCharname);
-	if (!acc)
-		return -1;
-
-	uint iClientID = HkGetClientIdFromAccount(acc);
+	uint iClientID = PlayerIndex::FindCharname(wscCharname);
 	if (iClientID == -1)
 		return -1;
 
@@ -216,13 +203,7 @@ HK_ERROR HkResolveShortCut(const wstring &wscShortcut, uint &_iClientID)
 
 uint HkGetClientIDByShip(uint iShip)
 {
-	for (uint i = 0; i <= MAX_CLIENT_ID; i++)
-	{
-		if (ClientInfo[i].iShip == iShip || ClientInfo[i].iShipOld == iShip)
-			return i;
-	}
-
-	return 0;
+	return PlayerIndex::FindShip(iShip);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -24,8 +24,9 @@ void HkAddHelpEntry(const wstring &wscCommand, const wstring &wscArguments, cons
 }
 void HkRemoveHelpEntry(const wstring &wscCommand, const wstring &wscArguments) {
 	foreach(lstHelpEntries, stHelpEntry, he) {
-		if (he->wszCommand == wscCommand && he->wszArguments == wscArguments)
+		if (he->wszCommand == wscCommand && he->wszArguments == wscArguments) {
 			lstHelpEntries.erase(he);
-
+			return;
+		}
 	}
 }
\ No newline at end of file
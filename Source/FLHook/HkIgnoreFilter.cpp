@@ -0,0 +1,75 @@
+#include "hook.h"
+
+/**************************************************************************************************************
+the ignore list of every client compiled for chat delivery: exact charnames in a map and the "i" entries
+(charname contains) in a string matcher, so a line is checked with one lookup and one scan of the sender's
+name. rebuilt from CLIENT_INFO::lstIgnore when it is loaded or changed by /ignore and /delignore.
+**************************************************************************************************************/
+
+namespace IgnoreFilter
+{
+	enum IGNORE_MATCH
+	{
+		IGNORE_MATCH_ALL = 1,
+		IGNORE_MATCH_PRIVATE = 2,
+	};
+
+	struct IGNORE_FILTER
+	{
+		map<wstring, bool> mapNames; // lower case charname, true = every chat, false = private chat only
+		CStringMatcher matcher;
+	};
+
+	static IGNORE_FILTER filters[MAX_CLIENT_ID + 1];
+
+	void Rebuild(uint iClientID)
+	{
+		IGNORE_FILTER &filter = filters[iClientID];
+		filter.mapNames.clear();
+		filter.matcher.Clear();
+
+		foreach(ClientInfo[iClientID].lstIgnore, IGNORE_INFO, it)
+		{
+			bool bAllChat = !(it->iFlags & IGNORE_PRIVATE);
+			if (it->iFlags & IGNORE_SUBSTRING)
+				filter.matcher.Add(it->wscCharnameLower, bAllChat ? IGNORE_MATCH_ALL : IGNORE_MATCH_PRIVATE);
+			else
+			{
+				map<wstring, bool>::iterator itName = filter.mapNames.find(it->wscCharnameLower);
+				if (itName == filter.mapNames.end())
+					filter.mapNames[it->wscCharnameLower] = bAllChat;
+				else if (bAllChat)
+					itName->second = true;
+			}
+		}
+
+		filter.matcher.Compile();
+	}
+
+	bool IsIgnored(uint iClientID, const wstring &wscSenderLower, bool bPrivate)
+	{
+		IGNORE_FILTER &filter = filters[iClientID];
+		if (filter.mapNames.size())
+		{
+			map<wstring, bool>::iterator it = filter.mapNames.find(wscSenderLower);
+			if (it != filter.mapNames.end() && (bPrivate || it->second))
+				return true;
+		}
+
+		uint iMask = filter.matcher.Match(wscSenderLower);
+		return bPrivate ? (iMask != 0) : ((iMask & IGNORE_MATCH_ALL) != 0);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// lower case charname and flag bits so chat delivery doesn't have to convert them for every line
+void IgnoreInfoCompile(IGNORE_INFO &ii)
+{
+	ii.wscCharnameLower = ToLower(ii.wscCharname);
+	ii.iFlags = 0;
+	if (ii.wscFlags.find(L'p') != -1)
+		ii.iFlags |= IGNORE_PRIVATE;
+	if (ii.wscFlags.find(L'i') != -1)
+		ii.iFlags |= IGNORE_SUBSTRING;
+}
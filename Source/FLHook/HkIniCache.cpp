@@ -0,0 +1,467 @@
+#include "hook.h"
+#include <map>
+
+/**************************************************************************************************************
+parsed ini documents for the Ini* tools. every GetPrivateProfileString call opens, reads and scans the whole
+file again, the user and config files are read a lot more often than they change. documents are parsed once,
+looked up through per-section key maps and revalidated by the file's write time and size, so edits done by
+hand or by other programs are picked up on the next access.
+writes change the parsed document and store the file in a single write. between IniBeginBatch and IniEndBatch
+the stores are deferred, every touched file is written once when the batch ends.
+only files given with a full path are handled here, the profile api looks up everything else in the windows
+directory and those (and utf-16 files) still go through the profile api.
+**************************************************************************************************************/
+
+#define INI_CACHE_SIZE 64
+
+namespace IniCache
+{
+	struct INI_SECTION
+	{
+		string scHeader;
+		vector<string> vLines;
+		map<string, uint> mapKeys; // lower case key -> first line with this key
+	};
+
+	struct INI_DOCUMENT
+	{
+		bool bExists;
+		FILETIME ftLastWrite;
+		DWORD dwSize;
+		bool bDirty;
+		vector<string> vPreamble;
+		list<INI_SECTION> lstSections;
+		map<string, INI_SECTION*> mapSections; // lower case name -> first section with this name
+	};
+
+	struct CACHE_ENTRY
+	{
+		string scKey;
+		string scPath;
+		INI_DOCUMENT doc;
+	};
+
+	static list<CACHE_ENTRY> lstCache;
+	static map<string, list<CACHE_ENTRY>::iterator> mapCache;
+	static uint iBatchDepth = 0;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static string Trim(const string &scStr)
+	{
+		size_t iStart = scStr.find_first_not_of(" \t");
+		if (iStart == string::npos)
+			return "";
+
+		return scStr.substr(iStart, scStr.find_last_not_of(" \t") - iStart + 1);
+	}
+
+	static bool IsFullPath(const string &scPath)
+	{
+		if (scPath.length() >= 3 && scPath[1] == ':' && (scPath[2] == '\\' || scPath[2] == '/'))
+			return true;
+
+		return (scPath.length() >= 2 && scPath[0] == '\\' && scPath[1] == '\\');
+	}
+
+	static bool GetStamp(const string &scPath, FILETIME &ftLastWrite, DWORD &dwSize)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA fad;
+		if (!GetFileAttributesEx(scPath.c_str(), GetFileExInfoStandard, &fad))
+			return false;
+
+		ftLastWrite = fad.ftLastWriteTime;
+		dwSize = fad.nFileSizeLow;
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// returns the key of a "key=value" line, false for lines without a key
+	static bool GetLineKey(const string &scLine, string &scKeyLower)
+	{
+		size_t iEq = scLine.find('=');
+		if (iEq == string::npos)
+			return false;
+
+		scKeyLower = ToLower(Trim(scLine.substr(0, iEq)));
+		return true;
+	}
+
+	static void IndexSection(INI_SECTION &section)
+	{
+		section.mapKeys.clear();
+		for (uint i = 0; i < section.vLines.size(); i++)
+		{
+			string scKeyLower;
+			if (GetLineKey(section.vLines[i], scKeyLower) && !section.mapKeys.count(scKeyLower))
+				section.mapKeys[scKeyLower] = i;
+		}
+	}
+
+	static void IndexDocument(INI_DOCUMENT &doc)
+	{
+		doc.mapSections.clear();
+		for (list<INI_SECTION>::iterator it = doc.lstSections.begin(); it != doc.lstSections.end(); ++it)
+		{
+			string scHeader = Trim(it->scHeader);
+			size_t iClose = scHeader.find(']');
+			string scNameLower = ToLower(Trim(scHeader.substr(1, (iClose == string::npos ? scHeader.length() : iClose) - 1)));
+			if (!doc.mapSections.count(scNameLower))
+				doc.mapSections[scNameLower] = &(*it);
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void Parse(const char *szData, uint iLen, INI_DOCUMENT &doc)
+	{
+		doc.vPreamble.clear();
+		doc.lstSections.clear();
+
+		vector<string> *pvLines = &doc.vPreamble;
+		uint iStart = 0;
+		while (iStart < iLen)
+		{
+			uint iEnd = iStart;
+			while (iEnd < iLen && szData[iEnd] != '\n')
+				iEnd++;
+
+			uint iLineEnd = (iEnd > iStart && szData[iEnd - 1] == '\r') ? (iEnd - 1) : iEnd;
+			string scLine(szData + iStart, iLineEnd - iStart);
+			iStart = iEnd + 1;
+
+			string scTrimmed = Trim(scLine);
+			if (scTrimmed.length() && scTrimmed[0] == '[')
+			{
+				INI_SECTION section;
+				section.scHeader = scLine;
+				doc.lstSections.push_back(section);
+				pvLines = &doc.lstSections.back().vLines;
+			}
+			else
+				pvLines->push_back(scLine);
+		}
+
+		for (list<INI_SECTION>::iterator it = doc.lstSections.begin(); it != doc.lstSections.end(); ++it)
+			IndexSection(*it);
+		IndexDocument(doc);
+	}
+
+	static string Serialize(const INI_DOCUMENT &doc)
+	{
+		string scData;
+		for (uint i = 0; i < doc.vPreamble.size(); i++)
+			scData += doc.vPreamble[i] + "\r\n";
+
+		for (list<INI_SECTION>::const_iterator it = doc.lstSections.begin(); it != doc.lstSections.end(); ++it)
+		{
+			scData += it->scHeader + "\r\n";
+			for (uint i = 0; i < it->vLines.size(); i++)
+				scData += it->vLines[i] + "\r\n";
+		}
+
+		return scData;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// false if the file can't be handled here (read error or unicode file)
+	static bool ReadDocument(const string &scPath, INI_DOCUMENT &doc)
+	{
+		doc.bDirty = false;
+		HANDLE hFile = CreateFile(scPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+		if (hFile == INVALID_HANDLE_VALUE)
+		{
+			// a missing file is an empty document, writing to it creates the file
+			if (GetLastError() != ERROR_FILE_NOT_FOUND && GetLastError() != ERROR_PATH_NOT_FOUND)
+				return false;
+
+			doc.bExists = false;
+			doc.dwSize = 0;
+			doc.vPreamble.clear();
+			doc.lstSections.clear();
+			doc.mapSections.clear();
+			return true;
+		}
+
+		BY_HANDLE_FILE_INFORMATION fi;
+		if (!GetFileInformationByHandle(hFile, &fi))
+		{
+			CloseHandle(hFile);
+			return false;
+		}
+
+		string scData(fi.nFileSizeLow, '\0');
+		DWORD dwRead = 0;
+		bool bRead = !fi.nFileSizeLow || ReadFile(hFile, &scData[0], fi.nFileSizeLow, &dwRead, 0);
+		CloseHandle(hFile);
+		if (!bRead || (dwRead != fi.nFileSizeLow))
+			return false;
+
+		// utf-16 files are left to the profile api
+		if (dwRead >= 2 && (((uchar)scData[0] == 0xFF && (uchar)scData[1] == 0xFE) || ((uchar)scData[0] == 0xFE && (uchar)scData[1] == 0xFF)))
+			return false;
+
+		doc.bExists = true;
+		doc.ftLastWrite = fi.ftLastWriteTime;
+		doc.dwSize = fi.nFileSizeLow;
+		Parse(scData.data(), dwRead, doc);
+		return true;
+	}
+
+	static bool WriteDocument(const string &scPath, INI_DOCUMENT &doc)
+	{
+		string scData = Serialize(doc);
+		HANDLE hFile = CreateFile(scPath.c_str(), GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+		if (hFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		DWORD dwWritten = 0;
+		bool bWritten = scData.empty() || WriteFile(hFile, scData.data(), (DWORD)scData.length(), &dwWritten, 0);
+		CloseHandle(hFile);
+		if (!bWritten || (dwWritten != scData.length()))
+			return false;
+
+		doc.bDirty = false;
+		doc.bExists = GetStamp(scPath, doc.ftLastWrite, doc.dwSize);
+		return doc.bExists;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void Drop(list<CACHE_ENTRY>::iterator itEntry)
+	{
+		mapCache.erase(itEntry->scKey);
+		lstCache.erase(itEntry);
+	}
+
+	static void Store(list<CACHE_ENTRY>::iterator itEntry)
+	{
+		if (!WriteDocument(itEntry->scPath, itEntry->doc))
+		{
+			AddLog("ERROR: Could not write ini file %s", itEntry->scPath.c_str());
+			Drop(itEntry);
+		}
+	}
+
+	// returns the cached document of the file, 0 if the profile api has to handle it
+	static INI_DOCUMENT* Load(const string &scPath)
+	{
+		if (!IsFullPath(scPath))
+			return 0;
+
+		string scKey = ToLower(scPath);
+		FILETIME ftLastWrite;
+		DWORD dwSize = 0;
+		bool bExists = GetStamp(scPath, ftLastWrite, dwSize);
+
+		map<string, list<CACHE_ENTRY>::iterator>::iterator it = mapCache.find(scKey);
+		if (it != mapCache.end())
+		{
+			INI_DOCUMENT &cached = it->second->doc;
+			bool bValid = cached.bDirty || (bExists ? (cached.bExists && !CompareFileTime(&cached.ftLastWrite, &ftLastWrite) && (cached.dwSize == dwSize)) : !cached.bExists);
+			if (bValid)
+			{
+				lstCache.splice(lstCache.begin(), lstCache, it->second);
+				return &cached;
+			}
+
+			Drop(it->second);
+		}
+
+		if (lstCache.size() >= INI_CACHE_SIZE)
+		{
+			list<CACHE_ENTRY>::iterator itOldest = --lstCache.end();
+			if (itOldest->doc.bDirty)
+				Store(itOldest);
+			if (lstCache.size() >= INI_CACHE_SIZE)
+				Drop(--lstCache.end());
+		}
+
+		CACHE_ENTRY entry;
+		entry.scKey = scKey;
+		entry.scPath = scPath;
+		lstCache.push_front(entry);
+		if (!ReadDocument(scPath, lstCache.front().doc))
+		{
+			lstCache.pop_front();
+			return 0;
+		}
+
+		mapCache[scKey] = lstCache.begin();
+		return &lstCache.front().doc;
+	}
+
+	// the document passed in is always the front entry, Load just moved it there
+	static void Modified(INI_DOCUMENT *doc)
+	{
+		doc->bDirty = true;
+		if (!iBatchDepth)
+			Store(lstCache.begin());
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static INI_SECTION* FindSection(INI_DOCUMENT *doc, const string &scApp)
+	{
+		map<string, INI_SECTION*>::iterator it = doc->mapSections.find(ToLower(Trim(scApp)));
+		return (it == doc->mapSections.end()) ? 0 : it->second;
+	}
+
+	static int FindKey(INI_SECTION *section, const string &scKey)
+	{
+		map<string, uint>::iterator it = section->mapKeys.find(ToLower(Trim(scKey)));
+		return (it == section->mapKeys.end()) ? -1 : (int)it->second;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	bool Get(const string &scFile, const string &scApp, const string &scKey, string &scValue, bool &bFound)
+	{
+		INI_DOCUMENT *doc = Load(scFile);
+		if (!doc)
+			return false;
+
+		bFound = false;
+		INI_SECTION *section = FindSection(doc, scApp);
+		int iLine = section ? FindKey(section, scKey) : -1;
+		if (iLine == -1)
+			return true;
+
+		const string &scLine = section->vLines[iLine];
+		scValue = Trim(scLine.substr(scLine.find('=') + 1));
+
+		// the profile api strips enclosing quotes
+		if (scValue.length() >= 2 && ((scValue[0] == '"' && scValue[scValue.length() - 1] == '"') || (scValue[0] == '\'' && scValue[scValue.length() - 1] == '\'')))
+			scValue = scValue.substr(1, scValue.length() - 2);
+
+		bFound = true;
+		return true;
+	}
+
+	bool GetSection(const string &scFile, const string &scApp, list<INISECTIONVALUE> &lstValues)
+	{
+		INI_DOCUMENT *doc = Load(scFile);
+		if (!doc)
+			return false;
+
+		lstValues.clear();
+		INI_SECTION *section = FindSection(doc, scApp);
+		if (!section)
+			return true;
+
+		// same split as the sscanf "%[^=]=%[^\n]" on the profile api's section lines
+		for (uint i = 0; i < section->vLines.size(); i++)
+		{
+			string scLine = Trim(section->vLines[i]);
+			if (!scLine.length() || scLine[0] == '=')
+				continue;
+
+			INISECTIONVALUE isv;
+			size_t iEq = scLine.find('=');
+			isv.scKey = scLine.substr(0, iEq);
+			isv.scValue = (iEq == string::npos) ? "" : scLine.substr(iEq + 1);
+			lstValues.push_back(isv);
+		}
+
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	bool Write(const string &scFile, const string &scApp, const string &scKey, const string &scValue)
+	{
+		INI_DOCUMENT *doc = Load(scFile);
+		if (!doc)
+			return false;
+
+		string scLine = scKey + "=" + scValue;
+		INI_SECTION *section = FindSection(doc, scApp);
+		if (!section)
+		{
+			INI_SECTION newSection;
+			newSection.scHeader = "[" + scApp + "]";
+			doc->lstSections.push_back(newSection);
+			section = &doc->lstSections.back();
+			doc->mapSections[ToLower(Trim(scApp))] = section;
+		}
+
+		int iLine = FindKey(section, scKey);
+		if (iLine != -1)
+			section->vLines[iLine] = scLine;
+		else
+		{
+			// new keys go after the last non-empty line of the section, like the profile api does
+			uint iInsert = (uint)section->vLines.size();
+			while (iInsert && !Trim(section->vLines[iInsert - 1]).length())
+				iInsert--;
+			section->vLines.insert(section->vLines.begin() + iInsert, scLine);
+			IndexSection(*section);
+		}
+
+		Modified(doc);
+		return true;
+	}
+
+	bool Delete(const string &scFile, const string &scApp, const string &scKey)
+	{
+		INI_DOCUMENT *doc = Load(scFile);
+		if (!doc)
+			return false;
+
+		INI_SECTION *section = FindSection(doc, scApp);
+		int iLine = section ? FindKey(section, scKey) : -1;
+		if (iLine == -1)
+			return true;
+
+		section->vLines.erase(section->vLines.begin() + iLine);
+		IndexSection(*section);
+		Modified(doc);
+		return true;
+	}
+
+	bool DelSection(const string &scFile, const string &scApp)
+	{
+		INI_DOCUMENT *doc = Load(scFile);
+		if (!doc)
+			return false;
+
+		INI_SECTION *section = FindSection(doc, scApp);
+		if (!section)
+			return true;
+
+		for (list<INI_SECTION>::iterator it = doc->lstSections.begin(); it != doc->lstSections.end(); ++it)
+		{
+			if (&(*it) == section)
+			{
+				doc->lstSections.erase(it);
+				break;
+			}
+		}
+
+		IndexDocument(*doc);
+		Modified(doc);
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void BeginBatch()
+	{
+		iBatchDepth++;
+	}
+
+	void EndBatch()
+	{
+		if (!iBatchDepth || --iBatchDepth)
+			return;
+
+		for (list<CACHE_ENTRY>::iterator it = lstCache.begin(); it != lstCache.end(); )
+		{
+			list<CACHE_ENTRY>::iterator itEntry = it++;
+			if (itEntry->doc.bDirty)
+				Store(itEntry);
+		}
+	}
+}
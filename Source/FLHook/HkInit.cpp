@@ -166,9 +166,11 @@ clear the clientinfo
 
 void ClearClientInfo(uint iClientID)
 {
+	PlayerIndex::Remove(iClientID);
 	ClientInfo[iClientID].dieMsg = DIEMSG_ALL;
 	ClientInfo[iClientID].iShip = 0;
 	ClientInfo[iClientID].iShipOld = 0;
+	PlayerIndex::ShipsChanged(iClientID);
 	ClientInfo[iClientID].tmSpawnTime = 0;
 	ClientInfo[iClientID].lstMoneyFix.clear();
 	ClientInfo[iClientID].iTradePartner = 0;
@@ -182,8 +184,10 @@ void ClearClientInfo(uint iClientID)
 	ClientInfo[iClientID].tmF1Time = 0;
 	ClientInfo[iClientID].tmF1TimeDisconnect = 0;
 
-	DamageList dmg;
-	ClientInfo[iClientID].dmgLast = dmg;
+	ClientInfo[iClientID].dmgLast.iInflictorShip = 0;
+	ClientInfo[iClientID].dmgLast.iInflictorClient = 0;
+	ClientInfo[iClientID].dmgLast.iCause = 0;
+	ClientInfo[iClientID].dmgLast.tmTime = 0;
 	ClientInfo[iClientID].dieMsgSize = CS_DEFAULT;
 	ClientInfo[iClientID].chatSize = CS_DEFAULT;
 	ClientInfo[iClientID].chatStyle = CST_DEFAULT;
@@ -198,6 +202,7 @@ void ClearClientInfo(uint iClientID)
 	*/
 
 	ClientInfo[iClientID].lstIgnore.clear();
+	IgnoreFilter::Rebuild(iClientID);
 	ClientInfo[iClientID].iKillsInARow = 0;
 	ClientInfo[iClientID].bEngineKilled = false;
 	ClientInfo[iClientID].bThrusterActivated = false;
@@ -238,8 +243,10 @@ void LoadUserSettings(uint iClientID)
 		IGNORE_INFO ii;
 		ii.wscCharname = GetParam(wscIgnore, ' ', 0);
 		ii.wscFlags = GetParam(wscIgnore, ' ', 1);
+		IgnoreInfoCompile(ii);
 		ClientInfo[iClientID].lstIgnore.push_back(ii);
 	}
+	IgnoreFilter::Rebuild(iClientID);
 
 }
 
@@ -484,13 +491,7 @@ void HookRehashed()
 		WriteProcMem(pAddress, &cNewGroupSize, 1);
 	}
 
-	// open debug log if necessary
-	if (set_bDebug && !fLogDebug) {
-		fLogDebug = fopen(sDebugLog.c_str(), "at");
-	}
-	else if (!set_bDebug && fLogDebug) {
-		fclose(fLogDebug);
-		fLogDebug = 0;
-	}
+	// open or close the debug log
+	UpdateDebugLog();
 }
 
@@ -0,0 +1,455 @@
+#include "hook.h"
+#include <vector>
+
+/**************************************************************************************************************
+write-behind logging for flhook and the plugins. the calling thread only formats the line and pushes it onto
+a lock-free interlocked list, a background thread pops everything that has piled up, stamps it (the formatted
+time is cached per second), appends it to the log's buffer and writes every log with a single fwrite/fflush.
+logs with a size limit are rotated to <file>.1 by the writer instead of being deleted, HkLogRotate queues a
+rotation to any name. the log streams are only touched by the writer, except under csLogs.
+**************************************************************************************************************/
+
+#define LOG_MAX_FILES 64
+#define LOG_QUEUE_MAX 65536
+#define LOG_IDLE_WAIT 1000
+
+namespace Logger
+{
+	enum LOG_ENTRY_TYPE
+	{
+		LOG_ENTRY_TEXT,
+		LOG_ENTRY_CLOSE,
+		LOG_ENTRY_ROTATE, // szText is the file the log is moved to
+		LOG_ENTRY_APPEND, // szText is the file, a 0 and the line, iLogID is the LOG_STAMP
+	};
+
+	struct LOG_ENTRY
+	{
+		SLIST_ENTRY link; // must come first, entries are MEMORY_ALLOCATION_ALIGNMENT aligned
+		LOG_ENTRY_TYPE eType;
+		uint iLogID;
+		time_t tmStamp;
+		char szText[1];
+	};
+
+	struct LOG_FILE
+	{
+		string scPath;
+		uint iMaxSize;
+		LOG_STAMP eStamp;
+		FILE *f;
+		bool bOpen;
+		string scBuf;
+		volatile LONG lDropped;
+	};
+
+	static vector<LOG_FILE*> vLogs;
+	static SLIST_HEADER slQueue;
+	static volatile LONG lQueued = 0;
+	static HANDLE hWakeEvent = 0;
+	static HANDLE hWriterThread = 0;
+	static volatile bool bStop = false;
+
+	// protects vLogs and the log streams, the writer holds it while writing a batch
+	static CRITICAL_SECTION csLogs;
+
+	static struct LOGGER_INIT
+	{
+		LOGGER_INIT()
+		{
+			InitializeCriticalSection(&csLogs);
+			InitializeSListHead(&slQueue);
+		}
+	} loggerInit;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void FormatStamp(LOG_STAMP eStamp, time_t tmStamp, string &scStamp)
+	{
+		// one localtime/strftime per second and format, the writer is the only caller
+		static time_t tmCached[LOG_STAMP_AMOUNT];
+		static char szCached[LOG_STAMP_AMOUNT][32];
+		if (tmCached[eStamp] != tmStamp || !szCached[eStamp][0])
+		{
+			struct tm *t = localtime(&tmStamp);
+			if (eStamp == LOG_STAMP_EVENT)
+				strftime(szCached[eStamp], sizeof(szCached[eStamp]), "%m/%d/%Y %H:%M:%S ", t);
+			else if (eStamp == LOG_STAMP_PLUGIN)
+				strftime(szCached[eStamp], sizeof(szCached[eStamp]), "%d/%m/%Y %H:%M:%S ", t);
+			else
+				strftime(szCached[eStamp], sizeof(szCached[eStamp]), "[%d.%m.%Y %H:%M:%S] ", t);
+			tmCached[eStamp] = tmStamp;
+		}
+
+		scStamp = szCached[eStamp];
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void Push(LOG_ENTRY_TYPE eType, uint iLogID, const char *szText, uint iLen)
+	{
+		LOG_ENTRY *entry = (LOG_ENTRY*)_aligned_malloc(sizeof(LOG_ENTRY) + iLen, MEMORY_ALLOCATION_ALIGNMENT);
+		if (!entry)
+			return;
+
+		entry->eType = eType;
+		entry->iLogID = iLogID;
+		entry->tmStamp = time(0);
+		memcpy(entry->szText, szText, iLen);
+		entry->szText[iLen] = 0;
+
+		InterlockedIncrement(&lQueued);
+
+		// the writer is woken for the first entry only, everything pushed until it runs goes into the same batch
+		if (!InterlockedPushEntrySList(&slQueue, &entry->link))
+			SetEvent(hWakeEvent);
+	}
+
+	static void Push(LOG_ENTRY_TYPE eType, uint iLogID, const char *szText)
+	{
+		Push(eType, iLogID, szText, (uint)strlen(szText));
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void Rotate(LOG_FILE *log, const string &scRotatedPath)
+	{
+		fclose(log->f);
+		MoveFileEx(log->scPath.c_str(), scRotatedPath.c_str(), MOVEFILE_REPLACE_EXISTING);
+		log->f = fopen(log->scPath.c_str(), "at");
+	}
+
+	static void WriteBuffer(LOG_FILE *log)
+	{
+		LONG lDropped = InterlockedExchange(&log->lDropped, 0);
+		if (lDropped)
+		{
+			string scStamp;
+			FormatStamp(log->eStamp, time(0), scStamp);
+			char szBuf[64];
+			sprintf(szBuf, "WARNING: %u log lines dropped\n", (uint)lDropped);
+			log->scBuf += scStamp + szBuf;
+		}
+
+		if (log->scBuf.empty())
+			return;
+
+		if (!log->f && log->bOpen)
+			log->f = fopen(log->scPath.c_str(), "at");
+
+		if (log->f)
+		{
+			fwrite(log->scBuf.data(), 1, log->scBuf.length(), log->f);
+			fflush(log->f);
+			if (log->iMaxSize && ftell(log->f) > (long)log->iMaxSize)
+				Rotate(log, log->scPath + ".1");
+		}
+
+		log->scBuf.clear();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// writes everything queued so far, called by the writer thread and by Flush
+	static void ProcessQueue()
+	{
+		EnterCriticalSection(&csLogs);
+
+		// the list is lifo, reverse it to write the lines in the order they were logged
+		LOG_ENTRY *entry = (LOG_ENTRY*)InterlockedFlushSList(&slQueue);
+		LOG_ENTRY *ordered = 0;
+		while (entry)
+		{
+			LOG_ENTRY *next = (LOG_ENTRY*)entry->link.Next;
+			entry->link.Next = (SLIST_ENTRY*)ordered;
+			ordered = entry;
+			entry = next;
+		}
+
+		string scStamp;
+		while (ordered)
+		{
+			LOG_ENTRY *next = (LOG_ENTRY*)ordered->link.Next;
+			LOG_FILE *log = (ordered->iLogID && ordered->iLogID <= vLogs.size()) ? vLogs[ordered->iLogID - 1] : 0;
+			if (ordered->eType == LOG_ENTRY_APPEND)
+			{
+				// files that are only written now and then aren't kept open
+				const char *szLine = ordered->szText + strlen(ordered->szText) + 1;
+				FILE *f = fopen(ordered->szText, "at");
+				if (f)
+				{
+					FormatStamp((LOG_STAMP)ordered->iLogID, ordered->tmStamp, scStamp);
+					fprintf(f, "%s%s\n", scStamp.c_str(), szLine);
+					fclose(f);
+				}
+			}
+			else if (log && ordered->eType == LOG_ENTRY_TEXT)
+			{
+				FormatStamp(log->eStamp, ordered->tmStamp, scStamp);
+				log->scBuf += scStamp;
+				log->scBuf += ordered->szText;
+				log->scBuf += '\n';
+			}
+			else if (log && ordered->eType == LOG_ENTRY_CLOSE)
+			{
+				// the log may have been opened again since the close was queued
+				WriteBuffer(log);
+				if (!log->bOpen && log->f)
+				{
+					fclose(log->f);
+					log->f = 0;
+				}
+			}
+			else if (log && ordered->eType == LOG_ENTRY_ROTATE)
+			{
+				// the lines queued before the rotation still go to the old file
+				WriteBuffer(log);
+				if (log->f)
+					Rotate(log, ordered->szText);
+			}
+
+			_aligned_free(ordered);
+			InterlockedDecrement(&lQueued);
+			ordered = next;
+		}
+
+		for (uint i = 0; i < vLogs.size(); i++)
+			WriteBuffer(vLogs[i]);
+
+		LeaveCriticalSection(&csLogs);
+	}
+
+	static DWORD WINAPI WriterThread(LPVOID lpParam)
+	{
+		while (!bStop)
+		{
+			WaitForSingleObject(hWakeEvent, LOG_IDLE_WAIT);
+			ProcessQueue();
+		}
+
+		ProcessQueue();
+		return 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static uint Find(const string &scPath)
+	{
+		for (uint i = 0; i < vLogs.size(); i++)
+		{
+			if (!_stricmp(vLogs[i]->scPath.c_str(), scPath.c_str()))
+				return i + 1;
+		}
+
+		return 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	uint Open(const string &scPath, uint iMaxSizeKB, LOG_STAMP eStamp)
+	{
+		EnterCriticalSection(&csLogs);
+
+		if (!hWriterThread)
+		{
+			bStop = false;
+			hWakeEvent = CreateEvent(0, FALSE, FALSE, 0);
+			DWORD dwID;
+			hWriterThread = CreateThread(0, 0, WriterThread, 0, 0, &dwID);
+		}
+
+		uint iLogID = Find(scPath);
+		if (!iLogID)
+		{
+			if (vLogs.size() >= LOG_MAX_FILES)
+			{
+				LeaveCriticalSection(&csLogs);
+				return 0;
+			}
+
+			LOG_FILE *log = new LOG_FILE;
+			log->scPath = scPath;
+			log->f = 0;
+			log->bOpen = false;
+			log->lDropped = 0;
+			vLogs.push_back(log);
+			iLogID = (uint)vLogs.size();
+		}
+
+		LOG_FILE *log = vLogs[iLogID - 1];
+		log->iMaxSize = iMaxSizeKB << 10;
+		log->eStamp = eStamp;
+		if (!log->f)
+			log->f = fopen(scPath.c_str(), "at");
+		log->bOpen = (log->f != 0);
+
+		LeaveCriticalSection(&csLogs);
+		return log->bOpen ? iLogID : 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void Close(uint iLogID)
+	{
+		EnterCriticalSection(&csLogs);
+		if (hWriterThread && iLogID && iLogID <= vLogs.size())
+		{
+			// the stream is closed by the writer once the lines queued before have been written
+			vLogs[iLogID - 1]->bOpen = false;
+			Push(LOG_ENTRY_CLOSE, iLogID, "");
+		}
+		LeaveCriticalSection(&csLogs);
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// the file is moved by the writer after the lines queued so far have been written to it
+	bool Rotate(const string &scPath, const string &scRotatedPath)
+	{
+		EnterCriticalSection(&csLogs);
+		uint iLogID = Find(scPath);
+		bool bOpen = hWriterThread && iLogID && vLogs[iLogID - 1]->bOpen;
+		if (bOpen)
+			Push(LOG_ENTRY_ROTATE, iLogID, (scRotatedPath.length() ? scRotatedPath : (scPath + ".1")).c_str());
+		LeaveCriticalSection(&csLogs);
+		return bOpen;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	bool Write(uint iLogID, const char *szText)
+	{
+		if (!iLogID || !hWriterThread)
+			return false;
+
+		if (lQueued >= LOG_QUEUE_MAX)
+		{
+			// the writer can't keep up (disk stalled?), drop instead of growing without limit
+			EnterCriticalSection(&csLogs);
+			if (iLogID <= vLogs.size())
+				InterlockedIncrement(&vLogs[iLogID - 1]->lDropped);
+			LeaveCriticalSection(&csLogs);
+			return true;
+		}
+
+		Push(LOG_ENTRY_TEXT, iLogID, szText);
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	bool Append(const string &scPath, LOG_STAMP eStamp, const char *szText)
+	{
+		if (!hWriterThread || eStamp >= LOG_STAMP_AMOUNT)
+			return false;
+
+		// dropped lines of these files are not counted anywhere
+		if (lQueued >= LOG_QUEUE_MAX)
+			return true;
+
+		string scEntry = scPath;
+		scEntry += '\0';
+		scEntry += szText;
+		Push(LOG_ENTRY_APPEND, (uint)eStamp, scEntry.data(), (uint)scEntry.length());
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// writes everything queued so far on the calling thread, e.g. before a crash dump
+	void Flush()
+	{
+		if (hWriterThread)
+			ProcessQueue();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void Shutdown()
+	{
+		if (!hWriterThread)
+			return;
+
+		bStop = true;
+		SetEvent(hWakeEvent);
+		WaitForSingleObject(hWriterThread, INFINITE);
+		CloseHandle(hWriterThread);
+		CloseHandle(hWakeEvent);
+		hWriterThread = 0;
+		hWakeEvent = 0;
+
+		EnterCriticalSection(&csLogs);
+		for (uint i = 0; i < vLogs.size(); i++)
+		{
+			LOG_FILE *log = vLogs[i];
+			if (log->f)
+				fclose(log->f);
+			log->f = 0;
+			log->bOpen = false;
+		}
+		LeaveCriticalSection(&csLogs);
+	}
+}
+
+/**************************************************************************************************************
+Open a log file for HkLogWrite, iMaxSizeKB > 0 rotates the file to <file>.1 when it grows larger than that.
+Opening the same file again returns the same id. Returns 0 if the file can't be opened.
+**************************************************************************************************************/
+
+uint HkLogOpen(const string &scFile, uint iMaxSizeKB, LOG_STAMP eStamp)
+{
+	return Logger::Open(scFile, iMaxSizeKB, eStamp);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HkLogClose(uint iLogID)
+{
+	Logger::Close(iLogID);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HkLogWrite(uint iLogID, const char *szString, ...)
+{
+	char szBufString[1024];
+	va_list marker;
+	va_start(marker, szString);
+	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
+	szBufString[sizeof(szBufString) - 1] = 0;
+
+	Logger::Write(iLogID, szBufString);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HkLogFlush()
+{
+	Logger::Flush();
+}
+
+/**************************************************************************************************************
+Move an open log to scRotatedFile (<file>.1 if empty) and continue in a new file. The move is done by the
+writer thread after the lines queued so far, returns false if scFile isn't an open log.
+**************************************************************************************************************/
+
+bool HkLogRotate(const string &scFile, const string &scRotatedFile)
+{
+	return Logger::Rotate(scFile, scRotatedFile);
+}
+
+/**************************************************************************************************************
+Append a line to a file that isn't worth keeping open, e.g. one log per player base. The writer thread opens,
+writes and closes the file. Returns false if the logger isn't running.
+**************************************************************************************************************/
+
+bool HkLogAppend(const string &scFile, LOG_STAMP eStamp, const char *szString, ...)
+{
+	char szBufString[1024];
+	va_list marker;
+	va_start(marker, szString);
+	_vsnprintf(szBufString, sizeof(szBufString) - 1, szString, marker);
+	szBufString[sizeof(szBufString) - 1] = 0;
+
+	return Logger::Append(scFile, eStamp, szBufString);
+}
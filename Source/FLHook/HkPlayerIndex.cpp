@@ -0,0 +1,433 @@
+#include "hook.h"
+#include <map>
+
+/**************************************************************************************************************
+index of the logged in players: client -> system/base/ship/account/charname, system -> clients,
+charname -> client and account -> client. it is updated from the server hooks (and the few places where
+flhook calls the server directly) by reading the player's state back from the server, so lookups
+don't have to walk Players.traverse_active and ask the server for every player.
+every player also has a snapshot with the names of the base and system and the ip, it is only rebuilt
+when something changed and then gets a new generation.
+whether a player's system is a no-pvp one is looked up when the player changes system, not on every hit.
+ship -> client for HkGetClientIDByShip is a small open addressing hash table holding ClientInfo's iShip and
+iShipOld of every client.
+**************************************************************************************************************/
+
+#define SHIP_TABLE_BITS 10 // at least twice as many slots as ships (two per client)
+#define SHIP_TABLE_SIZE (1 << SHIP_TABLE_BITS)
+
+namespace PlayerIndex
+{
+	struct PLAYER_INDEX_ENTRY
+	{
+		uint iSystemID;
+		uint iBaseID;
+		uint iShip;
+		CAccount *acc;
+		wstring wscCharnameLower;
+		PLAYER_SNAPSHOT snapshot;
+	};
+
+	static PLAYER_INDEX_ENTRY arrPlayers[MAX_CLIENT_ID + 1];
+	static uint iGeneration = 0;
+	static map<uint, wstring> mapBaseNicknames;
+	static map<uint, wstring> mapSystemNicknames;
+
+	struct SHIP_SLOT
+	{
+		uint iShip;
+		uint iClientID;
+	};
+
+	static SHIP_SLOT arrShipTable[SHIP_TABLE_SIZE];
+	static uint arrClientShips[MAX_CLIENT_ID + 1][2];
+	static CLIENT_SET setOnline;
+	static CLIENT_SET setNoPvP;
+	static CLIENT_SET setEmpty;
+	static map<uint, CLIENT_SET> mapSystems;
+	static map<wstring, uint> mapCharnames;
+	static map<CAccount*, uint> mapAccounts;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static bool IsNoPvPSystem(uint iSystemID)
+	{
+		if (!iSystemID)
+			return false;
+
+		foreach(set_lstNoPVPSystems, uint, it)
+		{
+			if (*it == iSystemID)
+				return true;
+		}
+		return false;
+	}
+
+	static void SetSystem(uint iClientID, uint iSystemID)
+	{
+		PLAYER_INDEX_ENTRY &player = arrPlayers[iClientID];
+		if (player.iSystemID == iSystemID)
+			return;
+
+		if (player.iSystemID)
+			ClientSetRemove(mapSystems[player.iSystemID], iClientID);
+		if (iSystemID)
+			ClientSetAdd(mapSystems[iSystemID], iClientID);
+		player.iSystemID = iSystemID;
+
+		if (IsNoPvPSystem(iSystemID))
+			ClientSetAdd(setNoPvP, iClientID);
+		else
+			ClientSetRemove(setNoPvP, iClientID);
+	}
+
+	static void SetCharname(uint iClientID, const wstring &wscCharnameLower)
+	{
+		PLAYER_INDEX_ENTRY &player = arrPlayers[iClientID];
+		if (player.wscCharnameLower == wscCharnameLower)
+			return;
+
+		map<wstring, uint>::iterator it = mapCharnames.find(player.wscCharnameLower);
+		if ((it != mapCharnames.end()) && (it->second == iClientID))
+			mapCharnames.erase(it);
+		if (wscCharnameLower.length())
+			mapCharnames[wscCharnameLower] = iClientID;
+		player.wscCharnameLower = wscCharnameLower;
+	}
+
+	static void SetAccount(uint iClientID, CAccount *acc)
+	{
+		PLAYER_INDEX_ENTRY &player = arrPlayers[iClientID];
+		if (player.acc == acc)
+			return;
+
+		map<CAccount*, uint>::iterator it = mapAccounts.find(player.acc);
+		if ((it != mapAccounts.end()) && (it->second == iClientID))
+			mapAccounts.erase(it);
+		if (acc)
+			mapAccounts[acc] = iClientID;
+		player.acc = acc;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static const wstring& GetBaseNickname(uint iBaseID)
+	{
+		map<uint, wstring>::iterator it = mapBaseNicknames.find(iBaseID);
+		if (it != mapBaseNicknames.end())
+			return it->second;
+
+		char szBasename[1024] = "";
+		pub::GetBaseNickname(szBasename, sizeof(szBasename), iBaseID);
+		return mapBaseNicknames[iBaseID] = stows(szBasename);
+	}
+
+	static const wstring& GetSystemNickname(uint iSystemID)
+	{
+		map<uint, wstring>::iterator it = mapSystemNicknames.find(iSystemID);
+		if (it != mapSystemNicknames.end())
+			return it->second;
+
+		char szSystemname[1024] = "";
+		pub::GetSystemNickname(szSystemname, sizeof(szSystemname), iSystemID);
+		return mapSystemNicknames[iSystemID] = stows(szSystemname);
+	}
+
+	static void UpdateSnapshot(uint iClientID, const wchar_t *wszCharname)
+	{
+		PLAYER_INDEX_ENTRY &player = arrPlayers[iClientID];
+		PLAYER_SNAPSHOT &snapshot = player.snapshot;
+
+		bool bChanged = false;
+		if (snapshot.iClientID != iClientID)
+		{
+			snapshot.iClientID = iClientID;
+			HkGetPlayerIP(iClientID, snapshot.wscIP);
+			bChanged = true;
+		}
+
+		if (snapshot.wscCharname.compare(wszCharname ? wszCharname : L""))
+		{
+			snapshot.wscCharname = wszCharname ? wszCharname : L"";
+			bChanged = true;
+		}
+
+		if (snapshot.iBase != player.iBaseID)
+		{
+			snapshot.iBase = player.iBaseID;
+			snapshot.wscBase = player.iBaseID ? GetBaseNickname(player.iBaseID) : L"";
+			bChanged = true;
+		}
+
+		if (snapshot.iSystem != player.iSystemID)
+		{
+			snapshot.iSystem = player.iSystemID;
+			snapshot.wscSystem = player.iSystemID ? GetSystemNickname(player.iSystemID) : L"";
+			bChanged = true;
+		}
+
+		if (snapshot.iShip != player.iShip)
+		{
+			snapshot.iShip = player.iShip;
+			bChanged = true;
+		}
+
+		if (bChanged)
+			snapshot.iGeneration = ++iGeneration;
+	}
+
+	static void ClearSnapshot(uint iClientID)
+	{
+		PLAYER_SNAPSHOT &snapshot = arrPlayers[iClientID].snapshot;
+		if (!snapshot.iClientID)
+			return;
+
+		snapshot.iClientID = 0;
+		snapshot.wscCharname = snapshot.wscBase = snapshot.wscSystem = snapshot.wscIP = L"";
+		snapshot.iBase = snapshot.iSystem = snapshot.iShip = 0;
+		snapshot.iGeneration = ++iGeneration;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static uint ShipSlot(uint iShip)
+	{
+		return (iShip * 2654435761u) >> (32 - SHIP_TABLE_BITS);
+	}
+
+	static void ShipTableInsert(uint iShip, uint iClientID, bool bReplace)
+	{
+		if (!iShip)
+			return;
+
+		uint i = ShipSlot(iShip);
+		while (arrShipTable[i].iShip && arrShipTable[i].iShip != iShip)
+			i = (i + 1) & (SHIP_TABLE_SIZE - 1);
+
+		if (!arrShipTable[i].iShip || bReplace)
+		{
+			arrShipTable[i].iShip = iShip;
+			arrShipTable[i].iClientID = iClientID;
+		}
+	}
+
+	static void ShipTableRemove(uint iShip, uint iClientID)
+	{
+		uint i = ShipSlot(iShip);
+		while (arrShipTable[i].iShip != iShip)
+		{
+			if (!arrShipTable[i].iShip)
+				return;
+			i = (i + 1) & (SHIP_TABLE_SIZE - 1);
+		}
+
+		// the id may have been taken over by another client's ship
+		if (arrShipTable[i].iClientID != iClientID)
+			return;
+
+		// move the following entries back so no probe sequence is interrupted
+		uint j = i;
+		while (true)
+		{
+			j = (j + 1) & (SHIP_TABLE_SIZE - 1);
+			if (!arrShipTable[j].iShip)
+				break;
+
+			uint k = ShipSlot(arrShipTable[j].iShip);
+			if ((j > i) ? (k <= i || k > j) : (k <= i && k > j))
+			{
+				arrShipTable[i] = arrShipTable[j];
+				i = j;
+			}
+		}
+
+		arrShipTable[i].iShip = 0;
+		arrShipTable[i].iClientID = 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void Refresh(uint iClientID)
+	{
+		if (iClientID < 1 || iClientID > MAX_CLIENT_ID)
+			return;
+
+		try {
+			uint iSystemID = 0, iBaseID = 0, iShip = 0;
+			pub::Player::GetSystem(iClientID, iSystemID);
+			pub::Player::GetBase(iClientID, iBaseID);
+			pub::Player::GetShip(iClientID, iShip);
+
+			SetSystem(iClientID, iSystemID);
+			arrPlayers[iClientID].iBaseID = iBaseID;
+			arrPlayers[iClientID].iShip = iShip;
+
+			const wchar_t *wszCharname = (const wchar_t*)Players.GetActiveCharacterName(iClientID);
+			SetCharname(iClientID, wszCharname ? ToLower(wszCharname) : L"");
+			SetAccount(iClientID, Players.FindAccountFromClientID(iClientID));
+			ClientSetAdd(setOnline, iClientID);
+			UpdateSnapshot(iClientID, wszCharname);
+		}
+		catch (...) { LOG_EXCEPTION }
+	}
+
+	void ShipDestroyed(uint iClientID)
+	{
+		if (iClientID < 1 || iClientID > MAX_CLIENT_ID)
+			return;
+
+		arrPlayers[iClientID].iShip = 0;
+		if (arrPlayers[iClientID].snapshot.iShip)
+		{
+			arrPlayers[iClientID].snapshot.iShip = 0;
+			arrPlayers[iClientID].snapshot.iGeneration = ++iGeneration;
+		}
+	}
+
+	void Remove(uint iClientID)
+	{
+		if (iClientID < 1 || iClientID > MAX_CLIENT_ID)
+			return;
+
+		SetSystem(iClientID, 0);
+		SetCharname(iClientID, L"");
+		SetAccount(iClientID, 0);
+		arrPlayers[iClientID].iBaseID = 0;
+		arrPlayers[iClientID].iShip = 0;
+		ClientSetRemove(setOnline, iClientID);
+		ClearSnapshot(iClientID);
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// call after ClientInfo's iShip or iShipOld of the client has changed
+	void ShipsChanged(uint iClientID)
+	{
+		if (iClientID > MAX_CLIENT_ID)
+			return;
+
+		uint iShip = ClientInfo[iClientID].iShip;
+		uint iShipOld = ClientInfo[iClientID].iShipOld;
+		for (uint i = 0; i < 2; i++)
+		{
+			uint iIndexed = arrClientShips[iClientID][i];
+			if (iIndexed && iIndexed != iShip && iIndexed != iShipOld)
+				ShipTableRemove(iIndexed, iClientID);
+		}
+
+		// the ship someone is flying wins over the one someone else lost
+		ShipTableInsert(iShip, iClientID, true);
+		ShipTableInsert(iShipOld, iClientID, false);
+		arrClientShips[iClientID][0] = iShip;
+		arrClientShips[iClientID][1] = iShipOld;
+	}
+
+	uint FindShip(uint iShip)
+	{
+		if (!iShip)
+			return 0;
+
+		uint i = ShipSlot(iShip);
+		while (arrShipTable[i].iShip)
+		{
+			if (arrShipTable[i].iShip == iShip)
+				return arrShipTable[i].iClientID;
+			i = (i + 1) & (SHIP_TABLE_SIZE - 1);
+		}
+
+		return 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	uint GetSystem(uint iClientID)
+	{
+		return (iClientID <= MAX_CLIENT_ID) ? arrPlayers[iClientID].iSystemID : 0;
+	}
+
+	bool InNoPvPSystem(uint iClientID)
+	{
+		return (iClientID <= MAX_CLIENT_ID) && ClientSetContains(setNoPvP, iClientID);
+	}
+
+	// the [NoPVP] systems were reloaded
+	void NoPvPSystemsChanged()
+	{
+		setNoPvP = setEmpty;
+		for (uint iClientID = ClientSetNext(setOnline, 0); iClientID; iClientID = ClientSetNext(setOnline, iClientID))
+		{
+			if (IsNoPvPSystem(arrPlayers[iClientID].iSystemID))
+				ClientSetAdd(setNoPvP, iClientID);
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	uint GetBase(uint iClientID)
+	{
+		return (iClientID <= MAX_CLIENT_ID) ? arrPlayers[iClientID].iBaseID : 0;
+	}
+
+	uint GetShip(uint iClientID)
+	{
+		return (iClientID <= MAX_CLIENT_ID) ? arrPlayers[iClientID].iShip : 0;
+	}
+
+	CAccount* GetAccount(uint iClientID)
+	{
+		return (iClientID <= MAX_CLIENT_ID) ? arrPlayers[iClientID].acc : 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	uint FindCharname(const wstring &wscCharname)
+	{
+		map<wstring, uint>::iterator it = mapCharnames.find(ToLower(wscCharname));
+		if (it == mapCharnames.end())
+			return -1;
+
+		return it->second;
+	}
+
+	uint FindAccount(CAccount *acc)
+	{
+		map<CAccount*, uint>::iterator it = mapAccounts.find(acc);
+		if (!acc || (it == mapAccounts.end()))
+			return -1;
+
+		return it->second;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// the snapshot of a player who is online (also in the character select menu), 0 otherwise
+	const PLAYER_SNAPSHOT* GetPlayer(uint iClientID)
+	{
+		if (iClientID < 1 || iClientID > MAX_CLIENT_ID || !ClientSetContains(setOnline, iClientID))
+			return 0;
+
+		return &arrPlayers[iClientID].snapshot;
+	}
+
+	// changes whenever any snapshot changes
+	uint GetGeneration()
+	{
+		return iGeneration;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	const CLIENT_SET& GetOnlineClients()
+	{
+		return setOnline;
+	}
+
+	const CLIENT_SET& GetSystemClients(uint iSystemID)
+	{
+		map<uint, CLIENT_SET>::iterator it = mapSystems.find(iSystemID);
+		if (it == mapSystems.end())
+			return setEmpty;
+
+		return it->second;
+	}
+}
@@ -6,6 +6,7 @@ bool g_bPlugin_nofunctioncall;
 void* vPluginRet;
 
 list<PLUGIN_HOOKDATA>* pPluginHooks;
+PLUGIN_DISPATCH_TABLE* pPluginDispatch;
 list<PLUGIN_DATA> lstPlugins;
 
 enum PLUGIN_MESSAGE;
@@ -22,6 +23,289 @@ __declspec(dllexport) void Plugin_Communication(PLUGIN_MESSAGE msg, void* data)
 
 namespace PluginManager
 {
+	// dispatch tables replaced while a CALL_PLUGINS loop may still be walking them
+	static list<PLUGIN_DISPATCH_ENTRY*> lstRetiredDispatch;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// names of the PLUGIN_CALLBACKS for the performance timers, same order as the enum
+	static const char *szCallbackNames[] =
+	{
+		"HkIServerImpl_Update",
+		"HkIServerImpl_SubmitChat",
+		"HkIServerImpl_SubmitChat_AFTER",
+		"HkIServerImpl_PlayerLaunch",
+		"HkIServerImpl_PlayerLaunch_AFTER",
+		"HkIServerImpl_FireWeapon",
+		"HkIServerImpl_FireWeapon_AFTER",
+		"HkIServerImpl_SPMunitionCollision",
+		"HkIServerImpl_SPMunitionCollision_AFTER",
+		"HkIServerImpl_SPObjUpdate",
+		"HkIServerImpl_SPObjUpdate_AFTER",
+		"HkIServerImpl_SPObjCollision",
+		"HkIServerImpl_SPObjCollision_AFTER",
+		"HkIServerImpl_LaunchComplete",
+		"HkIServerImpl_LaunchComplete_AFTER",
+		"HkIServerImpl_CharacterSelect",
+		"HkIServerImpl_CharacterSelect_AFTER",
+		"HkIServerImpl_BaseEnter",
+		"HkIServerImpl_BaseEnter_AFTER",
+		"HkIServerImpl_BaseExit",
+		"HkIServerImpl_BaseExit_AFTER",
+		"HkIServerImpl_OnConnect",
+		"HkIServerImpl_OnConnect_AFTER",
+		"HkIServerImpl_DisConnect",
+		"HkIServerImpl_DisConnect_AFTER",
+		"HkIServerImpl_TerminateTrade",
+		"HkIServerImpl_TerminateTrade_AFTER",
+		"HkIServerImpl_InitiateTrade",
+		"HkIServerImpl_InitiateTrade_AFTER",
+		"HkIServerImpl_ActivateEquip",
+		"HkIServerImpl_ActivateEquip_AFTER",
+		"HkIServerImpl_ActivateCruise",
+		"HkIServerImpl_ActivateCruise_AFTER",
+		"HkIServerImpl_ActivateThrusters",
+		"HkIServerImpl_ActivateThrusters_AFTER",
+		"HkIServerImpl_GFGoodSell",
+		"HkIServerImpl_GFGoodSell_AFTER",
+		"HkIServerImpl_CharacterInfoReq",
+		"HkIServerImpl_CharacterInfoReq_AFTER",
+		"HkIServerImpl_JumpInComplete",
+		"HkIServerImpl_JumpInComplete_AFTER",
+		"HkIServerImpl_SystemSwitchOutComplete",
+		"HkIServerImpl_SystemSwitchOutComplete_AFTER",
+		"HkIServerImpl_Login",
+		"HkIServerImpl_Login_BEFORE",
+		"HkIServerImpl_Login_AFTER",
+		"HkIServerImpl_MineAsteroid",
+		"HkIServerImpl_MineAsteroid_AFTER",
+		"HkIServerImpl_GoTradelane",
+		"HkIServerImpl_GoTradelane_AFTER",
+		"HkIServerImpl_StopTradelane",
+		"HkIServerImpl_StopTradelane_AFTER",
+		"HkIServerImpl_AbortMission",
+		"HkIServerImpl_AbortMission_AFTER",
+		"HkIServerImpl_AcceptTrade",
+		"HkIServerImpl_AcceptTrade_AFTER",
+		"HkIServerImpl_AddTradeEquip",
+		"HkIServerImpl_AddTradeEquip_AFTER",
+		"HkIServerImpl_BaseInfoRequest",
+		"HkIServerImpl_BaseInfoRequest_AFTER",
+		"HkIServerImpl_CreateNewCharacter",
+		"HkIServerImpl_CreateNewCharacter_AFTER",
+		"HkIServerImpl_DelTradeEquip",
+		"HkIServerImpl_DelTradeEquip_AFTER",
+		"HkIServerImpl_DestroyCharacter",
+		"HkIServerImpl_DestroyCharacter_AFTER",
+		"HkIServerImpl_GFGoodBuy",
+		"HkIServerImpl_GFGoodBuy_AFTER",
+		"HkIServerImpl_GFGoodVaporized",
+		"HkIServerImpl_GFGoodVaporized_AFTER",
+		"HkIServerImpl_GFObjSelect",
+		"HkIServerImpl_GFObjSelect_AFTER",
+		"HkIServerImpl_Hail",
+		"HkIServerImpl_Hail_AFTER",
+		"HkIServerImpl_InterfaceItemUsed",
+		"HkIServerImpl_InterfaceItemUsed_AFTER",
+		"HkIServerImpl_JettisonCargo",
+		"HkIServerImpl_JettisonCargo_AFTER",
+		"HkIServerImpl_LocationEnter",
+		"HkIServerImpl_LocationEnter_AFTER",
+		"HkIServerImpl_LocationExit",
+		"HkIServerImpl_LocationExit_AFTER",
+		"HkIServerImpl_LocationInfoRequest",
+		"HkIServerImpl_LocationInfoRequest_AFTER",
+		"HkIServerImpl_MissionResponse",
+		"HkIServerImpl_MissionResponse_AFTER",
+		"HkIServerImpl_ReqAddItem",
+		"HkIServerImpl_ReqAddItem_AFTER",
+		"HkIServerImpl_ReqChangeCash",
+		"HkIServerImpl_ReqChangeCash_AFTER",
+		"HkIServerImpl_ReqCollisionGroups",
+		"HkIServerImpl_ReqCollisionGroups_AFTER",
+		"HkIServerImpl_ReqEquipment",
+		"HkIServerImpl_ReqEquipment_AFTER",
+		"HkIServerImpl_ReqHullStatus",
+		"HkIServerImpl_ReqHullStatus_AFTER",
+		"HkIServerImpl_ReqModifyItem",
+		"HkIServerImpl_ReqModifyItem_AFTER",
+		"HkIServerImpl_ReqRemoveItem",
+		"HkIServerImpl_ReqRemoveItem_AFTER",
+		"HkIServerImpl_ReqSetCash",
+		"HkIServerImpl_ReqSetCash_AFTER",
+		"HkIServerImpl_ReqShipArch",
+		"HkIServerImpl_ReqShipArch_AFTER",
+		"HkIServerImpl_RequestBestPath",
+		"HkIServerImpl_RequestBestPath_AFTER",
+		"HkIServerImpl_RequestCancel",
+		"HkIServerImpl_RequestCancel_AFTER",
+		"HkIServerImpl_RequestCreateShip",
+		"HkIServerImpl_RequestCreateShip_AFTER",
+		"HkIServerImpl_RequestEvent",
+		"HkIServerImpl_RequestEvent_AFTER",
+		"HkIServerImpl_RequestGroupPositions",
+		"HkIServerImpl_RequestGroupPositions_AFTER",
+		"HkIServerImpl_RequestPlayerStats",
+		"HkIServerImpl_RequestPlayerStats_AFTER",
+		"HkIServerImpl_RequestRankLevel",
+		"HkIServerImpl_RequestRankLevel_AFTER",
+		"HkIServerImpl_RequestTrade",
+		"HkIServerImpl_RequestTrade_AFTER",
+		"HkIServerImpl_SPRequestInvincibility",
+		"HkIServerImpl_SPRequestInvincibility_AFTER",
+		"HkIServerImpl_SPRequestUseItem",
+		"HkIServerImpl_SPRequestUseItem_AFTER",
+		"HkIServerImpl_SPScanCargo",
+		"HkIServerImpl_SPScanCargo_AFTER",
+		"HkIServerImpl_SetInterfaceState",
+		"HkIServerImpl_SetInterfaceState_AFTER",
+		"HkIServerImpl_SetManeuver",
+		"HkIServerImpl_SetManeuver_AFTER",
+		"HkIServerImpl_SetTarget",
+		"HkIServerImpl_SetTarget_AFTER",
+		"HkIServerImpl_SetTradeMoney",
+		"HkIServerImpl_SetTradeMoney_AFTER",
+		"HkIServerImpl_SetVisitedState",
+		"HkIServerImpl_SetVisitedState_AFTER",
+		"HkIServerImpl_SetWeaponGroup",
+		"HkIServerImpl_SetWeaponGroup_AFTER",
+		"HkIServerImpl_Shutdown",
+		"HkIServerImpl_Startup",
+		"HkIServerImpl_Startup_AFTER",
+		"HkIServerImpl_StopTradeRequest",
+		"HkIServerImpl_StopTradeRequest_AFTER",
+		"HkIServerImpl_TractorObjects",
+		"HkIServerImpl_TractorObjects_AFTER",
+		"HkIServerImpl_TradeResponse",
+		"HkIServerImpl_TradeResponse_AFTER",
+		"ClearClientInfo",
+		"LoadUserCharSettings",
+		"HkCb_SendChat",
+		"HkCB_MissileTorpHit",
+		"HkCb_AddDmgEntry",
+		"HkCb_AddDmgEntry_AFTER",
+		"HkCb_GeneralDmg",
+		"AllowPlayerDamage",
+		"SendDeathMsg",
+		"ShipDestroyed",
+		"BaseDestroyed",
+		"HkIClientImpl_Send_FLPACKET_SERVER_CREATESHIP",
+		"HkIClientImpl_Send_FLPACKET_SERVER_CREATESHIP_AFTER",
+		"HkIClientImpl_Send_FLPACKET_SERVER_CREATELOOT",
+		"HkIClientImpl_Send_FLPACKET_SERVER_CREATELOOT_AFTER",
+		"HkIClientImpl_Send_FLPACKET_SERVER_CREATESOLAR",
+		"HkIClientImpl_Send_FLPACKET_SERVER_LAUNCH",
+		"HkIClientImpl_Send_FLPACKET_COMMON_UPDATEOBJECT",
+		"HkIClientImpl_Send_FLPACKET_SERVER_ACTIVATEOBJECT",
+		"HkIClientImpl_Send_FLPACKET_SERVER_DESTROYOBJECT",
+		"HkIClientImpl_Send_FLPACKET_COMMON_FIREWEAPON",
+		"HkIClientImpl_Send_FLPACKET_COMMON_ACTIVATEEQUIP",
+		"HkIClientImpl_Send_FLPACKET_COMMON_ACTIVATECRUISE",
+		"HkIClientImpl_Send_FLPACKET_COMMON_ACTIVATETHRUSTERS",
+		"HkIClientImpl_Send_FLPACKET_SERVER_MISCOBJUPDATE_3",
+		"HkIClientImpl_Send_FLPACKET_SERVER_MISCOBJUPDATE_3_AFTER",
+		"HkIClientImpl_Send_FLPACKET_SERVER_MISCOBJUPDATE_5",
+		"HkIClientImpl_Send_FLPACKET_SERVER_REQUESTCREATESHIPRESP",
+		"HkIEngine_CShip_init",
+		"HkIEngine_CShip_destroy",
+		"HkCb_Update_Time",
+		"HkCb_Update_Time_AFTER",
+		"HkCb_Dock_Call",
+		"HkCb_Dock_Call_AFTER",
+		"HkCb_Elapse_Time",
+		"HkCb_Elapse_Time_AFTER",
+		"LaunchPosHook",
+		"HkTimerCheckKick",
+		"HkTimerNPCAndF1Check",
+		"UserCmd_Help",
+		"UserCmd_Process",
+		"CmdHelp_Callback",
+		"ExecuteCommandString_Callback",
+		"ProcessEvent_BEFORE",
+		"LoadSettings",
+		"Plugin_Communication",
+		"Plugin_Unload",
+	};
+
+	static_assert(sizeof(szCallbackNames) / sizeof(szCallbackNames[0]) == PLUGIN_CALLBACKS_AMOUNT, "szCallbackNames doesn't match PLUGIN_CALLBACKS");
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void RebuildDispatchTable(int iCallback)
+	{
+		PLUGIN_DISPATCH_ENTRY *pEntries = 0;
+		uint iCount = 0;
+
+		if (pPluginHooks[iCallback].size())
+		{
+			pEntries = new PLUGIN_DISPATCH_ENTRY[pPluginHooks[iCallback].size()];
+			foreach(pPluginHooks[iCallback], PLUGIN_HOOKDATA, it)
+			{
+				if (it->bPaused || !it->pFunc)
+					continue;
+
+				pEntries[iCount].pFunc = it->pFunc;
+				pEntries[iCount].ePluginReturnCode = it->ePluginReturnCode;
+				pEntries[iCount].szName = it->sName.c_str();
+				pEntries[iCount].iTimerID = it->iTimerID;
+				iCount++;
+			}
+		}
+
+		if (pPluginDispatch[iCallback].pEntries)
+			lstRetiredDispatch.push_back(pPluginDispatch[iCallback].pEntries);
+
+		pPluginDispatch[iCallback].pEntries = pEntries;
+		pPluginDispatch[iCallback].iCount = iCount;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void RebuildDispatchTables()
+	{
+		for (int i = 0; i < (int)PLUGIN_CALLBACKS_AMOUNT; i++)
+			RebuildDispatchTable(i);
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// called from the main loop where no plugin dispatch is in progress
+	void FreeRetiredDispatchTables()
+	{
+		if (lstRetiredDispatch.empty())
+			return;
+
+		foreach(lstRetiredDispatch, PLUGIN_DISPATCH_ENTRY*, it)
+			delete[] *it;
+		lstRetiredDispatch.clear();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// only the plugin that is going to be freed gets its Plugin_Unload hook called
+	static void CallUnloadHook(HMODULE hDLL)
+	{
+		foreach(pPluginHooks[(int)PLUGIN_Plugin_Unload], PLUGIN_HOOKDATA, it)
+		{
+			if (it->hDLL != hDLL || !it->pFunc)
+				continue;
+
+			try {
+				((void(*)())it->pFunc)();
+			} catch (...) { AddLog("ERROR: Exception in plugin '%s' in %s", it->sName.c_str(), __FUNCTION__); LOG_EXCEPTION }
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// undoes a load that failed before the hooks were added, Get_PluginInfo may already have registered commands and timers
+	static void DiscardPlugin(HMODULE hDLL)
+	{
+		TimerWheel::CancelModule(hDLL);
+		AdminCommands::RemoveModule(hDLL);
+		UserCmdRouter::RemoveModule(hDLL);
+		FreeLibrary(hDLL);
+	}
 
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +314,8 @@ namespace PluginManager
 	{
 		// create array of callback-function plugin-data lists
 		pPluginHooks = new list<PLUGIN_HOOKDATA>[(int)PLUGIN_CALLBACKS_AMOUNT];
+		pPluginDispatch = new PLUGIN_DISPATCH_TABLE[(int)PLUGIN_CALLBACKS_AMOUNT];
+		memset(pPluginDispatch, 0, sizeof(PLUGIN_DISPATCH_TABLE) * (int)PLUGIN_CALLBACKS_AMOUNT);
 
 		lstPlugins.clear();
 	}
@@ -38,6 +324,11 @@ namespace PluginManager
 
 	void Destroy()
 	{
+		for (int i = 0; i < (int)PLUGIN_CALLBACKS_AMOUNT; i++)
+			delete[] pPluginDispatch[i].pEntries;
+		delete[] pPluginDispatch;
+		FreeRetiredDispatchTables();
+
 		delete[] pPluginHooks;
 
 		lstPlugins.clear();
@@ -54,12 +345,20 @@ namespace PluginManager
 					return HKE_PLUGIN_UNPAUSABLE;
 
 				it->bPaused = bPause;
+				AdminCommands::PauseModule(it->hDLL, bPause);
+				UserCmdRouter::PauseModule(it->hDLL, bPause);
+				TimerWheel::PauseModule(it->hDLL, bPause);
 
 				for (int i = 0; i < (int)PLUGIN_CALLBACKS_AMOUNT; i++) {
+					bool bChanged = false;
 					foreach(pPluginHooks[i], PLUGIN_HOOKDATA, it2) {
-						if (it2->hDLL == it->hDLL)
+						if (it2->hDLL == it->hDLL) {
 							it2->bPaused = bPause;
+							bChanged = true;
+						}
 					}
+					if (bChanged)
+						RebuildDispatchTable(i);
 				}
 				return HKE_OK;
 			}
@@ -78,12 +377,17 @@ namespace PluginManager
 				if (it->bMayUnload == false)
 					return HKE_PLUGIN_UNLOADABLE;
 
+				CallUnloadHook(it->hDLL);
+				TimerWheel::CancelModule(it->hDLL);
+				AdminCommands::RemoveModule(it->hDLL);
+				UserCmdRouter::RemoveModule(it->hDLL);
 				FreeLibrary(it->hDLL);
 
 				for (int i = 0; i < (int)PLUGIN_CALLBACKS_AMOUNT; i++) {
 					foreach(pPluginHooks[i], PLUGIN_HOOKDATA, it2) {
 						if (it2->hDLL == it->hDLL) {
 							pPluginHooks[i].erase(it2);
+							RebuildDispatchTable(i);
 							break;
 						}
 					}
@@ -102,13 +406,25 @@ namespace PluginManager
 	void UnloadPlugins()
 	{
 
+		foreach(lstPlugins, PLUGIN_DATA, it)
+		{
+			if (it->bMayUnload)
+				CallUnloadHook(it->hDLL);
+		}
+
 		for (int i = 0; i < (int)PLUGIN_CALLBACKS_AMOUNT; i++)
 			pPluginHooks[i].clear();
+		RebuildDispatchTables();
 
 		foreach(lstPlugins, PLUGIN_DATA, it)
 		{
 			if (it->bMayUnload)
+			{
+				TimerWheel::CancelModule(it->hDLL);
+				AdminCommands::RemoveModule(it->hDLL);
+				UserCmdRouter::RemoveModule(it->hDLL);
 				FreeLibrary(it->hDLL);
+			}
 		}
 
 		lstPlugins.clear();
@@ -151,6 +467,16 @@ namespace PluginManager
 		if (!plugin.hDLL)
 			return adminInterface->Print(L"Error, can't load plugin (%s)\n", stows(sDLLName).c_str());
 
+		// the same dll under another name, LoadLibrary only added a reference to the loaded one
+		foreach(lstPlugins, PLUGIN_DATA, it)
+		{
+			if (it->hDLL == plugin.hDLL)
+			{
+				FreeLibrary(plugin.hDLL);
+				return adminInterface->Print(L"Plugin already loaded, skipping: (%s)\n", stows(it->sDLL).c_str());
+			}
+		}
+
 		plugin.bPaused = false;
 
 		FARPROC pPluginInfo = GetProcAddress(plugin.hDLL, "?Get_PluginInfo@@YAPAUPLUGIN_INFO@@XZ");
@@ -158,7 +484,7 @@ namespace PluginManager
 		if (!pPluginInfo)
 		{
 			adminInterface->Print(L"Error, could not read plugin info (Get_PluginInfo not exported?): %s\n", stows(sDLLName).c_str());
-			FreeLibrary(plugin.hDLL);
+			DiscardPlugin(plugin.hDLL);
 			return;
 		}
 
@@ -167,7 +493,7 @@ namespace PluginManager
 		if (!p_PI || !p_PI->sShortName.length() || !p_PI->sName.length())
 		{
 			adminInterface->Print(L"Error, invalid plugin info: %s\n", stows(sDLLName).c_str());
-			FreeLibrary(plugin.hDLL);
+			DiscardPlugin(plugin.hDLL);
 			return;
 		}
 
@@ -180,9 +506,15 @@ namespace PluginManager
 		// plugins that may not unload are interpreted as crucial plugins that can also not be loaded after FLServer startup
 		if (!plugin.bMayUnload && !bStartup) {
 			adminInterface->Print(L"Error, could not load plugin (unloadable, need server restart to load): %s\n", stows(plugin.sDLL).c_str());
+			DiscardPlugin(plugin.hDLL);
 			throw "";
 		}
 
+		if (!p_PI->ePluginReturnCode && p_PI->lstHooks.size())
+		{
+			DiscardPlugin(plugin.hDLL);
+			throw "plugin return code pointer not defined";
+		}
 
 		FARPROC pPluginReturnCode = GetProcAddress(plugin.hDLL, "?Get_PluginReturnCode@@YA?AW4PLUGIN_RETURNCODE@@XZ");
 
@@ -190,17 +522,19 @@ namespace PluginManager
 		{
 			PLUGIN_HOOKDATA hook;
 			hook.sName = plugin.sShortName;
-			hook.sPluginFunction = hook.sName + "-" + itos((int)it->eCallbackID);
+			hook.sPluginFunction = hook.sName + "-" + szCallbackNames[(int)it->eCallbackID];
 			hook.bPaused = false;
 			hook.hDLL = plugin.hDLL;
 			hook.iPriority = it->iPriority;
 			hook.pFunc = it->pFunc;
 			hook.ePluginReturnCode = p_PI->ePluginReturnCode;
-			if (!p_PI->ePluginReturnCode)
-				throw "plugin return code pointer not defined";
+			hook.iTimerID = PerfTimers::Intern(hook.sPluginFunction);
+			if (!hook.pFunc)
+				AddLog("ERROR: Plugin '%s' does not export callback %d", hook.sName.c_str(), (int)it->eCallbackID);
 
 			pPluginHooks[(int)it->eCallbackID].push_back(hook);
 			pPluginHooks[(int)it->eCallbackID].sort(PLUGIN_SORTCRIT());
+			RebuildDispatchTable((int)it->eCallbackID);
 		}
 
 		adminInterface->Print(L"Plugin loaded: %s (%s)\n", stows(plugin.sShortName).c_str(), stows(sDLLName).c_str());
@@ -0,0 +1,426 @@
+#include "hook.h"
+#include <vector>
+
+/**************************************************************************************************************
+hierarchical timer wheel shared by flhook and the plugins. four levels of 64 slots with a 1ms tick cover
+~4.6 hours, timers further in the future park in the last level and are re-queued when it cascades.
+scheduling and cancelling are O(1), every tick only touches the slot that expires.
+timers live in a pool and are linked into their wheel slot and (optionally) their client's list by index,
+a timer id is the pool index plus a generation counter so stale ids never hit a reused entry.
+the timers of a paused plugin stay scheduled but don't run, one-shots among them run once it is resumed.
+everything runs on the server thread, from HkIServerImpl::Update.
+**************************************************************************************************************/
+
+namespace TimerWheel
+{
+#define WHEEL_LEVELS 4
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_SPAN ((mstime)1 << (WHEEL_LEVELS * WHEEL_BITS))
+
+#define TIMER_INDEX_BITS 20
+#define TIMER_INDEX_MASK ((1 << TIMER_INDEX_BITS) - 1)
+#define TIMER_NONE 0xFFFFFFFF
+
+	enum TIMER_STATE
+	{
+		TIMER_FREE,
+		TIMER_QUEUED,
+		TIMER_RUNNING,
+		TIMER_CANCELLED,
+	};
+
+	struct TIMER_ENTRY
+	{
+		TIMER_STATE eState;
+		uint iGeneration;
+		mstime tmExpires;
+		uint iIntervalMS;
+		TIMER_CALLBACK callback;
+		void *pData;
+		uint iClientID;
+		HMODULE hModule;
+		bool bPaused;
+
+		// links of the list the timer is queued in (wheel slot, the run list or the paused list)
+		uint *piListHead;
+		uint iPrev;
+		uint iNext;
+
+		// links of the client's timer list
+		uint iClientPrev;
+		uint iClientNext;
+	};
+
+	static vector<TIMER_ENTRY> vTimers;
+	static uint iFreeHead = TIMER_NONE;
+	static uint arrSlots[WHEEL_LEVELS][WHEEL_SIZE];
+	static uint arrClientTimers[MAX_CLIENT_ID + 1];
+	static uint iRunHead = TIMER_NONE;
+	static uint iPausedHead = TIMER_NONE; // expired one-shots of paused plugins
+	static mstime tmCurrentTick = 0;
+	static mstime tmProcessNow = 0;
+	static uint iQueued = 0;
+	static bool bInitialized = false;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void Init()
+	{
+		for (uint i = 0; i < WHEEL_LEVELS; i++)
+		{
+			for (uint j = 0; j < WHEEL_SIZE; j++)
+				arrSlots[i][j] = TIMER_NONE;
+		}
+
+		for (uint i = 0; i <= MAX_CLIENT_ID; i++)
+			arrClientTimers[i] = TIMER_NONE;
+
+		tmCurrentTick = timeInMS();
+		bInitialized = true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static uint MakeID(uint iIndex)
+	{
+		return (vTimers[iIndex].iGeneration << TIMER_INDEX_BITS) | (iIndex + 1);
+	}
+
+	static uint FindTimer(uint iTimerID)
+	{
+		uint iIndex = (iTimerID & TIMER_INDEX_MASK) - 1;
+		if (!iTimerID || iIndex >= vTimers.size())
+			return TIMER_NONE;
+
+		const TIMER_ENTRY &timer = vTimers[iIndex];
+		if (timer.eState == TIMER_FREE || MakeID(iIndex) != iTimerID)
+			return TIMER_NONE;
+
+		return iIndex;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void LinkList(uint *piHead, uint iIndex)
+	{
+		TIMER_ENTRY &timer = vTimers[iIndex];
+		timer.piListHead = piHead;
+		timer.iPrev = TIMER_NONE;
+		timer.iNext = *piHead;
+		if (*piHead != TIMER_NONE)
+			vTimers[*piHead].iPrev = iIndex;
+		*piHead = iIndex;
+	}
+
+	static void UnlinkList(uint iIndex)
+	{
+		TIMER_ENTRY &timer = vTimers[iIndex];
+		if (!timer.piListHead)
+			return;
+
+		if (timer.iPrev != TIMER_NONE)
+			vTimers[timer.iPrev].iNext = timer.iNext;
+		else
+			*timer.piListHead = timer.iNext;
+		if (timer.iNext != TIMER_NONE)
+			vTimers[timer.iNext].iPrev = timer.iPrev;
+
+		timer.piListHead = 0;
+	}
+
+	static void LinkClient(uint iIndex)
+	{
+		TIMER_ENTRY &timer = vTimers[iIndex];
+		uint &iHead = arrClientTimers[timer.iClientID];
+		timer.iClientPrev = TIMER_NONE;
+		timer.iClientNext = iHead;
+		if (iHead != TIMER_NONE)
+			vTimers[iHead].iClientPrev = iIndex;
+		iHead = iIndex;
+	}
+
+	static void UnlinkClient(uint iIndex)
+	{
+		TIMER_ENTRY &timer = vTimers[iIndex];
+		if (!timer.iClientID)
+			return;
+
+		if (timer.iClientPrev != TIMER_NONE)
+			vTimers[timer.iClientPrev].iClientNext = timer.iClientNext;
+		else
+			arrClientTimers[timer.iClientID] = timer.iClientNext;
+		if (timer.iClientNext != TIMER_NONE)
+			vTimers[timer.iClientNext].iClientPrev = timer.iClientPrev;
+
+		timer.iClientID = 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// puts the timer into the slot its expiry falls into, relative to the current tick
+	static void Queue(uint iIndex)
+	{
+		TIMER_ENTRY &timer = vTimers[iIndex];
+		mstime tmExpires = timer.tmExpires;
+		if (tmExpires < tmCurrentTick)
+			tmExpires = tmCurrentTick;
+		else if ((tmExpires - tmCurrentTick) >= WHEEL_SPAN)
+			tmExpires = tmCurrentTick + WHEEL_SPAN - 1;
+
+		mstime tmDelta = tmExpires - tmCurrentTick;
+		uint iLevel = 0;
+		while (iLevel < (WHEEL_LEVELS - 1) && tmDelta >= ((mstime)1 << ((iLevel + 1) * WHEEL_BITS)))
+			iLevel++;
+
+		uint iSlot = (uint)(tmExpires >> (iLevel * WHEEL_BITS)) & WHEEL_MASK;
+		timer.eState = TIMER_QUEUED;
+		LinkList(&arrSlots[iLevel][iSlot], iIndex);
+	}
+
+	static void Free(uint iIndex)
+	{
+		UnlinkList(iIndex);
+		UnlinkClient(iIndex);
+
+		TIMER_ENTRY &timer = vTimers[iIndex];
+		timer.eState = TIMER_FREE;
+		timer.iGeneration = (timer.iGeneration + 1) & ((1 << (32 - TIMER_INDEX_BITS)) - 1);
+		timer.iNext = iFreeHead;
+		iFreeHead = iIndex;
+		iQueued--;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// re-queues every timer of a higher level slot, they end up one level further down
+	static void Cascade(uint iLevel, uint iSlot)
+	{
+		uint iIndex = arrSlots[iLevel][iSlot];
+		arrSlots[iLevel][iSlot] = TIMER_NONE;
+		while (iIndex != TIMER_NONE)
+		{
+			uint iNext = vTimers[iIndex].iNext;
+			vTimers[iIndex].piListHead = 0;
+			Queue(iIndex);
+			iIndex = iNext;
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void RunTimer(uint iIndex)
+	{
+		UnlinkList(iIndex);
+
+		TIMER_ENTRY &timer = vTimers[iIndex];
+		if (timer.bPaused && !timer.iIntervalMS)
+		{
+			LinkList(&iPausedHead, iIndex);
+			return;
+		}
+
+		// periodic timers of a paused plugin skip their run
+		if (!timer.bPaused)
+		{
+			timer.eState = TIMER_RUNNING;
+			uint iTimerID = MakeID(iIndex);
+			TIMER_CALLBACK callback = timer.callback;
+			void *pData = timer.pData;
+
+			try {
+				callback(iTimerID, pData);
+			}
+			catch (...) { AddLog("ERROR: Exception in timer callback %p", (void*)callback); LOG_EXCEPTION }
+		}
+
+		// the callback may have scheduled timers and grown the pool
+		TIMER_ENTRY &timerAfter = vTimers[iIndex];
+		if (timerAfter.eState == TIMER_CANCELLED || !timerAfter.iIntervalMS)
+		{
+			Free(iIndex);
+			return;
+		}
+
+		// periodic timers keep their phase, after a stall they skip the missed runs instead of
+		// running once for every interval while the wheel catches up
+		timerAfter.tmExpires += timerAfter.iIntervalMS;
+		if (timerAfter.tmExpires <= tmProcessNow)
+			timerAfter.tmExpires = tmProcessNow + timerAfter.iIntervalMS;
+		Queue(iIndex);
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void Process()
+	{
+		if (!bInitialized)
+			Init();
+
+		mstime tmNow = timeInMS();
+		tmProcessNow = tmNow;
+		while (tmCurrentTick <= tmNow)
+		{
+			// nothing queued, no need to walk the ticks one by one
+			if (!iQueued)
+			{
+				tmCurrentTick = tmNow + 1;
+				break;
+			}
+
+			uint iSlot = (uint)tmCurrentTick & WHEEL_MASK;
+			for (uint iLevel = 1; !iSlot && iLevel < WHEEL_LEVELS; iLevel++)
+			{
+				iSlot = (uint)(tmCurrentTick >> (iLevel * WHEEL_BITS)) & WHEEL_MASK;
+				Cascade(iLevel, iSlot);
+			}
+
+			// move the expired slot to the run list first so callbacks can freely queue and cancel
+			uint &iExpired = arrSlots[0][(uint)tmCurrentTick & WHEEL_MASK];
+			while (iExpired != TIMER_NONE)
+			{
+				uint iIndex = iExpired;
+				UnlinkList(iIndex);
+				LinkList(&iRunHead, iIndex);
+			}
+
+			tmCurrentTick++;
+			while (iRunHead != TIMER_NONE)
+				RunTimer(iRunHead);
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void CancelModule(HMODULE hModule)
+	{
+		for (uint i = 0; i < vTimers.size(); i++)
+		{
+			if (vTimers[i].eState != TIMER_FREE && vTimers[i].hModule == hModule)
+				HkCancelTimer(MakeID(i));
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void PauseModule(HMODULE hModule, bool bPause)
+	{
+		for (uint i = 0; i < vTimers.size(); i++)
+		{
+			if (vTimers[i].eState != TIMER_FREE && vTimers[i].hModule == hModule)
+				vTimers[i].bPaused = bPause;
+		}
+
+		if (bPause)
+			return;
+
+		// the one-shots that expired while the plugin was paused run with the next tick
+		uint iIndex = iPausedHead;
+		while (iIndex != TIMER_NONE)
+		{
+			uint iNext = vTimers[iIndex].iNext;
+			if (!vTimers[iIndex].bPaused)
+			{
+				UnlinkList(iIndex);
+				Queue(iIndex);
+			}
+			iIndex = iNext;
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	uint Schedule(uint iDelayMS, uint iIntervalMS, TIMER_CALLBACK callback, void *pData, uint iClientID)
+	{
+		if (!callback || iClientID > MAX_CLIENT_ID)
+			return 0;
+
+		if (!bInitialized)
+			Init();
+
+		uint iIndex;
+		if (iFreeHead != TIMER_NONE)
+		{
+			iIndex = iFreeHead;
+			iFreeHead = vTimers[iIndex].iNext;
+		}
+		else
+		{
+			if (vTimers.size() > TIMER_INDEX_MASK - 1)
+				return 0;
+
+			iIndex = (uint)vTimers.size();
+			TIMER_ENTRY timer;
+			timer.iGeneration = 0;
+			vTimers.push_back(timer);
+		}
+
+		TIMER_ENTRY &timer = vTimers[iIndex];
+		// from now, not from the next tick the wheel will process
+		timer.tmExpires = timeInMS() + iDelayMS;
+		timer.iIntervalMS = iIntervalMS;
+		timer.callback = callback;
+		timer.pData = pData;
+		timer.iClientID = iClientID;
+		timer.piListHead = 0;
+		timer.bPaused = false;
+
+		// remember which dll the callback lives in, its timers have to go when the plugin is unloaded
+		timer.hModule = 0;
+		GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)callback, &timer.hModule);
+
+		if (iClientID)
+			LinkClient(iIndex);
+
+		iQueued++;
+		Queue(iIndex);
+		return MakeID(iIndex);
+	}
+}
+
+/**************************************************************************************************************
+Schedule a timer callback. iDelayMS is the time until the first call, iIntervalMS the period after that
+(0 = one-shot). Timers bound to a client (iClientID != 0) are cancelled when it disconnects.
+Returns the timer id or 0 on failure.
+**************************************************************************************************************/
+
+uint HkScheduleTimer(uint iDelayMS, uint iIntervalMS, TIMER_CALLBACK callback, void *pData, uint iClientID)
+{
+	return TimerWheel::Schedule(iDelayMS, iIntervalMS, callback, pData, iClientID);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool HkCancelTimer(uint iTimerID)
+{
+	using namespace TimerWheel;
+
+	uint iIndex = FindTimer(iTimerID);
+	if (iIndex == TIMER_NONE || vTimers[iIndex].eState == TIMER_CANCELLED)
+		return false;
+
+	// a timer cancelled from its own callback is freed once the callback returns
+	if (vTimers[iIndex].eState == TIMER_RUNNING)
+	{
+		vTimers[iIndex].eState = TIMER_CANCELLED;
+		UnlinkClient(iIndex);
+	}
+	else
+		Free(iIndex);
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HkCancelClientTimers(uint iClientID)
+{
+	using namespace TimerWheel;
+
+	if (!iClientID || iClientID > MAX_CLIENT_ID || !bInitialized)
+		return;
+
+	while (arrClientTimers[iClientID] != TIMER_NONE)
+		HkCancelTimer(MakeID(arrClientTimers[iClientID]));
+}
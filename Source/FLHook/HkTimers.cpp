@@ -2,6 +2,10 @@
 #include "wildcards.hh"
 #include "hook.h"
 #include <math.h>
+#include <intrin.h>
+#include <vector>
+#include <map>
+#include <algorithm>
 
 CTimer::CTimer(string sFunc, uint iWarn)
 {
@@ -36,6 +40,438 @@ uint CTimer::stop()
 
 }
 
+/**************************************************************************************************************
+interned performance timers used by the plugin dispatch and server calls. every timer keeps a log-linear
+histogram of its call durations (in microseconds) so percentiles can be reported without storing samples.
+timers are only ever touched from the server thread, recording does not lock or allocate.
+**************************************************************************************************************/
+
+namespace PerfTimers
+{
+	// values below 16us get an exact bucket, above that every power of two is split into 8 sub-buckets
+	// (~12% resolution) up to 2^32us
+#define PERF_HISTOGRAM_LINEAR 16
+#define PERF_HISTOGRAM_SUBBUCKETS 8
+#define PERF_HISTOGRAM_BUCKETS (PERF_HISTOGRAM_LINEAR + (32 - 4) * PERF_HISTOGRAM_SUBBUCKETS)
+
+	struct PERF_TIMER
+	{
+		string sFunction;
+		uint iMax;
+
+		// histogram
+		mstime iCount;
+		mstime tmTotalUS;
+		uint iMaxUS;
+		uint arrBuckets[PERF_HISTOGRAM_BUCKETS];
+	};
+
+	bool bEnabled = false;
+
+	static vector<PERF_TIMER> vTimers;
+	static map<string, uint> mapTimerIDs;
+	static mstime iFreq = 0;
+	static mstime tmLastDump = 0;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static inline uint BucketIndex(uint iUS)
+	{
+		if (iUS < PERF_HISTOGRAM_LINEAR)
+			return iUS;
+
+		unsigned long iMsb;
+		_BitScanReverse(&iMsb, iUS);
+		return PERF_HISTOGRAM_LINEAR + (iMsb - 4) * PERF_HISTOGRAM_SUBBUCKETS + ((iUS >> (iMsb - 3)) & (PERF_HISTOGRAM_SUBBUCKETS - 1));
+	}
+
+	static mstime BucketUpperBound(uint iBucket)
+	{
+		if (iBucket < PERF_HISTOGRAM_LINEAR)
+			return iBucket;
+
+		uint iMsb = 4 + (iBucket - PERF_HISTOGRAM_LINEAR) / PERF_HISTOGRAM_SUBBUCKETS;
+		uint iSub = (iBucket - PERF_HISTOGRAM_LINEAR) % PERF_HISTOGRAM_SUBBUCKETS;
+		return (((mstime)(PERF_HISTOGRAM_SUBBUCKETS + iSub + 1)) << (iMsb - 3)) - 1;
+	}
+
+	static uint Percentile(const PERF_TIMER &timer, uint iPercent)
+	{
+		mstime iRank = (timer.iCount * iPercent + 99) / 100;
+		if (!iRank)
+			iRank = 1;
+
+		mstime iSeen = 0;
+		for (uint i = 0; i < PERF_HISTOGRAM_BUCKETS; i++)
+		{
+			iSeen += timer.arrBuckets[i];
+			if (iSeen >= iRank)
+			{
+				mstime iBound = BucketUpperBound(i);
+				return (iBound > timer.iMaxUS) ? timer.iMaxUS : (uint)iBound;
+			}
+		}
+
+		return timer.iMaxUS;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	uint Intern(const string &sFunction)
+	{
+		map<string, uint>::iterator it = mapTimerIDs.find(sFunction);
+		if (it != mapTimerIDs.end())
+			return it->second;
+
+		PERF_TIMER timer;
+		memset(timer.arrBuckets, 0, sizeof(timer.arrBuckets));
+		timer.sFunction = sFunction;
+		timer.iMax = 0;
+		timer.iCount = 0;
+		timer.tmTotalUS = 0;
+		timer.iMaxUS = 0;
+		vTimers.push_back(timer);
+
+		uint iTimerID = (uint)vTimers.size() - 1;
+		mapTimerIDs[sFunction] = iTimerID;
+		return iTimerID;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	mstime Start()
+	{
+		mstime iCount;
+		QueryPerformanceCounter((LARGE_INTEGER*)&iCount);
+		return iCount;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void Stop(uint iTimerID, mstime tmStart)
+	{
+		if (iTimerID >= vTimers.size())
+			return;
+
+		if (!iFreq)
+			QueryPerformanceFrequency((LARGE_INTEGER*)&iFreq);
+
+		mstime tmDeltaUS = (Start() - tmStart) * 1000000 / iFreq;
+		uint iDeltaUS = (tmDeltaUS > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint)tmDeltaUS;
+
+		PERF_TIMER &timer = vTimers[iTimerID];
+		timer.iCount++;
+		timer.tmTotalUS += iDeltaUS;
+		if (iDeltaUS > timer.iMaxUS)
+			timer.iMaxUS = iDeltaUS;
+		timer.arrBuckets[BucketIndex(iDeltaUS)]++;
+
+		if (!set_bPerfTimer)
+			return;
+
+		uint iDelta = iDeltaUS / 1000;
+		if (iDelta > timer.iMax && iDelta > set_iTimerThreshold) {
+			HkAddPerfTimerLog("Spent %d ms in %s, longest so far.", iDelta, timer.sFunction.c_str());
+			timer.iMax = iDelta;
+		}
+		else if (iDelta > set_iTimerDebugThreshold && set_iTimerDebugThreshold > 0)
+		{
+			HkAddPerfTimerLog("Spent %d ms in %s", iDelta, timer.sFunction.c_str());
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	struct PERF_SORTCRIT {
+		bool operator()(const PERF_TIMER_STATS& lhs, const PERF_TIMER_STATS& rhs) const {
+			return lhs.tmTotalUS > rhs.tmTotalUS;
+		}
+	};
+
+	void GetStats(list<PERF_TIMER_STATS> &lstStats)
+	{
+		lstStats.clear();
+		for (uint i = 0; i < vTimers.size(); i++)
+		{
+			const PERF_TIMER &timer = vTimers[i];
+			if (!timer.iCount)
+				continue;
+
+			PERF_TIMER_STATS stats;
+			stats.sFunction = timer.sFunction;
+			stats.iCount = timer.iCount;
+			stats.tmTotalUS = timer.tmTotalUS;
+			stats.iP50 = Percentile(timer, 50);
+			stats.iP90 = Percentile(timer, 90);
+			stats.iP99 = Percentile(timer, 99);
+			stats.iMax = timer.iMaxUS;
+			lstStats.push_back(stats);
+		}
+
+		// most expensive first
+		lstStats.sort(PERF_SORTCRIT());
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void Reset()
+	{
+		for (uint i = 0; i < vTimers.size(); i++)
+		{
+			PERF_TIMER &timer = vTimers[i];
+			timer.iCount = 0;
+			timer.tmTotalUS = 0;
+			timer.iMaxUS = 0;
+			memset(timer.arrBuckets, 0, sizeof(timer.arrBuckets));
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void TimerDump()
+	{
+		if (!bEnabled || !set_iPerfStatsDumpInterval)
+			return;
+
+		mstime tmNow = timeInMS();
+		if (!tmLastDump)
+			tmLastDump = tmNow;
+		if ((tmNow - tmLastDump) < ((mstime)set_iPerfStatsDumpInterval * 1000))
+			return;
+		tmLastDump = tmNow;
+
+		FILE *f = fopen("./flhook_logs/flhook_perfstats.log", "wt");
+		if (!f)
+			return;
+
+		char szBuf[64];
+		time_t tNow = time(0);
+		struct tm *t = localtime(&tNow);
+		strftime(szBuf, sizeof(szBuf), "%d.%m.%Y %H:%M:%S", t);
+		fprintf(f, "[%s] durations in microseconds\n", szBuf);
+
+		list<PERF_TIMER_STATS> lstStats;
+		GetStats(lstStats);
+		foreach(lstStats, PERF_TIMER_STATS, it)
+			fprintf(f, "%s count=%I64u total=%I64u p50=%u p90=%u p99=%u max=%u\n", it->sFunction.c_str(), it->iCount, it->tmTotalUS, it->iP50, it->iP90, it->iP99, it->iMax);
+
+		fclose(f);
+	}
+}
+
+/**************************************************************************************************************
+frame profiler: timestamps the phases of every HkIServerImpl::Update call (flhook timers, every plugin's
+Update hook, FLServer's update) and keeps the last FRAME_HISTORY frames in a ring buffer
+**************************************************************************************************************/
+
+namespace FrameProfiler
+{
+#define FRAME_HISTORY 2048
+#define FRAME_MAX_PLUGINS 32
+
+	struct FRAME_SAMPLE
+	{
+		uint iTotalUS;
+		uint arrPhaseUS[FRAME_PHASE_AMOUNT];
+		uint arrPluginUS[FRAME_MAX_PLUGINS];
+	};
+
+	static FRAME_SAMPLE arrFrames[FRAME_HISTORY];
+	static uint iNextFrame = 0;
+	static uint iFrames = 0;
+
+	// plugins with an Update hook get a fixed column in the samples
+	static uint arrPluginTimerIDs[FRAME_MAX_PLUGINS];
+	static string arrPluginNames[FRAME_MAX_PLUGINS];
+	static uint iPlugins = 0;
+
+	static FRAME_SAMPLE curFrame;
+	static mstime tmFrameStart = 0;
+	static mstime tmPhaseStart = 0;
+	static bool bInFrame = false;
+	static mstime iFreq = 0;
+
+	static mstime iOverBudgetTotal = 0;
+	static uint iOverBudgetUnreported = 0;
+	static mstime tmLastOverBudgetEvent = 0;
+	static mstime tmLastReport = 0;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static uint ToUS(mstime tmTicks)
+	{
+		mstime tmUS = tmTicks * 1000000 / iFreq;
+		return (tmUS > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint)tmUS;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void BeginFrame()
+	{
+		bInFrame = PerfTimers::bEnabled;
+		if (!bInFrame)
+			return;
+
+		if (!iFreq)
+			QueryPerformanceFrequency((LARGE_INTEGER*)&iFreq);
+
+		memset(&curFrame, 0, sizeof(curFrame));
+		tmFrameStart = tmPhaseStart = PerfTimers::Start();
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void EndPhase(FRAME_PHASE ePhase)
+	{
+		if (!bInFrame)
+			return;
+
+		mstime tmNow = PerfTimers::Start();
+		curFrame.arrPhaseUS[ePhase] = ToUS(tmNow - tmPhaseStart);
+		tmPhaseStart = tmNow;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void AddPlugin(uint iTimerID, const char *szName, mstime tmStart)
+	{
+		if (!bInFrame)
+			return;
+
+		uint iSlot;
+		for (iSlot = 0; iSlot < iPlugins; iSlot++)
+		{
+			if (arrPluginTimerIDs[iSlot] == iTimerID)
+				break;
+		}
+
+		if (iSlot == iPlugins)
+		{
+			if (iPlugins == FRAME_MAX_PLUGINS)
+				return;
+
+			arrPluginTimerIDs[iSlot] = iTimerID;
+			arrPluginNames[iSlot] = szName;
+			iPlugins++;
+		}
+
+		curFrame.arrPluginUS[iSlot] += ToUS(PerfTimers::Start() - tmStart);
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void EndFrame()
+	{
+		if (!bInFrame)
+			return;
+		bInFrame = false;
+
+		curFrame.iTotalUS = ToUS(PerfTimers::Start() - tmFrameStart);
+		arrFrames[iNextFrame] = curFrame;
+		iNextFrame = (iNextFrame + 1) % FRAME_HISTORY;
+		if (iFrames < FRAME_HISTORY)
+			iFrames++;
+
+		if (!set_iFrameBudget || curFrame.iTotalUS <= (set_iFrameBudget * 1000))
+			return;
+
+		iOverBudgetTotal++;
+		iOverBudgetUnreported++;
+
+		// at most one event per second, the number of frames since the last one is part of it
+		mstime tmNow = timeInMS();
+		if ((tmNow - tmLastOverBudgetEvent) < 1000)
+			return;
+		tmLastOverBudgetEvent = tmNow;
+
+		ProcessEvent(L"frameoverbudget total=%u timers=%u plugins=%u server=%u frames=%u",
+			curFrame.iTotalUS,
+			curFrame.arrPhaseUS[FRAME_PHASE_TIMERS],
+			curFrame.arrPhaseUS[FRAME_PHASE_PLUGINS],
+			curFrame.arrPhaseUS[FRAME_PHASE_SERVER],
+			iOverBudgetUnreported);
+		iOverBudgetUnreported = 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void GetStats(FRAME_STATS &stats)
+	{
+		stats.iFrames = iFrames;
+		stats.iP50 = stats.iP90 = stats.iP99 = stats.iMax = 0;
+		memset(stats.arrAvgPhaseUS, 0, sizeof(stats.arrAvgPhaseUS));
+		stats.iOverBudget = 0;
+		stats.iOverBudgetTotal = iOverBudgetTotal;
+		stats.lstPlugins.clear();
+
+		if (!iFrames)
+			return;
+
+		vector<uint> vTotals;
+		vTotals.reserve(iFrames);
+		mstime arrPhaseSum[FRAME_PHASE_AMOUNT] = { 0 };
+		mstime arrPluginSum[FRAME_MAX_PLUGINS] = { 0 };
+		uint arrPluginMax[FRAME_MAX_PLUGINS] = { 0 };
+		for (uint i = 0; i < iFrames; i++)
+		{
+			const FRAME_SAMPLE &frame = arrFrames[i];
+			vTotals.push_back(frame.iTotalUS);
+			if (set_iFrameBudget && frame.iTotalUS > (set_iFrameBudget * 1000))
+				stats.iOverBudget++;
+			for (uint j = 0; j < FRAME_PHASE_AMOUNT; j++)
+				arrPhaseSum[j] += frame.arrPhaseUS[j];
+			for (uint j = 0; j < iPlugins; j++)
+			{
+				arrPluginSum[j] += frame.arrPluginUS[j];
+				if (frame.arrPluginUS[j] > arrPluginMax[j])
+					arrPluginMax[j] = frame.arrPluginUS[j];
+			}
+		}
+
+		sort(vTotals.begin(), vTotals.end());
+		stats.iP50 = vTotals[(iFrames - 1) * 50 / 100];
+		stats.iP90 = vTotals[(iFrames - 1) * 90 / 100];
+		stats.iP99 = vTotals[(iFrames - 1) * 99 / 100];
+		stats.iMax = vTotals[iFrames - 1];
+
+		for (uint j = 0; j < FRAME_PHASE_AMOUNT; j++)
+			stats.arrAvgPhaseUS[j] = (uint)(arrPhaseSum[j] / iFrames);
+
+		for (uint j = 0; j < iPlugins; j++)
+		{
+			FRAME_PLUGIN_STATS plugin;
+			plugin.sName = arrPluginNames[j];
+			plugin.iAvgUS = (uint)(arrPluginSum[j] / iFrames);
+			plugin.iMaxUS = arrPluginMax[j];
+			stats.lstPlugins.push_back(plugin);
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void TimerReport()
+	{
+		if (!PerfTimers::bEnabled || !set_iFrameStatsEventInterval)
+			return;
+
+		mstime tmNow = timeInMS();
+		if (!tmLastReport)
+			tmLastReport = tmNow;
+		if ((tmNow - tmLastReport) < ((mstime)set_iFrameStatsEventInterval * 1000))
+			return;
+		tmLastReport = tmNow;
+
+		FRAME_STATS stats;
+		GetStats(stats);
+		ProcessEvent(L"framestats frames=%u p50=%u p90=%u p99=%u max=%u timers=%u plugins=%u server=%u overbudget=%u",
+			stats.iFrames, stats.iP50, stats.iP90, stats.iP99, stats.iMax,
+			stats.arrAvgPhaseUS[FRAME_PHASE_TIMERS],
+			stats.arrAvgPhaseUS[FRAME_PHASE_PLUGINS],
+			stats.arrAvgPhaseUS[FRAME_PHASE_SERVER],
+			stats.iOverBudget);
+	}
+}
+
 /**************************************************************************************************************
 check if players should be kicked
 **************************************************************************************************************/
@@ -48,13 +484,9 @@ void HkTimerCheckKick()
 
 	try {
 		// for all players
-		struct PlayerData *pPD = 0;
-		while (pPD = Players.traverse_active(pPD))
+		const CLIENT_SET &clients = PlayerIndex::GetOnlineClients();
+		for (uint iClientID = ClientSetNext(clients, 0); iClientID; iClientID = ClientSetNext(clients, iClientID))
 		{
-			uint iClientID = HkGetClientIdFromPD(pPD);
-			if (iClientID < 1 || iClientID > MAX_CLIENT_ID)
-				continue;
-
 			if (ClientInfo[iClientID].tmKickTime)
 			{
 				if (timeInMS() >= ClientInfo[iClientID].tmKickTime)
@@ -67,8 +499,7 @@ void HkTimerCheckKick()
 
 			if (set_iAntiBaseIdle)
 			{ // anti base-idle check
-				uint iBaseID;
-				pub::Player::GetBase(iClientID, iBaseID);
+				uint iBaseID = PlayerIndex::GetBase(iClientID);
 				if (iBaseID && ClientInfo[iClientID].iBaseEnterTime)
 				{
 					if ((time(0) - ClientInfo[iClientID].iBaseEnterTime) >= set_iAntiBaseIdle)
@@ -82,7 +513,7 @@ void HkTimerCheckKick()
 
 			if (set_iAntiCharMenuIdle)
 			{ // anti charmenu-idle check
-				if (HkIsInCharSelectMenu(iClientID)) {
+				if (!PlayerIndex::GetBase(iClientID) && !PlayerIndex::GetSystem(iClientID)) {
 					if (!ClientInfo[iClientID].iCharMenuEnterTime)
 						ClientInfo[iClientID].iCharMenuEnterTime = (uint)time(0);
 					else if ((time(0) - ClientInfo[iClientID].iCharMenuEnterTime) >= set_iAntiCharMenuIdle) {
@@ -119,6 +550,7 @@ void HkTimerNPCAndF1Check()
 
 			if (ClientInfo[iClientID].tmF1Time && (timeInMS() >= ClientInfo[iClientID].tmF1Time)) { // f1
 				Server.CharacterInfoReq(iClientID, false);
+				PlayerIndex::Refresh(iClientID);
 				ClientInfo[iClientID].tmF1Time = 0;
 			}
 			else if (ClientInfo[iClientID].tmF1TimeDisconnect && (timeInMS() >= ClientInfo[iClientID].tmF1TimeDisconnect)) {
@@ -7,12 +7,10 @@
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-typedef void(*_UserCmdProc)(uint, const wstring &);
-
 struct USERCMD
 {
 	wchar_t *wszCmd;
-	_UserCmdProc proc;
+	USERCMD_PROC proc;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -168,8 +166,10 @@ void UserCmd_SetChatFont(uint iClientID, const wstring &wscParam)
 
 	// save to ini
 	GET_USERFILE(scUserFile);
+	IniBeginBatch();
 	IniWrite(scUserFile, "settings", "ChatSize", itos(chatSize));
 	IniWrite(scUserFile, "settings", "ChatStyle", itos(chatStyle));
+	IniEndBatch();
 
 	// save in ClientInfo
 	ClientInfo[iClientID].chatSize = chatSize;
@@ -233,7 +233,9 @@ void UserCmd_Ignore(uint iClientID, const wstring &wscParam)
 	IGNORE_INFO ii;
 	ii.wscCharname = wscCharname;
 	ii.wscFlags = wscFlags;
+	IgnoreInfoCompile(ii);
 	ClientInfo[iClientID].lstIgnore.push_back(ii);
+	IgnoreFilter::Rebuild(iClientID);
 
 	// send confirmation msg
 	PRINT_OK();
@@ -289,7 +291,9 @@ void UserCmd_IgnoreID(uint iClientID, const wstring &wscParam)
 	IGNORE_INFO ii;
 	ii.wscCharname = wscCharname;
 	ii.wscFlags = wscFlags;
+	IgnoreInfoCompile(ii);
 	ClientInfo[iClientID].lstIgnore.push_back(ii);
+	IgnoreFilter::Rebuild(iClientID);
 
 	// send confirmation msg
 	PrintUserCmdText(iClientID, L"OK, \"%s\" added to ignore list", wscCharname.c_str());
@@ -345,6 +349,7 @@ void UserCmd_DelIgnore(uint iClientID, const wstring &wscParam)
 	{ // delete all
 		IniDelSection(scUserFile, "IgnoreList");
 		ClientInfo[iClientID].lstIgnore.clear();
+		IgnoreFilter::Rebuild(iClientID);
 		PRINT_OK();
 		return;
 	}
@@ -380,8 +385,10 @@ void UserCmd_DelIgnore(uint iClientID, const wstring &wscParam)
 		}
 	}
 	ClientInfo[iClientID].lstIgnore.reverse();
+	IgnoreFilter::Rebuild(iClientID);
 
 	// send confirmation msg
+	IniBeginBatch();
 	IniDelSection(scUserFile, "IgnoreList");
 	int i = 1;
 	foreach(ClientInfo[iClientID].lstIgnore, IGNORE_INFO, it3)
@@ -389,6 +396,7 @@ void UserCmd_DelIgnore(uint iClientID, const wstring &wscParam)
 		IniWriteW(scUserFile, "IgnoreList", itos(i), ((*it3).wscCharname + L" " + (*it3).wscFlags));
 		i++;
 	}
+	IniEndBatch();
 	PRINT_OK();
 }
 
@@ -452,12 +460,14 @@ void UserCmd_AutoBuy(uint iClientID, const wstring &wscParam)
 		ClientInfo[iClientID].bAutoBuyCD = bEnable;
 		ClientInfo[iClientID].bAutoBuyCM = bEnable;
 		ClientInfo[iClientID].bAutoBuyReload = bEnable;
+		IniBeginBatch();
 		IniWrite(scUserFile, scSection, "missiles", bEnable ? "yes" : "no");
 		IniWrite(scUserFile, scSection, "mines", bEnable ? "yes" : "no");
 		IniWrite(scUserFile, scSection, "torps", bEnable ? "yes" : "no");
 		IniWrite(scUserFile, scSection, "cd", bEnable ? "yes" : "no");
 		IniWrite(scUserFile, scSection, "cm", bEnable ? "yes" : "no");
 		IniWrite(scUserFile, scSection, "reload", bEnable ? "yes" : "no");
+		IniEndBatch();
 	} else if(!wscType.compare(L"missiles")) {
 		ClientInfo[iClientID].bAutoBuyMissiles = bEnable;
 		IniWrite(scUserFile, scSection, "missiles", bEnable ? "yes" : "no");
@@ -591,6 +601,21 @@ void UserCmd_Help(uint iClientID, const wstring &wscParam)
 	wstring boldHelp = set_wscUserCmdStyle.substr(0, set_wscUserCmdStyle.length() - 1) + L"1";
 	wstring normal = set_wscUserCmdStyle;
 
+	// commands registered with their help are found in the router
+	wstring wscArguments, wscLongHelp;
+	if (singleCommandHelp && UserCmdRouter::GetHelp(wscParam, wscArguments, wscLongHelp)) {
+		set_wscUserCmdStyle = boldHelp;
+		PrintUserCmdText(iClientID, wscParam + L" " + wscArguments);
+		set_wscUserCmdStyle = normal;
+		int pos = 0;
+		while (pos != wstring::npos) {
+			int nextPos = wscLongHelp.find('\n', pos + 1);
+			PrintUserCmdText(iClientID, L"  " + wscLongHelp.substr(pos, (nextPos - pos)));
+			pos = nextPos;
+		}
+		return;
+	}
+
 	foreach(lstHelpEntries, stHelpEntry, he) {
 		if (he->fnIsDisplayed(iClientID)) {
 			if (singleCommandHelp) {
@@ -657,40 +682,14 @@ bool UserCmd_Process(uint iClientID, const wstring &wscCmd)
 
 	CALL_PLUGINS(PLUGIN_UserCmd_Process, bool, , (uint iClientID, const wstring &wscCmd), (iClientID, wscCmd));
 
-
-	wstring wscCmdLower = ToLower(wscCmd);
-
-	for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
+	// flhook's commands go into the router with the first command
+	static bool bRegistered = false;
+	if (!bRegistered)
 	{
-		if (wscCmdLower.find(UserCmds[i].wszCmd) == 0)
-		{
-			wstring wscParam = L"";
-			if (wscCmd.length() > wcslen(UserCmds[i].wszCmd))
-			{
-				if (wscCmd[wcslen(UserCmds[i].wszCmd)] != ' ')
-					continue;
-				wscParam = wscCmd.substr(wcslen(UserCmds[i].wszCmd) + 1);
-			}
-
-			// addlog
-			if (set_bLogUserCmds) {
-				wstring wscCharname = (wchar_t*)Players.GetActiveCharacterName(iClientID);
-				HkAddUserCmdLog("%s: %s", wstos(wscCharname).c_str(), wstos(wscCmd).c_str());
-			}
-
-			try {
-				UserCmds[i].proc(iClientID, wscParam);
-				if (set_bLogUserCmds)
-					HkAddUserCmdLog("finished");
-			}
-			catch (...) {
-				if (set_bLogUserCmds)
-					HkAddUserCmdLog("exception");
-			}
-
-			return true;
-		}
+		for (uint i = 0; (i < sizeof(UserCmds) / sizeof(USERCMD)); i++)
+			UserCmdRouter::RegisterCore(UserCmds[i].wszCmd, UserCmds[i].proc);
+		bRegistered = true;
 	}
 
-	return false;
+	return UserCmdRouter::Process(iClientID, wscCmd);
 }
@@ -0,0 +1,283 @@
+#include "hook.h"
+#include <map>
+
+/**************************************************************************************************************
+user commands of flhook and the plugins in one trie, keyed on the lower case command ("/set diemsg", "/i$").
+a chat line walks the trie once and every command that ends at a word boundary is a candidate, the longest
+one is tried first. the routes of a command are called in order (plugins before flhook) until one handles it,
+so a command goes straight to its owner instead of being offered to every plugin.
+**************************************************************************************************************/
+
+namespace UserCmdRouter
+{
+	struct ROUTE
+	{
+		wstring wscCmd;
+		USERCMD_CALLBACK callback;
+		USERCMD_PROC coreProc;
+		wstring wscUsage;
+		wstring wscArguments;
+		wstring wscShortHelp;
+		wstring wscLongHelp;
+		HMODULE hModule;
+		bool bPaused;
+	};
+
+	struct TRIE_NODE
+	{
+		map<wchar_t, uint> mapChildren;
+		list<ROUTE*> lstRoutes;
+	};
+
+	// node 0 is the root, nodes are referenced by index so the vector may grow
+	static vector<TRIE_NODE> vNodes(1);
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static uint GetNode(const wstring &wscCmd, bool bCreate)
+	{
+		uint iNode = 0;
+		for (uint i = 0; i < wscCmd.length(); i++)
+		{
+			map<wchar_t, uint>::iterator it = vNodes[iNode].mapChildren.find(wscCmd[i]);
+			if (it != vNodes[iNode].mapChildren.end())
+			{
+				iNode = it->second;
+				continue;
+			}
+
+			if (!bCreate)
+				return 0;
+
+			vNodes.push_back(TRIE_NODE());
+			uint iChild = (uint)vNodes.size() - 1;
+			vNodes[iNode].mapChildren[wscCmd[i]] = iChild;
+			iNode = iChild;
+		}
+
+		return iNode;
+	}
+
+	static void AddRoute(ROUTE *route)
+	{
+		list<ROUTE*> &lstRoutes = vNodes[GetNode(route->wscCmd, true)].lstRoutes;
+
+		// plugins come before flhook's own commands so they can still override them
+		list<ROUTE*>::iterator it = lstRoutes.begin();
+		if (!route->coreProc)
+		{
+			while (it != lstRoutes.end() && !(*it)->coreProc)
+				it++;
+		}
+		else
+			it = lstRoutes.end();
+
+		lstRoutes.insert(it, route);
+
+		if (route->wscShortHelp.length() || route->wscLongHelp.length())
+			HkAddHelpEntry(route->wscCmd, route->wscArguments, route->wscShortHelp, route->wscLongHelp, get_bTrue);
+	}
+
+	static void DeleteRoute(ROUTE *route)
+	{
+		if (route->wscShortHelp.length() || route->wscLongHelp.length())
+			HkRemoveHelpEntry(route->wscCmd, route->wscArguments);
+		delete route;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void RegisterCore(const wstring &wscCmd, USERCMD_PROC proc)
+	{
+		ROUTE *route = new ROUTE;
+		route->wscCmd = ToLower(wscCmd);
+		route->callback = 0;
+		route->coreProc = proc;
+		route->hModule = 0;
+		route->bPaused = false;
+		AddRoute(route);
+	}
+
+	bool Register(const wstring &wscCmd, USERCMD_CALLBACK callback, const wstring &wscUsage, const wstring &wscArguments, const wstring &wscShortHelp, const wstring &wscLongHelp)
+	{
+		if (!callback || !wscCmd.length())
+			return false;
+
+		ROUTE *route = new ROUTE;
+		route->wscCmd = ToLower(wscCmd);
+		route->callback = callback;
+		route->coreProc = 0;
+		route->wscUsage = wscUsage;
+		route->wscArguments = wscArguments;
+		route->wscShortHelp = wscShortHelp;
+		route->wscLongHelp = wscLongHelp;
+		route->bPaused = false;
+
+		// remember which dll the callback lives in, its commands have to go when the plugin is unloaded
+		route->hModule = 0;
+		GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)callback, &route->hModule);
+
+		AddRoute(route);
+		return true;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void Unregister(const wstring &wscCmd, USERCMD_CALLBACK callback)
+	{
+		uint iNode = GetNode(ToLower(wscCmd), false);
+		if (!iNode)
+			return;
+
+		list<ROUTE*> &lstRoutes = vNodes[iNode].lstRoutes;
+		for (list<ROUTE*>::iterator it = lstRoutes.begin(); it != lstRoutes.end(); )
+		{
+			if ((*it)->callback && (*it)->callback == callback)
+			{
+				DeleteRoute(*it);
+				it = lstRoutes.erase(it);
+			}
+			else
+				it++;
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void PauseModule(HMODULE hModule, bool bPause)
+	{
+		for (uint i = 0; i < vNodes.size(); i++)
+		{
+			foreach(vNodes[i].lstRoutes, ROUTE*, it)
+			{
+				if ((*it)->hModule == hModule)
+					(*it)->bPaused = bPause;
+			}
+		}
+	}
+
+	void RemoveModule(HMODULE hModule)
+	{
+		for (uint i = 0; i < vNodes.size(); i++)
+		{
+			list<ROUTE*> &lstRoutes = vNodes[i].lstRoutes;
+			for (list<ROUTE*>::iterator it = lstRoutes.begin(); it != lstRoutes.end(); )
+			{
+				if ((*it)->hModule == hModule)
+				{
+					DeleteRoute(*it);
+					it = lstRoutes.erase(it);
+				}
+				else
+					it++;
+			}
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	bool Process(uint iClientID, const wstring &wscCmd)
+	{
+		wstring wscCmdLower = ToLower(wscCmd);
+
+		// commands ending at a word boundary, shortest first
+		uint arrMatches[32];
+		uint arrLengths[32];
+		uint iMatches = 0;
+
+		uint iNode = 0;
+		for (uint i = 0; i < wscCmdLower.length(); i++)
+		{
+			map<wchar_t, uint>::iterator it = vNodes[iNode].mapChildren.find(wscCmdLower[i]);
+			if (it == vNodes[iNode].mapChildren.end())
+				break;
+
+			iNode = it->second;
+			if (vNodes[iNode].lstRoutes.size() && ((i + 1) == wscCmdLower.length() || wscCmdLower[i + 1] == L' '))
+			{
+				if (iMatches == (sizeof(arrMatches) / sizeof(uint)))
+					iMatches--;
+				arrMatches[iMatches] = iNode;
+				arrLengths[iMatches] = i + 1;
+				iMatches++;
+			}
+		}
+
+		while (iMatches--)
+		{
+			uint iLen = arrLengths[iMatches];
+			wstring wscParam = (wscCmd.length() > iLen) ? wscCmd.substr(iLen + 1) : L"";
+
+			foreach(vNodes[arrMatches[iMatches]].lstRoutes, ROUTE*, it)
+			{
+				ROUTE *route = *it;
+				if (route->bPaused)
+					continue;
+
+				if (set_bLogUserCmds) {
+					wstring wscCharname = (wchar_t*)Players.GetActiveCharacterName(iClientID);
+					HkAddUserCmdLog("%s: %s", wstos(wscCharname).c_str(), wstos(wscCmd).c_str());
+				}
+
+				bool bHandled = true;
+				try {
+					if (route->coreProc)
+						route->coreProc(iClientID, wscParam);
+					else
+						bHandled = route->callback(iClientID, wscCmd, wscParam, route->wscUsage.c_str());
+					if (set_bLogUserCmds)
+						HkAddUserCmdLog(bHandled ? "finished" : "not handled");
+				}
+				catch (...) {
+					if (set_bLogUserCmds)
+						HkAddUserCmdLog("exception");
+				}
+
+				if (bHandled)
+					return true;
+			}
+		}
+
+		return false;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// help of a registered command for "/help <command>"
+	bool GetHelp(const wstring &wscCmd, wstring &wscArguments, wstring &wscLongHelp)
+	{
+		uint iNode = GetNode(ToLower(wscCmd), false);
+		if (!iNode)
+			return false;
+
+		foreach(vNodes[iNode].lstRoutes, ROUTE*, it)
+		{
+			if ((*it)->bPaused || !((*it)->wscShortHelp.length() || (*it)->wscLongHelp.length()))
+				continue;
+
+			wscArguments = (*it)->wscArguments;
+			wscLongHelp = (*it)->wscLongHelp.length() ? (*it)->wscLongHelp : (*it)->wscShortHelp;
+			return true;
+		}
+
+		return false;
+	}
+}
+
+/**************************************************************************************************************
+Register a user command of a plugin. The callback is called for chat lines starting with wscCmd (case
+insensitive) followed by a space or the end of the line and returns true if it handled the command.
+wscUsage is passed on to the callback, the help texts are shown by /help.
+**************************************************************************************************************/
+
+bool HkRegisterUserCommand(const wstring &wscCmd, USERCMD_CALLBACK callback, const wstring &wscUsage, const wstring &wscArguments, const wstring &wscShortHelp, const wstring &wscLongHelp)
+{
+	return UserCmdRouter::Register(wscCmd, callback, wscUsage, wscArguments, wscShortHelp, wscLongHelp);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void HkUnregisterUserCommand(const wstring &wscCmd, USERCMD_CALLBACK callback)
+{
+	UserCmdRouter::Unregister(wscCmd, callback);
+}
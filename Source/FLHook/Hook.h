@@ -2,6 +2,9 @@
 #define _HOOK_
 
 #include <time.h>
+#include <intrin.h>
+#include <vector>
+#include <map>
 #if _MSC_VER == 1200
 #include "xtrace.h" // __FUNCTION__ macro for vc6
 #endif
@@ -115,6 +118,42 @@ private:
 	uint iWarning;
 };
 
+// multi pattern substring search over lower case text, see CStringMatcher.cpp
+struct STRING_MATCH
+{
+	uint iPos;
+	uint iLen;
+	uint iMask;
+};
+
+class CStringMatcher
+{
+public:
+	EXPORT CStringMatcher();
+	EXPORT void Clear();
+	EXPORT void Add(const wstring &wscPattern, uint iMask, bool bWholeWord = false);
+	EXPORT void Compile();
+	EXPORT uint Match(const wstring &wscText) const;
+	EXPORT uint Find(const wstring &wscText, list<STRING_MATCH> &lstMatches) const;
+	EXPORT bool Empty() const;
+
+private:
+	struct NODE
+	{
+		map<wchar_t, uint> mapNext;
+		uint iFail;
+		uint iOutput;
+		uint iLen;
+		uint iMask;
+		uint iWordMask;
+	};
+
+	uint Next(uint iNode, wchar_t wc) const;
+	uint Scan(const wstring &wscText, list<STRING_MATCH> *lstMatches) const;
+
+	vector<NODE> vNodes;
+};
+
 struct PLUGIN_HOOKDATA
 {
 	string sName;
@@ -124,6 +163,23 @@ struct PLUGIN_HOOKDATA
 	bool bPaused;
 	FARPROC* pFunc;
 	PLUGIN_RETURNCODE* ePluginReturnCode;
+	uint iTimerID;
+};
+
+// compiled, priority-sorted view of pPluginHooks[callback] without paused plugins;
+// rebuilt by the plugin manager whenever a plugin is loaded, unloaded or (un)paused
+struct PLUGIN_DISPATCH_ENTRY
+{
+	FARPROC* pFunc;
+	PLUGIN_RETURNCODE* ePluginReturnCode;
+	const char* szName;
+	uint iTimerID;
+};
+
+struct PLUGIN_DISPATCH_TABLE
+{
+	PLUGIN_DISPATCH_ENTRY* pEntries;
+	uint iCount;
 };
 
 struct PLUGIN_DATA
@@ -146,36 +202,103 @@ struct PLUGIN_SORTCRIT {
 	}
 };
 
+// performance timers, identified by an id interned once per function name
+struct PERF_TIMER_STATS
+{
+	string sFunction;
+	mstime iCount;
+	mstime tmTotalUS;
+	uint iP50;
+	uint iP90;
+	uint iP99;
+	uint iMax;
+};
 
+namespace PerfTimers
+{
+	extern EXPORT bool bEnabled;
+	EXPORT uint Intern(const string &sFunction);
+	EXPORT mstime Start();
+	EXPORT void Stop(uint iTimerID, mstime tmStart);
+	EXPORT void GetStats(list<PERF_TIMER_STATS> &lstStats);
+	EXPORT void Reset();
+	void TimerDump();
+}
 
-#define CALL_PLUGINS(callback_id,ret_type,calling_convention,arg_types,args) \
-{ \
-	ret_type vPluginRet; \
-	bool bPluginReturn = false; \
+// per-frame accounting of HkIServerImpl::Update
+enum FRAME_PHASE
+{
+	FRAME_PHASE_TIMERS,
+	FRAME_PHASE_PLUGINS,
+	FRAME_PHASE_SERVER,
+	FRAME_PHASE_AMOUNT,
+};
+
+struct FRAME_PLUGIN_STATS
+{
+	string sName;
+	uint iAvgUS;
+	uint iMaxUS;
+};
+
+struct FRAME_STATS
+{
+	uint iFrames;
+	uint iP50;
+	uint iP90;
+	uint iP99;
+	uint iMax;
+	uint arrAvgPhaseUS[FRAME_PHASE_AMOUNT];
+	uint iOverBudget;
+	mstime iOverBudgetTotal;
+	list<FRAME_PLUGIN_STATS> lstPlugins;
+};
+
+namespace FrameProfiler
+{
+	void BeginFrame();
+	void EndPhase(FRAME_PHASE ePhase);
+	void AddPlugin(uint iTimerID, const char *szName, mstime tmStart);
+	void EndFrame();
+	EXPORT void GetStats(FRAME_STATS &stats);
+	void TimerReport();
+}
+
+// the dispatch table pointer and size are copied before the loop so that a table
+// rebuilt from inside a plugin call stays valid until the current dispatch is done
+#define CALL_PLUGINS_LOOP(callback_id,invoke,on_skipplugins_nofunctioncall,on_nofunctioncall) \
 	g_bPlugin_nofunctioncall = false; \
 	try { \
-		foreach(pPluginHooks[(int)callback_id],PLUGIN_HOOKDATA, itplugin) { \
-			if(itplugin->bPaused) \
-				continue; \
-			if(itplugin->pFunc) { \
-				CTimer timer(itplugin->sPluginFunction,set_iTimerThreshold); \
-				timer.start(); \
-				try { \
-					vPluginRet = ((ret_type (calling_convention*) arg_types )itplugin->pFunc) args; \
-				} catch(...) { AddLog("ERROR: Exception in plugin '%s' in %s", itplugin->sName.c_str(), __FUNCTION__); LOG_EXCEPTION } \
-				timer.stop(); \
-			} else  \
-				AddLog("ERROR: Plugin '%s' does not export %s [%s]", itplugin->sName.c_str(), __FUNCTION__, __FUNCDNAME__); \
-			if(*itplugin->ePluginReturnCode == SKIPPLUGINS_NOFUNCTIONCALL) { \
-				bPluginReturn = true; \
+		const PLUGIN_DISPATCH_ENTRY *pDispatch = pPluginDispatch[(int)callback_id].pEntries; \
+		const uint iDispatchCount = pPluginDispatch[(int)callback_id].iCount; \
+		for(uint iPlugin = 0; iPlugin < iDispatchCount; iPlugin++) { \
+			const PLUGIN_DISPATCH_ENTRY &dispatchEntry = pDispatch[iPlugin]; \
+			mstime tmPluginStart = PerfTimers::bEnabled ? PerfTimers::Start() : 0; \
+			try { \
+				invoke; \
+			} catch(...) { AddLog("ERROR: Exception in plugin '%s' in %s", dispatchEntry.szName, __FUNCTION__); LOG_EXCEPTION } \
+			if(PerfTimers::bEnabled) \
+				PerfTimers::Stop(dispatchEntry.iTimerID, tmPluginStart); \
+			PLUGIN_RETURNCODE ePluginReturnCode = *dispatchEntry.ePluginReturnCode; \
+			if(ePluginReturnCode == SKIPPLUGINS_NOFUNCTIONCALL) { \
+				on_skipplugins_nofunctioncall; \
 				break; \
-			} else if(*itplugin->ePluginReturnCode == NOFUNCTIONCALL) { \
-				bPluginReturn = true; \
+			} else if(ePluginReturnCode == NOFUNCTIONCALL) { \
+				on_nofunctioncall; \
 				g_bPlugin_nofunctioncall = true; \
-			} else if(*itplugin->ePluginReturnCode == SKIPPLUGINS) \
+			} else if(ePluginReturnCode == SKIPPLUGINS) \
 				break; \
 		} \
 	} catch(...) { AddLog("ERROR: Exception %s", __FUNCTION__); LOG_EXCEPTION } \
+
+#define CALL_PLUGINS(callback_id,ret_type,calling_convention,arg_types,args) \
+{ \
+	ret_type vPluginRet; \
+	bool bPluginReturn = false; \
+	CALL_PLUGINS_LOOP(callback_id, \
+		vPluginRet = ((ret_type (calling_convention*) arg_types )dispatchEntry.pFunc) args, \
+		bPluginReturn = true, \
+		bPluginReturn = true) \
 	if(bPluginReturn) \
 		return vPluginRet; \
 } \
@@ -184,30 +307,10 @@ struct PLUGIN_SORTCRIT {
 #define CALL_PLUGINS_V(callback_id,calling_convention,arg_types,args) \
 { \
 	bool bPluginReturn = false; \
-	g_bPlugin_nofunctioncall = false; \
-	try { \
-		foreach(pPluginHooks[(int)callback_id],PLUGIN_HOOKDATA, itplugin) { \
-			if(itplugin->bPaused) \
-				continue; \
-			if(itplugin->pFunc) { \
-				CTimer timer(itplugin->sPluginFunction,set_iTimerThreshold); \
-				timer.start(); \
-				try { \
-					((void (calling_convention*) arg_types )itplugin->pFunc) args; \
-				} catch(...) { AddLog("ERROR: Exception in plugin '%s' in %s", itplugin->sName.c_str(), __FUNCTION__); LOG_EXCEPTION } \
-				timer.stop(); \
-			} else  \
-				AddLog("ERROR: Plugin '%s' does not export %s [%s]", itplugin->sName.c_str(), __FUNCTION__, __FUNCDNAME__); \
-			if(*itplugin->ePluginReturnCode == SKIPPLUGINS_NOFUNCTIONCALL) { \
-				bPluginReturn = true; \
-				break; \
-			} else if(*itplugin->ePluginReturnCode == NOFUNCTIONCALL) { \
-				bPluginReturn = true; \
-				g_bPlugin_nofunctioncall = true; \
-			} else if(*itplugin->ePluginReturnCode == SKIPPLUGINS) \
-				break; \
-		} \
-	} catch(...) { AddLog("ERROR: Exception %s", __FUNCTION__); LOG_EXCEPTION } \
+	CALL_PLUGINS_LOOP(callback_id, \
+		((void (calling_convention*) arg_types )dispatchEntry.pFunc) args, \
+		bPluginReturn = true, \
+		bPluginReturn = true) \
 	if(bPluginReturn) \
 		return; \
 } \
@@ -215,30 +318,10 @@ struct PLUGIN_SORTCRIT {
 // extra macro for plugin calls where we dont care about or dont allow returning
 #define CALL_PLUGINS_NORET(callback_id,calling_convention,arg_types,args) \
 { \
-	g_bPlugin_nofunctioncall = false; \
-	try { \
-		foreach(pPluginHooks[(int)callback_id],PLUGIN_HOOKDATA, itplugin) { \
-			if(itplugin->bPaused) \
-				continue; \
-			if(itplugin->pFunc) { \
-				CTimer timer(itplugin->sPluginFunction,set_iTimerThreshold); \
-				timer.start(); \
-				try { \
-					((void (calling_convention*) arg_types )itplugin->pFunc) args; \
-				} catch(...) { AddLog("ERROR: Exception in plugin '%s' in %s", itplugin->sName.c_str(), __FUNCTION__); LOG_EXCEPTION } \
-				timer.stop(); \
-			} else  \
-				AddLog("ERROR: Plugin '%s' does not export %s [%s]", itplugin->sName.c_str(), __FUNCTION__, __FUNCDNAME__); \
-			if(*itplugin->ePluginReturnCode == SKIPPLUGINS_NOFUNCTIONCALL) { \
-				AddLog("ERROR: Plugin '%s' wants to suppress function call in %s [%s] - denied!", itplugin->sName.c_str(), __FUNCTION__, __FUNCDNAME__); \
-				break; \
-			} else if(*itplugin->ePluginReturnCode == NOFUNCTIONCALL) { \
-				AddLog("ERROR: Plugin '%s' wants to suppress function call in %s [%s] - denied!", itplugin->sName.c_str(), __FUNCTION__, __FUNCDNAME__); \
-				g_bPlugin_nofunctioncall = true; \
-			} else if(*itplugin->ePluginReturnCode == SKIPPLUGINS) \
-				break; \
-		} \
-	} catch(...) { AddLog("ERROR: Exception %s", __FUNCTION__); LOG_EXCEPTION } \
+	CALL_PLUGINS_LOOP(callback_id, \
+		((void (calling_convention*) arg_types )dispatchEntry.pFunc) args, \
+		AddLog("ERROR: Plugin '%s' wants to suppress function call in %s [%s] - denied!", dispatchEntry.szName, __FUNCTION__, __FUNCDNAME__), \
+		AddLog("ERROR: Plugin '%s' wants to suppress function call in %s [%s] - denied!", dispatchEntry.szName, __FUNCTION__, __FUNCDNAME__)) \
 } \
 
 typedef PLUGIN_RETURNCODE(*PLUGIN_Get_PluginReturnCode)();
@@ -387,10 +470,28 @@ struct MONEY_FIX
 };
 
 // ignore
+enum IGNORE_FLAGS
+{
+	IGNORE_PRIVATE = 1,		// "p", only private chat
+	IGNORE_SUBSTRING = 2,	// "i", charname contains wscCharname
+};
+
 struct IGNORE_INFO
 {
 	wstring wscCharname;
 	wstring wscFlags;
+	// compiled from the above by IgnoreInfoCompile
+	wstring wscCharnameLower;
+	uint iFlags;
+};
+
+// the last hull hit of a player, only kept as the few values the death message needs
+struct DAMAGE_INFO
+{
+	uint iInflictorShip;
+	uint iInflictorClient;
+	uint iCause;
+	mstime tmTime;
 };
 
 struct CLIENT_INFO
@@ -400,7 +501,7 @@ struct CLIENT_INFO
 	uint		iShipOld;
 	mstime		tmSpawnTime;
 
-	DamageList	dmgLast;
+	DAMAGE_INFO	dmgLast;
 
 	// money cmd
 	list<MONEY_FIX> lstMoneyFix;
@@ -503,6 +604,20 @@ struct HKPLAYERINFO
 	wstring wscIP;
 };
 
+// cached state of a player, see PlayerIndex::GetPlayer
+struct PLAYER_SNAPSHOT
+{
+	uint iClientID;
+	uint iGeneration; // changes whenever one of the fields below changes
+	wstring wscCharname;
+	wstring wscBase;
+	wstring wscSystem;
+	uint iBase;
+	uint iSystem;
+	uint iShip;
+	wstring wscIP;
+};
+
 // patch stuff
 struct PATCH_INFO_ENTRY
 {
@@ -554,6 +669,7 @@ namespace PluginManager {
 	EXPORT HK_ERROR PausePlugin(const string &sShortName, bool bPause);
 	EXPORT HK_ERROR UnloadPlugin(const string &sShortName);
 	EXPORT void UnloadPlugins();
+	void FreeRetiredDispatchTables();
 }
 
 EXPORT void Plugin_Communication(PLUGIN_MESSAGE msgtype, void* msg);
@@ -598,6 +714,7 @@ EXPORT HK_ERROR HkMsg(const wstring &wscCharname, const wstring &wscMessage);
 EXPORT HK_ERROR HkMsgS(const wstring &wscSystemname, const wstring &wscMessage);
 EXPORT HK_ERROR HkMsgU(const wstring &wscMessage);
 EXPORT HK_ERROR HkFMsgEncodeXML(const wstring &wscXML, char *szBuf, uint iSize, uint &iRet);
+EXPORT HK_ERROR HkFMsgEncodeMsg(const wstring &wscTRA, const wstring &wscText, char *szBuf, uint iSize, uint &iRet);
 EXPORT HK_ERROR HkFMsgSendChat(uint iClientID, char *szBuf, uint iSize);
 EXPORT HK_ERROR HkFMsg(uint iClientID, const wstring &wscXML);
 EXPORT HK_ERROR HkFMsg(const wstring &wscCharname, const wstring &wscXML);
@@ -643,6 +760,34 @@ EXPORT void HkAddAdminCmdLog(const char *szString, ...);
 EXPORT void HkAddSocketCmdLog(const char *szString, ...);
 EXPORT void HkAddUserCmdLog(const char *szString, ...);
 EXPORT void HkAddPerfTimerLog(const char *szString, ...);
+void InitLogs();
+void UpdateDebugLog();
+
+// HkLogger
+enum LOG_STAMP
+{
+	LOG_STAMP_DEFAULT, // [dd.mm.yyyy hh:mm:ss]
+	LOG_STAMP_EVENT, // mm/dd/yyyy hh:mm:ss
+	LOG_STAMP_PLUGIN, // dd/mm/yyyy hh:mm:ss
+	LOG_STAMP_AMOUNT,
+};
+
+EXPORT uint HkLogOpen(const string &scFile, uint iMaxSizeKB = 0, LOG_STAMP eStamp = LOG_STAMP_DEFAULT);
+EXPORT void HkLogClose(uint iLogID);
+EXPORT void HkLogWrite(uint iLogID, const char *szString, ...);
+EXPORT void HkLogFlush();
+EXPORT bool HkLogRotate(const string &scFile, const string &scRotatedFile = "");
+EXPORT bool HkLogAppend(const string &scFile, LOG_STAMP eStamp, const char *szString, ...);
+namespace Logger
+{
+	uint Open(const string &scPath, uint iMaxSizeKB, LOG_STAMP eStamp);
+	void Close(uint iLogID);
+	bool Rotate(const string &scPath, const string &scRotatedPath);
+	bool Append(const string &scPath, LOG_STAMP eStamp, const char *szText);
+	bool Write(uint iLogID, const char *szText);
+	void Flush();
+	void Shutdown();
+}
 
 // HkFuncOther
 EXPORT void HkGetPlayerIP(uint iClientID, wstring &wscIP);
@@ -664,6 +809,50 @@ EXPORT HK_ERROR HkFLIniGet(const wstring &wscCharname, const wstring &wscKey, ws
 EXPORT HK_ERROR HkFLIniWrite(const wstring &wscCharname, const wstring &wscKey, const wstring &wscValue);
 
 EXPORT wstring HkErrGetText(HK_ERROR hkErr);
+
+// HkCharFile
+struct CHARFILE
+{
+	FILETIME ftLastWrite;
+	DWORD dwSize;
+	bool bEncoded;
+	vector<string> vLines;
+	bool bTrailingNewline;
+};
+
+namespace CharFileCache
+{
+	HK_ERROR Load(const string &scPath, const CHARFILE *&charfile);
+	HK_ERROR Save(const string &scPath, CHARFILE &charfile, bool bEncode);
+	void Invalidate(const string &scPath);
+	string GetValue(const CHARFILE &charfile, const string &scSection, const string &scKey, const string &scDefault);
+	void SetValue(CHARFILE &charfile, const string &scSection, const string &scKey, const string &scValue);
+}
+
+// HkIniCache
+namespace IniCache
+{
+	bool Get(const string &scFile, const string &scApp, const string &scKey, string &scValue, bool &bFound);
+	bool GetSection(const string &scFile, const string &scApp, list<INISECTIONVALUE> &lstValues);
+	bool Write(const string &scFile, const string &scApp, const string &scKey, const string &scValue);
+	bool Delete(const string &scFile, const string &scApp, const string &scKey);
+	bool DelSection(const string &scFile, const string &scApp);
+	void BeginBatch();
+	void EndBatch();
+}
+
+// HkScheduler
+typedef void(*TIMER_CALLBACK)(uint iTimerID, void *pData);
+EXPORT uint HkScheduleTimer(uint iDelayMS, uint iIntervalMS, TIMER_CALLBACK callback, void *pData = 0, uint iClientID = 0);
+EXPORT bool HkCancelTimer(uint iTimerID);
+EXPORT void HkCancelClientTimers(uint iClientID);
+namespace TimerWheel
+{
+	void Process();
+	void CancelModule(HMODULE hModule);
+	void PauseModule(HMODULE hModule, bool bPause);
+}
+
 void ClearClientInfo(uint iClientID);
 void LoadUserSettings(uint iClientID);
 
@@ -673,6 +862,29 @@ EXPORT void UserCmd_SetDieMsg(uint iClientID, wstring &wscParam);
 EXPORT void UserCmd_SetChatFont(uint iClientID, wstring &wscParam);
 EXPORT void PrintUserCmdText(uint iClientID, wstring wscText, ...);
 
+// HkIgnoreFilter
+void IgnoreInfoCompile(IGNORE_INFO &ii);
+namespace IgnoreFilter
+{
+	void Rebuild(uint iClientID);
+	bool IsIgnored(uint iClientID, const wstring &wscSenderLower, bool bPrivate);
+}
+
+// HkUserCmdRouter
+typedef void(*USERCMD_PROC)(uint iClientID, const wstring &wscParam);
+typedef bool(*USERCMD_CALLBACK)(uint iClientID, const wstring &wscCmd, const wstring &wscParam, const wchar_t *wszUsage);
+EXPORT bool HkRegisterUserCommand(const wstring &wscCmd, USERCMD_CALLBACK callback, const wstring &wscUsage = L"", const wstring &wscArguments = L"", const wstring &wscShortHelp = L"", const wstring &wscLongHelp = L"");
+EXPORT void HkUnregisterUserCommand(const wstring &wscCmd, USERCMD_CALLBACK callback);
+
+namespace UserCmdRouter
+{
+	void RegisterCore(const wstring &wscCmd, USERCMD_PROC proc);
+	bool Process(uint iClientID, const wstring &wscCmd);
+	bool GetHelp(const wstring &wscCmd, wstring &wscArguments, wstring &wscLongHelp);
+	void PauseModule(HMODULE hModule, bool bPause);
+	void RemoveModule(HMODULE hModule);
+}
+
 // HkDeath
 void ShipDestroyedHook();
 void BaseDestroyed(uint iObject, uint iClientIDBy);
@@ -683,6 +895,8 @@ void _HkCb_AddDmgEntry();
 void _HkCb_GeneralDmg();
 void _HkCb_GeneralDmg2();
 bool AllowPlayerDamage(uint iClientID, uint iClientIDTarget);
+EXPORT void HkSetLastDamage(uint iClientID, const DamageList &dmg);
+EXPORT void HkGetLastDamage(uint iClientID, DamageList &dmg);
 void _HkCb_NonGunWeaponHitsBase();
 extern FARPROC fpOldNonGunWeaponHitsBase;
 EXPORT extern bool g_gNonGunHitsBase;
@@ -692,6 +906,24 @@ EXPORT extern float g_LastHitPts;
 void _SendMessageHook();
 void __stdcall HkCb_SendChat(uint iId, uint iTo, uint iSize, void *pRDL);
 
+// one chat line while flserver hands it to the recipients, shared by all HkCb_SendChat calls of the line
+struct CHAT_VARIANT
+{
+	uint iKey;
+	string sEncoded;
+};
+
+struct CHAT_CONTEXT
+{
+	uint iTextLen;
+	string sRDL;
+	wstring wscSender;
+	wstring wscSenderLower;
+	wstring wscSenderXML;
+	wstring wscTextXML;
+	list<CHAT_VARIANT> lstVariants;
+};
+
 // HkCbDisconnect
 void _DisconnectPacketSent();
 extern FARPROC fpOldDiscPacketSent;
@@ -729,6 +961,7 @@ namespace HkIServerImpl
 	void __stdcall Shutdown(void);
 	EXPORT extern bool g_bInSubmitChat;
 	EXPORT extern uint g_iTextLen;
+	extern CHAT_CONTEXT *g_pChat;
 	extern HOOKENTRY hookEntries[85];
 }
 
@@ -739,6 +972,7 @@ bool HkLoadBaseMarket();
 // variables
 
 extern EXPORT list<PLUGIN_HOOKDATA>* pPluginHooks;
+extern EXPORT PLUGIN_DISPATCH_TABLE* pPluginDispatch;
 extern EXPORT list<PLUGIN_DATA> lstPlugins;
 
 extern EXPORT HkIClientImpl* FakeClient;
@@ -774,6 +1008,58 @@ extern EXPORT uint g_iPlayerCount;
 extern EXPORT bool g_bNPCDisabled;
 extern EXPORT char *g_FLServerDataPtr;
 
+// HkPlayerIndex
+#define CLIENT_SET_WORDS ((MAX_CLIENT_ID + 32) / 32)
+
+struct CLIENT_SET
+{
+	uint arrBits[CLIENT_SET_WORDS];
+};
+
+inline void ClientSetAdd(CLIENT_SET &clients, uint iClientID) { clients.arrBits[iClientID >> 5] |= (1u << (iClientID & 31)); }
+inline void ClientSetRemove(CLIENT_SET &clients, uint iClientID) { clients.arrBits[iClientID >> 5] &= ~(1u << (iClientID & 31)); }
+inline bool ClientSetContains(const CLIENT_SET &clients, uint iClientID) { return (clients.arrBits[iClientID >> 5] & (1u << (iClientID & 31))) != 0; }
+
+// returns the first client in the set after iClientID (0 to start), 0 if there is none
+// for(uint iClientID = ClientSetNext(clients, 0); iClientID; iClientID = ClientSetNext(clients, iClientID))
+inline uint ClientSetNext(const CLIENT_SET &clients, uint iClientID)
+{
+	uint iNext = iClientID + 1;
+	for (uint iWord = (iNext >> 5); iWord < CLIENT_SET_WORDS; iWord++)
+	{
+		uint iBits = clients.arrBits[iWord];
+		if (iWord == (iNext >> 5))
+			iBits &= (~0u << (iNext & 31));
+
+		unsigned long iBit;
+		if (_BitScanForward(&iBit, iBits))
+			return (iWord << 5) + iBit;
+	}
+
+	return 0;
+}
+
+namespace PlayerIndex
+{
+	void Refresh(uint iClientID);
+	void ShipDestroyed(uint iClientID);
+	void Remove(uint iClientID);
+	void ShipsChanged(uint iClientID);
+	EXPORT uint FindShip(uint iShip);
+	EXPORT uint GetSystem(uint iClientID);
+	EXPORT bool InNoPvPSystem(uint iClientID);
+	void NoPvPSystemsChanged();
+	EXPORT uint GetBase(uint iClientID);
+	EXPORT uint GetShip(uint iClientID);
+	EXPORT CAccount* GetAccount(uint iClientID);
+	EXPORT uint FindCharname(const wstring &wscCharname);
+	EXPORT uint FindAccount(CAccount *acc);
+	EXPORT const CLIENT_SET& GetOnlineClients();
+	EXPORT const CLIENT_SET& GetSystemClients(uint iSystemID);
+	EXPORT const PLAYER_SNAPSHOT* GetPlayer(uint iClientID);
+	EXPORT uint GetGeneration();
+}
+
 extern EXPORT bool g_bPlugin_nofunctioncall;
 
 
@@ -31,6 +31,10 @@ bool			set_bLogUserCmds;
 bool			set_bPerfTimer;
 uint			set_iTimerThreshold;
 uint			set_iTimerDebugThreshold;
+bool			set_bPerfStats;
+uint			set_iPerfStatsDumpInterval;
+uint			set_iFrameBudget;
+uint			set_iFrameStatsEventInterval;
 
 // Kick
 uint			set_iAntiBaseIdle;
@@ -134,6 +138,11 @@ void LoadSettings()
 	set_bPerfTimer = IniGetB(set_scCfgFile, "Log", "LogPerformanceTimers", false);
 	set_iTimerThreshold = IniGetI(set_scCfgFile, "Log", "TimerThreshold", 100);
 	set_iTimerDebugThreshold = IniGetI(set_scCfgFile, "Log", "TimerDebugThreshold", 0);
+	set_bPerfStats = IniGetB(set_scCfgFile, "Log", "PerfStats", false);
+	set_iPerfStatsDumpInterval = IniGetI(set_scCfgFile, "Log", "PerfStatsDumpInterval", 0);
+	PerfTimers::bEnabled = set_bPerfTimer || set_bPerfStats;
+	set_iFrameBudget = IniGetI(set_scCfgFile, "Log", "FrameBudget", 0);
+	set_iFrameStatsEventInterval = IniGetI(set_scCfgFile, "Log", "FrameStatsEventInterval", 0);
 
 	// Kick
 	set_iAntiBaseIdle = IniGetI(set_scCfgFile, "Kick", "AntiBaseIdle", 0);
@@ -193,6 +202,7 @@ void LoadSettings()
 		pub::GetSystemID(iSystemID, scSystem.c_str());
 		set_lstNoPVPSystems.push_back(iSystemID);
 	}
+	PlayerIndex::NoPvPSystemsChanged();
 
 	// read chat suppress
 	set_lstChatSuppress.clear();
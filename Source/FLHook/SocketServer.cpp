@@ -0,0 +1,636 @@
+#include "CSocket.h"
+#include <map>
+#include <algorithm>
+
+/**************************************************************************************************************
+admin socket i/o on its own thread. the network thread owns the listeners and connections: it accepts,
+receives into the input ring buffers, decrypts, splits the lines and hands them to the game thread, and it
+encodes, encrypts and sends what the game thread prints. both directions go through bounded lock-free queues,
+the game thread only executes the commands (ProcessPendingCommands) and never touches a socket.
+all listeners and connections are waited on with one select(), a loopback udp socket wakes the thread up
+when the game thread queued output.
+connections whose output queue overflows (e.g. event mode consumers that don't keep up) are closed.
+events come in batches, every event line is encoded once per connection format and the same bytes are
+appended to all event mode connections whose topic filter matches.
+**************************************************************************************************************/
+
+#define MAX_SOCKET_CONNECTIONS 1020
+#define SOCKET_SNDBUF 300000
+#define SOCKET_INPUT_MAX (64 * 1024)
+#define SOCKET_OUTPUT_MAX (1024 * 1024)
+#define SOCKET_QUEUE_IN 1024
+#define SOCKET_QUEUE_OUT 8192
+#define SOCKET_WAIT_MS 100
+
+extern SOCKET sListen;
+extern SOCKET sWListen;
+extern SOCKET sEListen;
+extern SOCKET sEWListen;
+
+namespace SocketServer
+{
+	struct NET_CONNECTION
+	{
+		uint iConnID;
+		SOCKET s;
+		string sIP;
+		ushort iPort;
+		bool bUnicode;
+		bool bEncrypted;
+		BLOWFISH_CTX bfc;
+		bool bAuthed;
+		bool bClosed;
+		bool bNotified; // the game thread knows about the close
+		bool bEventMode;
+		vector<wstring> vTopics; // sorted, all events if empty
+		CRingBuffer rbIn;
+		CRingBuffer rbOut;
+		wstring wscPending;
+
+		NET_CONNECTION() : rbIn(SOCKET_INPUT_MAX), rbOut(SOCKET_OUTPUT_MAX) {}
+	};
+
+	// fd_set with room for every listener and connection, winsock's fd_set only holds FD_SETSIZE (64) sockets
+	struct SOCKET_SET
+	{
+		u_int fd_count;
+		SOCKET fd_array[MAX_SOCKET_CONNECTIONS + 5];
+	};
+
+	static CSocketQueue queueIn(SOCKET_QUEUE_IN);
+	static CSocketQueue queueOut(SOCKET_QUEUE_OUT);
+	static list<NET_CONNECTION*> lstConnections;
+	static map<uint, NET_CONNECTION*> mapConnections;
+	static uint iNextConnID = 1;
+
+	static HANDLE hNetThread = 0;
+	static volatile bool bStop = false;
+	static SOCKET sWakeRecv = INVALID_SOCKET;
+	static SOCKET sWakeSend = INVALID_SOCKET;
+	static volatile LONG lWakePending = 0;
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void CreateWakeSockets()
+	{
+		sockaddr_in adr;
+		memset(&adr, 0, sizeof(adr));
+		adr.sin_family = AF_INET;
+		adr.sin_addr.s_addr = inet_addr("127.0.0.1");
+		int iLen = sizeof(adr);
+
+		sWakeRecv = socket(AF_INET, SOCK_DGRAM, 0);
+		sWakeSend = socket(AF_INET, SOCK_DGRAM, 0);
+		if (sWakeRecv == INVALID_SOCKET || sWakeSend == INVALID_SOCKET
+			|| ::bind(sWakeRecv, (sockaddr*)&adr, sizeof(adr)) != 0
+			|| getsockname(sWakeRecv, (sockaddr*)&adr, &iLen) != 0
+			|| connect(sWakeSend, (sockaddr*)&adr, sizeof(adr)) != 0)
+		{
+			// without it the thread just polls for output more often
+			if (sWakeRecv != INVALID_SOCKET)
+				closesocket(sWakeRecv);
+			if (sWakeSend != INVALID_SOCKET)
+				closesocket(sWakeSend);
+			sWakeRecv = sWakeSend = INVALID_SOCKET;
+			return;
+		}
+
+		ulong lNB = 1;
+		ioctlsocket(sWakeRecv, FIONBIO, &lNB);
+		ioctlsocket(sWakeSend, FIONBIO, &lNB);
+	}
+
+	static void Wake()
+	{
+		if (sWakeSend != INVALID_SOCKET && !InterlockedExchange(&lWakePending, 1))
+			send(sWakeSend, "", 1, 0);
+	}
+
+	static void DrainWake()
+	{
+		InterlockedExchange(&lWakePending, 0);
+
+		char szBuf[64];
+		while (recv(sWakeRecv, szBuf, sizeof(szBuf), 0) > 0)
+			;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void AcceptConnections(SOCKET sListener, bool bUnicode, bool bEncrypted)
+	{
+		ulong lNB = 1;
+		ioctlsocket(sListener, FIONBIO, &lNB);
+
+		// new connections wait in the backlog while the game thread is busy
+		while (!queueIn.Full())
+		{
+			sockaddr_in adr;
+			int iLen = sizeof(adr);
+			SOCKET s = accept(sListener, (sockaddr*)&adr, &iLen);
+			if (s == INVALID_SOCKET)
+				return;
+
+			if (lstConnections.size() >= MAX_SOCKET_CONNECTIONS)
+			{
+				AddLog("socket: connection from %s:%d refused (too many connections)", inet_ntoa(adr.sin_addr), adr.sin_port);
+				closesocket(s);
+				continue;
+			}
+
+			ioctlsocket(s, FIONBIO, &lNB);
+			int iSndBuf = SOCKET_SNDBUF;
+			setsockopt(s, SOL_SOCKET, SO_SNDBUF, (const char*)&iSndBuf, sizeof(iSndBuf));
+
+			NET_CONNECTION *conn = new NET_CONNECTION;
+			conn->iConnID = iNextConnID++;
+			conn->s = s;
+			conn->sIP = inet_ntoa(adr.sin_addr);
+			conn->iPort = adr.sin_port;
+			conn->bUnicode = bUnicode;
+			conn->bEncrypted = bEncrypted;
+			conn->bAuthed = false;
+			conn->bClosed = false;
+			conn->bNotified = false;
+			conn->bEventMode = false;
+
+			// every connection keeps the key it was opened with, a rehash doesn't change it under the thread
+			if (bEncrypted)
+				conn->bfc = *set_BF_CTX;
+
+			lstConnections.push_back(conn);
+			mapConnections[conn->iConnID] = conn;
+
+			// "<ip> <port> <unicode> <encrypted>"
+			wchar_t wszInfo[64];
+			swprintf(wszInfo, L"%s %u %u %u", stows(conn->sIP).c_str(), (uint)conn->iPort, bUnicode ? 1 : 0, bEncrypted ? 1 : 0);
+			queueIn.Push(SOCKET_MSG_OPENED, conn->iConnID, wszInfo);
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// sends queued output until the socket would block
+	static void Flush(NET_CONNECTION *conn)
+	{
+		while (conn->rbOut.Size())
+		{
+			uint iLen;
+			const char *pData = conn->rbOut.ReadPtr(iLen);
+			int iSent = send(conn->s, pData, (int)iLen, 0);
+			if (iSent == SOCKET_ERROR)
+			{
+				if (WSAGetLastError() != WSAEWOULDBLOCK)
+					conn->bClosed = true;
+				return;
+			}
+
+			conn->rbOut.Consume((uint)iSent);
+		}
+	}
+
+	// converts the text to what the client expects, false if it can't be encrypted
+	static bool EncodeText(wstring &wscText, bool bUnicode, bool bEncrypted, BLOWFISH_CTX *bfc, string &scData)
+	{
+		for (uint i = 0; (i < wscText.length()); i++)
+		{
+			if (wscText[i] == '\n')
+			{
+				wscText.replace(i, 1, L"\r\n");
+				i++;
+			}
+		}
+
+		if (bUnicode)
+		{
+			// data to be encrypted has to be a multiple of 8 bytes, pad with 0x00s
+			if (bEncrypted && (wscText.length() % 4))
+				wscText.resize(wscText.length() + 4 - (wscText.length() % 4), L'\x00');
+			scData.assign((const char*)wscText.data(), wscText.length() * 2);
+		}
+		else
+		{
+			scData = wstos(wscText);
+			if (bEncrypted && (scData.length() % 8))
+				scData.resize(scData.length() + 8 - (scData.length() % 8), '\x00');
+		}
+
+		// encrypted in place, the clients expect big-endian blocks
+		if (bEncrypted && scData.length() && !Blowfish_EncryptBuffer(bfc, &scData[0], (unsigned long)scData.length()))
+			return false;
+
+		return true;
+	}
+
+	// queues encoded data without sending it, false (and the connection is closed) if the output queue is full
+	static bool AppendOutput(NET_CONNECTION *conn, const string &scData)
+	{
+		if (conn->rbOut.Write(scData.data(), (uint)scData.length()))
+			return true;
+
+		// the other side doesn't read (fast enough), don't buffer without limit
+		AddLog("socket: output queue of %s:%d full, closing connection", conn->sIP.c_str(), conn->iPort);
+		conn->bClosed = true;
+		return false;
+	}
+
+	static void QueueOutput(NET_CONNECTION *conn, wstring &wscText)
+	{
+		string scData;
+		if (EncodeText(wscText, conn->bUnicode, conn->bEncrypted, &conn->bfc, scData) && AppendOutput(conn, scData))
+			Flush(conn);
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	struct EVENT_FRAME
+	{
+		wstring wscTopic;
+		wstring wscLine;
+	};
+
+	// the frames of a batch encoded for one connection format, encoded on first use
+	struct EVENT_ENCODING
+	{
+		bool bUnicode;
+		bool bEncrypted;
+		BLOWFISH_CTX *bfc;
+		vector<string> vFrames;
+	};
+
+	static void SetEventMode(NET_CONNECTION *conn, const wstring &wscTopics)
+	{
+		conn->bEventMode = true;
+		conn->vTopics.clear();
+		for (uint i = 0;; i++)
+		{
+			wstring wscTopic = ToLower(GetParam(wscTopics, ' ', i));
+			if (!wscTopic.length())
+				break;
+			conn->vTopics.push_back(wscTopic);
+		}
+
+		sort(conn->vTopics.begin(), conn->vTopics.end());
+	}
+
+	static void ProcessEvents(const wstring &wscBatch)
+	{
+		// one event per line, the topic is the first word
+		vector<EVENT_FRAME> vFrames;
+		size_t iStart = 0;
+		size_t iEnd;
+		while ((iEnd = wscBatch.find(L'\n', iStart)) != wstring::npos)
+		{
+			vFrames.push_back(EVENT_FRAME());
+			EVENT_FRAME &frame = vFrames.back();
+			frame.wscLine = wscBatch.substr(iStart, iEnd - iStart + 1);
+			frame.wscTopic = ToLower(frame.wscLine.substr(0, frame.wscLine.find_first_of(L" \n")));
+			iStart = iEnd + 1;
+		}
+
+		list<EVENT_ENCODING> lstEncodings;
+		foreach(lstConnections, NET_CONNECTION*, i)
+		{
+			NET_CONNECTION *conn = *i;
+			if (!conn->bEventMode || conn->bClosed)
+				continue;
+
+			// connections of the same format share the encoded frames, encrypted ones only if the key is the same
+			EVENT_ENCODING *enc = 0;
+			foreach(lstEncodings, EVENT_ENCODING, e)
+			{
+				if (e->bUnicode == conn->bUnicode && e->bEncrypted == conn->bEncrypted
+					&& (!conn->bEncrypted || !memcmp(e->bfc, &conn->bfc, sizeof(BLOWFISH_CTX))))
+				{
+					enc = &(*e);
+					break;
+				}
+			}
+
+			if (!enc)
+			{
+				lstEncodings.push_back(EVENT_ENCODING());
+				enc = &lstEncodings.back();
+				enc->bUnicode = conn->bUnicode;
+				enc->bEncrypted = conn->bEncrypted;
+				enc->bfc = &conn->bfc;
+				enc->vFrames.resize(vFrames.size());
+			}
+
+			for (uint k = 0; k < vFrames.size(); k++)
+			{
+				if (conn->vTopics.size() && !binary_search(conn->vTopics.begin(), conn->vTopics.end(), vFrames[k].wscTopic))
+					continue;
+
+				// an encoded frame is never empty, it contains at least the line break
+				if (enc->vFrames[k].empty())
+				{
+					wstring wscLine = vFrames[k].wscLine;
+					EncodeText(wscLine, enc->bUnicode, enc->bEncrypted, enc->bfc, enc->vFrames[k]);
+				}
+
+				if (!AppendOutput(conn, enc->vFrames[k]))
+					break;
+			}
+
+			if (!conn->bClosed)
+				Flush(conn);
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void ProcessOutput()
+	{
+		SOCKET_MESSAGE msg;
+		while (queueOut.Pop(msg))
+		{
+			if (msg.eType == SOCKET_MSG_EVENTS)
+			{
+				ProcessEvents(msg.wscText);
+				continue;
+			}
+
+			map<uint, NET_CONNECTION*>::iterator it = mapConnections.find(msg.iConnID);
+			if (it == mapConnections.end() || it->second->bClosed)
+				continue;
+
+			NET_CONNECTION *conn = it->second;
+			if (msg.eType == SOCKET_MSG_TEXT)
+				QueueOutput(conn, msg.wscText);
+			else if (msg.eType == SOCKET_MSG_AUTHED)
+				conn->bAuthed = true;
+			else if (msg.eType == SOCKET_MSG_EVENTMODE)
+				SetEventMode(conn, msg.wscText);
+			else if (msg.eType == SOCKET_MSG_CLOSE)
+			{
+				// send what's left (e.g. "Goodbye.") before the socket is closed
+				Flush(conn);
+				conn->bClosed = true;
+				conn->bNotified = true;
+			}
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// reads everything available into rbIn, false if the connection was closed
+	static bool Receive(NET_CONNECTION *conn)
+	{
+		for (;;)
+		{
+			uint iLen;
+			char *pData = conn->rbIn.WritePtr(iLen);
+			if (!pData)
+				return true;
+
+			int iRead = recv(conn->s, pData, (int)iLen, 0);
+			if (!iRead)
+				return false;
+			if (iRead == SOCKET_ERROR)
+				return (WSAGetLastError() == WSAEWOULDBLOCK);
+
+			conn->rbIn.Commit((uint)iRead);
+			if ((uint)iRead < iLen)
+				return true;
+		}
+	}
+
+	// decodes the received bytes into wscPending, false if the connection has to be closed
+	static bool DecodeInput(NET_CONNECTION *conn)
+	{
+		// encrypted data is decrypted in whole blocks, unicode text in whole characters
+		uint iUnit = conn->bEncrypted ? 8 : (conn->bUnicode ? 2 : 1);
+
+		wstring wscData;
+		char szBuf[4096];
+		for (;;)
+		{
+			uint iLen;
+			const char *pData = conn->rbIn.ReadPtr(iLen);
+			iLen = min(iLen, (uint)sizeof(szBuf));
+			if (iLen < iUnit)
+			{
+				// the unit may be split at the end of the ring, copy it out piece by piece
+				if (conn->rbIn.Size() < iUnit)
+					break;
+				iLen = 0;
+				while (iLen < iUnit)
+				{
+					uint iPart;
+					pData = conn->rbIn.ReadPtr(iPart);
+					iPart = min(iPart, iUnit - iLen);
+					memcpy(szBuf + iLen, pData, iPart);
+					conn->rbIn.Consume(iPart);
+					iLen += iPart;
+				}
+			}
+			else
+			{
+				iLen -= iLen % iUnit;
+				memcpy(szBuf, pData, iLen);
+				conn->rbIn.Consume(iLen);
+			}
+
+			if (conn->bEncrypted)
+				Blowfish_DecryptBuffer(&conn->bfc, szBuf, iLen);
+
+			if (conn->bUnicode)
+				wscData.append((wchar_t*)szBuf, iLen / 2);
+			else
+				wscData += stows(string(szBuf, iLen));
+		}
+
+		// drop the 0x00s encrypted clients pad their data with
+		wscData.erase(remove(wscData.begin(), wscData.end(), L'\0'), wscData.end());
+
+		// check for memory overflow ddos attack
+		uint iMaxKB = conn->bAuthed ? 500 : 1;
+		if ((conn->wscPending.length() + wscData.length()) > (1024 * iMaxKB)) {
+			ConPrint(L"socket: socket connection closed (possible ddos attempt)\n");
+			AddLog("socket: socket connection from %s:%d closed (possible ddos attempt)", conn->sIP.c_str(), conn->iPort);
+			return false;
+		}
+
+		conn->wscPending += wscData;
+		return true;
+	}
+
+	// hands the complete lines (terminated by \n) to the game thread, false if the queue is full
+	static bool HandOverCommands(NET_CONNECTION *conn)
+	{
+		bool bDone = true;
+		size_t iStart = 0;
+		size_t iEnd;
+		while ((iEnd = conn->wscPending.find(L'\n', iStart)) != wstring::npos)
+		{
+			size_t iCmdEnd = (iEnd > iStart && conn->wscPending[iEnd - 1] == L'\r') ? (iEnd - 1) : iEnd;
+			if (!queueIn.Push(SOCKET_MSG_COMMAND, conn->iConnID, conn->wscPending.substr(iStart, iCmdEnd - iStart)))
+			{
+				bDone = false;
+				break;
+			}
+			iStart = iEnd + 1;
+		}
+
+		conn->wscPending.erase(0, iStart);
+		return bDone;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	static void Poll()
+	{
+		SOCKET_SET setRead, setWrite;
+		setRead.fd_count = 0;
+		setWrite.fd_count = 0;
+
+		SOCKET arrListeners[] = { sListen, sWListen, sEListen, sEWListen, sWakeRecv };
+		for (uint i = 0; i < sizeof(arrListeners) / sizeof(SOCKET); i++)
+		{
+			if (arrListeners[i] != INVALID_SOCKET)
+				setRead.fd_array[setRead.fd_count++] = arrListeners[i];
+		}
+
+		bool bBlocked = false;
+		foreach(lstConnections, NET_CONNECTION*, i)
+		{
+			NET_CONNECTION *conn = *i;
+			if (conn->bClosed)
+				continue;
+
+			// connections with lines the game thread couldn't take yet aren't read from
+			if (!HandOverCommands(conn))
+				bBlocked = true;
+			else
+				setRead.fd_array[setRead.fd_count++] = conn->s;
+
+			if (conn->rbOut.Size())
+				setWrite.fd_array[setWrite.fd_count++] = conn->s;
+		}
+
+		timeval tv = { 0, 1000 * ((bBlocked || sWakeRecv == INVALID_SOCKET) ? 10 : SOCKET_WAIT_MS) };
+		if (!setRead.fd_count)
+		{
+			Sleep(tv.tv_usec / 1000);
+			setWrite.fd_count = 0;
+		}
+		else if (select(0, (fd_set*)&setRead, (fd_set*)&setWrite, 0, &tv) <= 0)
+			setRead.fd_count = setWrite.fd_count = 0;
+
+		if (sWakeRecv != INVALID_SOCKET && FD_ISSET(sWakeRecv, (fd_set*)&setRead))
+			DrainWake();
+		ProcessOutput();
+
+		// new connections
+		if (sListen != INVALID_SOCKET && FD_ISSET(sListen, (fd_set*)&setRead))
+			AcceptConnections(sListen, false, false);
+		if (sWListen != INVALID_SOCKET && FD_ISSET(sWListen, (fd_set*)&setRead))
+			AcceptConnections(sWListen, true, false);
+		if (sEListen != INVALID_SOCKET && FD_ISSET(sEListen, (fd_set*)&setRead))
+			AcceptConnections(sEListen, false, true);
+		if (sEWListen != INVALID_SOCKET && FD_ISSET(sEWListen, (fd_set*)&setRead))
+			AcceptConnections(sEWListen, true, true);
+
+		// pending output and input
+		for (list<NET_CONNECTION*>::iterator i = lstConnections.begin(); i != lstConnections.end(); )
+		{
+			NET_CONNECTION *conn = *i;
+			if (!conn->bClosed && FD_ISSET(conn->s, (fd_set*)&setWrite))
+				Flush(conn);
+
+			if (!conn->bClosed && FD_ISSET(conn->s, (fd_set*)&setRead))
+			{
+				if (!Receive(conn))
+					conn->bClosed = true;
+				else if (!DecodeInput(conn))
+					conn->bClosed = true;
+				else
+					HandOverCommands(conn);
+			}
+
+			// the game thread has to forget the connection before its id goes away
+			if (conn->bClosed && !conn->bNotified)
+				conn->bNotified = queueIn.Push(SOCKET_MSG_CLOSED, conn->iConnID, L"");
+
+			if (conn->bClosed && conn->bNotified)
+			{
+				closesocket(conn->s);
+				mapConnections.erase(conn->iConnID);
+				delete conn;
+				i = lstConnections.erase(i);
+			}
+			else
+				i++;
+		}
+	}
+
+	static DWORD WINAPI NetThread(LPVOID lpParam)
+	{
+		while (!bStop)
+		{
+			try {
+				Poll();
+			}
+			catch (...) { LOG_EXCEPTION }
+		}
+
+		return 0;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	void Start()
+	{
+		if (hNetThread)
+			return;
+
+		CreateWakeSockets();
+		bStop = false;
+		DWORD dwID;
+		hNetThread = CreateThread(0, 0, NetThread, 0, 0, &dwID);
+	}
+
+	void Stop()
+	{
+		if (!hNetThread)
+			return;
+
+		bStop = true;
+		Wake();
+		WaitForSingleObject(hNetThread, INFINITE);
+		CloseHandle(hNetThread);
+		hNetThread = 0;
+
+		foreach(lstConnections, NET_CONNECTION*, i)
+		{
+			closesocket((*i)->s);
+			delete *i;
+		}
+		lstConnections.clear();
+		mapConnections.clear();
+
+		if (sWakeRecv != INVALID_SOCKET)
+			closesocket(sWakeRecv);
+		if (sWakeSend != INVALID_SOCKET)
+			closesocket(sWakeSend);
+		sWakeRecv = sWakeSend = INVALID_SOCKET;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+	// game thread side
+	bool Receive(SOCKET_MESSAGE &msg)
+	{
+		return queueIn.Pop(msg);
+	}
+
+	bool Send(SOCKET_MESSAGE_TYPE eType, uint iConnID, const wstring &wscText)
+	{
+		if (!queueOut.Push(eType, iConnID, wscText))
+			return false;
+
+		Wake();
+		return true;
+	}
+}
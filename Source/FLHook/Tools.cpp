@@ -100,8 +100,15 @@ wstring ToMoneyStr(int iCash)
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// the Ini* tools read and write through the parsed documents of IniCache, files it can't handle go through
+// the profile api like before
 string IniGetS(const string &scFile, const string &scApp, const string &scKey, const string &scDefault)
 {
+	string scValue;
+	bool bFound;
+	if (IniCache::Get(scFile, scApp, scKey, scValue, bFound))
+		return bFound ? scValue : scDefault;
+
 	char szRet[2048 * 2];
 	GetPrivateProfileString(scApp.c_str(), scKey.c_str(), scDefault.c_str(), szRet, sizeof(szRet), scFile.c_str());
 	return szRet;
@@ -111,13 +118,31 @@ string IniGetS(const string &scFile, const string &scApp, const string &scKey, c
 
 int IniGetI(const string &scFile, const string &scApp, const string &scKey, int iDefault)
 {
-	return GetPrivateProfileInt(scApp.c_str(), scKey.c_str(), iDefault, scFile.c_str());
+	string scValue;
+	bool bFound;
+	if (!IniCache::Get(scFile, scApp, scKey, scValue, bFound))
+		return GetPrivateProfileInt(scApp.c_str(), scKey.c_str(), iDefault, scFile.c_str());
+
+	if (!bFound)
+		return iDefault;
+
+	// parsed like GetPrivateProfileInt: decimal with optional sign or 0x hex, 0 if there's no number
+	const char *szValue = scValue.c_str();
+	if (szValue[0] == '0' && (szValue[1] == 'x' || szValue[1] == 'X'))
+		return (int)strtoul(szValue + 2, 0, 16);
+
+	return (int)strtol(szValue, 0, 10);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 float IniGetF(const string &scFile, const string &scApp, const string &scKey, float fDefault)
 {
+	string scValue;
+	bool bFound;
+	if (IniCache::Get(scFile, scApp, scKey, scValue, bFound))
+		return bFound ? (float)atof(scValue.c_str()) : fDefault;
+
 	char szRet[2048 * 2];
 	char szDefault[16];
 	sprintf(szDefault, "%f", fDefault);
@@ -136,7 +161,8 @@ bool IniGetB(const string &scFile, const string &scApp, const string &scKey, boo
 
 void IniWrite(const string &scFile, const string &scApp, const string &scKey, const string &scValue)
 {
-	WritePrivateProfileString(scApp.c_str(), scKey.c_str(), scValue.c_str(), scFile.c_str());
+	if (!IniCache::Write(scFile, scApp, scKey, scValue))
+		WritePrivateProfileString(scApp.c_str(), scKey.c_str(), scValue.c_str(), scFile.c_str());
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -152,16 +178,14 @@ void IniWriteW(const string &scFile, const string &scApp, const string &scKey, c
 		sprintf(szBuf, "%02X%02X", ((uint)cHiByte) & 0xFF, ((uint)cLoByte) & 0xFF);
 		scValue += szBuf;
 	}
-	WritePrivateProfileString(scApp.c_str(), scKey.c_str(), scValue.c_str(), scFile.c_str());
+	IniWrite(scFile, scApp, scKey, scValue);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 wstring IniGetWS(const string &scFile, const string &scApp, const string &scKey, const wstring &wscDefault)
 {
-	char szRet[2048 * 2];
-	GetPrivateProfileString(scApp.c_str(), scKey.c_str(), "", szRet, sizeof(szRet), scFile.c_str());
-	string scValue = szRet;
+	string scValue = IniGetS(scFile, scApp, scKey, "");
 	if (!scValue.length())
 		return wscDefault;
 
@@ -182,20 +206,25 @@ wstring IniGetWS(const string &scFile, const string &scApp, const string &scKey,
 
 void IniDelete(const string &scFile, const string &scApp, const string &scKey)
 {
-	WritePrivateProfileString(scApp.c_str(), scKey.c_str(), NULL, scFile.c_str());
+	if (!IniCache::Delete(scFile, scApp, scKey))
+		WritePrivateProfileString(scApp.c_str(), scKey.c_str(), NULL, scFile.c_str());
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void IniDelSection(const string &scFile, const string &scApp)
 {
-	WritePrivateProfileString(scApp.c_str(), NULL, NULL, scFile.c_str());
+	if (!IniCache::DelSection(scFile, scApp))
+		WritePrivateProfileString(scApp.c_str(), NULL, NULL, scFile.c_str());
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 void IniGetSection(const string &scFile, const string &scApp, list<INISECTIONVALUE> &lstValues)
 {
+	if (IniCache::GetSection(scFile, scApp, lstValues))
+		return;
+
 	lstValues.clear();
 	char szBuf[0xFFFF];
 	GetPrivateProfileSection(scApp.c_str(), szBuf, sizeof(szBuf), scFile.c_str());
@@ -216,6 +245,25 @@ void IniGetSection(const string &scFile, const string &scApp, list<INISECTIONVAL
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**************************************************************************************************************
+Defer the file writes of the Ini* tools, every file written to in between is stored once by the matching
+IniEndBatch. Batches can be nested.
+**************************************************************************************************************/
+
+void IniBeginBatch()
+{
+	IniCache::BeginBatch();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void IniEndBatch()
+{
+	IniCache::EndBatch();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 wstring XMLText(const wstring &wscText)
 {
 	wstring wscRet;
@@ -301,10 +349,13 @@ wstring ReplaceStr(const wstring &wscSource, const wstring &wscSearchFor, const
 
 mstime timeInMS()
 {
+	// the frequency is fixed at system boot, no need to query it on every call
+	static mstime iFreq = 0;
+	if (!iFreq)
+		QueryPerformanceFrequency((LARGE_INTEGER*)&iFreq);
+
 	mstime iCount;
 	QueryPerformanceCounter((LARGE_INTEGER*)&iCount);
-	mstime iFreq;
-	QueryPerformanceFrequency((LARGE_INTEGER*)&iFreq);
 	return 1000 * iCount / iFreq;
 }
 
@@ -482,6 +533,8 @@ void AddExceptionInfoLog(LPEXCEPTION_POINTERS pep)
 			AddLog("No register information available");
 		}
 
+		// the process might not survive this, get the lines above onto the disk
+		Logger::Flush();
 		WriteMiniDump(pep);
 
 	}
@@ -57,6 +57,7 @@ have time to provide unpaid support for everyone who uses this code.
 
 
 #include "blowfish.h"
+#include <stdlib.h>
 
 #define N               16
 
@@ -328,114 +329,142 @@ static const unsigned long ORIG_S[4][256] = {
 };
 
 
-static unsigned long F(BLOWFISH_CTX *ctx, unsigned long x) {
-	unsigned short a, b, c, d;
-	unsigned long  y;
-
-	d = (unsigned short)(x & 0xFF);
-	x >>= 8;
-	c = (unsigned short)(x & 0xFF);
-	x >>= 8;
-	b = (unsigned short)(x & 0xFF);
-	x >>= 8;
-	a = (unsigned short)(x & 0xFF);
-	y = ctx->S[0][a] + ctx->S[1][b];
-	y = y ^ ctx->S[2][c];
-	y = y + ctx->S[3][d];
+/*
+The rounds are unrolled and F() is inlined, the S-box lookups take the bytes
+straight from the word. Blowfish_EncryptBuffer/Blowfish_DecryptBuffer work on
+big-endian words, which is what the socket clients send (the same as calling
+SwapBytes before and after Blowfish_Encrypt/Blowfish_Decrypt), the byte order
+is converted while loading and storing the blocks.
+*/
 
-	return y;
+#define F(S, x) ((((S)[0][(x) >> 24] + (S)[1][((x) >> 16) & 0xFF]) ^ (S)[2][((x) >> 8) & 0xFF]) + (S)[3][(x) & 0xFF])
+
+#define ROUND(S, P, a, b, n) \
+	a ^= (P)[n]; \
+	b ^= F(S, a);
+
+static __forceinline void Encrypt64(const BLOWFISH_CTX *ctx, unsigned long *xl, unsigned long *xr) {
+	const unsigned long (*S)[256] = ctx->S;
+	const unsigned long *P = ctx->P;
+	unsigned long Xl = *xl;
+	unsigned long Xr = *xr;
+
+	ROUND(S, P, Xl, Xr, 0);
+	ROUND(S, P, Xr, Xl, 1);
+	ROUND(S, P, Xl, Xr, 2);
+	ROUND(S, P, Xr, Xl, 3);
+	ROUND(S, P, Xl, Xr, 4);
+	ROUND(S, P, Xr, Xl, 5);
+	ROUND(S, P, Xl, Xr, 6);
+	ROUND(S, P, Xr, Xl, 7);
+	ROUND(S, P, Xl, Xr, 8);
+	ROUND(S, P, Xr, Xl, 9);
+	ROUND(S, P, Xl, Xr, 10);
+	ROUND(S, P, Xr, Xl, 11);
+	ROUND(S, P, Xl, Xr, 12);
+	ROUND(S, P, Xr, Xl, 13);
+	ROUND(S, P, Xl, Xr, 14);
+	ROUND(S, P, Xr, Xl, 15);
+
+	*xl = Xr ^ P[N + 1];
+	*xr = Xl ^ P[N];
 }
 
 
-void Encrypt64(BLOWFISH_CTX *ctx, unsigned long *xl, unsigned long *xr) {
-	unsigned long  Xl;
-	unsigned long  Xr;
-	unsigned long  temp;
-	short       i;
-
-	Xl = *xl;
-	Xr = *xr;
+static __forceinline void Decrypt64(const BLOWFISH_CTX *ctx, unsigned long *xl, unsigned long *xr) {
+	const unsigned long (*S)[256] = ctx->S;
+	const unsigned long *P = ctx->P;
+	unsigned long Xl = *xl;
+	unsigned long Xr = *xr;
+
+	ROUND(S, P, Xl, Xr, 17);
+	ROUND(S, P, Xr, Xl, 16);
+	ROUND(S, P, Xl, Xr, 15);
+	ROUND(S, P, Xr, Xl, 14);
+	ROUND(S, P, Xl, Xr, 13);
+	ROUND(S, P, Xr, Xl, 12);
+	ROUND(S, P, Xl, Xr, 11);
+	ROUND(S, P, Xr, Xl, 10);
+	ROUND(S, P, Xl, Xr, 9);
+	ROUND(S, P, Xr, Xl, 8);
+	ROUND(S, P, Xl, Xr, 7);
+	ROUND(S, P, Xr, Xl, 6);
+	ROUND(S, P, Xl, Xr, 5);
+	ROUND(S, P, Xr, Xl, 4);
+	ROUND(S, P, Xl, Xr, 3);
+	ROUND(S, P, Xr, Xl, 2);
+
+	*xl = Xr ^ P[0];
+	*xr = Xl ^ P[1];
+}
 
-	for (i = 0; i < N; ++i) {
-		Xl = Xl ^ ctx->P[i];
-		Xr = F(ctx, Xl) ^ Xr;
 
-		temp = Xl;
-		Xl = Xr;
-		Xr = temp;
-	}
+char Blowfish_Encrypt(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen)
+{
+	unsigned long i;
+	unsigned long *data = (unsigned long *)ptr;
 
-	temp = Xl;
-	Xl = Xr;
-	Xr = temp;
+	if (dataLen % 8)
+		return 0;
 
-	Xr = Xr ^ ctx->P[N];
-	Xl = Xl ^ ctx->P[N + 1];
+	for (i = 0; i < dataLen / 4; i += 2)
+		Encrypt64(ctx, &data[i], &data[i + 1]);
 
-	*xl = Xl;
-	*xr = Xr;
+	return 1;
 }
 
 
-void Decrypt64(BLOWFISH_CTX *ctx, unsigned long *xl, unsigned long *xr) {
-	unsigned long  Xl;
-	unsigned long  Xr;
-	unsigned long  temp;
-	short       i;
-
-	Xl = *xl;
-	Xr = *xr;
-
-	for (i = N + 1; i > 1; --i) {
-		Xl = Xl ^ ctx->P[i];
-		Xr = F(ctx, Xl) ^ Xr;
-
-		/* Exchange Xl and Xr */
-		temp = Xl;
-		Xl = Xr;
-		Xr = temp;
-	}
+char Blowfish_Decrypt(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen)
+{
+	unsigned long i;
+	unsigned long *data = (unsigned long *)ptr;
 
-	/* Exchange Xl and Xr */
-	temp = Xl;
-	Xl = Xr;
-	Xr = temp;
+	if (dataLen % 8)
+		return 0;
 
-	Xr = Xr ^ ctx->P[1];
-	Xl = Xl ^ ctx->P[0];
+	for (i = 0; i < dataLen / 4; i += 2)
+		Decrypt64(ctx, &data[i], &data[i + 1]);
 
-	*xl = Xl;
-	*xr = Xr;
+	return 1;
 }
 
 
-char Blowfish_Encrypt(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen)
+char Blowfish_EncryptBuffer(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen)
 {
 	unsigned long i;
+	unsigned long *data = (unsigned long *)ptr;
 
 	if (dataLen % 8)
 		return 0;
 
-	for (i = 0; i < dataLen; i += 8)
+	for (i = 0; i < dataLen / 4; i += 2)
 	{
-
-		Encrypt64(ctx, (unsigned long *)((char*)ptr + i), (unsigned long *)((char*)ptr + i + 4));
+		unsigned long xl = _byteswap_ulong(data[i]);
+		unsigned long xr = _byteswap_ulong(data[i + 1]);
+		Encrypt64(ctx, &xl, &xr);
+		data[i] = _byteswap_ulong(xl);
+		data[i + 1] = _byteswap_ulong(xr);
 	}
 
 	return 1;
 }
 
 
-char Blowfish_Decrypt(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen)
+char Blowfish_DecryptBuffer(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen)
 {
 	unsigned long i;
+	unsigned long *data = (unsigned long *)ptr;
 
 	if (dataLen % 8)
 		return 0;
 
-	for (i = 0; i < dataLen; i += 8)
+	for (i = 0; i < dataLen / 4; i += 2)
 	{
-		Decrypt64(ctx, (unsigned long *)((char*)ptr + i), (unsigned long *)((char*)ptr + i + 4));
+		unsigned long xl = _byteswap_ulong(data[i]);
+		unsigned long xr = _byteswap_ulong(data[i + 1]);
+		Decrypt64(ctx, &xl, &xr);
+		data[i] = _byteswap_ulong(xl);
+		data[i + 1] = _byteswap_ulong(xr);
 	}
 
 	return 1;
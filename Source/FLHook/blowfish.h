@@ -29,6 +29,8 @@ typedef struct {
 EXPORT void Blowfish_Init(BLOWFISH_CTX *ctx, unsigned char *key, int keyLen);
 EXPORT char Blowfish_Encrypt(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen);
 EXPORT char Blowfish_Decrypt(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen);
+EXPORT char Blowfish_EncryptBuffer(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen); // big-endian words, see blowfish.cpp
+EXPORT char Blowfish_DecryptBuffer(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen);
 
 
 
@@ -38,147 +38,144 @@ EDITED by mc_horst for use in FLHook
 /* Very Secret Key - this is Microsoft Security In Action[tm] */
 const char gene[] = "Gene";
 
-bool flc_decode(const char *ifile, const char *ofile)
+/*
+the key byte for offset i is ((gene[i % 4] + i) % 256) | 0x80, so the keystream repeats every 256 bytes.
+it is built once and XORed 16 bytes at a time (SSE2), define FLC_NO_SSE2 for the plain byte loop.
+*/
+
+#ifndef FLC_NO_SSE2
+#include <emmintrin.h>
+#endif
+
+static unsigned char keystream[256];
+static bool keystream_init = false;
+
+static void flc_init_keystream()
 {
-	int ifd, ofd, i, l, len, rc;
-	char *mem, *buff, c, k, r;
+	int i;
 
-	ifd = _open(ifile, O_RDONLY | _O_BINARY);
+	for (i = 0; i < 256; i++)
+		keystream[i] = (unsigned char)(((gene[i % 4] + i) % 256) | 0x80);
+	keystream_init = true;
+}
+
+static void flc_xor(const char *ibuf, int len, char *obuf)
+{
+	int i = 0;
 
+	if (!keystream_init)
+		flc_init_keystream();
+
+#ifndef FLC_NO_SSE2
+	for (; i + 16 <= len; i += 16) {
+		__m128i data = _mm_loadu_si128((const __m128i*)(ibuf + i));
+		__m128i key = _mm_loadu_si128((const __m128i*)(keystream + (i & 255)));
+		_mm_storeu_si128((__m128i*)(obuf + i), _mm_xor_si128(data, key));
+	}
+#endif
+
+	for (; i < len; i++)
+		obuf[i] = ibuf[i] ^ keystream[i & 255];
+}
+
+static char *flc_read_file(const char *ifile, int *len)
+{
+	int ifd, rc;
+	char *mem;
+
+	ifd = _open(ifile, O_RDONLY | _O_BINARY);
 	if (ifd == -1)
-		return false;
+		return NULL;
 
-	len = _lseek(ifd, 0, SEEK_END);
+	*len = _lseek(ifd, 0, SEEK_END);
 	_lseek(ifd, 0, SEEK_SET);
 
-	mem = (char*)malloc(len + 1);
+	mem = (char*)malloc(*len + 4);
 	if (mem == NULL)
 	{
 		_close(ifd);
-		return false;
+		return NULL;
 	}
 
-	rc = _read(ifd, mem, len);
-	/*  if(rc != len)
-	  {
-		  free(mem);
-		  close(ifd);
-		  return false;
-	  } */
-
+	rc = _read(ifd, mem, *len);
 	_close(ifd);
-
-	if (strncmp(mem, "FLS1", 4) != 0)
+	if (rc != *len)
 	{
 		free(mem);
-		return false;
+		return NULL;
 	}
 
+	return mem;
+}
+
+static bool flc_write_file(const char *ofile, const char *buff, int len)
+{
+	int ofd, rc;
+
 	ofd = _open(ofile, O_CREAT | O_TRUNC | O_WRONLY | _O_BINARY, 0640);
 	if (ofd == -1)
-	{
-		free(mem);
 		return false;
-	}
-
-	/* skip FLS1 */
-	buff = mem + 4;
-	l = len - 4;
-
-	i = 0;
-	while (i < l) {
 
-		c = buff[i];
-		k = (gene[i % 4] + i) % 256;
+	rc = _write(ofd, buff, len);
+	_close(ofd);
+	return rc == len;
+}
 
-		r = c ^ (k | 0x80);
+bool flc_decode(const char *ifile, const char *ofile)
+{
+	int len;
+	char *mem;
+	bool ret;
 
-		rc = _write(ofd, &r, 1);
-		if (rc != 1)
-		{
-			free(mem);
-			_close(ofd);
-			return false;
-		}
+	mem = flc_read_file(ifile, &len);
+	if (mem == NULL)
+		return false;
 
-		i++;
-	}
+	/* decode in place, the output is the input minus the magic token */
+	ret = flc_decode_buf(mem, len, mem) && flc_write_file(ofile, mem, len - 4);
 
 	free(mem);
-	_close(ofd);
-	return true;
+	return ret;
 }
 
 bool flc_encode(const char *ifile, const char *ofile)
 {
-	int ifd, ofd, i, l, len, rc;
-	char *mem, *buff, c, k, r;
-
-	ifd = _open(ifile, O_RDONLY | _O_BINARY);
-
-	if (ifd == -1)
-		return false;
-
-	len = _lseek(ifd, 0, SEEK_END);
-	_lseek(ifd, 0, SEEK_SET);
+	int len;
+	char *mem, *out;
+	bool ret;
 
-	mem = (char*)malloc(len + 1);
-	memset(mem, 0, len + 1);
+	mem = flc_read_file(ifile, &len);
 	if (mem == NULL)
-	{
-		_close(ifd);
 		return false;
-	}
-
-	rc = _read(ifd, mem, len);
-	/*  if (rc != len)
-	  {
-			free(mem);
-			close(ifd);
-			return false;
-	  } */
-
-	_close(ifd);
 
-	ofd = _open(ofile, O_CREAT | O_TRUNC | O_WRONLY | _O_BINARY, 0640);
-	if (ofd == -1)
+	out = (char*)malloc(len + 4);
+	if (out == NULL)
 	{
 		free(mem);
 		return false;
 	}
 
+	ret = flc_encode_buf(mem, len, out) && flc_write_file(ofile, out, len + 4);
 
-	buff = mem;
-	l = len;
+	free(out);
+	free(mem);
+	return ret;
+}
 
-	/* write magic token */
-	rc = _write(ofd, "FLS1", 4);
-	if (rc != 4)
-	{
-		free(mem);
-		_close(ofd);
+bool flc_decode_buf(const char *ibuf, int len, char *obuf)
+{
+	if (len < 4 || strncmp(ibuf, "FLS1", 4) != 0)
 		return false;
-	}
-
-	i = 0;
-	while (i < l) {
 
-		c = buff[i];
-		k = (gene[i % 4] + i) % 256;
-
-		r = c ^ (k | 0x80);
-
-		rc = _write(ofd, &r, 1);
-		if (rc != 1)
-		{
-			free(mem);
-			_close(ofd);
-			return false;
-		}
+	/* skip FLS1 */
+	flc_xor(ibuf + 4, len - 4, obuf);
+	return true;
+}
 
-		i++;
-	}
-	free(mem);
-	_close(ofd);
+bool flc_encode_buf(const char *ibuf, int len, char *obuf)
+{
+	/* write magic token, obuf may not overlap ibuf */
+	memcpy(obuf, "FLS1", 4);
+	flc_xor(ibuf, len, obuf + 4);
 	return true;
 }
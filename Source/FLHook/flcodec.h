@@ -4,4 +4,8 @@
 EXPORT bool flc_decode(const char *ifile, const char *ofile);
 EXPORT bool flc_encode(const char *ifile, const char *ofile);
 
+/* in-memory variants: decode writes len - 4 bytes (obuf may be ibuf), encode len + 4 bytes to obuf */
+EXPORT bool flc_decode_buf(const char *ibuf, int len, char *obuf);
+EXPORT bool flc_encode_buf(const char *ibuf, int len, char *obuf);
+
 #endif
\ No newline at end of file
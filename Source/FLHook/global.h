@@ -94,6 +94,7 @@ EXPORT void ProcessEvent(wstring wscText, ...);
 EXPORT void SendChatEvent(uint iClientID, uint iToID, wstring &wscMsg);
 void LoadSettings();
 void ProcessPendingCommands();
+void FlushEvents();
 
 // tools
 EXPORT wstring stows(const string &scText);
@@ -120,6 +121,8 @@ EXPORT wstring IniGetWS(const string &scFile, const string &scApp, const string
 EXPORT wstring ToMoneyStr(int iCash);
 EXPORT float IniGetF(const string &scFile, const string &scApp, const string &scKey, float fDefault);
 EXPORT void IniGetSection(const string &scFile, const string &scApp, list<INISECTIONVALUE> &lstValues);
+EXPORT void IniBeginBatch();
+EXPORT void IniEndBatch();
 EXPORT float ToFloat(const wstring &wscStr);
 EXPORT mstime timeInMS();
 EXPORT void SwapBytes(void *ptr, uint iLen);
@@ -142,8 +145,6 @@ extern EXPORT _GetWCString GetWCString;
 extern EXPORT _WStringAssign WStringAssign;
 extern EXPORT _WStringAppend WStringAppend;
 extern EXPORT _CPlayerAccount_GetServerSignature CPlayerAccount_GetServerSignature;
-extern EXPORT FILE *fLog;
-extern EXPORT FILE *fLogDebug;
 extern EXPORT FARPROC fpOldUpdate;
 extern EXPORT string sDebugLog;
 
@@ -204,5 +205,9 @@ extern EXPORT bool	set_bLogSocketCmds;
 extern EXPORT bool	set_bLogLocalSocketCmds;
 extern EXPORT bool	set_bLogUserCmds;
 extern EXPORT bool	set_bPerfTimer;
+extern EXPORT bool	set_bPerfStats;
+extern EXPORT uint	set_iPerfStatsDumpInterval;
+extern EXPORT uint	set_iFrameBudget;
+extern EXPORT uint	set_iFrameStatsEventInterval;
 
 #endif
@@ -25,7 +25,10 @@
 #include <stdio.h>
 #include <string>
 #include <list>
+#include <vector>
+#include <map>
 #include <time.h>
+#include <intrin.h>
 using namespace std;
 
 
@@ -236,10 +239,28 @@ struct MONEY_FIX
 };
 
 // ignore
+enum IGNORE_FLAGS
+{
+	IGNORE_PRIVATE = 1,		// "p", only private chat
+	IGNORE_SUBSTRING = 2,	// "i", charname contains wscCharname
+};
+
 struct IGNORE_INFO
 {
 	wstring wscCharname;
 	wstring wscFlags;
+	// compiled from the above by FLHook
+	wstring wscCharnameLower;
+	uint iFlags;
+};
+
+// the last hull hit of a player, only kept as the few values the death message needs
+struct DAMAGE_INFO
+{
+	uint iInflictorShip;
+	uint iInflictorClient;
+	uint iCause;
+	mstime tmTime;
 };
 
 struct CLIENT_INFO
@@ -249,7 +270,7 @@ struct CLIENT_INFO
 	uint		iShipOld;
 	mstime		tmSpawnTime;
 
-	DamageList	dmgLast;
+	DAMAGE_INFO	dmgLast;
 
 	// money cmd
 	list<MONEY_FIX> lstMoneyFix;
@@ -370,6 +391,20 @@ struct HKPLAYERINFO
 	wstring wscIP;
 };
 
+// cached state of a player, see PlayerIndex::GetPlayer
+struct PLAYER_SNAPSHOT
+{
+	uint iClientID;
+	uint iGeneration; // changes whenever one of the fields below changes
+	wstring wscCharname;
+	wstring wscBase;
+	wstring wscSystem;
+	uint iBase;
+	uint iSystem;
+	uint iShip;
+	wstring wscIP;
+};
+
 // patch stuff
 struct PATCH_INFO_ENTRY
 {
@@ -464,6 +499,7 @@ IMPORT HK_ERROR HkMsg(const wstring &wscCharname, const wstring &wscMessage);
 IMPORT HK_ERROR HkMsgS(const wstring &wscSystemname, const wstring &wscMessage);
 IMPORT HK_ERROR HkMsgU(const wstring &wscMessage);
 IMPORT HK_ERROR HkFMsgEncodeXML(const wstring &wscXML, char *szBuf, uint iSize, uint &iRet);
+IMPORT HK_ERROR HkFMsgEncodeMsg(const wstring &wscTRA, const wstring &wscText, char *szBuf, uint iSize, uint &iRet);
 IMPORT HK_ERROR HkFMsgSendChat(uint iClientID, char *szBuf, uint iSize);
 IMPORT HK_ERROR HkFMsg(uint iClientID, const wstring &wscXML);
 IMPORT HK_ERROR HkFMsg(const wstring &wscCharname, const wstring &wscXML);
@@ -509,6 +545,22 @@ IMPORT void HkAddAdminCmdLog(const char *szString, ...);
 IMPORT void HkAddUserCmdLog(const char *szString, ...);
 IMPORT void HkAddPerfTimerLog(const char *szString, ...);
 
+// HkLogger
+enum LOG_STAMP
+{
+	LOG_STAMP_DEFAULT, // [dd.mm.yyyy hh:mm:ss]
+	LOG_STAMP_EVENT, // mm/dd/yyyy hh:mm:ss
+	LOG_STAMP_PLUGIN, // dd/mm/yyyy hh:mm:ss
+	LOG_STAMP_AMOUNT,
+};
+
+IMPORT uint HkLogOpen(const string &scFile, uint iMaxSizeKB = 0, LOG_STAMP eStamp = LOG_STAMP_DEFAULT);
+IMPORT void HkLogClose(uint iLogID);
+IMPORT void HkLogWrite(uint iLogID, const char *szString, ...);
+IMPORT void HkLogFlush();
+IMPORT bool HkLogRotate(const string &scFile, const string &scRotatedFile = "");
+IMPORT bool HkLogAppend(const string &scFile, LOG_STAMP eStamp, const char *szString, ...);
+
 // HkFuncOther
 IMPORT void HkGetPlayerIP(uint iClientID, wstring &wscIP);
 IMPORT HK_ERROR HkGetPlayerInfo(const wstring &wscCharname, HKPLAYERINFO &pi, bool bAlsoCharmenu);
@@ -526,6 +578,12 @@ IMPORT HK_ERROR HkFLIniWrite(const wstring &wscCharname, const wstring &wscKey,
 
 IMPORT wstring HkErrGetText(HK_ERROR hkErr);
 
+// HkScheduler
+typedef void(*TIMER_CALLBACK)(uint iTimerID, void *pData);
+IMPORT uint HkScheduleTimer(uint iDelayMS, uint iIntervalMS, TIMER_CALLBACK callback, void *pData = 0, uint iClientID = 0);
+IMPORT bool HkCancelTimer(uint iTimerID);
+IMPORT void HkCancelClientTimers(uint iClientID);
+
 IMPORT void UserCmd_SetDieMsg(uint iClientID, const wstring &wscParam);
 IMPORT void UserCmd_SetChatFont(uint iClientID, const wstring &wscParam);
 
@@ -557,6 +615,8 @@ IMPORT wstring IniGetWS(const string &scFile, const string &scApp, const string
 IMPORT wstring ToMoneyStr(int iCash);
 IMPORT float IniGetF(const string &scFile, const string &scApp, const string &scKey, float fDefault);
 IMPORT void IniGetSection(const string &scFile, const string &scApp, list<INISECTIONVALUE> &lstValues);
+IMPORT void IniBeginBatch();
+IMPORT void IniEndBatch();
 IMPORT float ToFloat(const wstring &wscStr);
 IMPORT mstime timeInMS();
 IMPORT void SwapBytes(void *ptr, uint iLen);
@@ -608,6 +668,42 @@ private:
 	uint iWarning;
 };
 
+// multi pattern substring search over lower case text, see CStringMatcher.cpp
+struct STRING_MATCH
+{
+	uint iPos;
+	uint iLen;
+	uint iMask;
+};
+
+class CStringMatcher
+{
+public:
+	IMPORT CStringMatcher();
+	IMPORT void Clear();
+	IMPORT void Add(const wstring &wscPattern, uint iMask, bool bWholeWord = false);
+	IMPORT void Compile();
+	IMPORT uint Match(const wstring &wscText) const;
+	IMPORT uint Find(const wstring &wscText, list<STRING_MATCH> &lstMatches) const;
+	IMPORT bool Empty() const;
+
+private:
+	struct NODE
+	{
+		map<wchar_t, uint> mapNext;
+		uint iFail;
+		uint iOutput;
+		uint iLen;
+		uint iMask;
+		uint iWordMask;
+	};
+
+	uint Next(uint iNode, wchar_t wc) const;
+	uint Scan(const wstring &wscText, list<STRING_MATCH> *lstMatches) const;
+
+	vector<NODE> vNodes;
+};
+
 // admin stuff
 class CCmds
 {
@@ -709,6 +805,14 @@ public:
 	wstring wscCurCmdString;
 };
 
+typedef bool(*ADMIN_CMD_CALLBACK)(CCmds *cmds, const wstring &wscCmd);
+IMPORT bool HkRegisterAdminCommand(const wstring &wscCmd, DWORD dwRights, ADMIN_CMD_CALLBACK callback);
+IMPORT void HkUnregisterAdminCommand(const wstring &wscCmd);
+
+typedef bool(*USERCMD_CALLBACK)(uint iClientID, const wstring &wscCmd, const wstring &wscParam, const wchar_t *wszUsage);
+IMPORT bool HkRegisterUserCommand(const wstring &wscCmd, USERCMD_CALLBACK callback, const wstring &wscUsage = L"", const wstring &wscArguments = L"", const wstring &wscShortHelp = L"", const wstring &wscLongHelp = L"");
+IMPORT void HkUnregisterUserCommand(const wstring &wscCmd, USERCMD_CALLBACK callback);
+
 
 // namespaces
 namespace HkIServerImpl
@@ -737,6 +841,8 @@ extern IMPORT char* OldClient;
 extern IMPORT uint	iDmgTo;
 extern IMPORT uint iDmgToSpaceID;
 extern IMPORT uint iDmgMunitionID;
+IMPORT void HkSetLastDamage(uint iClientID, const DamageList &dmg);
+IMPORT void HkGetLastDamage(uint iClientID, DamageList &dmg);
 
 extern IMPORT bool g_bMsg;
 extern IMPORT bool g_bMsgS;
@@ -758,8 +864,6 @@ extern IMPORT _GetWCString GetWCString;
 extern IMPORT _WStringAssign WStringAssign;
 extern IMPORT _WStringAppend WStringAppend;
 extern IMPORT _CPlayerAccount_GetServerSignature CPlayerAccount_GetServerSignature;
-extern IMPORT FILE *fLog;
-extern IMPORT FILE *fLogDebug;
 extern IMPORT FARPROC fpOldUpdate;
 extern IMPORT string sDebugLog;
 
@@ -839,6 +943,53 @@ extern IMPORT char *g_FLServerDataPtr;
 extern IMPORT bool g_gNonGunHitsBase;
 extern IMPORT float g_LastHitPts;
 
+// HkPlayerIndex
+#define CLIENT_SET_WORDS ((MAX_CLIENT_ID + 32) / 32)
+
+struct CLIENT_SET
+{
+	uint arrBits[CLIENT_SET_WORDS];
+};
+
+inline void ClientSetAdd(CLIENT_SET &clients, uint iClientID) { clients.arrBits[iClientID >> 5] |= (1u << (iClientID & 31)); }
+inline void ClientSetRemove(CLIENT_SET &clients, uint iClientID) { clients.arrBits[iClientID >> 5] &= ~(1u << (iClientID & 31)); }
+inline bool ClientSetContains(const CLIENT_SET &clients, uint iClientID) { return (clients.arrBits[iClientID >> 5] & (1u << (iClientID & 31))) != 0; }
+
+// returns the first client in the set after iClientID (0 to start), 0 if there is none
+// for(uint iClientID = ClientSetNext(clients, 0); iClientID; iClientID = ClientSetNext(clients, iClientID))
+inline uint ClientSetNext(const CLIENT_SET &clients, uint iClientID)
+{
+	uint iNext = iClientID + 1;
+	for (uint iWord = (iNext >> 5); iWord < CLIENT_SET_WORDS; iWord++)
+	{
+		uint iBits = clients.arrBits[iWord];
+		if (iWord == (iNext >> 5))
+			iBits &= (~0u << (iNext & 31));
+
+		unsigned long iBit;
+		if (_BitScanForward(&iBit, iBits))
+			return (iWord << 5) + iBit;
+	}
+
+	return 0;
+}
+
+namespace PlayerIndex
+{
+	IMPORT uint FindShip(uint iShip);
+	IMPORT uint GetSystem(uint iClientID);
+	IMPORT bool InNoPvPSystem(uint iClientID);
+	IMPORT uint GetBase(uint iClientID);
+	IMPORT uint GetShip(uint iClientID);
+	IMPORT CAccount* GetAccount(uint iClientID);
+	IMPORT uint FindCharname(const wstring &wscCharname);
+	IMPORT uint FindAccount(CAccount *acc);
+	IMPORT const CLIENT_SET& GetOnlineClients();
+	IMPORT const CLIENT_SET& GetSystemClients(uint iSystemID);
+	IMPORT const PLAYER_SNAPSHOT* GetPlayer(uint iClientID);
+	IMPORT uint GetGeneration();
+}
+
 // help
 
 typedef bool(*_HelpEntryDisplayed)(uint);
@@ -856,6 +1007,8 @@ typedef struct {
 IMPORT void Blowfish_Init(BLOWFISH_CTX *ctx, unsigned char *key, int keyLen);
 IMPORT char Blowfish_Encrypt(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen);
 IMPORT char Blowfish_Decrypt(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen);
+IMPORT char Blowfish_EncryptBuffer(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen); // big-endian words, see blowfish.cpp
+IMPORT char Blowfish_DecryptBuffer(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen);
 
 
 #endif
@@ -208,6 +208,7 @@ enum PLUGIN_CALLBACKS
 	PLUGIN_ProcessEvent_BEFORE,
 	PLUGIN_LoadSettings,
 	PLUGIN_Plugin_Communication,
+	PLUGIN_Plugin_Unload,
 	PLUGIN_CALLBACKS_AMOUNT,
 };
 
@@ -0,0 +1,141 @@
+#include "test.h"
+#include "plugin_dispatch.h"
+
+/**************************************************************************************************************
+admin commands of plugins: the registered commands of HkAdminCommands.cpp against the broadcast before them,
+where every command went through ExecuteCommandString_Callback to every plugin and each plugin compared it
+with its own commands (the IS_CMD chains) until one took it
+**************************************************************************************************************/
+
+#define BENCH_PLUGINS 10
+#define BENCH_PLUGIN_CMDS 10
+#define BENCH_CALLS 1000000
+
+class BenchCmds : public CCmds
+{
+public:
+	void DoPrint(const wstring &wscText) { iBenchSink++; }
+	wstring GetAdminName() { return L"Benchmark"; }
+};
+
+static wstring arrCmdNames[BENCH_PLUGINS][BENCH_PLUGIN_CMDS];
+static PLUGIN_RETURNCODE arrReturncodes[BENCH_PLUGINS];
+
+// a plugin's ExecuteCommandString_Callback, the if (IS_CMD("...")) else if (...) chain as a loop
+template<uint PLUGIN> static bool LegacyPluginCallback(CCmds *cmds, const wstring &wscCmd)
+{
+	arrReturncodes[PLUGIN] = DEFAULT_RETURNCODE;
+	for (uint i = 0; i < BENCH_PLUGIN_CMDS; i++)
+	{
+		if (!wscCmd.compare(arrCmdNames[PLUGIN][i].c_str()))
+		{
+			arrReturncodes[PLUGIN] = SKIPPLUGINS_NOFUNCTIONCALL;
+			iBenchSink++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// the callback a plugin registers for its commands
+static bool AdminCmd(CCmds *cmds, const wstring &wscCmd)
+{
+	iBenchSink++;
+	return true;
+}
+
+static FARPROC* arrLegacyCallbacks[BENCH_PLUGINS] =
+{
+	(FARPROC*)LegacyPluginCallback<0>, (FARPROC*)LegacyPluginCallback<1>, (FARPROC*)LegacyPluginCallback<2>,
+	(FARPROC*)LegacyPluginCallback<3>, (FARPROC*)LegacyPluginCallback<4>, (FARPROC*)LegacyPluginCallback<5>,
+	(FARPROC*)LegacyPluginCallback<6>, (FARPROC*)LegacyPluginCallback<7>, (FARPROC*)LegacyPluginCallback<8>,
+	(FARPROC*)LegacyPluginCallback<9>,
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// dispatch table 0: every plugin hooks ExecuteCommandString_Callback, table 1: none does any more
+static bool LegacyExecute(CCmds *cmds, const wstring &wscCmd)
+{
+	CALL_PLUGINS(0, bool, , (CCmds*, const wstring&), (cmds, wscCmd));
+	return false;
+}
+
+static bool RoutedExecute(CCmds *cmds, const wstring &wscCmd)
+{
+	if (AdminCommands::Execute(cmds, wscCmd))
+		return true;
+
+	CALL_PLUGINS(1, bool, , (CCmds*, const wstring&), (cmds, wscCmd));
+	return false;
+}
+
+static void Bench(const char *szName, const vector<wstring> &vCmds)
+{
+	BenchCmds cmds;
+	cmds.rights = 0xFFFFFFFF;
+	printf("%s\n", szName);
+
+	uint iHandled = 0;
+	double dStart = BenchNow();
+	for (uint i = 0; i < BENCH_CALLS; i++)
+		iHandled += LegacyExecute(&cmds, vCmds[i % vCmds.size()]) ? 1 : 0;
+	BenchReport("  ExecuteCommandString_Callback broadcast", dStart, BENCH_CALLS);
+
+	uint iRouted = 0;
+	dStart = BenchNow();
+	for (uint i = 0; i < BENCH_CALLS; i++)
+		iRouted += RoutedExecute(&cmds, vCmds[i % vCmds.size()]) ? 1 : 0;
+	BenchReport("  registered commands", dStart, BENCH_CALLS);
+
+	if (iHandled != iRouted)
+		printf("  the handled commands differ: %u / %u\n", iHandled, iRouted);
+}
+
+int main()
+{
+	PLUGIN_DISPATCH_TABLE arrTables[2];
+	PLUGIN_DISPATCH_ENTRY arrEntries[BENCH_PLUGINS];
+	for (uint iPlugin = 0; iPlugin < BENCH_PLUGINS; iPlugin++)
+	{
+		for (uint iCmd = 0; iCmd < BENCH_PLUGIN_CMDS; iCmd++)
+		{
+			arrCmdNames[iPlugin][iCmd] = L"plugin" + stows(itos(iPlugin)) + L"cmd" + stows(itos(iCmd));
+			HkRegisterAdminCommand(arrCmdNames[iPlugin][iCmd], 0, AdminCmd);
+		}
+
+		arrReturncodes[iPlugin] = DEFAULT_RETURNCODE;
+		arrEntries[iPlugin].pFunc = arrLegacyCallbacks[iPlugin];
+		arrEntries[iPlugin].ePluginReturnCode = &arrReturncodes[iPlugin];
+		arrEntries[iPlugin].szName = "Benchmark Plugin";
+		arrEntries[iPlugin].iTimerID = iPlugin;
+	}
+	arrTables[0].pEntries = arrEntries;
+	arrTables[0].iCount = BENCH_PLUGINS;
+	arrTables[1].pEntries = 0;
+	arrTables[1].iCount = 0;
+	pPluginDispatch = arrTables;
+	printf("%u plugins with %u admin commands each, %u commands\n", BENCH_PLUGINS, BENCH_PLUGIN_CMDS, BENCH_CALLS);
+
+	vector<wstring> vCmds;
+	for (uint iPlugin = 0; iPlugin < BENCH_PLUGINS; iPlugin++)
+	{
+		for (uint iCmd = 0; iCmd < BENCH_PLUGIN_CMDS; iCmd++)
+			vCmds.push_back(arrCmdNames[iPlugin][iCmd]);
+	}
+	Bench("commands of all plugins", vCmds);
+
+	vCmds.clear();
+	vCmds.push_back(arrCmdNames[BENCH_PLUGINS - 1][BENCH_PLUGIN_CMDS - 1]);
+	Bench("the last command of the last plugin", vCmds);
+
+	// core commands are offered to every plugin first as well
+	vCmds.clear();
+	vCmds.push_back(L"getplayers");
+	vCmds.push_back(L"kick");
+	vCmds.push_back(L"beam");
+	Bench("commands no plugin handles", vCmds);
+
+	return 0;
+}
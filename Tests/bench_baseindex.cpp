@@ -0,0 +1,120 @@
+#include "test.h"
+#include "chat.h"
+#include "base_plugin.h"
+
+/**************************************************************************************************************
+base_plugin's index (BaseIndex.cpp): the bases of a system and the bases within a range of a position
+against the loops over all player_bases before it, with several hundred bases spread over the universe
+**************************************************************************************************************/
+
+#define BENCH_BASES 600
+#define BENCH_SYSTEMS 40
+#define BENCH_QUERIES 200000
+
+map<uint, PlayerBase*> player_bases;
+
+// SyncReputationForClientShip, CharacterSelect, ... before the index
+static uint LegacySystemBases(uint iSystemID)
+{
+	uint iCount = 0;
+	map<uint, PlayerBase*>::iterator base = player_bases.begin();
+	for (; base != player_bases.end(); base++)
+	{
+		if (base->second->system == iSystemID)
+			iCount++;
+	}
+	return iCount;
+}
+
+// PlayerBase::SiegeModChainReaction and the siege sounds before the index
+static uint LegacyInRange(uint iSystemID, const Vector &vPos, float fRange)
+{
+	uint iCount = 0;
+	for (map<uint, PlayerBase*>::iterator it = player_bases.begin(); it != player_bases.end(); ++it)
+	{
+		if (it->second->system == iSystemID)
+		{
+			if (HkDistance3D(it->second->position, vPos) < fRange)
+				iCount++;
+		}
+	}
+	return iCount;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	// half the bases in a few busy systems, the rest spread out, all within 100k of the sun
+	CChatGenerator gen(24);
+	vector<PlayerBase> vBases(BENCH_BASES);
+	for (uint i = 0; i < BENCH_BASES; i++)
+	{
+		vBases[i].base = 0x1000 + i;
+		vBases[i].system = (i % 2) ? gen.Rand(3) : gen.Rand(BENCH_SYSTEMS);
+		vBases[i].position.x = (float)gen.Rand(200000) - 100000.0f;
+		vBases[i].position.y = (float)gen.Rand(20000) - 10000.0f;
+		vBases[i].position.z = (float)gen.Rand(200000) - 100000.0f;
+		player_bases[vBases[i].base] = &vBases[i];
+		BaseIndex::Add(&vBases[i]);
+	}
+	printf("%u bases in %u systems, %u queries\n", BENCH_BASES, BENCH_SYSTEMS, BENCH_QUERIES);
+
+	// around the bases, where the siege queries are made
+	vector<Vector> vPositions;
+	for (uint i = 0; i < 1024; i++)
+	{
+		Vector vPos = vBases[gen.Rand(BENCH_BASES)].position;
+		vPos.x += (float)gen.Rand(4000) - 2000.0f;
+		vPositions.push_back(vPos);
+	}
+
+	uint iOld = 0;
+	double dStart = BenchNow();
+	for (uint i = 0; i < BENCH_QUERIES; i++)
+		iOld += LegacySystemBases(i % BENCH_SYSTEMS);
+	BenchReport("  bases of a system, player_bases loop", dStart, BENCH_QUERIES);
+
+	uint iNew = 0;
+	dStart = BenchNow();
+	for (uint i = 0; i < BENCH_QUERIES; i++)
+		iNew += (uint)BaseIndex::GetSystemBases(i % BENCH_SYSTEMS).size();
+	BenchReport("  bases of a system, BaseIndex", dStart, BENCH_QUERIES);
+	printf("  %u / %u bases found\n", iOld, iNew);
+
+	// the siege chain reaction distance, the siege sound range and one over several cells
+	float arrRanges[] = { 8000.0f, 15000.0f, 50000.0f };
+	for (uint r = 0; r < sizeof(arrRanges) / sizeof(float); r++)
+	{
+		printf("range %.0f\n", arrRanges[r]);
+
+		iOld = 0;
+		dStart = BenchNow();
+		for (uint i = 0; i < BENCH_QUERIES; i++)
+			iOld += LegacyInRange(vBases[i % BENCH_BASES].system, vPositions[i % vPositions.size()], arrRanges[r]);
+		BenchReport("  bases in range, player_bases loop", dStart, BENCH_QUERIES);
+
+		iNew = 0;
+		vector<PlayerBase*> vFound;
+		dStart = BenchNow();
+		for (uint i = 0; i < BENCH_QUERIES; i++)
+		{
+			vFound.clear();
+			BaseIndex::FindInRange(vBases[i % BENCH_BASES].system, vPositions[i % vPositions.size()], arrRanges[r], vFound);
+			iNew += (uint)vFound.size();
+		}
+		BenchReport("  bases in range, BaseIndex grid", dStart, BENCH_QUERIES);
+		printf("  %u / %u bases found\n", iOld, iNew);
+	}
+
+	// bases built and destroyed
+	dStart = BenchNow();
+	for (uint i = 0; i < BENCH_BASES; i++)
+	{
+		BaseIndex::Remove(&vBases[i]);
+		BaseIndex::Add(&vBases[i]);
+	}
+	BenchReport("BaseIndex::Remove + Add", dStart, BENCH_BASES);
+
+	return 0;
+}
@@ -0,0 +1,64 @@
+#include "test.h"
+
+#define long int
+#include "blowfish.h"
+#include "legacy/legacy_blowfish.h"
+#undef long
+
+/**************************************************************************************************************
+encrypting the output of a socket connection: Blowfish_EncryptBuffer in place against the path before it,
+which copied the text to a malloc'ed buffer and called SwapBytes before and after the reference Blowfish_Encrypt
+**************************************************************************************************************/
+
+#define BENCH_BYTES (64 * 1024 * 1024)
+
+static void LegacySend(BLOWFISH_CTX *ctx, const string &scText)
+{
+	uint iLen = (uint)scText.length();
+	char *data = (char*)malloc(iLen);
+	memcpy(data, scText.data(), iLen);
+	legacy_SwapBytes(data, iLen);
+	if (legacy_Blowfish_Encrypt(ctx, data, iLen))
+	{
+		legacy_SwapBytes(data, iLen);
+		iBenchSink += data[0];
+	}
+	free(data);
+}
+
+static void BufferSend(BLOWFISH_CTX *ctx, string &scText)
+{
+	if (Blowfish_EncryptBuffer(ctx, &scText[0], (uint)scText.length()))
+		iBenchSink += scText[0];
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	string scKey = "SomeRandomKey19";
+	BLOWFISH_CTX ctx, ctxLegacy;
+	Blowfish_Init(&ctx, (unsigned char*)scKey.data(), (int)scKey.length());
+	legacy_Blowfish_Init(&ctxLegacy, (unsigned char*)scKey.data(), (int)scKey.length());
+
+	// an event mode line and a big getplayers answer, padded to whole blocks
+	uint arrLengths[] = { 104, 4096 };
+	for (uint i = 0; i < sizeof(arrLengths) / sizeof(uint); i++)
+	{
+		string scText(arrLengths[i], 'x');
+		uint iLines = BENCH_BYTES / arrLengths[i];
+		printf("%u byte lines, %u MB\n", arrLengths[i], BENCH_BYTES / 1024 / 1024);
+
+		double dStart = BenchNow();
+		for (uint iLine = 0; iLine < iLines; iLine++)
+			LegacySend(&ctxLegacy, scText);
+		BenchReport("  malloc + SwapBytes + reference Blowfish_Encrypt", dStart, iLines);
+
+		dStart = BenchNow();
+		for (uint iLine = 0; iLine < iLines; iLine++)
+			BufferSend(&ctx, scText);
+		BenchReport("  Blowfish_EncryptBuffer in place", dStart, iLines);
+	}
+
+	return 0;
+}
@@ -0,0 +1,130 @@
+#include "test.h"
+#include "charfile.h"
+#include "legacy/legacy.h"
+
+/**************************************************************************************************************
+reading values from a corpus of real-size charfiles: the charfile cache (HkCharFile.cpp) cold and warm
+against the path before it, which checked the magic token, decoded to a temp file byte by byte, read the
+values with GetPrivateProfileString and deleted the temp file again
+**************************************************************************************************************/
+
+#define BENCH_FILES 200
+#define BENCH_ROUNDS 5
+#define BENCH_LEGACY_FILES 20 // one _write per byte, the old path takes a while
+
+static const char *arrKeys[] = { "money", "rank", "base" };
+static const uint iKeys = sizeof(arrKeys) / sizeof(const char*);
+
+// HkIsEncoded as it was
+static bool LegacyIsEncoded(const string &scFile)
+{
+	FILE *f = fopen(scFile.c_str(), "rb");
+	if (!f)
+		return false;
+
+	char szMagic[4] = { 0 };
+	bool bEncoded = (fread(szMagic, 1, 4, f) == 4) && !strncmp(szMagic, "FLS1", 4);
+	fclose(f);
+	return bEncoded;
+}
+
+static uint LegacyRead(const string &scFile)
+{
+	string scTemp = scFile + ".ini";
+	string scRead = scFile;
+	if (LegacyIsEncoded(scFile))
+	{
+		if (!legacy_flc_decode(scFile.c_str(), scTemp.c_str()))
+			return 0;
+		scRead = scTemp;
+	}
+
+	uint iLength = 0;
+	for (uint i = 0; i < iKeys; i++)
+		iLength += (uint)legacy_GetPrivateProfileString(scRead, "Player", arrKeys[i]).length();
+
+	if (scRead == scTemp)
+		remove(scTemp.c_str());
+	return iLength;
+}
+
+static uint CacheRead(const string &scFile)
+{
+	const CHARFILE *charfile;
+	if (CharFileCache::Load("C:" + scFile, charfile) != HKE_OK)
+		return 0;
+
+	uint iLength = 0;
+	for (uint i = 0; i < iKeys; i++)
+		iLength += (uint)CharFileCache::GetValue(*charfile, "Player", arrKeys[i], "").length();
+	return iLength;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	vector<string> vFiles;
+	uint iBytes = 0;
+	for (uint i = 0; i < BENCH_FILES; i++)
+	{
+		string scPlain = MakeCharfile(i + 1);
+		string scEncoded(scPlain.length() + 4, '\0');
+		flc_encode_buf(scPlain.data(), (int)scPlain.length(), &scEncoded[0]);
+		iBytes += (uint)scEncoded.length();
+
+		// flcodec and the stdio calls take the path without the drive letter of the win32 shims
+		string scFile = TestPath("char" + itos(i) + ".fl").substr(2);
+		FILE *f = fopen(scFile.c_str(), "wb");
+		fwrite(scEncoded.data(), 1, scEncoded.length(), f);
+		fclose(f);
+		vFiles.push_back(scFile);
+	}
+	printf("%u charfiles, %u kb on average, %u values read from each\n", BENCH_FILES, iBytes / BENCH_FILES / 1024, iKeys);
+
+	uint iLegacyLength = 0;
+	double dStart = BenchNow();
+	for (uint i = 0; i < BENCH_LEGACY_FILES; i++)
+		iLegacyLength += LegacyRead(vFiles[i]);
+	BenchReport("  temp file + profile api, per file", dStart, BENCH_LEGACY_FILES);
+
+	uint iCacheLength = 0;
+	for (uint i = 0; i < BENCH_LEGACY_FILES; i++)
+		iCacheLength += CacheRead(vFiles[i]);
+	if (iLegacyLength != iCacheLength)
+		printf("the values read differ: %u / %u bytes\n", iLegacyLength, iCacheLength);
+
+	dStart = BenchNow();
+	for (uint iRound = 0; iRound < BENCH_ROUNDS; iRound++)
+	{
+		for (uint i = 0; i < vFiles.size(); i++)
+		{
+			CharFileCache::Invalidate("C:" + vFiles[i]);
+			iBenchSink += CacheRead(vFiles[i]);
+		}
+	}
+	BenchReport("  charfile cache, not cached, per file", dStart, BENCH_FILES * BENCH_ROUNDS);
+
+	// the cache holds fewer files than the corpus, the warm run reads the ones it holds
+	vector<string> vCached(vFiles.begin(), vFiles.begin() + 100);
+	for (uint i = 0; i < vCached.size(); i++)
+		CacheRead(vCached[i]);
+	dStart = BenchNow();
+	for (uint iRound = 0; iRound < BENCH_ROUNDS; iRound++)
+	{
+		for (uint i = 0; i < vCached.size(); i++)
+			iBenchSink += CacheRead(vCached[i]);
+	}
+	BenchReport("  charfile cache, cached, per file", dStart, (mstime)vCached.size() * BENCH_ROUNDS);
+
+	// the codec alone
+	string scEncoded(iBytes / BENCH_FILES, 'x');
+	memcpy(&scEncoded[0], "FLS1", 4);
+	string scPlain(scEncoded.length(), '\0');
+	dStart = BenchNow();
+	for (uint i = 0; i < BENCH_FILES * BENCH_ROUNDS; i++)
+		flc_decode_buf(scEncoded.data(), (int)scEncoded.length(), &scPlain[0]);
+	BenchReport("  flc_decode_buf, per file", dStart, BENCH_FILES * BENCH_ROUNDS);
+
+	return 0;
+}
@@ -0,0 +1,143 @@
+#include "test.h"
+
+/**************************************************************************************************************
+a stream of hits between players replayed through the bookkeeping of HkCb_AddDmgEntry: the no-pvp check with
+PlayerIndex::InNoPvPSystem and HkSetLastDamage for hull hits, against the path before them, which asked the
+server for the shooter's system and walked set_lstNoPVPSystems, and copied the whole DamageList (with its
+list of entries) into LastDmgList on every hit and into ClientInfo[].dmgLast on every hull hit.
+pub::Player::GetSystem is an array lookup here, in the server it is a call into server.dll.
+**************************************************************************************************************/
+
+#define BENCH_PLAYERS 200
+#define BENCH_SYSTEMS 40
+#define BENCH_NOPVP_SYSTEMS 8
+#define BENCH_DAMAGE_LISTS 4096
+#define BENCH_HITS 2000000
+
+CLIENT_INFO ClientInfo[MAX_CLIENT_ID + 1];
+list<uint> set_lstNoPVPSystems;
+PlayerDB Players;
+
+static uint arrSystems[MAX_CLIENT_ID + 1];
+static wstring arrCharnames[MAX_CLIENT_ID + 1];
+
+void HkGetPlayerIP(uint iClientID, wstring &wscIP) { wscIP = L"10.0.0.1"; }
+int pub::GetBaseNickname(char *szNickname, uint iSize, const uint &iBaseID) { snprintf(szNickname, iSize, "base_%u", iBaseID); return 0; }
+int pub::GetSystemNickname(char *szNickname, uint iSize, const uint &iSystemID) { snprintf(szNickname, iSize, "system_%u", iSystemID); return 0; }
+int pub::Player::GetSystem(const uint &iClientID, uint &iSystemID) { iSystemID = arrSystems[iClientID]; return 0; }
+int pub::Player::GetBase(const uint &iClientID, uint &iBaseID) { iBaseID = 0; return 0; }
+int pub::Player::GetShip(const uint &iClientID, uint &iShip) { iShip = ClientInfo[iClientID].iShip; return 0; }
+const wchar_t* PlayerDB::GetActiveCharacterName(uint iClientID) const { return arrCharnames[iClientID].length() ? arrCharnames[iClientID].c_str() : 0; }
+CAccount* PlayerDB::FindAccountFromClientID(uint iClientID) const { return 0; }
+
+struct HIT
+{
+	uint iFrom;
+	uint iTo;
+	ushort iSubObj; // 1 is the hull
+	uint iDamageList;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// HkCb_AddDmgEntry and AllowPlayerDamage as they were
+static DamageList LastDmgList;
+static DamageList arrLegacyLast[MAX_CLIENT_ID + 1];
+
+static bool LegacyHit(const HIT &hit, DamageList &dmg)
+{
+	bool bAllowed = true;
+	uint iSystemID;
+	pub::Player::GetSystem(hit.iFrom, iSystemID);
+	foreach(set_lstNoPVPSystems, uint, i)
+	{
+		if (iSystemID == (*i))
+		{
+			bAllowed = false; // no pvp
+			break;
+		}
+	}
+
+	LastDmgList = dmg; // save
+	if (hit.iSubObj == 1) // only save hits on the hull (p1=1)
+		arrLegacyLast[hit.iTo] = dmg;
+	return bAllowed;
+}
+
+static bool IndexHit(const HIT &hit, DamageList &dmg)
+{
+	bool bAllowed = !PlayerIndex::InNoPvPSystem(hit.iFrom);
+	if (hit.iSubObj == 1)
+		HkSetLastDamage(hit.iTo, dmg);
+	return bAllowed;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	uint iSeed = 12345;
+#define NEXT_RANDOM() (iSeed = iSeed * 1103515245 + 12345, (iSeed >> 8))
+
+	for (uint i = 0; i < BENCH_NOPVP_SYSTEMS; i++)
+		set_lstNoPVPSystems.push_back(0x1000 + i * 5);
+
+	for (uint iClientID = 1; iClientID <= BENCH_PLAYERS; iClientID++)
+	{
+		arrSystems[iClientID] = 0x1000 + NEXT_RANDOM() % BENCH_SYSTEMS;
+		arrCharnames[iClientID] = L"Player_" + stows(itos(iClientID));
+		ClientInfo[iClientID].iShip = 0x80000000 + iClientID * 4099;
+		PlayerIndex::Refresh(iClientID);
+		PlayerIndex::ShipsChanged(iClientID);
+	}
+	PlayerIndex::NoPvPSystemsChanged();
+
+	// the lists the server passes in, a shot takes off one to four parts
+	vector<DamageList> vDamageLists(BENCH_DAMAGE_LISTS);
+	for (uint i = 0; i < BENCH_DAMAGE_LISTS; i++)
+	{
+		uint iFrom = 1 + NEXT_RANDOM() % BENCH_PLAYERS;
+		vDamageLists[i].set_inflictor_id(ClientInfo[iFrom].iShip);
+		vDamageLists[i].set_inflictor_owner_player(iFrom);
+		vDamageLists[i].set_cause(DC_GUN);
+		uint iEntries = 1 + NEXT_RANDOM() % 4;
+		for (uint k = 0; k < iEntries; k++)
+			vDamageLists[i].add_damage_entry((ushort)(1 + k), 100.0f * k, DamageEntry::FATE_ALIVE);
+	}
+
+	// the shots of a fight: most hit the hull, the rest shields and equipment
+	vector<HIT> vHits(BENCH_HITS);
+	for (uint i = 0; i < BENCH_HITS; i++)
+	{
+		HIT &hit = vHits[i];
+		hit.iDamageList = NEXT_RANDOM() % BENCH_DAMAGE_LISTS;
+		hit.iFrom = vDamageLists[hit.iDamageList].get_inflictor_owner_player();
+		hit.iTo = 1 + NEXT_RANDOM() % BENCH_PLAYERS;
+		hit.iSubObj = (NEXT_RANDOM() % 10 < 7) ? 1 : (ushort)(2 + NEXT_RANDOM() % 20);
+	}
+	printf("%u players, %u of %u systems no-pvp, %u hits\n", BENCH_PLAYERS, BENCH_NOPVP_SYSTEMS, BENCH_SYSTEMS, BENCH_HITS);
+
+	uint iLegacyAllowed = 0;
+	double dStart = BenchNow();
+	for (uint i = 0; i < BENCH_HITS; i++)
+		iLegacyAllowed += LegacyHit(vHits[i], vDamageLists[vHits[i].iDamageList]) ? 1 : 0;
+	BenchReport("  system lookup + DamageList copies, per hit", dStart, BENCH_HITS);
+
+	uint iAllowed = 0;
+	dStart = BenchNow();
+	for (uint i = 0; i < BENCH_HITS; i++)
+		iAllowed += IndexHit(vHits[i], vDamageLists[vHits[i].iDamageList]) ? 1 : 0;
+	BenchReport("  InNoPvPSystem + HkSetLastDamage, per hit", dStart, BENCH_HITS);
+
+	if (iAllowed != iLegacyAllowed)
+		printf("the no-pvp checks differ: %u / %u hits allowed\n", iLegacyAllowed, iAllowed);
+	for (uint iClientID = 1; iClientID <= BENCH_PLAYERS; iClientID++)
+	{
+		DamageList dmg;
+		HkGetLastDamage(iClientID, dmg);
+		if (dmg.get_inflictor_id() != arrLegacyLast[iClientID].get_inflictor_id() || dmg.get_cause() != arrLegacyLast[iClientID].get_cause())
+			printf("the last hit on client %u differs\n", iClientID);
+	}
+
+	return 0;
+}
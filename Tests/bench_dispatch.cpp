@@ -0,0 +1,163 @@
+#include "test.h"
+#include "plugin_dispatch.h"
+
+/**************************************************************************************************************
+plugin callback dispatch: the compiled tables of CALL_PLUGINS against the CALL_PLUGINS macro before them,
+which walked the std::list of PLUGIN_HOOKDATA of the callback and timed every call with a CTimer
+**************************************************************************************************************/
+
+#define BENCH_CALLS 2000000
+
+// the hook data and the macro as they were before the dispatch tables (HkPluginManager.cpp, Hook.h)
+struct LEGACY_HOOKDATA
+{
+	string sName;
+	string sPluginFunction;
+	HMODULE hDLL;
+	int iPriority;
+	bool bPaused;
+	FARPROC* pFunc;
+	PLUGIN_RETURNCODE* ePluginReturnCode;
+};
+
+static list<LEGACY_HOOKDATA> lstLegacyHooks;
+static uint set_iTimerThreshold = 100;
+static uint set_iTimerDebugThreshold = 0;
+
+class CTimer
+{
+public:
+	CTimer(string sFunc, uint iWarn) { iMax = 0; iWarning = iWarn; sFunction = sFunc; }
+	void start() { tmStart = timeInMS(); }
+	uint stop()
+	{
+		uint iDelta = abs((int)(timeInMS() - tmStart));
+		if (iDelta > iMax && iDelta > iWarning)
+			iMax = iDelta;
+		else if (iDelta > set_iTimerDebugThreshold && set_iTimerDebugThreshold > 0)
+			iBenchSink++;
+		return iDelta;
+	}
+
+private:
+	mstime tmStart;
+	uint iMax;
+	string sFunction;
+	uint iWarning;
+};
+
+#define LEGACY_CALL_PLUGINS_V(calling_convention,arg_types,args) \
+{ \
+	bool bPluginReturn = false; \
+	g_bPlugin_nofunctioncall = false; \
+	try { \
+		foreach(lstLegacyHooks,LEGACY_HOOKDATA, itplugin) { \
+			if(itplugin->bPaused) \
+				continue; \
+			if(itplugin->pFunc) { \
+				CTimer timer(itplugin->sPluginFunction,set_iTimerThreshold); \
+				timer.start(); \
+				try { \
+					((void (calling_convention*) arg_types )itplugin->pFunc) args; \
+				} catch(...) { AddLog("ERROR: Exception in plugin '%s' in %s", itplugin->sName.c_str(), __FUNCTION__); LOG_EXCEPTION } \
+				timer.stop(); \
+			} else  \
+				AddLog("ERROR: Plugin '%s' does not export %s [%s]", itplugin->sName.c_str(), __FUNCTION__, __FUNCDNAME__); \
+			if(*itplugin->ePluginReturnCode == SKIPPLUGINS_NOFUNCTIONCALL) { \
+				bPluginReturn = true; \
+				break; \
+			} else if(*itplugin->ePluginReturnCode == NOFUNCTIONCALL) { \
+				bPluginReturn = true; \
+				g_bPlugin_nofunctioncall = true; \
+			} else if(*itplugin->ePluginReturnCode == SKIPPLUGINS) \
+				break; \
+		} \
+	} catch(...) { AddLog("ERROR: Exception %s", __FUNCTION__); LOG_EXCEPTION } \
+	if(bPluginReturn) \
+		return; \
+} \
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static PLUGIN_RETURNCODE returncode = DEFAULT_RETURNCODE;
+
+static void __stdcall Plugin_SPObjUpdate(uint iClientID)
+{
+	returncode = DEFAULT_RETURNCODE;
+	iBenchSink += iClientID;
+}
+
+static void HookLegacy(uint iClientID)
+{
+	LEGACY_CALL_PLUGINS_V(__stdcall, (uint), (iClientID));
+}
+
+static void HookTable(uint iClientID)
+{
+	CALL_PLUGINS_V(0, __stdcall, (uint), (iClientID));
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void SetPlugins(uint iCount)
+{
+	static PLUGIN_DISPATCH_TABLE table;
+	static vector<PLUGIN_DISPATCH_ENTRY> vEntries;
+
+	lstLegacyHooks.clear();
+	vEntries.clear();
+	for (uint i = 0; i < iCount; i++)
+	{
+		LEGACY_HOOKDATA hook;
+		hook.sName = "Benchmark Plugin " + itos(i);
+		hook.sPluginFunction = "HkIServerImpl::SPObjUpdate";
+		hook.hDLL = 0;
+		hook.iPriority = 0;
+		hook.bPaused = false;
+		hook.pFunc = (FARPROC*)Plugin_SPObjUpdate;
+		hook.ePluginReturnCode = &returncode;
+		lstLegacyHooks.push_back(hook);
+
+		PLUGIN_DISPATCH_ENTRY entry;
+		entry.pFunc = (FARPROC*)Plugin_SPObjUpdate;
+		entry.ePluginReturnCode = &returncode;
+		entry.szName = "Benchmark Plugin";
+		entry.iTimerID = i;
+		vEntries.push_back(entry);
+	}
+
+	table.pEntries = iCount ? &vEntries[0] : 0;
+	table.iCount = iCount;
+	pPluginDispatch = &table;
+}
+
+int main()
+{
+	uint arrPluginCounts[] = { 1, 5, 20 };
+	for (uint i = 0; i < sizeof(arrPluginCounts) / sizeof(uint); i++)
+	{
+		uint iPlugins = arrPluginCounts[i];
+		SetPlugins(iPlugins);
+		printf("%u plugin(s) on the callback, %u calls\n", iPlugins, BENCH_CALLS);
+
+		double dStart = BenchNow();
+		for (uint iCall = 0; iCall < BENCH_CALLS; iCall++)
+			HookLegacy(iCall);
+		BenchReport("  old CALL_PLUGINS (list + CTimer)", dStart, BENCH_CALLS);
+
+		PerfTimers::bEnabled = false;
+		dStart = BenchNow();
+		for (uint iCall = 0; iCall < BENCH_CALLS; iCall++)
+			HookTable(iCall);
+		BenchReport("  dispatch table", dStart, BENCH_CALLS);
+
+		PerfTimers::bEnabled = true;
+		dStart = BenchNow();
+		for (uint iCall = 0; iCall < BENCH_CALLS; iCall++)
+			HookTable(iCall);
+		BenchReport("  dispatch table, PerfStats=yes", dStart, BENCH_CALLS);
+		PerfTimers::bEnabled = false;
+	}
+
+	return 0;
+}
@@ -0,0 +1,136 @@
+#include "test.h"
+#include "socketserver.h"
+#include "SocketServer.cpp"
+
+/**************************************************************************************************************
+event mode throughput with N subscribers: a batch of events through SocketServer::ProcessEvents, which encodes
+every line once per connection format and appends the same bytes to every connection whose topic filter
+matches, against every event sent to every event mode connection on its own and encoded for it, the way
+ProcessEvent printed to the connections before the batches. the subscribers read everything they get, a
+third is encrypted and a third receives all topics, the rest one or two of them.
+**************************************************************************************************************/
+
+#define BENCH_BATCH_LINES 50
+#define BENCH_LINES 200000
+
+static const wchar_t *arrTopics[] = { L"chat", L"kill", L"launch", L"login", L"jump" };
+static const uint iTopics = sizeof(arrTopics) / sizeof(const wchar_t*);
+static const wchar_t *arrFilters[] = { L"", L"chat", L"kill launch" };
+
+static void Connect(uint iSubscribers)
+{
+	for (uint i = 0; i < iSubscribers; i++)
+		SimAddClient((i % 3 == 1) ? sEListen : sListen, "", SIM_READ_ALL, false);
+
+	SOCKET_MESSAGE msg;
+	while (SocketServer::lstConnections.size() < iSubscribers)
+	{
+		SocketServer::AcceptConnections(sListen, false, false);
+		SocketServer::AcceptConnections(sEListen, false, true);
+		while (SocketServer::Receive(msg))
+			;
+	}
+
+	uint i = 0;
+	foreach(SocketServer::lstConnections, SocketServer::NET_CONNECTION*, it)
+		SocketServer::SetEventMode(*it, arrFilters[(i++ / 3) % 3]);
+}
+
+static void Disconnect()
+{
+	foreach(SocketServer::lstConnections, SocketServer::NET_CONNECTION*, it)
+	{
+		closesocket((*it)->s);
+		delete *it;
+	}
+	SocketServer::lstConnections.clear();
+	SocketServer::mapConnections.clear();
+}
+
+static wstring MakeBatch(uint iBatch)
+{
+	wstring wscBatch;
+	for (uint iLine = 0; iLine < BENCH_BATCH_LINES; iLine++)
+	{
+		wscBatch += wstring(arrTopics[(iBatch + iLine) % iTopics]) + L" batch=" + stows(itos(iBatch)) + L" line="
+			+ stows(itos(iLine)) + L" system=Li01 charname=Some_Player_Name\n";
+	}
+	return wscBatch;
+}
+
+// the event connections before the batches, each line encoded and queued for every connection on its own
+static void LegacyProcessEvents(const wstring &wscBatch)
+{
+	size_t iStart = 0;
+	size_t iEnd;
+	while ((iEnd = wscBatch.find(L'\n', iStart)) != wstring::npos)
+	{
+		wstring wscLine = wscBatch.substr(iStart, iEnd - iStart + 1);
+		wstring wscTopic = ToLower(wscLine.substr(0, wscLine.find_first_of(L" \n")));
+		iStart = iEnd + 1;
+
+		foreach(SocketServer::lstConnections, SocketServer::NET_CONNECTION*, it)
+		{
+			SocketServer::NET_CONNECTION *conn = *it;
+			if (!conn->bEventMode || conn->bClosed)
+				continue;
+			if (conn->vTopics.size() && !binary_search(conn->vTopics.begin(), conn->vTopics.end(), wscTopic))
+				continue;
+
+			wstring wscText = wscLine;
+			SocketServer::QueueOutput(conn, wscText);
+		}
+	}
+}
+
+static unsigned long long ReceivedBytes()
+{
+	unsigned long long iBytes = 0;
+	foreach(SocketServer::lstConnections, SocketServer::NET_CONNECTION*, it)
+		iBytes += SimGetReceivedBytes((*it)->s);
+	return iBytes;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	BLOWFISH_CTX ctx;
+	Blowfish_Init(&ctx, (unsigned char*)"SECRETKEY", 9);
+	set_BF_CTX = &ctx;
+	sListen = SimListen();
+	sEListen = SimListen();
+
+	vector<wstring> vBatches;
+	for (uint i = 0; i < 16; i++)
+		vBatches.push_back(MakeBatch(i));
+
+	uint arrSubscribers[] = { 10, 100, 250, 1000 };
+	for (uint s = 0; s < sizeof(arrSubscribers) / sizeof(uint); s++)
+	{
+		uint iSubscribers = arrSubscribers[s];
+		uint iBatches = max(1u, BENCH_LINES / BENCH_BATCH_LINES / iSubscribers * 10);
+		printf("%u subscribers, %u batches of %u events\n", iSubscribers, iBatches, BENCH_BATCH_LINES);
+		Connect(iSubscribers);
+
+		// every subscriber gets select()'s budget for the whole run
+		SimSelect(0, 0, 0, 0, 0);
+		double dStart = BenchNow();
+		for (uint i = 0; i < iBatches; i++)
+			LegacyProcessEvents(vBatches[i % vBatches.size()]);
+		BenchReport("  encoded per connection, per event", dStart, (mstime)iBatches * BENCH_BATCH_LINES);
+		unsigned long long iLegacyBytes = ReceivedBytes();
+
+		SimSelect(0, 0, 0, 0, 0);
+		dStart = BenchNow();
+		for (uint i = 0; i < iBatches; i++)
+			SocketServer::ProcessEvents(vBatches[i % vBatches.size()]);
+		BenchReport("  ProcessEvents, encoded per format, per event", dStart, (mstime)iBatches * BENCH_BATCH_LINES);
+		if (ReceivedBytes() != 2 * iLegacyBytes)
+			printf("the subscribers received different data: %llu / %llu bytes\n", iLegacyBytes, ReceivedBytes() - iLegacyBytes);
+
+		Disconnect();
+	}
+
+	return 0;
+}
@@ -0,0 +1,72 @@
+#include "test.h"
+#include "chat.h"
+#include "legacy/legacy.h"
+
+/**************************************************************************************************************
+ignore lists on a full server: 249 clients with 50 entries each, every chat line checked against the list
+of every receiver, compiled (HkIgnoreFilter.cpp) against the loop HkCbChat ran over the raw entries before
+**************************************************************************************************************/
+
+#define BENCH_CLIENTS MAX_CLIENT_ID // a full server
+#define BENCH_ENTRIES 50
+#define BENCH_LINES 2000
+
+CLIENT_INFO ClientInfo[MAX_CLIENT_ID + 1];
+
+static wstring Charname(CChatGenerator &gen)
+{
+	wstring wscName = gen.Word(5);
+	wscName[0] = towupper(wscName[0]);
+	if (!gen.Rand(3))
+		wscName = L"[TAG]" + wscName;
+	return wscName;
+}
+
+int main()
+{
+	CChatGenerator gen(18);
+	vector<wstring> vSenders;
+	for (uint i = 0; i < 500; i++)
+		vSenders.push_back(Charname(gen));
+
+	// every 5th entry "i", every 10th "p"
+	double dStart = BenchNow();
+	for (uint iClientID = 1; iClientID <= BENCH_CLIENTS; iClientID++)
+	{
+		for (uint i = 0; i < BENCH_ENTRIES; i++)
+		{
+			IGNORE_INFO ii;
+			ii.wscCharname = (i % 5 == 4) ? Charname(gen).substr(0, 4) : vSenders[gen.Rand((uint)vSenders.size())];
+			ii.wscFlags = (i % 5 == 4) ? L"i" : (i % 10 == 3 ? L"p" : L"");
+			IgnoreInfoCompile(ii);
+			ClientInfo[iClientID].lstIgnore.push_back(ii);
+		}
+		IgnoreFilter::Rebuild(iClientID);
+	}
+	BenchReport("compiling the lists, per client", dStart, BENCH_CLIENTS);
+	printf("%u clients with %u entries, %u lines to every client\n", BENCH_CLIENTS, BENCH_ENTRIES, BENCH_LINES);
+
+	uint iOld = 0;
+	dStart = BenchNow();
+	for (uint iLine = 0; iLine < BENCH_LINES; iLine++)
+	{
+		const wstring &wscSender = vSenders[iLine % vSenders.size()];
+		for (uint iClientID = 1; iClientID <= BENCH_CLIENTS; iClientID++)
+			iOld += legacy_IsIgnored(ClientInfo[iClientID].lstIgnore, wscSender, true) ? 1 : 0;
+	}
+	BenchReport("  lstIgnore loop, per delivery", dStart, (mstime)BENCH_LINES * BENCH_CLIENTS);
+
+	// HkCbChat lowers the sender once per line
+	uint iNew = 0;
+	dStart = BenchNow();
+	for (uint iLine = 0; iLine < BENCH_LINES; iLine++)
+	{
+		wstring wscSenderLower = ToLower(vSenders[iLine % vSenders.size()]);
+		for (uint iClientID = 1; iClientID <= BENCH_CLIENTS; iClientID++)
+			iNew += IgnoreFilter::IsIgnored(iClientID, wscSenderLower, false) ? 1 : 0;
+	}
+	BenchReport("  IgnoreFilter::IsIgnored, per delivery", dStart, (mstime)BENCH_LINES * BENCH_CLIENTS);
+
+	printf("  %u / %u deliveries ignored\n", iOld, iNew);
+	return 0;
+}
@@ -0,0 +1,122 @@
+#include "test.h"
+#include "legacy/legacy.h"
+
+/**************************************************************************************************************
+reading 50 keys from the same file: the parsed document cache behind the Ini* tools (HkIniCache.cpp) against
+the pattern before it, one GetPrivateProfileString call per key that opened and scanned the file every time
+**************************************************************************************************************/
+
+#define BENCH_SECTIONS 10
+#define BENCH_KEYS_PER_SECTION 20
+#define BENCH_READ_KEYS 50
+#define BENCH_FILES 100 // more than the cache holds, so a read of every file in turn parses it again
+#define BENCH_ROUNDS 20
+
+static string SectionName(uint iSection)
+{
+	return "Section" + itos(iSection);
+}
+
+static string KeyName(uint iKey)
+{
+	return "key_number_" + itos(iKey);
+}
+
+// a config file of the size of flhook.ini, with comments and blank lines between the sections
+static string MakeIni(uint iSeed)
+{
+	string scText = "; generated for bench_inicache\r\n";
+	for (uint iSection = 0; iSection < BENCH_SECTIONS; iSection++)
+	{
+		scText += "\r\n[" + SectionName(iSection) + "]\r\n";
+		for (uint iKey = 0; iKey < BENCH_KEYS_PER_SECTION; iKey++)
+			scText += KeyName(iKey) + " = value " + itos(iSeed * 1000 + iSection * BENCH_KEYS_PER_SECTION + iKey) + "\r\n";
+	}
+	return scText;
+}
+
+// the 50 keys are spread over all sections, the way LoadSettings reads a file
+static void GetReadKey(uint i, string &scApp, string &scKey)
+{
+	scApp = SectionName(i % BENCH_SECTIONS);
+	scKey = KeyName((i * 7) % BENCH_KEYS_PER_SECTION);
+}
+
+static uint LegacyRead(const string &scFile)
+{
+	uint iLength = 0;
+	string scApp, scKey;
+	for (uint i = 0; i < BENCH_READ_KEYS; i++)
+	{
+		GetReadKey(i, scApp, scKey);
+		iLength += (uint)legacy_GetPrivateProfileString(scFile, scApp, scKey).length();
+	}
+	return iLength;
+}
+
+static uint CacheRead(const string &scFile)
+{
+	uint iLength = 0;
+	string scApp, scKey, scValue;
+	for (uint i = 0; i < BENCH_READ_KEYS; i++)
+	{
+		GetReadKey(i, scApp, scKey);
+		bool bFound = false;
+		if (IniCache::Get(scFile, scApp, scKey, scValue, bFound) && bFound)
+			iLength += (uint)scValue.length();
+	}
+	return iLength;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	vector<string> vFiles;
+	uint iBytes = 0;
+	for (uint i = 0; i < BENCH_FILES; i++)
+	{
+		string scText = MakeIni(i);
+		iBytes += (uint)scText.length();
+
+		string scFile = TestPath("bench" + itos(i) + ".ini");
+		FILE *f = fopen(scFile.substr(2).c_str(), "wb");
+		fwrite(scText.data(), 1, scText.length(), f);
+		fclose(f);
+		vFiles.push_back(scFile);
+	}
+	printf("%u files, %u bytes on average, %u keys read from each\n", BENCH_FILES, iBytes / BENCH_FILES, BENCH_READ_KEYS);
+
+	// stdio takes the path without the drive letter of the win32 shims
+	uint iLegacyLength = 0, iCacheLength = 0;
+	for (uint i = 0; i < BENCH_FILES; i++)
+	{
+		iLegacyLength += LegacyRead(vFiles[i].substr(2));
+		iCacheLength += CacheRead(vFiles[i]);
+	}
+	if (iLegacyLength != iCacheLength)
+		printf("the values read differ: %u / %u bytes\n", iLegacyLength, iCacheLength);
+
+	double dStart = BenchNow();
+	for (uint iRound = 0; iRound < BENCH_ROUNDS; iRound++)
+	{
+		for (uint i = 0; i < BENCH_FILES; i++)
+			iBenchSink += LegacyRead(vFiles[i].substr(2));
+	}
+	BenchReport("  profile api per key, 50 keys", dStart, BENCH_FILES * BENCH_ROUNDS);
+
+	dStart = BenchNow();
+	for (uint iRound = 0; iRound < BENCH_ROUNDS; iRound++)
+	{
+		for (uint i = 0; i < BENCH_FILES; i++)
+			iBenchSink += CacheRead(vFiles[i]);
+	}
+	BenchReport("  ini cache, parsed on the first key, 50 keys", dStart, BENCH_FILES * BENCH_ROUNDS);
+
+	dStart = BenchNow();
+	for (uint iRound = 0; iRound < BENCH_ROUNDS * BENCH_FILES; iRound++)
+		iBenchSink += CacheRead(vFiles[0]);
+	BenchReport("  ini cache, cached, 50 keys", dStart, BENCH_FILES * BENCH_ROUNDS);
+
+	return 0;
+}
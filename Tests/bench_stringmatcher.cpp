@@ -0,0 +1,65 @@
+#include "test.h"
+#include "chat.h"
+#include "legacy/legacy.h"
+
+/**************************************************************************************************************
+swear word filter: CStringMatcher over a 2,000 word list against playercntl's loop before it, which looked
+for every word of the list in the lowered chat line one after the other
+**************************************************************************************************************/
+
+#define BENCH_WORDS 2000
+#define BENCH_LINES 10000
+#define BENCH_ROUNDS 2
+
+int main()
+{
+	CChatGenerator gen(19);
+	vector<wstring> vWords = gen.Words(BENCH_WORDS);
+	list<wstring> lstWords(vWords.begin(), vWords.end());
+
+	// clean lines mostly, like on a server
+	vector<wstring> vLines;
+	vector<wstring> vNone;
+	for (uint i = 0; i < BENCH_LINES; i++)
+		vLines.push_back(gen.Line(i % 10 ? vNone : vWords, 20));
+	printf("%u swear words, %u chat lines\n", BENCH_WORDS, BENCH_LINES);
+
+	double dStart = BenchNow();
+	CStringMatcher matcher;
+	for (uint i = 0; i < vWords.size(); i++)
+		matcher.Add(vWords[i], 1);
+	matcher.Compile();
+	BenchReport("  CStringMatcher::Add + Compile, per word", dStart, BENCH_WORDS);
+
+	uint iOld = 0;
+	dStart = BenchNow();
+	for (uint iRound = 0; iRound < BENCH_ROUNDS; iRound++)
+	{
+		for (uint i = 0; i < vLines.size(); i++)
+			iOld += legacy_IsSwearing(lstWords, vLines[i]) ? 1 : 0;
+	}
+	BenchReport("  find() for every word, per line", dStart, BENCH_LINES * BENCH_ROUNDS);
+
+	uint iNew = 0;
+	dStart = BenchNow();
+	for (uint iRound = 0; iRound < BENCH_ROUNDS; iRound++)
+	{
+		for (uint i = 0; i < vLines.size(); i++)
+			iNew += matcher.Match(vLines[i]) ? 1 : 0;
+	}
+	BenchReport("  CStringMatcher::Match, per line", dStart, BENCH_LINES * BENCH_ROUNDS);
+
+	dStart = BenchNow();
+	for (uint iRound = 0; iRound < BENCH_ROUNDS; iRound++)
+	{
+		for (uint i = 0; i < vLines.size(); i++)
+		{
+			list<STRING_MATCH> lstMatches;
+			iBenchSink += matcher.Find(vLines[i], lstMatches);
+		}
+	}
+	BenchReport("  CStringMatcher::Find, per line", dStart, BENCH_LINES * BENCH_ROUNDS);
+
+	printf("  %u / %u lines with swear words\n", iOld / BENCH_ROUNDS, iNew / BENCH_ROUNDS);
+	return 0;
+}
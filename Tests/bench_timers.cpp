@@ -0,0 +1,119 @@
+#include "test.h"
+
+/**************************************************************************************************************
+10k timers: the timer wheel behind HkScheduleTimer against the polling of the Timers[] arrays it replaced,
+which compared timeInMS() with the last call of every timer on every server frame
+**************************************************************************************************************/
+
+#define BENCH_TIMERS 10000
+#define BENCH_FRAME_MS 10
+#define BENCH_SECONDS 120
+
+// the timer and the loop of IServerImplHook::Update as they were before the timer wheel
+typedef void(*_TimerFunc)();
+
+struct TIMER
+{
+	_TimerFunc	proc;
+	mstime		tmIntervallMS;
+	mstime		tmLastCall;
+};
+
+static vector<TIMER> vPolled;
+static uint iRuns = 0;
+
+static void PolledTimer()
+{
+	iRuns++;
+}
+
+static void PollTimers()
+{
+	for (uint i = 0; (i < vPolled.size()); i++)
+	{
+		if ((timeInMS() - vPolled[i].tmLastCall) >= vPolled[i].tmIntervallMS)
+		{
+			vPolled[i].tmLastCall = timeInMS();
+			vPolled[i].proc();
+		}
+	}
+}
+
+static void WheelTimer(uint iTimerID, void *pData)
+{
+	iRuns++;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the intervals of the plugins' timers, mostly the once a second checks
+static mstime GetInterval(uint i)
+{
+	if (i % 10 == 0)
+		return 50;
+	else if (i % 10 == 1)
+		return 5000;
+	return 1000;
+}
+
+int main()
+{
+	const mstime iFrames = BENCH_SECONDS * 1000 / BENCH_FRAME_MS;
+	printf("%u timers, %u s of %u ms server frames\n", BENCH_TIMERS, BENCH_SECONDS, BENCH_FRAME_MS);
+
+	// polling: every timer looked at on every frame
+	tmTestTime = 1000000;
+	for (uint i = 0; i < BENCH_TIMERS; i++)
+	{
+		TIMER timer = { PolledTimer, GetInterval(i), tmTestTime - (i % GetInterval(i)) };
+		vPolled.push_back(timer);
+	}
+
+	iRuns = 0;
+	double dStart = BenchNow();
+	for (mstime iFrame = 0; iFrame < iFrames; iFrame++)
+	{
+		tmTestTime += BENCH_FRAME_MS;
+		PollTimers();
+	}
+	BenchReport("  polling Timers[], per frame", dStart, iFrames);
+	printf("  %u runs\n", iRuns);
+
+	// the wheel: the same timers, their first runs spread over the interval
+	tmTestTime = 1000000;
+	TimerWheel::Process();
+	vector<uint> vTimerIDs;
+	dStart = BenchNow();
+	for (uint i = 0; i < BENCH_TIMERS; i++)
+		vTimerIDs.push_back(HkScheduleTimer((uint)(GetInterval(i) - i % GetInterval(i)), (uint)GetInterval(i), WheelTimer));
+	BenchReport("  HkScheduleTimer, per timer", dStart, BENCH_TIMERS);
+
+	iRuns = 0;
+	dStart = BenchNow();
+	for (mstime iFrame = 0; iFrame < iFrames; iFrame++)
+	{
+		tmTestTime += BENCH_FRAME_MS;
+		TimerWheel::Process();
+	}
+	BenchReport("  timer wheel, per frame", dStart, iFrames);
+	printf("  %u runs\n", iRuns);
+
+	dStart = BenchNow();
+	for (uint i = 0; i < vTimerIDs.size(); i++)
+		HkCancelTimer(vTimerIDs[i]);
+	BenchReport("  HkCancelTimer, per timer", dStart, BENCH_TIMERS);
+
+	// one-shots all over the wheel's levels, scheduled and run until none is left
+	iRuns = 0;
+	dStart = BenchNow();
+	for (uint i = 0; i < BENCH_TIMERS; i++)
+		HkScheduleTimer((i * 7919) % (600 * 1000), 0, WheelTimer);
+	while (iRuns < BENCH_TIMERS)
+	{
+		tmTestTime += BENCH_FRAME_MS;
+		TimerWheel::Process();
+	}
+	BenchReport("  one-shots over 10 min, per timer", dStart, BENCH_TIMERS);
+
+	return 0;
+}
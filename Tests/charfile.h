@@ -0,0 +1,65 @@
+#ifndef _CHARFILE_
+#define _CHARFILE_
+
+/**************************************************************************************************************
+decoded charfiles with the layout and size of the ones of a long running server: a [Player] section with
+the reputations and cargo, a [mPlayer] section with thousands of visit lines (100 - 200 kb in total)
+**************************************************************************************************************/
+
+inline uint NextRand(uint &iRand)
+{
+	iRand = iRand * 1103515245 + 12345;
+	return iRand >> 8;
+}
+
+inline string MakeCharfile(uint iSeed)
+{
+	uint iRand = iSeed * 2654435761u + 1;
+
+	string scFile;
+	char szBuf[256];
+	scFile += "[Player]\r\n";
+	snprintf(szBuf, sizeof(szBuf), "description = 005400720065006E0074%04u\r\n", iSeed % 10000);
+	scFile += szBuf;
+	scFile += "tstamp = 30847382, 2913813248\r\n";
+	uint iRank = NextRand(iRand) % 100;
+	uint iMoney = NextRand(iRand) % 999999999;
+	snprintf(szBuf, sizeof(szBuf), "name = 005400720065006E0074\r\nrank = %u\r\nmoney = %u\r\n", iRank, iMoney);
+	scFile += szBuf;
+	scFile += "rep_group = fc_freelancer\r\nbase = Li01_01_Base\r\nlocation = 0\r\nship_archetype = 2151746432\r\n";
+	for (uint i = 0; i < 70; i++)
+	{
+		snprintf(szBuf, sizeof(szBuf), "house = %.6f, faction_%02u\r\n", (int)(NextRand(iRand) % 2000) / 1000.0 - 1.0, i);
+		scFile += szBuf;
+	}
+	for (uint i = 0; i < 40; i++)
+	{
+		uint iEquip = NextRand(iRand);
+		uint iCargo = NextRand(iRand);
+		uint iCount = NextRand(iRand) % 3000;
+		snprintf(szBuf, sizeof(szBuf), "equip = %u, HpWeapon%02u, 1\r\ncargo = %u, %u, , , 0\r\n", iEquip, i, iCargo, iCount);
+		scFile += szBuf;
+	}
+	scFile += "\r\n[mPlayer]\r\ncan_dock = 1\r\ncan_tl = 1\r\ntotal_cash_earned = 198712.000000\r\n";
+
+	uint iVisits = 4000 + NextRand(iRand) % 4000;
+	for (uint i = 0; i < iVisits; i++)
+	{
+		uint iBase = NextRand(iRand);
+		uint iFlags = NextRand(iRand) % 2 ? 1 : 65;
+		snprintf(szBuf, sizeof(szBuf), "visit = %u, %u\r\n", iBase, iFlags);
+		scFile += szBuf;
+	}
+	for (uint i = 0; i < 200; i++)
+	{
+		uint iShipType = NextRand(iRand);
+		uint iKills = NextRand(iRand) % 50;
+		snprintf(szBuf, sizeof(szBuf), "ship_type_killed = %u, %u\r\n", iShipType, iKills);
+		scFile += szBuf;
+	}
+	scFile += "rumors_heard = 0\r\n";
+
+	return scFile;
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef _CHAT_
+#define _CHAT_
+
+/**************************************************************************************************************
+made up words and chat lines for the chat filters: lower case words of 3 - 9 letters, lists of them (some
+of two words like in the swear word lists) and lines of 40 - 120 chars in mixed case with punctuation
+**************************************************************************************************************/
+
+class CChatGenerator
+{
+public:
+	CChatGenerator(uint iSeed) : iRand(iSeed * 2654435761u + 1) {}
+
+	uint Rand(uint iRange)
+	{
+		iRand = iRand * 1103515245 + 12345;
+		return (iRand >> 8) % iRange;
+	}
+
+	wstring Word(uint iMinLen = 3)
+	{
+		wstring wscWord;
+		uint iLen = iMinLen + Rand(10 - iMinLen);
+		for (uint i = 0; i < iLen; i++)
+			wscWord += (wchar_t)(L'a' + Rand(26));
+		return wscWord;
+	}
+
+	// iWords different words of at least 4 letters (so that made up lines don't hit them by chance all
+	// the time), every 20th of two words
+	vector<wstring> Words(uint iWords)
+	{
+		set<wstring> setWords;
+		vector<wstring> vWords;
+		while (vWords.size() < iWords)
+		{
+			wstring wscWord = Word(4);
+			if (vWords.size() % 20 == 19)
+				wscWord += L" " + Word();
+			if (setWords.insert(wscWord).second)
+				vWords.push_back(wscWord);
+		}
+		return vWords;
+	}
+
+	// a line of made up words, with a word of vInsert now and then
+	wstring Line(const vector<wstring> &vInsert, uint iInsertPercent)
+	{
+		static const wchar_t *arrSeparators[] = { L" ", L" ", L" ", L", ", L"! ", L"? ", L". ", L" :) " };
+		wstring wscLine;
+		uint iLen = 40 + Rand(80);
+		while (wscLine.length() < iLen)
+		{
+			wstring wscWord = (vInsert.size() && Rand(100) < iInsertPercent) ? vInsert[Rand((uint)vInsert.size())] : Word();
+			if (!Rand(4))
+				wscWord[0] = towupper(wscWord[0]);
+			if (!Rand(10))
+				wscWord = L"x" + wscWord;
+			wscLine += wscWord + arrSeparators[Rand(sizeof(arrSeparators) / sizeof(const wchar_t*))];
+		}
+		return wscLine;
+	}
+
+private:
+	uint iRand;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef _LEGACY_
+#define _LEGACY_
+
+/**************************************************************************************************************
+code as it was before the changes the tests and benchmarks measure, kept to compare the results with
+**************************************************************************************************************/
+
+// flcodec.cpp: one _write per byte
+bool legacy_flc_decode(const char *ifile, const char *ofile);
+bool legacy_flc_encode(const char *ifile, const char *ofile);
+
+// stands in for GetPrivateProfileString, which opens and scans the whole file on every call
+inline string legacy_GetPrivateProfileString(const string &scFile, const string &scApp, const string &scKey)
+{
+	FILE *f = fopen(scFile.c_str(), "rb");
+	if (!f)
+		return "";
+
+	char szLine[1024];
+	bool bInApp = false;
+	string scValue;
+	while (fgets(szLine, sizeof(szLine), f))
+	{
+		string scLine = szLine;
+		scLine.erase(scLine.find_last_not_of("\r\n ") + 1);
+		if (scLine.length() && scLine[0] == '[')
+		{
+			bInApp = !strcasecmp(scLine.c_str(), ("[" + scApp + "]").c_str());
+			continue;
+		}
+
+		size_t iEq = scLine.find('=');
+		if (!bInApp || iEq == string::npos)
+			continue;
+		string scLineKey = scLine.substr(0, scLine.find_last_not_of(' ', iEq - 1) + 1);
+		if (!strcasecmp(scLineKey.c_str(), scKey.c_str()))
+		{
+			scValue = scLine.substr(scLine.find_first_not_of(' ', iEq + 1));
+			break;
+		}
+	}
+
+	fclose(f);
+	return scValue;
+}
+
+// playercntl's Message::SubmitChat: every swear word looked for in the lowered chat line one by one
+inline bool legacy_IsSwearing(list<wstring> &set_lstSwearWords, const wstring &wscText)
+{
+	wstring wscChatMsg = ToLower(wscText);
+	foreach(set_lstSwearWords, wstring, worditer)
+	{
+		if (wscChatMsg.find(*worditer) != -1)
+		{
+			if (*worditer == (L"cock"))
+			{
+				if (wscChatMsg.find(L"cockpit") != -1)
+				{
+					return false;
+				}
+				else if (wscChatMsg.find(L"cockroach") != -1)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+// HkCbChat before the compiled ignore lists, the flags and names of every entry looked at for every line.
+// bPublic is (iTo & 0x10000)
+#define HAS_FLAG(a, b) ((a).wscFlags.find(b) != -1)
+inline bool legacy_IsIgnored(list<IGNORE_INFO> &lstIgnore, const wstring &wscSender, bool bPublic)
+{
+	foreach(lstIgnore, IGNORE_INFO, it)
+	{
+		if (HAS_FLAG(*it, L"p") && bPublic)
+			continue; // no privchat
+		else if (!HAS_FLAG(*it, L"i") && !(ToLower(wscSender).compare(ToLower((*it).wscCharname))))
+			return true; // ignored
+		else if (HAS_FLAG(*it, L"i") && (ToLower(wscSender).find(ToLower((*it).wscCharname)) != -1))
+			return true; // ignored
+	}
+	return false;
+}
+
+#endif
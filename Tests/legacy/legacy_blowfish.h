@@ -0,0 +1,11 @@
+#ifndef _LEGACY_BLOWFISH_
+#define _LEGACY_BLOWFISH_
+
+// blowfish.cpp and SwapBytes before the unrolled rounds and the buffer api, include after blowfish.h
+
+void legacy_Blowfish_Init(BLOWFISH_CTX *ctx, unsigned char *key, int keyLen);
+char legacy_Blowfish_Encrypt(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen);
+char legacy_Blowfish_Decrypt(BLOWFISH_CTX *ctx, void *ptr, unsigned long dataLen);
+void legacy_SwapBytes(void *ptr, uint iLen);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef __MAIN_H__
+#define __MAIN_H__ 1
+
+/**************************************************************************************************************
+stands in for base_plugin's Main.h when BaseIndex.cpp is built on its own: a base is only its system and
+position to the index, HkDistance3D is the one of PluginUtilities
+**************************************************************************************************************/
+
+class Vector
+{
+public:
+	float x, y, z;
+};
+
+inline float HkDistance3D(Vector v1, Vector v2)
+{
+	float sq1 = v1.x - v2.x, sq2 = v1.y - v2.y, sq3 = v1.z - v2.z;
+	return sqrt(sq1*sq1 + sq2 * sq2 + sq3 * sq3);
+}
+
+class PlayerBase
+{
+public:
+	uint base;
+	uint system;
+	Vector position;
+};
+
+extern map<uint, class PlayerBase*> player_bases;
+
+namespace BaseIndex
+{
+	void Add(PlayerBase *base);
+	void Remove(PlayerBase *base);
+	const vector<PlayerBase*>& GetSystemBases(uint system);
+	void FindInRange(uint system, const Vector &pos, float range, vector<PlayerBase*> &bases);
+}
+
+#endif
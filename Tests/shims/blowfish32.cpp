@@ -0,0 +1,5 @@
+// blowfish.cpp with the 32 bit unsigned long it has on windows
+#include <stdlib.h>
+#define long int
+#include "blowfish.cpp"
+#undef long
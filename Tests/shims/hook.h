@@ -0,0 +1,509 @@
+#ifndef _HOOK_
+#define _HOOK_
+
+/**************************************************************************************************************
+stands in for Hook.h and global.h when flhook sources are built on their own for the tests. it is
+force-included in front of every source, so the sources' own includes of hook.h, global.h and CCmds.h
+find their guards already defined. only what the tested files use is declared here, with the same
+signatures as in Hook.h; the windows calls they make are implemented on posix in shim.cpp.
+**************************************************************************************************************/
+
+#define _GLOBAL_
+#define _CCMDS_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <math.h>
+#include <wchar.h>
+#include <wctype.h>
+#include <stdint.h>
+#include <string>
+#include <list>
+#include <vector>
+#include <map>
+#include <set>
+#include <algorithm>
+
+using namespace std;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// compiler
+
+#define __declspec(x)
+#define __forceinline inline
+#define __stdcall
+#define __cdecl
+#define __FUNCDNAME__ __FUNCTION__
+#define _byteswap_ulong(x) __builtin_bswap32(x)
+
+#define IMPORT __declspec(dllimport)
+#define EXPORT __declspec(dllexport)
+#define foreach(lst, type, var) for(list<type>::iterator var = lst.begin(); (var != lst.end()); var++)
+#define foreachreverse(lst, type, var) for(list<type>::reverse_iterator var = lst.rbegin(); (var != lst.rend()); var++)
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// windows types and calls
+
+typedef unsigned int uint;
+typedef unsigned char uchar;
+typedef unsigned short ushort;
+typedef unsigned long ulong;
+typedef unsigned long long mstime;
+
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef int BOOL;
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef const char* LPCSTR;
+typedef intptr_t(*FARPROC)();
+
+#define FALSE 0
+#define TRUE 1
+
+#define GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT 0x2
+#define GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS 0x4
+
+// there are no plugin dlls here, every callback belongs to module 0
+inline BOOL GetModuleHandleEx(DWORD dwFlags, LPCSTR lpModuleName, HMODULE *phModule) { *phModule = 0; return FALSE; }
+
+inline LONG InterlockedExchange(volatile LONG *plTarget, LONG lValue) { return __atomic_exchange_n(plTarget, lValue, __ATOMIC_SEQ_CST); }
+
+inline unsigned char _BitScanForward(unsigned long *piIndex, uint iMask)
+{
+	if (!iMask)
+		return 0;
+	*piIndex = __builtin_ctz(iMask);
+	return 1;
+}
+
+#define _stricmp strcasecmp
+
+struct FILETIME
+{
+	DWORD dwLowDateTime;
+	DWORD dwHighDateTime;
+};
+
+struct WIN32_FILE_ATTRIBUTE_DATA
+{
+	DWORD dwFileAttributes;
+	FILETIME ftCreationTime;
+	FILETIME ftLastAccessTime;
+	FILETIME ftLastWriteTime;
+	DWORD nFileSizeHigh;
+	DWORD nFileSizeLow;
+};
+
+struct BY_HANDLE_FILE_INFORMATION
+{
+	DWORD dwFileAttributes;
+	FILETIME ftCreationTime;
+	FILETIME ftLastAccessTime;
+	FILETIME ftLastWriteTime;
+	DWORD dwVolumeSerialNumber;
+	DWORD nFileSizeHigh;
+	DWORD nFileSizeLow;
+	DWORD nNumberOfLinks;
+	DWORD nFileIndexHigh;
+	DWORD nFileIndexLow;
+};
+
+enum GET_FILEEX_INFO_LEVELS
+{
+	GetFileExInfoStandard,
+};
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define GENERIC_READ 0x80000000
+#define GENERIC_WRITE 0x40000000
+#define FILE_SHARE_READ 0x1
+#define FILE_SHARE_WRITE 0x2
+#define CREATE_ALWAYS 2
+#define OPEN_EXISTING 3
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define ERROR_FILE_NOT_FOUND 2
+#define ERROR_PATH_NOT_FOUND 3
+
+// "C:\dir\file" is passed on as "/dir/file", so the full path checks of the sources still apply
+HANDLE CreateFile(LPCSTR szPath, DWORD dwAccess, DWORD dwShare, void *pSecurity, DWORD dwDisposition, DWORD dwAttributes, HANDLE hTemplate);
+BOOL ReadFile(HANDLE hFile, void *pBuffer, DWORD dwToRead, DWORD *pdwRead, void *pOverlapped);
+BOOL WriteFile(HANDLE hFile, const void *pBuffer, DWORD dwToWrite, DWORD *pdwWritten, void *pOverlapped);
+BOOL CloseHandle(HANDLE hFile);
+BOOL GetFileInformationByHandle(HANDLE hFile, BY_HANDLE_FILE_INFORMATION *pInfo);
+BOOL GetFileAttributesEx(LPCSTR szPath, GET_FILEEX_INFO_LEVELS eLevel, void *pInfo);
+LONG CompareFileTime(const FILETIME *pft1, const FILETIME *pft2);
+DWORD GetLastError();
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// flhook tools
+
+#define MAX_CLIENT_ID 249
+
+#define LOG_EXCEPTION { AddLog("ERROR: Exception in %s", __FUNCTION__); }
+
+struct INISECTIONVALUE
+{
+	string scKey;
+	string scValue;
+};
+
+EXPORT void AddLog(const char *szString, ...);
+EXPORT wstring stows(const string &scText);
+EXPORT string wstos(const wstring &wscText);
+EXPORT string itos(int i);
+EXPORT wstring ToLower(const wstring &wscStr);
+EXPORT string ToLower(const string &scStr);
+
+// milliseconds like the real timeInMS, unless a test set tmTestTime to run the clock by hand
+extern mstime tmTestTime;
+EXPORT mstime timeInMS();
+
+// number of AddLog calls so far, tests use it to check that errors were reported
+extern uint iTestLogLines;
+
+// makes a windows style full path ("C:/tmp/...") of a file in a fresh temporary directory
+string TestPath(const string &scFile);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// plugin dispatch (HkPluginManager)
+
+enum PLUGIN_RETURNCODE
+{
+	DEFAULT_RETURNCODE = 0,
+	SKIPPLUGINS = 1,
+	SKIPPLUGINS_NOFUNCTIONCALL = 2,
+	NOFUNCTIONCALL = 3,
+};
+
+struct PLUGIN_DISPATCH_ENTRY
+{
+	FARPROC* pFunc;
+	PLUGIN_RETURNCODE* ePluginReturnCode;
+	const char* szName;
+	uint iTimerID;
+};
+
+struct PLUGIN_DISPATCH_TABLE
+{
+	PLUGIN_DISPATCH_ENTRY* pEntries;
+	uint iCount;
+};
+
+namespace PerfTimers
+{
+	extern EXPORT bool bEnabled;
+	EXPORT mstime Start();
+	EXPORT void Stop(uint iTimerID, mstime tmStart);
+}
+
+// number of PerfTimers::Stop calls so far
+extern uint iTestPerfSamples;
+
+extern EXPORT PLUGIN_DISPATCH_TABLE* pPluginDispatch;
+extern EXPORT bool g_bPlugin_nofunctioncall;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HkScheduler
+
+typedef void(*TIMER_CALLBACK)(uint iTimerID, void *pData);
+EXPORT uint HkScheduleTimer(uint iDelayMS, uint iIntervalMS, TIMER_CALLBACK callback, void *pData = 0, uint iClientID = 0);
+EXPORT bool HkCancelTimer(uint iTimerID);
+EXPORT void HkCancelClientTimers(uint iClientID);
+namespace TimerWheel
+{
+	void Process();
+	void CancelModule(HMODULE hModule);
+	void PauseModule(HMODULE hModule, bool bPause);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HkIniCache
+
+namespace IniCache
+{
+	bool Get(const string &scFile, const string &scApp, const string &scKey, string &scValue, bool &bFound);
+	bool GetSection(const string &scFile, const string &scApp, list<INISECTIONVALUE> &lstValues);
+	bool Write(const string &scFile, const string &scApp, const string &scKey, const string &scValue);
+	bool Delete(const string &scFile, const string &scApp, const string &scKey);
+	bool DelSection(const string &scFile, const string &scApp);
+	void BeginBatch();
+	void EndBatch();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HkPlayerIndex and the server state it reads, the ignore lists and the last hit in ClientInfo
+
+class CAccount;
+
+enum IGNORE_FLAGS
+{
+	IGNORE_PRIVATE = 1,		// "p", only private chat
+	IGNORE_SUBSTRING = 2,	// "i", charname contains wscCharname
+};
+
+struct IGNORE_INFO
+{
+	wstring wscCharname;
+	wstring wscFlags;
+	// compiled from the above by IgnoreInfoCompile
+	wstring wscCharnameLower;
+	uint iFlags;
+};
+
+// the members of FLCoreCommon.h's DamageList, its calls are in the server's common.dll
+enum DamageCause
+{
+	DC_GUN = 1,
+};
+
+struct DamageEntry
+{
+	enum SubObjFate
+	{
+		FATE_ALIVE = 0,
+	};
+
+	ushort subobj;
+	float health;
+	SubObjFate fate;
+};
+
+struct DamageList
+{
+	DamageList() : iDunno1(0), bDestroyed(false), iDunno2(0), iInflictorID(0), iInflictorPlayerID(0) {}
+	void add_damage_entry(ushort subobj, float health, DamageEntry::SubObjFate fate) { DamageEntry e = { subobj, health, fate }; damageentries.push_back(e); }
+	DamageCause get_cause() const { return (DamageCause)iDunno2; }
+	uint get_inflictor_id() const { return iInflictorID; }
+	uint get_inflictor_owner_player() const { return iInflictorPlayerID; }
+	bool is_inflictor_a_player() const { return iInflictorPlayerID != 0; }
+	void set_cause(DamageCause cause) { iDunno2 = cause; }
+	void set_inflictor_id(uint iID) { iInflictorID = iID; }
+	void set_inflictor_owner_player(uint iClientID) { iInflictorPlayerID = iClientID; }
+
+	uint iDunno1;
+	list<DamageEntry> damageentries;
+	bool bDestroyed;
+	uint iDunno2;
+	uint iInflictorID;
+	uint iInflictorPlayerID;
+};
+
+// the last hull hit of a player, only kept as the few values the death message needs
+struct DAMAGE_INFO
+{
+	uint iInflictorShip;
+	uint iInflictorClient;
+	uint iCause;
+	mstime tmTime;
+};
+
+struct CLIENT_INFO
+{
+	uint iShip;
+	uint iShipOld;
+	DAMAGE_INFO dmgLast;
+	list<IGNORE_INFO> lstIgnore;
+};
+
+EXPORT void HkSetLastDamage(uint iClientID, const DamageList &dmg);
+EXPORT void HkGetLastDamage(uint iClientID, DamageList &dmg);
+
+extern EXPORT CLIENT_INFO ClientInfo[MAX_CLIENT_ID + 1];
+extern EXPORT list<uint> set_lstNoPVPSystems;
+EXPORT void HkGetPlayerIP(uint iClientID, wstring &wscIP);
+
+namespace pub
+{
+	int GetBaseNickname(char *szNickname, uint iSize, const uint &iBaseID);
+	int GetSystemNickname(char *szNickname, uint iSize, const uint &iSystemID);
+
+	namespace Player
+	{
+		int GetSystem(const uint &iClientID, uint &iSystemID);
+		int GetBase(const uint &iClientID, uint &iBaseID);
+		int GetShip(const uint &iClientID, uint &iShip);
+	}
+}
+
+struct PlayerDB
+{
+	const wchar_t* GetActiveCharacterName(uint iClientID) const;
+	CAccount* FindAccountFromClientID(uint iClientID) const;
+};
+extern PlayerDB Players;
+
+struct PLAYER_SNAPSHOT
+{
+	uint iClientID;
+	uint iGeneration; // changes whenever one of the fields below changes
+	wstring wscCharname;
+	wstring wscBase;
+	wstring wscSystem;
+	uint iBase;
+	uint iSystem;
+	uint iShip;
+	wstring wscIP;
+};
+
+#define CLIENT_SET_WORDS ((MAX_CLIENT_ID + 32) / 32)
+
+struct CLIENT_SET
+{
+	uint arrBits[CLIENT_SET_WORDS];
+};
+
+inline void ClientSetAdd(CLIENT_SET &clients, uint iClientID) { clients.arrBits[iClientID >> 5] |= (1u << (iClientID & 31)); }
+inline void ClientSetRemove(CLIENT_SET &clients, uint iClientID) { clients.arrBits[iClientID >> 5] &= ~(1u << (iClientID & 31)); }
+inline bool ClientSetContains(const CLIENT_SET &clients, uint iClientID) { return (clients.arrBits[iClientID >> 5] & (1u << (iClientID & 31))) != 0; }
+
+inline uint ClientSetNext(const CLIENT_SET &clients, uint iClientID)
+{
+	uint iNext = iClientID + 1;
+	for (uint iWord = (iNext >> 5); iWord < CLIENT_SET_WORDS; iWord++)
+	{
+		uint iBits = clients.arrBits[iWord];
+		if (iWord == (iNext >> 5))
+			iBits &= (~0u << (iNext & 31));
+
+		unsigned long iBit;
+		if (_BitScanForward(&iBit, iBits))
+			return (iWord << 5) + iBit;
+	}
+
+	return 0;
+}
+
+namespace PlayerIndex
+{
+	void Refresh(uint iClientID);
+	void ShipDestroyed(uint iClientID);
+	void Remove(uint iClientID);
+	void ShipsChanged(uint iClientID);
+	EXPORT uint FindShip(uint iShip);
+	EXPORT uint GetSystem(uint iClientID);
+	EXPORT bool InNoPvPSystem(uint iClientID);
+	void NoPvPSystemsChanged();
+	EXPORT uint GetBase(uint iClientID);
+	EXPORT uint GetShip(uint iClientID);
+	EXPORT CAccount* GetAccount(uint iClientID);
+	EXPORT uint FindCharname(const wstring &wscCharname);
+	EXPORT uint FindAccount(CAccount *acc);
+	EXPORT const CLIENT_SET& GetOnlineClients();
+	EXPORT const CLIENT_SET& GetSystemClients(uint iSystemID);
+	EXPORT const PLAYER_SNAPSHOT* GetPlayer(uint iClientID);
+	EXPORT uint GetGeneration();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HkCharFile
+
+#include "flcodec.h"
+
+enum HK_ERROR
+{
+	HKE_OK,
+	HKE_CHAR_DOES_NOT_EXIST,
+	HKE_COULD_NOT_DECODE_CHARFILE,
+	HKE_COULD_NOT_ENCODE_CHARFILE,
+	HKE_UNKNOWN_ERROR,
+};
+
+struct CHARFILE
+{
+	FILETIME ftLastWrite;
+	DWORD dwSize;
+	bool bEncoded;
+	vector<string> vLines;
+	bool bTrailingNewline;
+};
+
+namespace CharFileCache
+{
+	HK_ERROR Load(const string &scPath, const CHARFILE *&charfile);
+	HK_ERROR Save(const string &scPath, CHARFILE &charfile, bool bEncode);
+	void Invalidate(const string &scPath);
+	string GetValue(const CHARFILE &charfile, const string &scSection, const string &scKey, const string &scDefault);
+	void SetValue(CHARFILE &charfile, const string &scSection, const string &scKey, const string &scValue);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CStringMatcher
+
+struct STRING_MATCH
+{
+	uint iPos;
+	uint iLen;
+	uint iMask;
+};
+
+class CStringMatcher
+{
+public:
+	EXPORT CStringMatcher();
+	EXPORT void Clear();
+	EXPORT void Add(const wstring &wscPattern, uint iMask, bool bWholeWord = false);
+	EXPORT void Compile();
+	EXPORT uint Match(const wstring &wscText) const;
+	EXPORT uint Find(const wstring &wscText, list<STRING_MATCH> &lstMatches) const;
+	EXPORT bool Empty() const;
+
+private:
+	struct NODE
+	{
+		map<wchar_t, uint> mapNext;
+		uint iFail;
+		uint iOutput;
+		uint iLen;
+		uint iMask;
+		uint iWordMask;
+	};
+
+	uint Next(uint iNode, wchar_t wc) const;
+	uint Scan(const wstring &wscText, list<STRING_MATCH> *lstMatches) const;
+
+	vector<NODE> vNodes;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HkIgnoreFilter
+
+void IgnoreInfoCompile(IGNORE_INFO &ii);
+namespace IgnoreFilter
+{
+	void Rebuild(uint iClientID);
+	bool IsIgnored(uint iClientID, const wstring &wscSenderLower, bool bPrivate);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// CCmds, the base of CSocket, and the admin commands of the plugins (HkAdminCommands.cpp)
+
+class CCmds
+{
+public:
+	DWORD rights;
+
+	CCmds() : rights(0) {}
+	virtual ~CCmds() {}
+	EXPORT void Print(wstring wscText, ...);
+	virtual void DoPrint(const wstring &wscText) = 0;
+	virtual wstring GetAdminName() = 0;
+};
+
+typedef bool(*ADMIN_CMD_CALLBACK)(CCmds *cmds, const wstring &wscCmd);
+EXPORT bool HkRegisterAdminCommand(const wstring &wscCmd, DWORD dwRights, ADMIN_CMD_CALLBACK callback);
+EXPORT void HkUnregisterAdminCommand(const wstring &wscCmd);
+namespace AdminCommands
+{
+	bool Register(const wstring &wscCmd, DWORD dwRights, ADMIN_CMD_CALLBACK callback);
+	void Unregister(const wstring &wscCmd);
+	void PauseModule(HMODULE hModule, bool bPause);
+	void RemoveModule(HMODULE hModule);
+	bool Execute(CCmds *cmds, const wstring &wscCmd);
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef _SHIM_IO_
+#define _SHIM_IO_
+
+// the msvc low level i/o calls used by flcodec.cpp
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#define _O_BINARY 0
+#define _open open
+#define _read read
+#define _write write
+#define _lseek lseek
+#define _close close
+
+#endif
@@ -0,0 +1,232 @@
+#include "hook.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <ftw.h>
+
+/**************************************************************************************************************
+posix versions of the windows calls and flhook tools declared in shims/hook.h
+**************************************************************************************************************/
+
+mstime tmTestTime = 0;
+uint iTestLogLines = 0;
+uint iTestPerfSamples = 0;
+
+PLUGIN_DISPATCH_TABLE* pPluginDispatch = 0;
+bool g_bPlugin_nofunctioncall = false;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static string PosixPath(LPCSTR szPath)
+{
+	string scPath = szPath;
+	if (scPath.length() >= 2 && scPath[1] == ':')
+		scPath = scPath.substr(2);
+	replace(scPath.begin(), scPath.end(), '\\', '/');
+	return scPath;
+}
+
+static HANDLE ToHandle(int fd)
+{
+	return (fd == -1) ? INVALID_HANDLE_VALUE : (HANDLE)(intptr_t)fd;
+}
+
+static int ToFD(HANDLE hFile)
+{
+	return (int)(intptr_t)hFile;
+}
+
+static FILETIME ToFileTime(const struct stat &st)
+{
+	// 100ns ticks are all a test needs, the epoch doesn't matter
+	unsigned long long iTicks = (unsigned long long)st.st_mtim.tv_sec * 10000000ull + st.st_mtim.tv_nsec / 100;
+	FILETIME ft;
+	ft.dwLowDateTime = (DWORD)iTicks;
+	ft.dwHighDateTime = (DWORD)(iTicks >> 32);
+	return ft;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HANDLE CreateFile(LPCSTR szPath, DWORD dwAccess, DWORD dwShare, void *pSecurity, DWORD dwDisposition, DWORD dwAttributes, HANDLE hTemplate)
+{
+	int iFlags = (dwAccess & GENERIC_WRITE) ? ((dwAccess & GENERIC_READ) ? O_RDWR : O_WRONLY) : O_RDONLY;
+	if (dwDisposition == CREATE_ALWAYS)
+		iFlags |= O_CREAT | O_TRUNC;
+
+	return ToHandle(open(PosixPath(szPath).c_str(), iFlags, 0644));
+}
+
+BOOL ReadFile(HANDLE hFile, void *pBuffer, DWORD dwToRead, DWORD *pdwRead, void *pOverlapped)
+{
+	ssize_t iRead = read(ToFD(hFile), pBuffer, dwToRead);
+	*pdwRead = (iRead < 0) ? 0 : (DWORD)iRead;
+	return iRead >= 0;
+}
+
+BOOL WriteFile(HANDLE hFile, const void *pBuffer, DWORD dwToWrite, DWORD *pdwWritten, void *pOverlapped)
+{
+	ssize_t iWritten = write(ToFD(hFile), pBuffer, dwToWrite);
+	*pdwWritten = (iWritten < 0) ? 0 : (DWORD)iWritten;
+	return iWritten >= 0;
+}
+
+BOOL CloseHandle(HANDLE hFile)
+{
+	return close(ToFD(hFile)) == 0;
+}
+
+BOOL GetFileInformationByHandle(HANDLE hFile, BY_HANDLE_FILE_INFORMATION *pInfo)
+{
+	struct stat st;
+	if (fstat(ToFD(hFile), &st) != 0)
+		return FALSE;
+
+	memset(pInfo, 0, sizeof(*pInfo));
+	pInfo->ftLastWriteTime = ToFileTime(st);
+	pInfo->nFileSizeLow = (DWORD)st.st_size;
+	return TRUE;
+}
+
+BOOL GetFileAttributesEx(LPCSTR szPath, GET_FILEEX_INFO_LEVELS eLevel, void *pInfo)
+{
+	struct stat st;
+	if (stat(PosixPath(szPath).c_str(), &st) != 0)
+		return FALSE;
+
+	WIN32_FILE_ATTRIBUTE_DATA *pData = (WIN32_FILE_ATTRIBUTE_DATA*)pInfo;
+	memset(pData, 0, sizeof(*pData));
+	pData->ftLastWriteTime = ToFileTime(st);
+	pData->nFileSizeLow = (DWORD)st.st_size;
+	return TRUE;
+}
+
+LONG CompareFileTime(const FILETIME *pft1, const FILETIME *pft2)
+{
+	unsigned long long i1 = ((unsigned long long)pft1->dwHighDateTime << 32) | pft1->dwLowDateTime;
+	unsigned long long i2 = ((unsigned long long)pft2->dwHighDateTime << 32) | pft2->dwLowDateTime;
+	return (i1 < i2) ? -1 : ((i1 > i2) ? 1 : 0);
+}
+
+DWORD GetLastError()
+{
+	return (errno == ENOENT) ? ERROR_FILE_NOT_FOUND : (errno == ENOTDIR ? ERROR_PATH_NOT_FOUND : (DWORD)errno);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AddLog(const char *szString, ...)
+{
+	iTestLogLines++;
+}
+
+wstring stows(const string &scText)
+{
+	return wstring(scText.begin(), scText.end());
+}
+
+string wstos(const wstring &wscText)
+{
+	string scText;
+	for (uint i = 0; i < wscText.length(); i++)
+		scText += (char)wscText[i];
+	return scText;
+}
+
+string itos(int i)
+{
+	char szBuf[16];
+	sprintf(szBuf, "%d", i);
+	return szBuf;
+}
+
+wstring ToLower(const wstring &wscStr)
+{
+	wstring wscResult = wscStr;
+	for (uint i = 0; i < wscResult.length(); i++)
+		wscResult[i] = towlower(wscResult[i]);
+	return wscResult;
+}
+
+string ToLower(const string &scStr)
+{
+	string scResult = scStr;
+	for (uint i = 0; i < scResult.length(); i++)
+		scResult[i] = tolower(scResult[i]);
+	return scResult;
+}
+
+mstime timeInMS()
+{
+	if (tmTestTime)
+		return tmTestTime;
+
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (mstime)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the histograms of HkTimers.cpp aren't kept here, Stop only counts the samples
+namespace PerfTimers
+{
+	bool bEnabled = false;
+
+	mstime Start()
+	{
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (mstime)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+	}
+
+	void Stop(uint iTimerID, mstime tmStart)
+	{
+		iTestPerfSamples++;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void CCmds::Print(wstring wscText, ...)
+{
+	wchar_t wszBuf[1024 * 8] = L"";
+	va_list marker;
+	va_start(marker, wscText);
+	vswprintf(wszBuf, sizeof(wszBuf) / sizeof(wchar_t) - 1, wscText.c_str(), marker);
+	va_end(marker);
+
+	DoPrint(wszBuf);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static string scTestDir;
+
+static int RemoveEntry(const char *szPath, const struct stat *st, int iType, struct FTW *ftw)
+{
+	return remove(szPath);
+}
+
+static void RemoveTestDir()
+{
+	nftw(scTestDir.c_str(), RemoveEntry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+string TestPath(const string &scFile)
+{
+	if (scTestDir.empty())
+	{
+		char szDir[] = "/tmp/flhook_tests_XXXXXX";
+		if (!mkdtemp(szDir))
+		{
+			perror("mkdtemp");
+			exit(1);
+		}
+		scTestDir = szDir;
+		atexit(RemoveTestDir);
+	}
+
+	return "C:" + scTestDir + "/" + scFile;
+}
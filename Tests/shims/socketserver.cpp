@@ -0,0 +1,307 @@
+#include "socketserver.h"
+
+/**************************************************************************************************************
+the simulated sockets and threads of shims/socketserver.h
+**************************************************************************************************************/
+
+SOCKET sListen = INVALID_SOCKET;
+SOCKET sWListen = INVALID_SOCKET;
+SOCKET sEListen = INVALID_SOCKET;
+SOCKET sEWListen = INVALID_SOCKET;
+BLOWFISH_CTX *set_BF_CTX = 0;
+
+struct SIM_SOCKET
+{
+	bool bListener;
+	bool bClosed;
+	list<SOCKET> lstBacklog;
+	string scInput;
+	uint iInputPos;
+	bool bHangUp;
+	uint iReadRate;
+	uint iReadable; // what the client reads until the next select()
+	bool bKeep;
+	string scReceived;
+	unsigned long long iReceived;
+};
+
+static vector<SIM_SOCKET> vSockets;
+static int iLastError = 0;
+
+// socket 0 would look like a valid handle that was never opened
+#define SIM_SOCKET_BASE 3
+
+static SIM_SOCKET* GetSocket(SOCKET s)
+{
+	if (s < SIM_SOCKET_BASE || (uint)(s - SIM_SOCKET_BASE) >= vSockets.size())
+		return 0;
+	return &vSockets[s - SIM_SOCKET_BASE];
+}
+
+static SOCKET NewSocket()
+{
+	SIM_SOCKET sock;
+	sock.bListener = false;
+	sock.bClosed = false;
+	sock.iInputPos = 0;
+	sock.bHangUp = false;
+	sock.iReadRate = 0;
+	sock.iReadable = 0;
+	sock.bKeep = false;
+	sock.iReceived = 0;
+	vSockets.push_back(sock);
+	return (SOCKET)vSockets.size() - 1 + SIM_SOCKET_BASE;
+}
+
+static int Fail(int iError)
+{
+	iLastError = iError;
+	return SOCKET_ERROR;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+SOCKET SimListen()
+{
+	SOCKET s = NewSocket();
+	GetSocket(s)->bListener = true;
+	return s;
+}
+
+SOCKET SimAddClient(SOCKET sListener, const string &scInput, uint iReadRate, bool bKeep)
+{
+	SOCKET s = NewSocket();
+	SIM_SOCKET *sock = GetSocket(s);
+	sock->scInput = scInput;
+	sock->iReadRate = iReadRate;
+	sock->bKeep = bKeep;
+	GetSocket(sListener)->lstBacklog.push_back(s);
+	return s;
+}
+
+void SimHangUp(SOCKET s)
+{
+	GetSocket(s)->bHangUp = true;
+}
+
+const string& SimGetReceived(SOCKET s)
+{
+	return GetSocket(s)->scReceived;
+}
+
+unsigned long long SimGetReceivedBytes(SOCKET s)
+{
+	return GetSocket(s)->iReceived;
+}
+
+bool SimIsClosed(SOCKET s)
+{
+	return GetSocket(s)->bClosed;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// only listeners and clients are simulated, the wake sockets can't be created
+SOCKET SimSocket(int iFamily, int iType, int iProtocol)
+{
+	Fail(WSAEWOULDBLOCK);
+	return INVALID_SOCKET;
+}
+
+int SimBind(SOCKET s, const sockaddr *adr, int iLen) { return Fail(WSAEWOULDBLOCK); }
+int SimConnect(SOCKET s, const sockaddr *adr, int iLen) { return Fail(WSAEWOULDBLOCK); }
+int SimGetSockName(SOCKET s, sockaddr *adr, int *piLen) { return Fail(WSAEWOULDBLOCK); }
+int SimSetSockOpt(SOCKET s, int iLevel, int iName, const char *pValue, int iLen) { return 0; }
+int ioctlsocket(SOCKET s, long iCmd, ulong *plArg) { return 0; }
+int WSAGetLastError() { return iLastError; }
+
+SOCKET SimAccept(SOCKET s, sockaddr *adr, int *piLen)
+{
+	SIM_SOCKET *sock = GetSocket(s);
+	if (!sock || !sock->bListener || sock->lstBacklog.empty())
+	{
+		Fail(WSAEWOULDBLOCK);
+		return INVALID_SOCKET;
+	}
+
+	SOCKET sClient = sock->lstBacklog.front();
+	sock->lstBacklog.pop_front();
+
+	// the port tells the clients apart
+	sockaddr_in *adrIn = (sockaddr_in*)adr;
+	memset(adrIn, 0, sizeof(sockaddr_in));
+	adrIn->sin_family = AF_INET;
+	adrIn->sin_port = (ushort)sClient;
+	adrIn->sin_addr.s_addr = SimInetAddr("127.0.0.1");
+	*piLen = sizeof(sockaddr_in);
+	return sClient;
+}
+
+int SimSend(SOCKET s, const char *pData, int iLen, int iFlags)
+{
+	SIM_SOCKET *sock = GetSocket(s);
+	if (!sock || sock->bClosed)
+		return Fail(WSAEWOULDBLOCK + 1);
+
+	uint iSent = min((uint)iLen, sock->iReadable);
+	if (!iSent)
+		return Fail(WSAEWOULDBLOCK);
+
+	sock->iReadable -= iSent;
+	sock->iReceived += iSent;
+	if (sock->bKeep)
+		sock->scReceived.append(pData, iSent);
+	return (int)iSent;
+}
+
+int SimRecv(SOCKET s, char *pData, int iLen, int iFlags)
+{
+	SIM_SOCKET *sock = GetSocket(s);
+	if (!sock || sock->bClosed)
+		return Fail(WSAEWOULDBLOCK + 1);
+
+	uint iLeft = (uint)sock->scInput.length() - sock->iInputPos;
+	if (!iLeft)
+		return sock->bHangUp ? 0 : Fail(WSAEWOULDBLOCK);
+
+	uint iRead = min((uint)iLen, iLeft);
+	memcpy(pData, sock->scInput.data() + sock->iInputPos, iRead);
+	sock->iInputPos += iRead;
+	return (int)iRead;
+}
+
+// keeps the ready sockets in the sets like winsock does, every client reads its rate of bytes per call
+int SimSelect(int iCount, fd_set *pRead, fd_set *pWrite, fd_set *pExcept, const timeval *pTimeout)
+{
+	for (uint i = 0; i < vSockets.size(); i++)
+		vSockets[i].iReadable = vSockets[i].iReadRate;
+
+	int iReady = 0;
+	SIM_FD_SET *setRead = (SIM_FD_SET*)pRead;
+	if (setRead)
+	{
+		u_int iKept = 0;
+		for (u_int i = 0; i < setRead->fd_count; i++)
+		{
+			SIM_SOCKET *sock = GetSocket(setRead->fd_array[i]);
+			if (!sock || sock->bClosed)
+				continue;
+
+			if (sock->bListener ? !sock->lstBacklog.empty() : (sock->iInputPos < sock->scInput.length() || sock->bHangUp))
+				setRead->fd_array[iKept++] = setRead->fd_array[i];
+		}
+		setRead->fd_count = iKept;
+		iReady += iKept;
+	}
+
+	SIM_FD_SET *setWrite = (SIM_FD_SET*)pWrite;
+	if (setWrite)
+	{
+		u_int iKept = 0;
+		for (u_int i = 0; i < setWrite->fd_count; i++)
+		{
+			SIM_SOCKET *sock = GetSocket(setWrite->fd_array[i]);
+			if (sock && !sock->bClosed && sock->iReadable)
+				setWrite->fd_array[iKept++] = setWrite->fd_array[i];
+		}
+		setWrite->fd_count = iKept;
+		iReady += iKept;
+	}
+
+	// nothing to wait for in memory, let the other thread run instead
+	if (!iReady)
+		std::this_thread::yield();
+	return iReady;
+}
+
+bool SimFdIsSet(SOCKET s, const SIM_FD_SET *set)
+{
+	for (u_int i = 0; i < set->fd_count; i++)
+	{
+		if (set->fd_array[i] == s)
+			return true;
+	}
+	return false;
+}
+
+int closesocket(SOCKET s)
+{
+	SIM_SOCKET *sock = GetSocket(s);
+	if (!sock)
+		return Fail(WSAEWOULDBLOCK + 1);
+
+	sock->bClosed = true;
+	return 0;
+}
+
+ulong SimInetAddr(const char *szIP)
+{
+	uint a = 0, b = 0, c = 0, d = 0;
+	sscanf(szIP, "%u.%u.%u.%u", &a, &b, &c, &d);
+	return a | (b << 8) | (c << 16) | (d << 24);
+}
+
+char* SimInetNtoa(in_addr adr)
+{
+	static char szIP[16];
+	ulong l = adr.s_addr;
+	snprintf(szIP, sizeof(szIP), "%u.%u.%u.%u", (uint)(l & 0xFF), (uint)((l >> 8) & 0xFF), (uint)((l >> 16) & 0xFF), (uint)((l >> 24) & 0xFF));
+	return szIP;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+HANDLE CreateThread(void *pSecurity, size_t iStackSize, LPTHREAD_START_ROUTINE proc, LPVOID lpParam, DWORD dwFlags, DWORD *pdwID)
+{
+	*pdwID = 0;
+	return new std::thread(proc, lpParam);
+}
+
+DWORD WaitForSingleObject(HANDLE hHandle, DWORD dwMS)
+{
+	((std::thread*)hHandle)->join();
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ConPrint(wstring wscText, ...)
+{
+}
+
+wstring GetParam(const wstring &wscLine, wchar_t wcSplitChar, uint iPos)
+{
+	uint i = 0, j = 0;
+
+	wstring wscResult = L"";
+	for (i = 0, j = 0; (i <= iPos) && (j < wscLine.length()); j++)
+	{
+		if (wscLine[j] == wcSplitChar)
+		{
+			while (((j + 1) < wscLine.length()) && (wscLine[j + 1] == wcSplitChar))
+				j++; // skip "whitechar"
+
+			i++;
+			continue;
+		}
+
+		if (i == iPos)
+			wscResult += wscLine[j];
+	}
+
+	return wscResult;
+}
+
+int SimSwprintf(wchar_t *wszBuf, const wchar_t *wszFormat, ...)
+{
+	// glibc takes %s for narrow strings, %ls for wide ones
+	wstring wscFormat = wszFormat;
+	for (size_t i = 0; (i = wscFormat.find(L"%s", i)) != wstring::npos; i += 3)
+		wscFormat.replace(i, 2, L"%ls");
+
+	va_list marker;
+	va_start(marker, wszFormat);
+	int iLen = vswprintf(wszBuf, 1024, wscFormat.c_str(), marker);
+	va_end(marker);
+	return iLen;
+}
@@ -0,0 +1,132 @@
+#ifndef _SHIM_SOCKETSERVER_
+#define _SHIM_SOCKETSERVER_
+
+/**************************************************************************************************************
+stands in for winsock and the rest of what SocketServer.cpp uses, so a test can include the source itself
+and drive its network loop (Poll, ProcessEvents) from its own thread. the sockets are simulated in memory:
+a listener has a backlog of clients, a client has the bytes it sends and a rate at which it reads what the
+server sends, sends beyond it fail with WSAEWOULDBLOCK like a full socket buffer would.
+only the network thread may call the winsock functions and the Sim* functions.
+**************************************************************************************************************/
+
+#include <unistd.h>
+#include <thread>
+
+#define long int
+#include "blowfish.h"
+#undef long
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// winsock
+
+typedef int SOCKET;
+
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#define WSAEWOULDBLOCK 10035
+#define AF_INET 2
+#define SOCK_DGRAM 2
+#define SOL_SOCKET 0xffff
+#define SO_SNDBUF 0x1001
+#define FIONBIO 0x8004667e
+
+struct in_addr
+{
+	ulong s_addr;
+};
+
+struct sockaddr
+{
+	ushort sa_family;
+	char sa_data[14];
+};
+
+struct sockaddr_in
+{
+	short sin_family;
+	ushort sin_port;
+	struct in_addr sin_addr;
+	char sin_zero[8];
+};
+
+// the fd_set of winsock, SocketServer.cpp casts its own larger set to it
+struct SIM_FD_SET
+{
+	u_int fd_count;
+	SOCKET fd_array[1];
+};
+
+// glibc has some of these names already, the source gets the simulated ones
+#define socket SimSocket
+#define bind SimBind
+#define connect SimConnect
+#define accept SimAccept
+#define getsockname SimGetSockName
+#define setsockopt SimSetSockOpt
+#define send SimSend
+#define recv SimRecv
+#define select SimSelect
+#define inet_addr SimInetAddr
+#define inet_ntoa SimInetNtoa
+#undef FD_ISSET
+#define FD_ISSET(s, set) SimFdIsSet(s, (SIM_FD_SET*)(set))
+
+SOCKET SimSocket(int iFamily, int iType, int iProtocol);
+int SimBind(SOCKET s, const sockaddr *adr, int iLen);
+int SimConnect(SOCKET s, const sockaddr *adr, int iLen);
+SOCKET SimAccept(SOCKET s, sockaddr *adr, int *piLen);
+int SimGetSockName(SOCKET s, sockaddr *adr, int *piLen);
+int SimSetSockOpt(SOCKET s, int iLevel, int iName, const char *pValue, int iLen);
+int SimSend(SOCKET s, const char *pData, int iLen, int iFlags);
+int SimRecv(SOCKET s, char *pData, int iLen, int iFlags);
+int SimSelect(int iCount, fd_set *pRead, fd_set *pWrite, fd_set *pExcept, const timeval *pTimeout);
+ulong SimInetAddr(const char *szIP);
+char* SimInetNtoa(in_addr adr);
+bool SimFdIsSet(SOCKET s, const SIM_FD_SET *set);
+int closesocket(SOCKET s);
+int ioctlsocket(SOCKET s, long iCmd, ulong *plArg);
+int WSAGetLastError();
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// threads
+
+#define WINAPI
+#define INFINITE 0xFFFFFFFF
+typedef void* LPVOID;
+typedef DWORD(*LPTHREAD_START_ROUTINE)(LPVOID lpParam);
+
+HANDLE CreateThread(void *pSecurity, size_t iStackSize, LPTHREAD_START_ROUTINE proc, LPVOID lpParam, DWORD dwFlags, DWORD *pdwID);
+DWORD WaitForSingleObject(HANDLE hHandle, DWORD dwMS);
+inline void Sleep(DWORD dwMS) { usleep(dwMS * 1000); }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// flhook
+
+extern BLOWFISH_CTX *set_BF_CTX;
+EXPORT void ConPrint(wstring wscText, ...);
+EXPORT wstring GetParam(const wstring &wscLine, wchar_t wcSplitChar, uint iPos);
+
+// msvc's swprintf, without the size and with %s for wide strings
+int SimSwprintf(wchar_t *wszBuf, const wchar_t *wszFormat, ...);
+#define swprintf SimSwprintf
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// the simulated clients
+
+#define SIM_READ_ALL 0xFFFFFFFF
+
+// a listening socket, to be assigned to sListen, sWListen etc.
+SOCKET SimListen();
+
+// a client in the backlog of the listener. scInput is what it sends, it reads iReadRate bytes per select().
+// with bKeep the bytes it reads are kept for SimGetReceived, otherwise they are only counted.
+SOCKET SimAddClient(SOCKET sListener, const string &scInput, uint iReadRate, bool bKeep);
+
+// the client hangs up once the server read all of its input
+void SimHangUp(SOCKET s);
+
+const string& SimGetReceived(SOCKET s);
+unsigned long long SimGetReceivedBytes(SOCKET s);
+bool SimIsClosed(SOCKET s); // closed by the server
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef _TEST_
+#define _TEST_
+
+/**************************************************************************************************************
+checks for the test programs and a clock for the benchmarks. a failed CHECK prints where it failed and the
+test goes on, TEST_RESULT() at the end of main returns 1 if anything failed so ctest reports it.
+**************************************************************************************************************/
+
+#include <time.h>
+
+static uint iTestFailures = 0;
+
+#define CHECK(expr) \
+	if(!(expr)) { \
+		printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #expr); \
+		iTestFailures++; \
+	}
+
+#define TEST_RESULT() \
+	(iTestFailures ? (printf("%u check(s) failed\n", iTestFailures), 1) : (printf("all checks passed\n"), 0))
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline double BenchNow()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// prints the time per operation of a run of iOps operations that started at dStart
+inline void BenchReport(const char *szName, double dStart, mstime iOps)
+{
+	double dSeconds = BenchNow() - dStart;
+	printf("%-48s %12.1f ns/op %10.3f s\n", szName, dSeconds * 1e9 / (double)iOps, dSeconds);
+}
+
+// keeps the compiler from dropping the work of a benchmark loop
+static volatile uint iBenchSink = 0;
+
+#endif
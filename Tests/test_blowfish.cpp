@@ -0,0 +1,113 @@
+#include "test.h"
+
+#define long int
+#include "blowfish.h"
+#include "legacy/legacy_blowfish.h"
+#undef long
+
+/**************************************************************************************************************
+blowfish.cpp: the known answers of the reference vectors, the buffer api against SwapBytes around the
+native word api, and both against the reference implementation the unrolled rounds replaced
+(legacy/blowfish.cpp), so encrypted socket clients keep working
+**************************************************************************************************************/
+
+static string FromHex(const char *szHex)
+{
+	string scData;
+	for (uint i = 0; szHex[i] && szHex[i + 1]; i += 2)
+	{
+		char szByte[3] = { szHex[i], szHex[i + 1], 0 };
+		scData += (char)strtoul(szByte, 0, 16);
+	}
+	return scData;
+}
+
+static string EncryptBuffer(const string &scKey, const string &scData)
+{
+	BLOWFISH_CTX ctx;
+	Blowfish_Init(&ctx, (unsigned char*)scKey.data(), (int)scKey.length());
+	string scOut = scData;
+	if (!Blowfish_EncryptBuffer(&ctx, &scOut[0], (uint)scOut.length()))
+		return "<failed>";
+	return scOut;
+}
+
+// the socket's path before the buffer api
+static string LegacyEncrypt(const string &scKey, const string &scData)
+{
+	BLOWFISH_CTX ctx;
+	legacy_Blowfish_Init(&ctx, (unsigned char*)scKey.data(), (int)scKey.length());
+	string scOut = scData;
+	legacy_SwapBytes(&scOut[0], (uint)scOut.length());
+	if (!legacy_Blowfish_Encrypt(&ctx, &scOut[0], (uint)scOut.length()))
+		return "<failed>";
+	legacy_SwapBytes(&scOut[0], (uint)scOut.length());
+	return scOut;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	CHECK(sizeof(BLOWFISH_CTX) == 4 * (18 + 4 * 256));
+
+	// the reference vectors (key, plaintext, ciphertext), big-endian like on the wire
+	const char *arrVectors[][3] =
+	{
+		{ "0000000000000000", "0000000000000000", "4EF997456198DD78" },
+		{ "FFFFFFFFFFFFFFFF", "FFFFFFFFFFFFFFFF", "51866FD5B85ECB8A" },
+		{ "3000000000000000", "1000000000000001", "7D856F9A613063F2" },
+		{ "1111111111111111", "1111111111111111", "2466DD878B963C9D" },
+		{ "0123456789ABCDEF", "1111111111111111", "61F9C3802281B096" },
+		{ "FEDCBA9876543210", "0123456789ABCDEF", "0ACEAB0FC6A0A28D" },
+	};
+	for (uint i = 0; i < sizeof(arrVectors) / sizeof(arrVectors[0]); i++)
+	{
+		string scKey = FromHex(arrVectors[i][0]), scPlain = FromHex(arrVectors[i][1]), scCipher = FromHex(arrVectors[i][2]);
+		CHECK(EncryptBuffer(scKey, scPlain) == scCipher);
+		CHECK(LegacyEncrypt(scKey, scPlain) == scCipher);
+
+		BLOWFISH_CTX ctx;
+		Blowfish_Init(&ctx, (unsigned char*)scKey.data(), (int)scKey.length());
+		string scData = scCipher;
+		CHECK(Blowfish_DecryptBuffer(&ctx, &scData[0], (uint)scData.length()));
+		CHECK(scData == scPlain);
+	}
+
+	// the key schedule is the reference one
+	string scKey = "SomeRandomKey19";
+	BLOWFISH_CTX ctx, ctxLegacy;
+	Blowfish_Init(&ctx, (unsigned char*)scKey.data(), (int)scKey.length());
+	legacy_Blowfish_Init(&ctxLegacy, (unsigned char*)scKey.data(), (int)scKey.length());
+	CHECK(!memcmp(&ctx, &ctxLegacy, sizeof(BLOWFISH_CTX)));
+
+	// a socket's worth of text: the buffer api, the native api with SwapBytes and the old code agree
+	string scText;
+	for (uint i = 0; i < 4096; i++)
+		scText += (char)(i * 31 + (i >> 5));
+	string scEncrypted = EncryptBuffer(scKey, scText);
+	CHECK(scEncrypted == LegacyEncrypt(scKey, scText));
+
+	string scNative = scText;
+	legacy_SwapBytes(&scNative[0], (uint)scNative.length());
+	CHECK(Blowfish_Encrypt(&ctx, &scNative[0], (uint)scNative.length()));
+	legacy_SwapBytes(&scNative[0], (uint)scNative.length());
+	CHECK(scNative == scEncrypted);
+
+	legacy_SwapBytes(&scNative[0], (uint)scNative.length());
+	CHECK(Blowfish_Decrypt(&ctx, &scNative[0], (uint)scNative.length()));
+	legacy_SwapBytes(&scNative[0], (uint)scNative.length());
+	CHECK(scNative == scText);
+
+	string scDecrypted = scEncrypted;
+	CHECK(Blowfish_DecryptBuffer(&ctx, &scDecrypted[0], (uint)scDecrypted.length()));
+	CHECK(scDecrypted == scText);
+
+	// lengths that aren't whole blocks are refused and the data is left alone
+	string scOdd = scText.substr(0, 12);
+	CHECK(!Blowfish_EncryptBuffer(&ctx, &scOdd[0], (uint)scOdd.length()));
+	CHECK(!Blowfish_Encrypt(&ctx, &scOdd[0], (uint)scOdd.length()));
+	CHECK(scOdd == scText.substr(0, 12));
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,117 @@
+#include "test.h"
+
+/**************************************************************************************************************
+HkCharFile.cpp and flcodec.cpp: encoded and plain charfiles are read into the cache, looked up like the
+profile api does, edited, written back (encoded again) and read again after a change on disk
+**************************************************************************************************************/
+
+static void WriteData(const string &scFile, const string &scData)
+{
+	HANDLE hFile = CreateFile(scFile.c_str(), GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	DWORD dwWritten;
+	WriteFile(hFile, scData.data(), (DWORD)scData.length(), &dwWritten, 0);
+	CloseHandle(hFile);
+}
+
+static string ReadData(const string &scFile)
+{
+	HANDLE hFile = CreateFile(scFile.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	string scData(1 << 16, '\0');
+	DWORD dwRead = 0;
+	ReadFile(hFile, &scData[0], (DWORD)scData.length(), &dwRead, 0);
+	CloseHandle(hFile);
+	scData.resize(dwRead);
+	return scData;
+}
+
+static string Encode(const string &scPlain)
+{
+	string scEncoded(scPlain.length() + 4, '\0');
+	flc_encode_buf(scPlain.data(), (int)scPlain.length(), &scEncoded[0]);
+	return scEncoded;
+}
+
+static string Decode(const string &scEncoded)
+{
+	string scPlain(scEncoded.length() - 4, '\0');
+	if (!flc_decode_buf(scEncoded.data(), (int)scEncoded.length(), &scPlain[0]))
+		return "<not encoded>";
+	return scPlain;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	const string scPlain =
+		"[Player]\r\n"
+		"description = Trent\r\n"
+		"money = 12345\r\n"
+		"system = li01\r\n"
+		"\r\n"
+		"[mPlayer]\r\n"
+		"can_dock = 1\r\n"
+		"ship_type_killed = 123, 4\r\n";
+
+	// the codec itself, every offset of the 256 byte keystream and the odd tail lengths
+	string scAll;
+	for (uint i = 0; i < 1000; i++)
+		scAll += (char)(i * 7);
+	for (uint iLen = 0; iLen < 600; iLen += 37)
+		CHECK(Decode(Encode(scAll.substr(0, iLen))) == scAll.substr(0, iLen));
+	CHECK(Encode("").substr(0, 4) == "FLS1");
+	CHECK(Decode("FLS2abc") == "<not encoded>");
+
+	string scFile = TestPath("trent.fl");
+	WriteData(scFile, Encode(scPlain));
+
+	const CHARFILE *charfile;
+	CHECK(CharFileCache::Load(scFile, charfile) == HKE_OK);
+	CHECK(charfile->bEncoded);
+	CHECK(charfile->vLines.size() == 8);
+	CHECK(CharFileCache::GetValue(*charfile, "player", "MONEY", "") == "12345");
+	CHECK(CharFileCache::GetValue(*charfile, "Player", "rank", "none") == "none");
+	CHECK(CharFileCache::GetValue(*charfile, "mPlayer", "description", "none") == "none");
+
+	// a second load comes from the cache
+	const CHARFILE *cached;
+	CHECK(CharFileCache::Load(scFile, cached) == HKE_OK);
+	CHECK(cached == charfile);
+
+	// edits are written back encoded, byte for byte what the file would be with them done by hand
+	CHARFILE edit = *charfile;
+	CharFileCache::SetValue(edit, "Player", "money", "500");
+	CharFileCache::SetValue(edit, "Player", "rank", "3");
+	CharFileCache::SetValue(edit, "mShipKills", "kills", "1");
+	CHECK(CharFileCache::Save(scFile, edit, true) == HKE_OK);
+	string scExpected =
+		"[Player]\r\n"
+		"description = Trent\r\n"
+		"money=500\r\n"
+		"system = li01\r\n"
+		"rank=3\r\n"
+		"\r\n"
+		"[mPlayer]\r\n"
+		"can_dock = 1\r\n"
+		"ship_type_killed = 123, 4\r\n"
+		"[mShipKills]\r\n"
+		"kills=1\r\n";
+	CHECK(Decode(ReadData(scFile)) == scExpected);
+	CHECK(CharFileCache::Load(scFile, charfile) == HKE_OK);
+	CHECK(CharFileCache::GetValue(*charfile, "Player", "money", "") == "500");
+
+	// charfile encryption off: written and read as plain text
+	CHECK(CharFileCache::Save(scFile, edit, false) == HKE_OK);
+	CHECK(ReadData(scFile) == scExpected);
+	CHECK(CharFileCache::Load(scFile, charfile) == HKE_OK);
+	CHECK(!charfile->bEncoded);
+
+	// changed behind the cache's back
+	WriteData(scFile, Encode("[Player]\r\nmoney = 1\r\n"));
+	CHECK(CharFileCache::Load(scFile, charfile) == HKE_OK);
+	CHECK(CharFileCache::GetValue(*charfile, "Player", "money", "") == "1");
+
+	CHECK(CharFileCache::Load(TestPath("missing.fl"), charfile) == HKE_CHAR_DOES_NOT_EXIST);
+
+	return TEST_RESULT();
+}
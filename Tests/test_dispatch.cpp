@@ -0,0 +1,180 @@
+#include "test.h"
+#include "plugin_dispatch.h"
+
+/**************************************************************************************************************
+the CALL_PLUGINS macros of Hook.h over hand built dispatch tables: call order, the plugin return codes,
+exceptions and a table that is swapped by a plugin while it is dispatched
+**************************************************************************************************************/
+
+#define TEST_PLUGINS 4
+#define CORE_RESULT -1
+
+static PLUGIN_RETURNCODE arrReturnCodes[TEST_PLUGINS];
+static PLUGIN_RETURNCODE arrNextReturnCodes[TEST_PLUGINS];
+static string scCalls;
+static PLUGIN_DISPATCH_TABLE arrTables[2];
+static PLUGIN_DISPATCH_ENTRY arrEntries[TEST_PLUGINS];
+static PLUGIN_DISPATCH_ENTRY *pSwapTo = 0;
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template<int N> int __stdcall Plugin_Callback(int iArg)
+{
+	scCalls += (char)('A' + N);
+	arrReturnCodes[N] = arrNextReturnCodes[N];
+	return iArg + N;
+}
+
+static int __stdcall Plugin_Throw(int iArg)
+{
+	scCalls += 'X';
+	throw 1;
+}
+
+static int __stdcall Plugin_Swap(int iArg)
+{
+	scCalls += 'S';
+	arrTables[0].pEntries = pSwapTo;
+	arrTables[0].iCount = 1;
+	return iArg;
+}
+
+static void __stdcall Plugin_Void(int iArg)
+{
+	scCalls += 'V';
+	arrReturnCodes[0] = arrNextReturnCodes[0];
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the server side of a hook, it only runs if no plugin suppressed it
+static int Hook(int iArg)
+{
+	CALL_PLUGINS(0, int, __stdcall, (int), (iArg));
+
+	scCalls += '.';
+	return CORE_RESULT;
+}
+
+static void HookV(int iArg)
+{
+	CALL_PLUGINS_V(0, __stdcall, (int), (iArg));
+
+	scCalls += '.';
+}
+
+static void HookNoRet(int iArg)
+{
+	CALL_PLUGINS_NORET(0, __stdcall, (int), (iArg));
+
+	scCalls += '.';
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void SetPlugins(FARPROC *arrFuncs, uint iCount)
+{
+	for (uint i = 0; i < iCount; i++)
+	{
+		arrEntries[i].pFunc = arrFuncs[i] ? (FARPROC*)arrFuncs[i] : 0;
+		arrEntries[i].ePluginReturnCode = &arrReturnCodes[i];
+		arrEntries[i].szName = "test";
+		arrEntries[i].iTimerID = i;
+		arrReturnCodes[i] = DEFAULT_RETURNCODE;
+		arrNextReturnCodes[i] = DEFAULT_RETURNCODE;
+	}
+
+	arrTables[0].pEntries = iCount ? arrEntries : 0;
+	arrTables[0].iCount = iCount;
+	scCalls = "";
+}
+
+static FARPROC arrCallbacks[TEST_PLUGINS] = { (FARPROC)Plugin_Callback<0>, (FARPROC)Plugin_Callback<1>, (FARPROC)Plugin_Callback<2>, (FARPROC)Plugin_Callback<3> };
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	pPluginDispatch = arrTables;
+
+	// without plugins the server code runs
+	SetPlugins(arrCallbacks, 0);
+	CHECK(Hook(10) == CORE_RESULT);
+	CHECK(scCalls == ".");
+
+	// all plugins in table order, then the server
+	SetPlugins(arrCallbacks, 3);
+	CHECK(Hook(10) == CORE_RESULT);
+	CHECK(scCalls == "ABC.");
+	CHECK(!g_bPlugin_nofunctioncall);
+
+	// SKIPPLUGINS stops the plugins but not the server
+	SetPlugins(arrCallbacks, 3);
+	arrNextReturnCodes[1] = SKIPPLUGINS;
+	CHECK(Hook(10) == CORE_RESULT);
+	CHECK(scCalls == "AB.");
+
+	// NOFUNCTIONCALL lets the other plugins run, the result of the last one is returned
+	SetPlugins(arrCallbacks, 3);
+	arrNextReturnCodes[0] = NOFUNCTIONCALL;
+	CHECK(Hook(10) == 12);
+	CHECK(scCalls == "ABC");
+	CHECK(g_bPlugin_nofunctioncall);
+
+	// SKIPPLUGINS_NOFUNCTIONCALL returns the plugin's result right away
+	SetPlugins(arrCallbacks, 3);
+	arrNextReturnCodes[1] = SKIPPLUGINS_NOFUNCTIONCALL;
+	CHECK(Hook(10) == 11);
+	CHECK(scCalls == "AB");
+
+	// a throwing plugin is logged and the rest still runs
+	FARPROC arrThrow[] = { (FARPROC)Plugin_Throw, (FARPROC)Plugin_Callback<1> };
+	SetPlugins(arrThrow, 2);
+	uint iLogLines = iTestLogLines;
+	CHECK(Hook(10) == CORE_RESULT);
+	CHECK(scCalls == "XB.");
+	CHECK(iTestLogLines > iLogLines);
+
+	// a table rebuilt during the dispatch is used from the next dispatch on
+	static PLUGIN_DISPATCH_ENTRY swapEntry;
+	swapEntry.pFunc = (FARPROC*)Plugin_Callback<3>;
+	swapEntry.ePluginReturnCode = &arrReturnCodes[3];
+	swapEntry.szName = "swapped";
+	swapEntry.iTimerID = 0;
+	pSwapTo = &swapEntry;
+	FARPROC arrSwap[] = { (FARPROC)Plugin_Swap, (FARPROC)Plugin_Callback<1> };
+	SetPlugins(arrSwap, 2);
+	CHECK(Hook(10) == CORE_RESULT);
+	CHECK(scCalls == "SB.");
+	scCalls = "";
+	CHECK(Hook(10) == CORE_RESULT);
+	CHECK(scCalls == "D.");
+
+	// void hooks
+	FARPROC arrVoid[] = { (FARPROC)Plugin_Void };
+	SetPlugins(arrVoid, 1);
+	HookV(0);
+	CHECK(scCalls == "V.");
+	SetPlugins(arrVoid, 1);
+	arrNextReturnCodes[0] = NOFUNCTIONCALL;
+	HookV(0);
+	CHECK(scCalls == "V");
+
+	// hooks that can't be suppressed log the attempt and run anyway
+	SetPlugins(arrVoid, 1);
+	arrNextReturnCodes[0] = SKIPPLUGINS_NOFUNCTIONCALL;
+	iLogLines = iTestLogLines;
+	HookNoRet(0);
+	CHECK(scCalls == "V.");
+	CHECK(iTestLogLines == iLogLines + 1);
+
+	// with the performance timers on every plugin call is measured
+	PerfTimers::bEnabled = true;
+	SetPlugins(arrCallbacks, 3);
+	uint iSamples = iTestPerfSamples;
+	Hook(10);
+	CHECK(iTestPerfSamples == iSamples + 3);
+	PerfTimers::bEnabled = false;
+
+	return TEST_RESULT();
+}
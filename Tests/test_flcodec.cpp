@@ -0,0 +1,136 @@
+#include "test.h"
+#include "charfile.h"
+#include "legacy/legacy.h"
+
+/**************************************************************************************************************
+flcodec.cpp against the codec before the buffer api (legacy/flcodec.cpp): real-size charfiles and every
+short length are encoded and decoded by both, through the files and the buffers, and must match byte for byte
+**************************************************************************************************************/
+
+// flcodec's file calls take the path as it is, without the drive letter TestPath adds for the win32 shims
+static string CodecPath(const string &scFile)
+{
+	return TestPath(scFile).substr(2);
+}
+
+static void WriteData(const string &scFile, const string &scData)
+{
+	FILE *f = fopen(scFile.c_str(), "wb");
+	fwrite(scData.data(), 1, scData.length(), f);
+	fclose(f);
+}
+
+static string ReadData(const string &scFile)
+{
+	FILE *f = fopen(scFile.c_str(), "rb");
+	if (!f)
+		return "<missing>";
+
+	string scData;
+	char szBuf[4096];
+	size_t iRead;
+	while ((iRead = fread(szBuf, 1, sizeof(szBuf), f)) > 0)
+		scData.append(szBuf, iRead);
+	fclose(f);
+	return scData;
+}
+
+static string LegacyEncode(const string &scPlain)
+{
+	string scIn = CodecPath("legacy_in"), scOut = CodecPath("legacy_out");
+	WriteData(scIn, scPlain);
+	if (!legacy_flc_encode(scIn.c_str(), scOut.c_str()))
+		return "<failed>";
+	return ReadData(scOut);
+}
+
+static string LegacyDecode(const string &scEncoded)
+{
+	string scIn = CodecPath("legacy_in"), scOut = CodecPath("legacy_out");
+	WriteData(scIn, scEncoded);
+	if (!legacy_flc_decode(scIn.c_str(), scOut.c_str()))
+		return "<failed>";
+	return ReadData(scOut);
+}
+
+static string EncodeBuf(const string &scPlain)
+{
+	string scEncoded(scPlain.length() + 4, '\0');
+	if (!flc_encode_buf(scPlain.data(), (int)scPlain.length(), &scEncoded[0]))
+		return "<failed>";
+	return scEncoded;
+}
+
+static string DecodeBuf(const string &scEncoded)
+{
+	string scPlain(scEncoded.length(), '\0');
+	if (!flc_decode_buf(scEncoded.data(), (int)scEncoded.length(), &scPlain[0]))
+		return "<failed>";
+	scPlain.resize(scEncoded.length() - 4);
+	return scPlain;
+}
+
+static string EncodeFile(const string &scPlain)
+{
+	string scIn = CodecPath("in"), scOut = CodecPath("out");
+	WriteData(scIn, scPlain);
+	if (!flc_encode(scIn.c_str(), scOut.c_str()))
+		return "<failed>";
+	return ReadData(scOut);
+}
+
+static string DecodeFile(const string &scEncoded)
+{
+	string scIn = CodecPath("in"), scOut = CodecPath("out");
+	WriteData(scIn, scEncoded);
+	if (!flc_decode(scIn.c_str(), scOut.c_str()))
+		return "<failed>";
+	return ReadData(scOut);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	// every length up to a few blocks and both sides of the 256 byte period of the keystream, all byte values
+	string scBytes;
+	for (uint i = 0; i < 1100; i++)
+		scBytes += (char)(i * 131 + i / 256);
+	bool bShortMatch = true;
+	for (uint iLen = 0; iLen < 1100; iLen += (iLen < 300 ? 1 : 97))
+	{
+		string scPlain = scBytes.substr(0, iLen);
+		string scEncoded = LegacyEncode(scPlain);
+		bShortMatch = bShortMatch && (EncodeBuf(scPlain) == scEncoded) && (DecodeBuf(scEncoded) == scPlain) && (LegacyDecode(scEncoded) == scPlain);
+	}
+	CHECK(bShortMatch);
+
+	// real-size charfiles through the buffers and the files
+	for (uint iSeed = 1; iSeed <= 5; iSeed++)
+	{
+		string scPlain = MakeCharfile(iSeed);
+		CHECK(scPlain.length() > 100000 && scPlain.length() < 250000);
+
+		string scEncoded = LegacyEncode(scPlain);
+		CHECK(scEncoded.length() == scPlain.length() + 4);
+		CHECK(EncodeBuf(scPlain) == scEncoded);
+		CHECK(EncodeFile(scPlain) == scEncoded);
+		CHECK(DecodeBuf(scEncoded) == scPlain);
+		CHECK(DecodeFile(scEncoded) == scPlain);
+		CHECK(LegacyDecode(EncodeBuf(scPlain)) == scPlain);
+
+		// decoding in place, like flc_decode and the charfile cache do
+		string scInPlace = scEncoded;
+		CHECK(flc_decode_buf(&scInPlace[0], (int)scInPlace.length(), &scInPlace[0]));
+		CHECK(scInPlace.substr(0, scPlain.length()) == scPlain);
+	}
+
+	// files without the magic token are refused by both, missing files too
+	CHECK(LegacyDecode("[Player]\r\n") == "<failed>");
+	CHECK(DecodeFile("[Player]\r\n") == "<failed>");
+	CHECK(DecodeBuf("FLS") == "<failed>");
+	CHECK(!flc_decode(CodecPath("missing").c_str(), CodecPath("out").c_str()));
+	CHECK(!flc_encode(CodecPath("missing").c_str(), CodecPath("out").c_str()));
+
+	return TEST_RESULT();
+}
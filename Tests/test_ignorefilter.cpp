@@ -0,0 +1,148 @@
+#include "test.h"
+#include "chat.h"
+#include "legacy/legacy.h"
+
+/**************************************************************************************************************
+HkIgnoreFilter.cpp: the /ignore semantics (exact names, "i" for names containing it, "p" for private chat
+only, case insensitive) and the compiled lists against the loop HkCbChat ran for every line before them
+**************************************************************************************************************/
+
+CLIENT_INFO ClientInfo[MAX_CLIENT_ID + 1];
+
+static void AddIgnore(uint iClientID, const wstring &wscCharname, const wstring &wscFlags)
+{
+	IGNORE_INFO ii;
+	ii.wscCharname = wscCharname;
+	ii.wscFlags = wscFlags;
+	IgnoreInfoCompile(ii);
+	ClientInfo[iClientID].lstIgnore.push_back(ii);
+	IgnoreFilter::Rebuild(iClientID);
+}
+
+// the sender as chat delivery passes it, public or private chat
+static bool Ignored(uint iClientID, const wstring &wscSender, bool bPrivate)
+{
+	return IgnoreFilter::IsIgnored(iClientID, ToLower(wscSender), bPrivate);
+}
+
+// a charname like the ones on a server, some with a tag in front
+static wstring Charname(CChatGenerator &gen)
+{
+	static const wchar_t *arrTags[] = { L"[TAG]", L"=LSF=", L"Order|", L"[bh]" };
+	wstring wscName = gen.Word();
+	wscName[0] = towupper(wscName[0]);
+	if (!gen.Rand(3))
+		wscName = arrTags[gen.Rand(sizeof(arrTags) / sizeof(const wchar_t*))] + wscName;
+	return wscName;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void TestSemantics()
+{
+	AddIgnore(1, L"Trent", L"");
+	AddIgnore(1, L"[TAG]", L"i");
+	AddIgnore(1, L"Spammer", L"p");
+	AddIgnore(1, L"bot", L"pi");
+
+	// exact names in every chat, in any case
+	CHECK(Ignored(1, L"Trent", false));
+	CHECK(Ignored(1, L"TRENT", true));
+	CHECK(!Ignored(1, L"Trent2", false));
+	CHECK(!Ignored(1, L"Tren", false));
+
+	// "i": names containing it
+	CHECK(Ignored(1, L"[tag]Juni", false));
+	CHECK(Ignored(1, L"x[Tag]y", true));
+	CHECK(!Ignored(1, L"[ta", false));
+
+	// "p": private chat only
+	CHECK(Ignored(1, L"spammer", true));
+	CHECK(!Ignored(1, L"spammer", false));
+	CHECK(Ignored(1, L"RoBoT", true));
+	CHECK(!Ignored(1, L"RoBoT", false));
+	CHECK(!Ignored(1, L"Spammer1", true));
+
+	// the same name private only and for every chat: every chat wins
+	AddIgnore(1, L"spammer", L"");
+	CHECK(Ignored(1, L"Spammer", false));
+
+	// other clients' lists are their own
+	CHECK(!Ignored(2, L"Trent", false));
+	AddIgnore(2, L"Juni", L"");
+	CHECK(!Ignored(1, L"Juni", true));
+	CHECK(Ignored(2, L"juni", true));
+
+	// /delignore and disconnects rebuild from the list
+	ClientInfo[1].lstIgnore.clear();
+	IgnoreFilter::Rebuild(1);
+	CHECK(!Ignored(1, L"Trent", false));
+	CHECK(!Ignored(1, L"[TAG]Juni", true));
+
+	// other letters (an upper case I too) are no flags
+	IGNORE_INFO ii;
+	ii.wscCharname = L"Name";
+	ii.wscFlags = L"xpI";
+	IgnoreInfoCompile(ii);
+	CHECK(ii.wscCharnameLower == L"name" && ii.iFlags == IGNORE_PRIVATE);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void TestAgainstLegacy()
+{
+	CChatGenerator gen(18);
+	static const wchar_t *arrFlags[] = { L"", L"", L"", L"i", L"p", L"pi" };
+
+	bool bSame = true;
+	uint iIgnored = 0, iChecked = 0;
+	for (uint iClientID = 10; iClientID < 60; iClientID++)
+	{
+		ClientInfo[iClientID].lstIgnore.clear();
+		vector<wstring> vNames;
+		for (uint i = 0; i < 50; i++)
+		{
+			wstring wscName = Charname(gen);
+			wstring wscFlags = arrFlags[gen.Rand(sizeof(arrFlags) / sizeof(const wchar_t*))];
+			// "i" entries are often just the tag or part of a name
+			if (wscFlags.find(L'i') != wstring::npos && gen.Rand(2))
+				wscName = wscName.substr(0, 3);
+			AddIgnore(iClientID, wscName, wscFlags);
+			vNames.push_back(wscName);
+		}
+
+		for (uint i = 0; i < 200; i++)
+		{
+			// listed names in other case or with something around them, and strangers
+			wstring wscSender;
+			switch (gen.Rand(4))
+			{
+			case 0: wscSender = ToLower(vNames[gen.Rand(50)]); break;
+			case 1: wscSender = L"[TAG]" + vNames[gen.Rand(50)] + L"2"; break;
+			case 2: wscSender = vNames[gen.Rand(50)]; break;
+			default: wscSender = Charname(gen); break;
+			}
+
+			for (uint iPrivate = 0; iPrivate < 2; iPrivate++)
+			{
+				bool bIgnored = Ignored(iClientID, wscSender, iPrivate != 0);
+				bSame = bSame && (bIgnored == legacy_IsIgnored(ClientInfo[iClientID].lstIgnore, wscSender, iPrivate == 0));
+				iIgnored += bIgnored ? 1 : 0;
+				iChecked++;
+			}
+		}
+	}
+
+	CHECK(bSame);
+	CHECK(iIgnored > iChecked / 10 && iIgnored < iChecked - iChecked / 10);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	TestSemantics();
+	TestAgainstLegacy();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,126 @@
+#include "test.h"
+
+/**************************************************************************************************************
+HkIniCache.cpp: lookups with the profile api's rules, writes that keep the rest of the file as it was,
+batched writes and picking up changes made to the file behind the cache's back
+**************************************************************************************************************/
+
+static void WriteText(const string &scFile, const string &scText)
+{
+	HANDLE hFile = CreateFile(scFile.c_str(), GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	DWORD dwWritten;
+	WriteFile(hFile, scText.data(), (DWORD)scText.length(), &dwWritten, 0);
+	CloseHandle(hFile);
+}
+
+static string ReadText(const string &scFile)
+{
+	HANDLE hFile = CreateFile(scFile.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return "<missing>";
+
+	char szBuf[4096];
+	DWORD dwRead = 0;
+	ReadFile(hFile, szBuf, sizeof(szBuf), &dwRead, 0);
+	CloseHandle(hFile);
+	return string(szBuf, dwRead);
+}
+
+static string Get(const string &scFile, const string &scApp, const string &scKey)
+{
+	string scValue;
+	bool bFound = false;
+	if (!IniCache::Get(scFile, scApp, scKey, scValue, bFound))
+		return "<not handled>";
+	return bFound ? scValue : "<not found>";
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	string scFile = TestPath("flhook.ini");
+	WriteText(scFile,
+		"; comment\r\n"
+		"[General]\r\n"
+		"Debug = yes\r\n"
+		"  Name=\"quoted value\"  \r\n"
+		"debug=second\r\n"
+		"\r\n"
+		"[ Socket ]\r\n"
+		"Port=1919\n"
+		"NoValue\n"
+		"[general]\r\n"
+		"Late=1\r\n");
+
+	// keys and sections are case insensitive and trimmed, the first one wins, quotes are stripped
+	CHECK(Get(scFile, "General", "Debug") == "yes");
+	CHECK(Get(scFile, "general", "DEBUG") == "yes");
+	CHECK(Get(scFile, "General", "name") == "quoted value");
+	CHECK(Get(scFile, "Socket", "Port") == "1919");
+	CHECK(Get(scFile, "General", "Late") == "<not found>");
+	CHECK(Get(scFile, "Missing", "Port") == "<not found>");
+
+	// relative paths are left to the profile api
+	CHECK(Get("flhook.ini", "General", "Debug") == "<not handled>");
+
+	list<INISECTIONVALUE> lstValues;
+	CHECK(IniCache::GetSection(scFile, "Socket", lstValues));
+	CHECK(lstValues.size() == 2);
+	CHECK(lstValues.front().scKey == "Port" && lstValues.front().scValue == "1919");
+	CHECK(lstValues.back().scKey == "NoValue" && lstValues.back().scValue == "");
+
+	// a changed value is written in place, new keys go after the section's last line, the rest stays
+	CHECK(IniCache::Write(scFile, "general", "debug", "no"));
+	CHECK(IniCache::Write(scFile, "General", "Added", "1"));
+	CHECK(IniCache::Write(scFile, "New", "Key", "value"));
+	CHECK(ReadText(scFile) ==
+		"; comment\r\n"
+		"[General]\r\n"
+		"debug=no\r\n"
+		"  Name=\"quoted value\"  \r\n"
+		"debug=second\r\n"
+		"Added=1\r\n"
+		"\r\n"
+		"[ Socket ]\r\n"
+		"Port=1919\r\n"
+		"NoValue\r\n"
+		"[general]\r\n"
+		"Late=1\r\n"
+		"[New]\r\n"
+		"Key=value\r\n");
+	CHECK(Get(scFile, "General", "Debug") == "no");
+	CHECK(Get(scFile, "New", "Key") == "value");
+
+	CHECK(IniCache::Delete(scFile, "General", "Added"));
+	CHECK(IniCache::DelSection(scFile, "Socket"));
+	CHECK(Get(scFile, "General", "Added") == "<not found>");
+	CHECK(Get(scFile, "Socket", "Port") == "<not found>");
+	CHECK(ReadText(scFile).find("Port") == string::npos);
+
+	// in a batch the file is written once when the batch ends
+	IniCache::BeginBatch();
+	IniCache::Write(scFile, "Batch", "A", "1");
+	IniCache::Write(scFile, "Batch", "B", "2");
+	CHECK(Get(scFile, "Batch", "B") == "2");
+	CHECK(ReadText(scFile).find("[Batch]") == string::npos);
+	IniCache::EndBatch();
+	CHECK(ReadText(scFile).find("[Batch]\r\nA=1\r\nB=2\r\n") != string::npos);
+
+	// a file changed by someone else is read again (the size differs, so the stamp does too)
+	WriteText(scFile, "[General]\r\nDebug=changed by hand\r\n");
+	CHECK(Get(scFile, "General", "Debug") == "changed by hand");
+
+	// writing to a file that doesn't exist creates it
+	string scNew = TestPath("new.ini");
+	CHECK(Get(scNew, "Any", "Key") == "<not found>");
+	CHECK(IniCache::Write(scNew, "Any", "Key", "1"));
+	CHECK(ReadText(scNew) == "[Any]\r\nKey=1\r\n");
+
+	// utf-16 files go to the profile api
+	string scUnicode = TestPath("unicode.ini");
+	WriteText(scUnicode, string("\xFF\xFE[\0A\0]\0", 8));
+	CHECK(Get(scUnicode, "A", "B") == "<not handled>");
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,190 @@
+#include "test.h"
+
+/**************************************************************************************************************
+HkPlayerIndex.cpp against a fake server: the ship hash table (collisions, removal with back shifting,
+ships taken over by other clients), the system/charname/account indexes, no-pvp systems and the snapshots
+**************************************************************************************************************/
+
+CLIENT_INFO ClientInfo[MAX_CLIENT_ID + 1];
+list<uint> set_lstNoPVPSystems;
+PlayerDB Players;
+
+struct FAKE_PLAYER
+{
+	uint iSystem;
+	uint iBase;
+	uint iShip;
+	wstring wscCharname;
+	CAccount *acc;
+};
+
+static FAKE_PLAYER arrServer[MAX_CLIENT_ID + 1];
+
+void HkGetPlayerIP(uint iClientID, wstring &wscIP)
+{
+	wscIP = L"10.0.0." + stows(itos(iClientID));
+}
+
+int pub::GetBaseNickname(char *szNickname, uint iSize, const uint &iBaseID)
+{
+	snprintf(szNickname, iSize, "base_%u", iBaseID);
+	return 0;
+}
+
+int pub::GetSystemNickname(char *szNickname, uint iSize, const uint &iSystemID)
+{
+	snprintf(szNickname, iSize, "system_%u", iSystemID);
+	return 0;
+}
+
+int pub::Player::GetSystem(const uint &iClientID, uint &iSystemID) { iSystemID = arrServer[iClientID].iSystem; return 0; }
+int pub::Player::GetBase(const uint &iClientID, uint &iBaseID) { iBaseID = arrServer[iClientID].iBase; return 0; }
+int pub::Player::GetShip(const uint &iClientID, uint &iShip) { iShip = arrServer[iClientID].iShip; return 0; }
+
+const wchar_t* PlayerDB::GetActiveCharacterName(uint iClientID) const
+{
+	return arrServer[iClientID].wscCharname.length() ? arrServer[iClientID].wscCharname.c_str() : 0;
+}
+
+CAccount* PlayerDB::FindAccountFromClientID(uint iClientID) const
+{
+	return arrServer[iClientID].acc;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void SetShips(uint iClientID, uint iShip, uint iShipOld)
+{
+	ClientInfo[iClientID].iShip = iShip;
+	ClientInfo[iClientID].iShipOld = iShipOld;
+	PlayerIndex::ShipsChanged(iClientID);
+}
+
+static uint CountClients(const CLIENT_SET &clients)
+{
+	uint iCount = 0;
+	for (uint iClientID = ClientSetNext(clients, 0); iClientID; iClientID = ClientSetNext(clients, iClientID))
+		iCount++;
+	return iCount;
+}
+
+static void TestShipTable()
+{
+	// every client in space with a ship, the ids are spread like the server's object ids
+	for (uint iClientID = 1; iClientID <= MAX_CLIENT_ID; iClientID++)
+		SetShips(iClientID, 0x80000000 + iClientID * 4099, 0);
+
+	bool bAllFound = true;
+	for (uint iClientID = 1; iClientID <= MAX_CLIENT_ID; iClientID++)
+		bAllFound = bAllFound && (PlayerIndex::FindShip(0x80000000 + iClientID * 4099) == iClientID);
+	CHECK(bAllFound);
+	CHECK(PlayerIndex::FindShip(0) == 0);
+	CHECK(PlayerIndex::FindShip(12345) == 0);
+
+	// ids that all hash to the same slot, removing one from the middle of the run keeps the others reachable
+	uint arrColliding[4];
+	for (uint i = 0, iShip = 1; i < 4; iShip++)
+	{
+		if (((iShip * 2654435761u) >> 22) == 7)
+			arrColliding[i++] = iShip;
+	}
+	for (uint i = 0; i < 4; i++)
+		SetShips(200 + i, arrColliding[i], 0);
+	SetShips(201, 0, 0);
+	CHECK(PlayerIndex::FindShip(arrColliding[1]) == 0);
+	CHECK(PlayerIndex::FindShip(arrColliding[0]) == 200);
+	CHECK(PlayerIndex::FindShip(arrColliding[2]) == 202);
+	CHECK(PlayerIndex::FindShip(arrColliding[3]) == 203);
+
+	// a destroyed ship (iShipOld) stays found until someone else flies a ship with its id
+	SetShips(5, 0, 555);
+	CHECK(PlayerIndex::FindShip(555) == 5);
+	SetShips(6, 555, 0);
+	CHECK(PlayerIndex::FindShip(555) == 6);
+	SetShips(5, 0, 0);
+	CHECK(PlayerIndex::FindShip(555) == 6);
+	SetShips(7, 0, 555);
+	CHECK(PlayerIndex::FindShip(555) == 6);
+
+	// all gone again
+	for (uint iClientID = 1; iClientID <= MAX_CLIENT_ID; iClientID++)
+		SetShips(iClientID, 0, 0);
+	bool bNoneFound = true;
+	for (uint iClientID = 1; iClientID <= MAX_CLIENT_ID; iClientID++)
+		bNoneFound = bNoneFound && !PlayerIndex::FindShip(0x80000000 + iClientID * 4099);
+	CHECK(bNoneFound);
+	CHECK(PlayerIndex::FindShip(555) == 0);
+	CHECK(PlayerIndex::FindShip(arrColliding[0]) == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void TestPlayers()
+{
+	CAccount *acc1 = (CAccount*)0x1000, *acc2 = (CAccount*)0x2000;
+	set_lstNoPVPSystems.push_back(20);
+
+	arrServer[1].iSystem = 10;
+	arrServer[1].iShip = 100;
+	arrServer[1].wscCharname = L"Trent";
+	arrServer[1].acc = acc1;
+	PlayerIndex::Refresh(1);
+
+	arrServer[2].iSystem = 20;
+	arrServer[2].wscCharname = L"Juni";
+	arrServer[2].acc = acc2;
+	PlayerIndex::Refresh(2);
+
+	CHECK(PlayerIndex::GetSystem(1) == 10);
+	CHECK(PlayerIndex::GetShip(1) == 100);
+	CHECK(PlayerIndex::FindCharname(L"TRENT") == 1);
+	CHECK(PlayerIndex::FindCharname(L"nobody") == (uint)-1);
+	CHECK(PlayerIndex::FindAccount(acc2) == 2);
+	CHECK(PlayerIndex::GetAccount(1) == acc1);
+	CHECK(!PlayerIndex::InNoPvPSystem(1));
+	CHECK(PlayerIndex::InNoPvPSystem(2));
+	CHECK(CountClients(PlayerIndex::GetOnlineClients()) == 2);
+	CHECK(CountClients(PlayerIndex::GetSystemClients(10)) == 1);
+	CHECK(CountClients(PlayerIndex::GetSystemClients(30)) == 0);
+
+	const PLAYER_SNAPSHOT *snapshot = PlayerIndex::GetPlayer(1);
+	CHECK(snapshot && snapshot->wscCharname == L"Trent" && snapshot->wscSystem == L"system_10" && snapshot->wscIP == L"10.0.0.1");
+	CHECK(!PlayerIndex::GetPlayer(3));
+
+	// a refresh without changes keeps the generation
+	uint iGeneration = PlayerIndex::GetGeneration();
+	PlayerIndex::Refresh(1);
+	CHECK(PlayerIndex::GetGeneration() == iGeneration);
+
+	// docking moves the player out of the system index
+	arrServer[1].iSystem = 0;
+	arrServer[1].iBase = 7;
+	arrServer[1].iShip = 0;
+	PlayerIndex::Refresh(1);
+	CHECK(PlayerIndex::GetGeneration() != iGeneration);
+	CHECK(PlayerIndex::GetBase(1) == 7);
+	CHECK(PlayerIndex::GetPlayer(1)->wscBase == L"base_7");
+	CHECK(CountClients(PlayerIndex::GetSystemClients(10)) == 0);
+
+	// the no-pvp list was reloaded
+	set_lstNoPVPSystems.clear();
+	PlayerIndex::NoPvPSystemsChanged();
+	CHECK(!PlayerIndex::InNoPvPSystem(2));
+
+	PlayerIndex::Remove(2);
+	CHECK(PlayerIndex::FindCharname(L"juni") == (uint)-1);
+	CHECK(PlayerIndex::FindAccount(acc2) == (uint)-1);
+	CHECK(!PlayerIndex::GetPlayer(2));
+	CHECK(CountClients(PlayerIndex::GetOnlineClients()) == 1);
+	CHECK(CountClients(PlayerIndex::GetSystemClients(20)) == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	TestShipTable();
+	TestPlayers();
+
+	return TEST_RESULT();
+}
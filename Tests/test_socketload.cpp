@@ -0,0 +1,240 @@
+#include "test.h"
+#include <atomic>
+#include "socketserver.h"
+#include "SocketServer.cpp"
+
+/**************************************************************************************************************
+SocketServer.cpp under load: hundreds of simulated admin clients on one network thread, which runs Poll as
+NetThread does, and a game thread that executes their commands, answers them and sends event batches.
+every command has to arrive in order and every answer has to come back complete, event mode consumers that
+read fast enough get all their events, the ones that don't are closed once their output queue overflows
+and the game thread is told about it. wchar_t has 4 bytes here, so the unicode listeners aren't simulated.
+**************************************************************************************************************/
+
+#define LOAD_CMD_CLIENTS 200
+#define LOAD_FAST_CONSUMERS 50
+#define LOAD_SLOW_CONSUMERS 50
+#define LOAD_CLIENTS (LOAD_CMD_CLIENTS + LOAD_FAST_CONSUMERS + LOAD_SLOW_CONSUMERS)
+#define LOAD_CMDS 50
+#define LOAD_BATCHES 1000
+#define LOAD_BATCH_LINES 20
+#define LOAD_SLOW_RATE 16 // bytes a slow consumer reads per select()
+#define LOAD_TIMEOUT_MS 60000
+
+enum CLIENT_KIND
+{
+	CLIENT_CMD,
+	CLIENT_FAST,
+	CLIENT_SLOW,
+};
+
+struct LOAD_CLIENT
+{
+	CLIENT_KIND eKind;
+	bool bEncrypted;
+	SOCKET s;
+	wstring wscTopics;
+	// game thread
+	uint iConnID;
+	uint iNextCmd;
+	bool bClosed;
+	// what it should receive
+	string scExpected;
+	unsigned long long iExpectedBytes;
+};
+
+static LOAD_CLIENT arrClients[LOAD_CLIENTS];
+static BLOWFISH_CTX ctxLoad;
+static std::atomic<bool> bGameDone(false);
+
+static const wchar_t *arrTopics[] = { L"chat", L"kill", L"launch", L"login", L"jump" };
+static const uint iTopics = sizeof(arrTopics) / sizeof(const wchar_t*);
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// the bytes a connection sends for a line, as the client would encode them
+static string Encode(const string &scLine, bool bEncrypted)
+{
+	string scData = scLine;
+	if (bEncrypted && (scData.length() % 8))
+		scData.resize(scData.length() + 8 - (scData.length() % 8), '\x00');
+	if (bEncrypted)
+		Blowfish_EncryptBuffer(&ctxLoad, &scData[0], (uint)scData.length());
+	return scData;
+}
+
+static wstring EventLine(uint iBatch, uint iLine)
+{
+	return wstring(arrTopics[(iBatch + iLine) % iTopics]) + L" batch=" + stows(itos(iBatch)) + L" line=" + stows(itos(iLine))
+		+ L" system=Li01 charname=Some_Player_Name\n";
+}
+
+static bool Subscribed(const LOAD_CLIENT &client, const wstring &wscTopic)
+{
+	return !client.wscTopics.length() || (client.wscTopics.find(wscTopic) != wstring::npos);
+}
+
+static void SetupClients()
+{
+	Blowfish_Init(&ctxLoad, (unsigned char*)"SECRETKEY", 9);
+	set_BF_CTX = &ctxLoad;
+	sListen = SimListen();
+	sEListen = SimListen();
+
+	for (uint i = 0; i < LOAD_CLIENTS; i++)
+	{
+		LOAD_CLIENT &client = arrClients[i];
+		client.eKind = (i < LOAD_CMD_CLIENTS) ? CLIENT_CMD : ((i < LOAD_CMD_CLIENTS + LOAD_FAST_CONSUMERS) ? CLIENT_FAST : CLIENT_SLOW);
+		client.bEncrypted = (i % 4 == 1);
+		client.iConnID = 0;
+		client.iNextCmd = 0;
+		client.bClosed = false;
+		client.iExpectedBytes = 0;
+		if (client.eKind == CLIENT_FAST)
+			client.wscTopics = (i % 3 == 0) ? L"" : ((i % 3 == 1) ? L"chat" : L"kill launch");
+
+		// every client says who it is, the others only give commands. encrypted clients send every line in
+		// blocks of their own
+		string scInput = Encode("hello " + itos(i) + "\n", client.bEncrypted);
+		if (client.eKind == CLIENT_CMD)
+		{
+			for (uint k = 0; k < LOAD_CMDS; k++)
+			{
+				scInput += Encode("cmd " + itos(i) + " " + itos(k) + "\r\n", client.bEncrypted);
+				client.scExpected += Encode("OK " + itos(i) + " " + itos(k) + "\r\n", client.bEncrypted);
+			}
+		}
+		else if (client.eKind == CLIENT_FAST)
+		{
+			for (uint iBatch = 0; iBatch < LOAD_BATCHES; iBatch++)
+			{
+				for (uint iLine = 0; iLine < LOAD_BATCH_LINES; iLine++)
+				{
+					wstring wscLine = EventLine(iBatch, iLine);
+					if (Subscribed(client, wscLine.substr(0, wscLine.find(L' '))))
+						client.iExpectedBytes += Encode(wstos(wscLine.substr(0, wscLine.length() - 1)) + "\r\n", client.bEncrypted).length();
+				}
+			}
+		}
+
+		uint iRate = (client.eKind == CLIENT_SLOW) ? LOAD_SLOW_RATE : SIM_READ_ALL;
+		client.s = SimAddClient(client.bEncrypted ? sEListen : sListen, scInput, iRate, client.eKind == CLIENT_CMD);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void NetThread()
+{
+	while (!bGameDone)
+		SocketServer::Poll();
+
+	// the output the game thread queued last
+	for (uint i = 0; i < 10000; i++)
+	{
+		SocketServer::Poll();
+		bool bPending = false;
+		foreach(SocketServer::lstConnections, SocketServer::NET_CONNECTION*, it)
+			bPending = bPending || (!(*it)->bClosed && (*it)->rbOut.Size());
+		if (!bPending)
+			break;
+	}
+}
+
+// like CSocket::DoPrint the game thread doesn't wait for the network thread, here it tries again instead
+static void SendRetry(SOCKET_MESSAGE_TYPE eType, uint iConnID, const wstring &wscText)
+{
+	while (!SocketServer::Send(eType, iConnID, wscText))
+		std::this_thread::yield();
+}
+
+int main()
+{
+	SetupClients();
+	std::thread threadNet(NetThread);
+
+	map<uint, uint> mapConnClients;
+	uint iOpened = 0, iHellos = 0, iCmdsDone = 0, iSlowClosed = 0, iBatches = 0;
+	bool bInOrder = true;
+	mstime tmStart = timeInMS();
+	while ((iCmdsDone < LOAD_CMD_CLIENTS || iBatches < LOAD_BATCHES || iSlowClosed < LOAD_SLOW_CONSUMERS)
+		&& (timeInMS() - tmStart) < LOAD_TIMEOUT_MS)
+	{
+		SOCKET_MESSAGE msg;
+		while (SocketServer::Receive(msg))
+		{
+			if (msg.eType == SOCKET_MSG_OPENED)
+				iOpened++;
+			else if (msg.eType == SOCKET_MSG_COMMAND)
+			{
+				uint iClient = (uint)wcstoul(GetParam(msg.wscText, ' ', 1).c_str(), 0, 10);
+				if (GetParam(msg.wscText, ' ', 0) == L"hello")
+				{
+					arrClients[iClient].iConnID = msg.iConnID;
+					mapConnClients[msg.iConnID] = iClient;
+					iHellos++;
+					if (arrClients[iClient].eKind != CLIENT_CMD)
+						SendRetry(SOCKET_MSG_EVENTMODE, msg.iConnID, arrClients[iClient].wscTopics);
+					continue;
+				}
+
+				LOAD_CLIENT &client = arrClients[iClient];
+				uint iCmd = (uint)wcstoul(GetParam(msg.wscText, ' ', 2).c_str(), 0, 10);
+				bInOrder = bInOrder && (client.iConnID == msg.iConnID) && (client.iNextCmd == iCmd);
+				client.iNextCmd++;
+				if (client.iNextCmd == LOAD_CMDS)
+					iCmdsDone++;
+				SendRetry(SOCKET_MSG_TEXT, msg.iConnID, L"OK " + stows(itos(iClient)) + L" " + stows(itos(iCmd)) + L"\n");
+			}
+			else if (msg.eType == SOCKET_MSG_CLOSED && mapConnClients.count(msg.iConnID))
+			{
+				LOAD_CLIENT &client = arrClients[mapConnClients[msg.iConnID]];
+				client.bClosed = true;
+				if (client.eKind == CLIENT_SLOW)
+					iSlowClosed++;
+			}
+		}
+
+		// the events start once every consumer is in event mode
+		if (iHellos < LOAD_CLIENTS || iBatches == LOAD_BATCHES)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		wstring wscBatch;
+		for (uint iLine = 0; iLine < LOAD_BATCH_LINES; iLine++)
+			wscBatch += EventLine(iBatches, iLine);
+		if (SocketServer::Send(SOCKET_MSG_EVENTS, 0, wscBatch))
+			iBatches++;
+	}
+
+	bGameDone = true;
+	threadNet.join();
+
+	CHECK((timeInMS() - tmStart) < LOAD_TIMEOUT_MS);
+	CHECK(iOpened == LOAD_CLIENTS);
+	CHECK(iHellos == LOAD_CLIENTS);
+	CHECK(bInOrder);
+	CHECK(iCmdsDone == LOAD_CMD_CLIENTS);
+	CHECK(iBatches == LOAD_BATCHES);
+	CHECK(iSlowClosed == LOAD_SLOW_CONSUMERS);
+	CHECK(iTestLogLines >= LOAD_SLOW_CONSUMERS);
+
+	uint iBadReplies = 0, iBadEvents = 0, iWrongClosed = 0;
+	for (uint i = 0; i < LOAD_CLIENTS; i++)
+	{
+		LOAD_CLIENT &client = arrClients[i];
+		if (client.eKind == CLIENT_CMD && SimGetReceived(client.s) != client.scExpected)
+			iBadReplies++;
+		if (client.eKind == CLIENT_FAST && SimGetReceivedBytes(client.s) != client.iExpectedBytes)
+			iBadEvents++;
+		if ((client.eKind == CLIENT_SLOW) != SimIsClosed(client.s) || (client.eKind == CLIENT_SLOW) != client.bClosed)
+			iWrongClosed++;
+	}
+	CHECK(iBadReplies == 0);
+	CHECK(iBadEvents == 0);
+	CHECK(iWrongClosed == 0);
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,142 @@
+#include "test.h"
+#include "CSocket.h"
+
+/**************************************************************************************************************
+CSocket.cpp: the ring buffer of the socket connections (wrapping, growing up to its maximum, the
+contiguous read/write pointers used by send/recv) and the bounded queue between the game and network thread
+**************************************************************************************************************/
+
+// CSocket::DoPrint hands its text to the network thread, there is none here
+bool SocketServer::Send(SOCKET_MESSAGE_TYPE eType, uint iConnID, const wstring &wscText)
+{
+	return false;
+}
+
+static string ReadAll(CRingBuffer &rb)
+{
+	string scData;
+	while (rb.Size())
+	{
+		uint iLen;
+		const char *pData = rb.ReadPtr(iLen);
+		scData.append(pData, iLen);
+		rb.Consume(iLen);
+	}
+	return scData;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void TestRingBuffer()
+{
+	CRingBuffer rb(16384);
+	uint iLen;
+	CHECK(rb.Size() == 0);
+	CHECK(rb.ReadPtr(iLen) == 0 && iLen == 0);
+	CHECK(rb.Write("", 0));
+
+	CHECK(rb.Write("hello", 5));
+	CHECK(rb.Size() == 5);
+	CHECK(ReadAll(rb) == "hello");
+
+	// data that wraps around the end of the buffer comes out in order, the first read stops at the end
+	string scFill(4000, 'a');
+	CHECK(rb.Write(scFill.data(), (uint)scFill.length()));
+	rb.ReadPtr(iLen);
+	rb.Consume(3990);
+	string scWrapped;
+	for (uint i = 0; i < 200; i++)
+		scWrapped += (char)('0' + i % 10);
+	CHECK(rb.Write(scWrapped.data(), (uint)scWrapped.length()));
+	const char *pData = rb.ReadPtr(iLen);
+	CHECK(iLen < rb.Size());
+	CHECK(string(pData, 10) == string(10, 'a'));
+	CHECK(ReadAll(rb) == string(10, 'a') + scWrapped);
+
+	// growing keeps the queued data, also when it wrapped
+	rb.Write(scFill.data(), 3000);
+	rb.Consume(2500);
+	string scBig;
+	for (uint i = 0; i < 10000; i++)
+		scBig += (char)('a' + i % 26);
+	CHECK(rb.Write(scBig.data(), (uint)scBig.length()));
+	CHECK(ReadAll(rb) == string(500, 'a') + scBig);
+
+	// nothing beyond the maximum size
+	string scMax(16384, 'm');
+	CHECK(rb.Write(scMax.data(), (uint)scMax.length()));
+	CHECK(!rb.Write("x", 1));
+	CHECK(rb.WritePtr(iLen) == 0 && iLen == 0);
+	CHECK(rb.Size() == 16384);
+	CHECK(ReadAll(rb) == scMax);
+
+	// recv writes straight into the free space
+	char *pWrite = rb.WritePtr(iLen);
+	CHECK(pWrite != 0 && iLen > 0);
+	memcpy(pWrite, "direct", 6);
+	rb.Commit(6);
+	CHECK(ReadAll(rb) == "direct");
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void TestSocketQueue()
+{
+	CSocketQueue queue(4);
+	SOCKET_MESSAGE msg;
+	CHECK(!queue.Pop(msg));
+	CHECK(!queue.Full());
+
+	// one slot always stays free
+	CHECK(queue.Push(SOCKET_MSG_OPENED, 1, L"127.0.0.1 1000 0 0"));
+	CHECK(queue.Push(SOCKET_MSG_COMMAND, 1, L"getplayers"));
+	CHECK(queue.Push(SOCKET_MSG_CLOSED, 1, L""));
+	CHECK(queue.Full());
+	CHECK(!queue.Push(SOCKET_MSG_TEXT, 2, L"lost"));
+
+	CHECK(queue.Pop(msg));
+	CHECK(msg.eType == SOCKET_MSG_OPENED && msg.iConnID == 1 && msg.wscText == L"127.0.0.1 1000 0 0");
+	CHECK(!queue.Full());
+	CHECK(queue.Push(SOCKET_MSG_TEXT, 2, L"wrapped"));
+
+	CHECK(queue.Pop(msg) && msg.eType == SOCKET_MSG_COMMAND && msg.wscText == L"getplayers");
+	CHECK(queue.Pop(msg) && msg.eType == SOCKET_MSG_CLOSED && msg.wscText == L"");
+	CHECK(queue.Pop(msg) && msg.eType == SOCKET_MSG_TEXT && msg.iConnID == 2 && msg.wscText == L"wrapped");
+	CHECK(!queue.Pop(msg));
+
+	// many more messages than slots
+	uint iPopped = 0;
+	bool bInOrder = true;
+	for (uint i = 0; i < 1000; i++)
+	{
+		CHECK(queue.Push(SOCKET_MSG_EVENTS, i, stows(itos(i))));
+		if (i % 3 == 2)
+		{
+			while (queue.Pop(msg))
+			{
+				bInOrder = bInOrder && (msg.iConnID == iPopped) && (msg.wscText == stows(itos(iPopped)));
+				iPopped++;
+			}
+		}
+	}
+	while (queue.Pop(msg))
+		iPopped++;
+	CHECK(bInOrder);
+	CHECK(iPopped == 1000);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	TestRingBuffer();
+	TestSocketQueue();
+
+	// a connection whose output can't be queued is marked for closing
+	CSocket sock;
+	sock.DoPrint(L"text");
+	CHECK(sock.bOverflow);
+	CHECK(sock.GetAdminName() == L"Socket connection (:0)");
+
+	return TEST_RESULT();
+}
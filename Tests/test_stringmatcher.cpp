@@ -0,0 +1,128 @@
+#include "test.h"
+#include "chat.h"
+#include "legacy/legacy.h"
+
+/**************************************************************************************************************
+CStringMatcher.cpp: a 2,000 word list against the loop playercntl used before (legacy_IsSwearing) on chat
+lines, every match position against a plain search, whole words, case folding and the masks that let the
+allowed words ("cockpit") take back the swear words they contain
+**************************************************************************************************************/
+
+#define TEST_WORDS 2000
+#define TEST_LINES 2000
+
+// every place any of the words appears in the lowered text, the way the matcher reports them
+static uint CountOccurrences(const vector<wstring> &vWords, const wstring &wscText)
+{
+	wstring wscLower = ToLower(wscText);
+	uint iCount = 0;
+	for (uint i = 0; i < vWords.size(); i++)
+	{
+		for (size_t iPos = wscLower.find(vWords[i]); iPos != wstring::npos; iPos = wscLower.find(vWords[i], iPos + 1))
+			iCount++;
+	}
+	return iCount;
+}
+
+static wstring Matches(const CStringMatcher &matcher, const wstring &wscText)
+{
+	list<STRING_MATCH> lstMatches;
+	matcher.Find(wscText, lstMatches);
+	wstring wscMatches;
+	foreach(lstMatches, STRING_MATCH, match)
+		wscMatches += wscText.substr(match->iPos, match->iLen) + L"/" + stows(itos(match->iMask)) + L" ";
+	return wscMatches;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void TestWordList()
+{
+	CChatGenerator gen(19);
+	vector<wstring> vWords = gen.Words(TEST_WORDS);
+	list<wstring> lstWords(vWords.begin(), vWords.end());
+
+	CStringMatcher matcher;
+	CHECK(matcher.Empty());
+	for (uint i = 0; i < vWords.size(); i++)
+		matcher.Add(vWords[i], 1);
+	matcher.Compile();
+	CHECK(!matcher.Empty());
+
+	// the same verdict as the old loop on every line, and every occurrence of every word reported
+	uint iSwearing = 0;
+	bool bSameVerdict = true, bAllFound = true, bPositionsRight = true;
+	for (uint iLine = 0; iLine < TEST_LINES; iLine++)
+	{
+		wstring wscLine = gen.Line(vWords, 5);
+		bool bOld = legacy_IsSwearing(lstWords, wscLine);
+		bool bNew = (matcher.Match(wscLine) & 1) != 0;
+		bSameVerdict = bSameVerdict && (bOld == bNew);
+		iSwearing += bNew ? 1 : 0;
+
+		list<STRING_MATCH> lstMatches;
+		matcher.Find(wscLine, lstMatches);
+		bAllFound = bAllFound && (lstMatches.size() == CountOccurrences(vWords, wscLine));
+		foreach(lstMatches, STRING_MATCH, match)
+		{
+			wstring wscFound = ToLower(wscLine.substr(match->iPos, match->iLen));
+			bPositionsRight = bPositionsRight && (find(vWords.begin(), vWords.end(), wscFound) != vWords.end());
+		}
+	}
+	CHECK(bSameVerdict);
+	CHECK(bAllFound);
+	CHECK(bPositionsRight);
+
+	// the lines must have some of both
+	CHECK(iSwearing > TEST_LINES / 10 && iSwearing < TEST_LINES - TEST_LINES / 10);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void TestSemantics()
+{
+	CStringMatcher matcher;
+	CHECK(matcher.Match(L"anything") == 0);
+
+	matcher.Add(L"cock", 1);
+	matcher.Add(L"COCKPIT", 2);
+	matcher.Add(L"ass", 4, true);
+	matcher.Add(L"bad word", 8);
+	matcher.Add(L"he", 16);
+	matcher.Add(L"hers", 16);
+	matcher.Compile();
+
+	// case insensitive, patterns inside patterns, matches in the order they end
+	CHECK(matcher.Match(L"Nice COCKPIT!") == 3);
+	CHECK(Matches(matcher, L"Nice COCKPIT!") == L"COCK/1 COCKPIT/2 ");
+	CHECK(Matches(matcher, L"ushers") == L"he/16 hers/16 ");
+	CHECK(Matches(matcher, L"a Bad Word here") == L"Bad Word/8 he/16 ");
+	CHECK(matcher.Match(L"badword") == 0);
+
+	// whole words: not next to letters or digits
+	CHECK(matcher.Match(L"ass") == 4);
+	CHECK(matcher.Match(L"you ass!") == 4);
+	CHECK(matcher.Match(L"(ASS)") == 4);
+	CHECK(matcher.Match(L"first class") == 0);
+	CHECK(matcher.Match(L"assassin") == 0);
+	CHECK(matcher.Match(L"ass1") == 0);
+	CHECK(Matches(matcher, L"class ass") == L"ass/4 ");
+
+	// an empty pattern is ignored, Clear starts over
+	matcher.Add(L"", 32);
+	matcher.Compile();
+	CHECK(matcher.Match(L"xyz") == 0);
+	matcher.Clear();
+	CHECK(matcher.Empty());
+	CHECK(matcher.Match(L"cock") == 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	TestWordList();
+	TestSemantics();
+
+	return TEST_RESULT();
+}
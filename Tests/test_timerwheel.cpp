@@ -0,0 +1,183 @@
+#include "test.h"
+
+/**************************************************************************************************************
+HkScheduler.cpp: expiry times across the wheel levels, periodic timers, cancelling (also from the
+callback and per client), stale ids, skipping the runs missed during a stall and pausing a plugin's timers
+**************************************************************************************************************/
+
+struct TIMER_RECORD
+{
+	uint iRuns;
+	mstime tmLastRun;
+	uint iCancelAfter; // cancels itself on this run
+	uint iTimerID;
+};
+
+static void RecordTimer(uint iTimerID, void *pData)
+{
+	TIMER_RECORD *record = (TIMER_RECORD*)pData;
+	record->iRuns++;
+	record->tmLastRun = timeInMS();
+	if (record->iCancelAfter && record->iRuns == record->iCancelAfter)
+		HkCancelTimer(iTimerID);
+}
+
+static uint iChainRuns = 0;
+
+static void ChainTimer(uint iTimerID, void *pData)
+{
+	if (++iChainRuns < 3)
+		HkScheduleTimer(10, 0, ChainTimer);
+}
+
+static void Advance(mstime tmDelta, mstime tmStep = 1)
+{
+	for (mstime tm = 0; tm < tmDelta; tm += tmStep)
+	{
+		tmTestTime += tmStep;
+		TimerWheel::Process();
+	}
+}
+
+static TIMER_RECORD NewRecord()
+{
+	TIMER_RECORD record = { 0, 0, 0, 0 };
+	return record;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int main()
+{
+	tmTestTime = 1000000;
+	TimerWheel::Process();
+
+	// one-shot
+	TIMER_RECORD oneShot = NewRecord();
+	mstime tmStart = tmTestTime;
+	CHECK(HkScheduleTimer(100, 0, RecordTimer, &oneShot) != 0);
+	Advance(99);
+	CHECK(oneShot.iRuns == 0);
+	Advance(1);
+	CHECK(oneShot.iRuns == 1);
+	CHECK(oneShot.tmLastRun == tmStart + 100);
+	Advance(500);
+	CHECK(oneShot.iRuns == 1);
+
+	// periodic timers keep their phase
+	TIMER_RECORD periodic = NewRecord();
+	tmStart = tmTestTime;
+	uint iPeriodic = HkScheduleTimer(20, 50, RecordTimer, &periodic);
+	Advance(20);
+	CHECK(periodic.iRuns == 1);
+	Advance(50 * 4);
+	CHECK(periodic.iRuns == 5);
+	CHECK(periodic.tmLastRun == tmStart + 20 + 50 * 4);
+	CHECK(HkCancelTimer(iPeriodic));
+	CHECK(!HkCancelTimer(iPeriodic));
+	Advance(200);
+	CHECK(periodic.iRuns == 5);
+
+	// the id of a cancelled timer doesn't reach the timer that reuses its slot
+	TIMER_RECORD reused = NewRecord();
+	uint iReused = HkScheduleTimer(10, 0, RecordTimer, &reused);
+	CHECK(iReused != iPeriodic);
+	CHECK(!HkCancelTimer(iPeriodic));
+	Advance(10);
+	CHECK(reused.iRuns == 1);
+	CHECK(!HkCancelTimer(0));
+	CHECK(!HkCancelTimer(0xFFFFFFFF));
+
+	// delays in every level of the wheel, run by big clock steps
+	mstime arrDelays[] = { 63, 64, 4095, 4096, 262143, 262144, 3 * 3600 * 1000 };
+	const uint iDelays = sizeof(arrDelays) / sizeof(mstime);
+	TIMER_RECORD arrRecords[iDelays];
+	tmStart = tmTestTime;
+	for (uint i = 0; i < iDelays; i++)
+	{
+		arrRecords[i] = NewRecord();
+		HkScheduleTimer((uint)arrDelays[i], 0, RecordTimer, &arrRecords[i]);
+	}
+	Advance(3 * 3600 * 1000 + 1000, 7);
+	for (uint i = 0; i < iDelays; i++)
+	{
+		CHECK(arrRecords[i].iRuns == 1);
+		CHECK(arrRecords[i].tmLastRun >= tmStart + arrDelays[i] && arrRecords[i].tmLastRun < tmStart + arrDelays[i] + 7);
+	}
+
+	// delays beyond the wheel's span park in the last level and still run on time
+	TIMER_RECORD farAway = NewRecord();
+	tmStart = tmTestTime;
+	HkScheduleTimer(6 * 3600 * 1000, 0, RecordTimer, &farAway);
+	Advance(6 * 3600 * 1000 - 1000, 1000);
+	CHECK(farAway.iRuns == 0);
+	Advance(2000, 1);
+	CHECK(farAway.iRuns == 1);
+	CHECK(farAway.tmLastRun == tmStart + 6 * 3600 * 1000);
+
+	// a timer that cancels itself from its callback
+	TIMER_RECORD selfCancel = NewRecord();
+	selfCancel.iCancelAfter = 3;
+	HkScheduleTimer(5, 5, RecordTimer, &selfCancel);
+	Advance(100);
+	CHECK(selfCancel.iRuns == 3);
+
+	// callbacks can schedule new timers
+	HkScheduleTimer(10, 0, ChainTimer);
+	Advance(100);
+	CHECK(iChainRuns == 3);
+
+	// a periodic timer runs once after a stall instead of once for every missed interval
+	TIMER_RECORD stalled = NewRecord();
+	tmStart = tmTestTime;
+	uint iStalled = HkScheduleTimer(100, 100, RecordTimer, &stalled);
+	tmTestTime += 1050;
+	TimerWheel::Process();
+	CHECK(stalled.iRuns == 1);
+	Advance(100);
+	CHECK(stalled.iRuns == 2);
+	CHECK(stalled.tmLastRun == tmStart + 1150);
+	HkCancelTimer(iStalled);
+
+	// client timers go when the client disconnects, the others stay
+	TIMER_RECORD client1 = NewRecord(), client2 = NewRecord(), global = NewRecord();
+	HkScheduleTimer(50, 50, RecordTimer, &client1, 1);
+	HkScheduleTimer(50, 0, RecordTimer, &client1, 1);
+	HkScheduleTimer(50, 50, RecordTimer, &client2, 2);
+	uint iGlobal = HkScheduleTimer(50, 50, RecordTimer, &global);
+	HkCancelClientTimers(1);
+	Advance(50);
+	CHECK(client1.iRuns == 0);
+	CHECK(client2.iRuns == 1);
+	CHECK(global.iRuns == 1);
+	HkCancelClientTimers(2);
+	HkCancelTimer(iGlobal);
+	CHECK(HkScheduleTimer(10, 0, RecordTimer, &client1, MAX_CLIENT_ID + 1) == 0);
+	CHECK(HkScheduleTimer(10, 0, 0) == 0);
+
+	// the timers of a paused plugin stay scheduled without running, its one-shots run once it is resumed.
+	// every callback is in module 0 here
+	TIMER_RECORD pausedPeriodic = NewRecord(), pausedOneShot = NewRecord(), pausedCancelled = NewRecord();
+	tmStart = tmTestTime;
+	uint iPausedPeriodic = HkScheduleTimer(50, 50, RecordTimer, &pausedPeriodic);
+	HkScheduleTimer(80, 0, RecordTimer, &pausedOneShot);
+	uint iPausedCancelled = HkScheduleTimer(80, 0, RecordTimer, &pausedCancelled);
+	Advance(50);
+	CHECK(pausedPeriodic.iRuns == 1);
+	TimerWheel::PauseModule(0, true);
+	Advance(200);
+	CHECK(pausedPeriodic.iRuns == 1);
+	CHECK(pausedOneShot.iRuns == 0);
+	CHECK(HkCancelTimer(iPausedCancelled));
+	TimerWheel::PauseModule(0, false);
+	Advance(1);
+	CHECK(pausedOneShot.iRuns == 1);
+	CHECK(pausedOneShot.tmLastRun == tmStart + 251);
+	CHECK(pausedCancelled.iRuns == 0);
+	Advance(49);
+	CHECK(pausedPeriodic.iRuns == 2);
+	CHECK(pausedPeriodic.tmLastRun == tmStart + 300);
+	HkCancelTimer(iPausedPeriodic);
+
+	return TEST_RESULT();
+}